@@ -0,0 +1,45 @@
+#ifndef ASYNCLOG_H
+#define ASYNCLOG_H
+
+/*******************************************************************************
+
+    ASYNCLOG -- Asynchronous ring-buffer log sink
+
+********************************************************************************
+
+Replaces easylogging++ file and console output. Logging thread formats the
+record and copies it into its own single-producer ring, a writer thread
+drains all rings every ASYNCLOG_FLUSH_MS and writes them out in one batch.
+Records that do not fit into a full ring are dropped and counted, logging
+thread never waits for the disk or the console.
+
+Records of different threads are ordered by drain pass, not by time.
+Ring of an exited thread is freed by the writer once drained.
+
+*******************************************************************************/
+
+#include <stddef.h>
+#include <stdio.h>
+
+// per-thread ring size in bytes, power of 2
+#define ASYNCLOG_RING_SIZE 0x40000 // 256 KiB
+
+// maximal record length, longer records are truncated
+#define ASYNCLOG_MAX_RECORD 0x2000
+
+// writer thread drain period
+#define ASYNCLOG_FLUSH_MS  50
+
+// start writer thread and redirect easylogging++ output to it
+int StartAsyncLog(void);
+
+// push formatted record from current thread
+void AsyncLogPush(const char * str, const size_t len);
+
+// write out all pushed records
+void FlushAsyncLog(void);
+
+// redirect output to file and console, for tests
+void AsyncLogOutput(FILE * file, const int console);
+
+#endif // ASYNCLOG_H
@@ -0,0 +1,67 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+/*******************************************************************************
+
+    AUTOTUNE -- Per-device work size search and tuning profile
+
+********************************************************************************
+
+The tuner doubles nonces per iteration from TUNE_MIN_NONCES up to
+TUNE_MAX_NONCES, or until one iteration takes longer than TUNE_MAX_ITER_MS,
+for every block size from TUNE_MIN_BLOCK_DIM up to the backend limit. It
+keeps the smallest work size within TUNE_TOLERANCE percent of the best
+throughput, smaller iterations react faster to a new block.
+
+Backend has to be prehashed before tuning. Results of tuning iterations
+are discarded.
+
+Profile is a text file with a line per device model:
+
+    <nonces per iteration> <block size> <device name>
+
+*******************************************************************************/
+
+#include "backend.h"
+#include "definitions.h"
+
+// nonces per iteration search range
+#define TUNE_MIN_NONCES    0x100000 // 2^20
+#define TUNE_MAX_NONCES    0x1000000 // 2^24
+
+// block size search range
+#define TUNE_MIN_BLOCK_DIM 32
+#define TUNE_MAX_BLOCK_DIM 1024
+
+// measured iterations per candidate
+#define TUNE_ITERS         3
+
+// maximal iteration duration
+#define TUNE_MAX_ITER_MS   1000
+
+// accepted throughput loss for a smaller work size in percent
+#define TUNE_TOLERANCE     2
+
+// search best work size and set it to backend
+int TuneWorkSize(backend_t * backend, uint32_t * nonces, uint32_t * dim);
+
+// find device work size in profile
+int ReadTuneProfile(
+    const char * fileName,
+    const char * device,
+    uint32_t * nonces,
+    uint32_t * dim
+);
+
+// append device work size to profile
+int WriteTuneProfile(
+    const char * fileName,
+    const char * device,
+    const uint32_t nonces,
+    const uint32_t dim
+);
+
+// set work size from profile, tune and store it if device is not there
+int Autotune(backend_t * backend, const char * fileName);
+
+#endif // AUTOTUNE_H
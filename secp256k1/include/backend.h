@@ -0,0 +1,136 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+/*******************************************************************************
+
+    BACKEND -- Compute device abstraction for miner threads
+
+********************************************************************************
+
+A backend owns all memory of one mining device and runs the puzzle steps
+on it. Every method is called from the owning miner thread only, returns
+EXIT_SUCCESS or EXIT_FAILURE and logs the reason of a failure itself.
+
+Allocate            check memory, allocate buffers, may reset keepPrehash
+SetKeys             upload public key and secret key
+UncompletePrehash   precalculate unfinalized hash contexts (keepPrehash)
+SetWorkSize         set nonces per iteration and mining kernel block size
+SetBlock            upload message, bound and one-time key pair
+SetBound            upload bound of the same message, hashes are kept
+Prehash             precalculate hashes and mining context for the block
+Mine                start one mining iteration of noncesPerIter nonces
+GetResult           wait for the iteration, ind = nonce offset + 1 or 0
+CreateSensor        create device sensor for duty-cycle control
+
+Work size defaults to the compile-time NONCES_PER_ITER and BLOCK_DIM and
+may be changed between iterations, e.g. by the autotuner.
+
+*******************************************************************************/
+
+#include "definitions.h"
+#include "throttle.h"
+#include "topology.h"
+
+// default simulated device model
+#define SIM_PREHASH_MS     1000
+#define SIM_ITER_MS        10
+#define SIM_MEMORY         8192
+
+// compute backend types
+typedef enum
+{
+    BACKEND_CUDA = 0,
+    BACKEND_CPU = 1,
+    BACKEND_SIM = 2
+}
+backend_type_t;
+
+// compute backend interface
+struct backend_t
+{
+    // nonces per mining iteration
+    uint32_t noncesPerIter;
+    // mining kernel block size and its upper limit, 1 if not applicable
+    uint32_t blockDim;
+    uint32_t maxBlockDim;
+
+    backend_t(void)
+    {
+        noncesPerIter = NONCES_PER_ITER;
+        blockDim = BLOCK_DIM;
+        maxBlockDim = BLOCK_DIM;
+    }
+
+    virtual ~backend_t(void) {}
+
+    // device name
+    virtual const char * Name(void) = 0;
+
+    // memory check and allocation
+    virtual int Allocate(int * keepPrehash) = 0;
+
+    // key-pair upload
+    virtual int SetKeys(const uint8_t * pk, const uint8_t * sk) = 0;
+
+    // unfinalized hash contexts precalculation
+    virtual int UncompletePrehash(void) = 0;
+
+    // work size setting
+    virtual int SetWorkSize(const uint32_t nonces, const uint32_t dim)
+    {
+        if (!nonces || !dim || dim > maxBlockDim) { return EXIT_FAILURE; }
+
+        noncesPerIter = nonces;
+        blockDim = dim;
+
+        return EXIT_SUCCESS;
+    }
+
+    // temperature and power sensor, NULL if there is none
+    virtual sensor_t * CreateSensor(void) { return NULL; }
+
+    // block data upload
+    virtual int SetBlock(
+        const uint8_t * mes,
+        const uint8_t * bound,
+        const uint8_t * x,
+        const uint8_t * w
+    ) = 0;
+
+    // bound upload without message change
+    virtual int SetBound(const uint8_t * bound) = 0;
+
+    // hashes precalculation
+    virtual int Prehash(void) = 0;
+
+    // mining iteration start
+    virtual int Mine(const uint64_t base) = 0;
+
+    // mining iteration result
+    virtual int GetResult(uint32_t * ind, uint8_t * res) = 0;
+};
+
+// parse backend type name
+int ParseBackendType(const char * str, const int len, int * type);
+
+// number of devices available to backend
+int GetBackendDeviceCount(const info_t * info, int * count);
+
+// create backend for device, placement may be NULL
+backend_t * CreateBackend(
+    const info_t * info,
+    const int deviceId,
+    const placement_t * placement
+);
+
+// backend implementations
+int GetCudaDeviceCount(int * count);
+backend_t * CreateCudaBackend(const int deviceId);
+backend_t * CreateCpuBackend(
+    const int deviceId,
+    const info_t * info,
+    const std::vector<int> * cpus
+);
+backend_t * CreateSimBackend(const int deviceId, const info_t * info);
+
+#endif // BACKEND_H
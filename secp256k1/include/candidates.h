@@ -0,0 +1,94 @@
+#ifndef CANDIDATES_H
+#define CANDIDATES_H
+
+/*******************************************************************************
+
+    CANDIDATES -- Candidate stream recording and replay
+
+********************************************************************************
+
+Recorder polls node /mining/candidate every CANDIDATES_POLL_MS and appends
+a record to the file whenever the response changes:
+
+T ms len
+<len bytes of response>
+
+where ms is time since the start of recording. Replay server serves the
+recorded stream at /mining/candidate with time scaled by speed, so that
+the miner pointed to it sees the same block switches as on the live node.
+It accepts /mining/solution and reports at /stats:
+
+polls               number of candidate requests and their rate
+switches            candidates served and mean and maximal switch latency,
+                    time from scheduled switch to the first poll that saw it
+solutions           posted solutions and stale ones, posted after a switch
+                    but before any poll saw it
+
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// recorder poll period
+#define CANDIDATES_POLL_MS 100
+
+// default replay server port, the node one
+#define CANDIDATES_PORT    9052
+
+// recorded node response
+struct candidate_t
+{
+    int64_t ms;
+    std::string body;
+};
+
+// replay schedule and statistics, times in real ms since start
+struct replay_t
+{
+    const std::vector<candidate_t> & stream;
+    double speed;
+
+    // candidate seen by the last poll
+    int served;
+
+    uint64_t polls;
+    uint64_t switches;
+    double latencySum;
+    double latencyMax;
+    uint64_t solutions;
+    uint64_t stale;
+
+    replay_t(const std::vector<candidate_t> & recorded, const double x);
+
+    // time of candidate switch
+    double SwitchMs(const int ind) const;
+
+    // candidate scheduled for time
+    int Current(const double nowMs) const;
+
+    // candidate served to poll
+    int Poll(const double nowMs);
+
+    // count posted solution
+    void Post(const double nowMs);
+};
+
+// append response received at ms since start of recording
+void WriteCandidate(FILE * out, const int64_t ms, const std::string & body);
+
+// record node candidate stream to file until interrupted
+int RecordCandidates(const char * node, const char * fileName);
+
+// read recorded candidate stream
+int ReadCandidates(const char * fileName, std::vector<candidate_t> * stream);
+
+// serve recorded candidate stream at speed times real time
+int ServeCandidates(
+    const std::vector<candidate_t> & stream,
+    const double speed,
+    const int port
+);
+
+#endif // CANDIDATES_H
@@ -8,6 +8,7 @@
 *******************************************************************************/
 
 #include "definitions.h"
+#include "kernel.h"
 
 // increment a counter in a warp
 __device__ uint32_t WarpInc(uint32_t * len);
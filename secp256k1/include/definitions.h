@@ -13,6 +13,7 @@
 #include <stddef.h>
 #include <time.h>
 #include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <string.h>
 ////////////////////////////////////////////////////////////////////////////////
@@ -44,9 +45,21 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 // Memory compatibility checks
-// should probably be now more correctly set
-#define MIN_FREE_MEMORY    2200000000
-#define MIN_FREE_MEMORY_PREHASH 7300000000
+// device allocations: hashes, bound and data, result and index
+#define MINING_MEMORY_8                                                        \
+(                                                                              \
+    (size_t)N_LEN * NUM_SIZE_8 + NUM_SIZE_8 + DATA_SIZE_8 + NUM_SIZE_8         \
+    + sizeof(uint32_t)                                                         \
+)
+
+// unfinalized hash contexts of keepPrehash
+#define PREHASH_MEMORY_8   ((size_t)N_LEN * sizeof(uctx_t))
+
+// allocation granularity and fragmentation
+#define MEMORY_MARGIN_8    ((size_t)64 << 20)
+
+#define MIN_FREE_MEMORY    (MINING_MEMORY_8 + MEMORY_MARGIN_8)
+#define MIN_FREE_MEMORY_PREHASH (MIN_FREE_MEMORY + PREHASH_MEMORY_8)
 
 ////////////////////////////////////////////////////////////////////////////////
 //  CONSTANTS: Autolykos algorithm
@@ -78,6 +91,14 @@
 #define q1_s               "0xBFD25E8C"
 #define q0_s               "0xD0364141"
 
+// operands of carry-chain intrinsics
+#define qhi_u32            0xFFFFFFFF
+#define q4_u32             0xFFFFFFFE
+#define q3_u32             0xBAAEDCE6
+#define q2_u32             0xAF48A03B
+#define q1_u32             0xBFD25E8C
+#define q0_u32             0xD0364141
+
 // Valid range: Q itself is multiplier-of-Q floor of 2^256
 // 64 bits
 #define Q3                 0xFFFFFFFFFFFFFFFF
@@ -115,12 +136,17 @@
 // JSON position of public key
 #define PK_POS             6
 
+// total JSON objects count of posted solution
+#define SOL_LEN            9
+
 //============================================================================//
 //  Configuration file 
 //============================================================================//
-// max JSON objects count for config file,
-// increased, to have more options if we need them
-#define CONF_LEN           21
+// options of config file, ReadConfig recognizes every one of them
+#define CONF_OPTIONS       22
+
+// max JSON objects count for config file, object and key-value of options
+#define CONF_LEN           (2 * CONF_OPTIONS + 1)
 
 // config JSON position of secret key
 #define SEED_POS           2
@@ -231,6 +257,41 @@ typedef enum
 }
 state_t;
 
+// block data changes against previous snapshot
+#define BLOCK_MES_CHANGED   1
+#define BLOCK_BOUND_CHANGED 2
+
+// block data snapshot
+struct block_data_t
+{
+    uint8_t mes[NUM_SIZE_8];
+    uint8_t bound[NUM_SIZE_8];
+    uint64_t changed;
+};
+
+#define BLOCK_DATA_SIZE_64 (sizeof(block_data_t) >> 3)
+
+// block data published by poller to miner threads without locking:
+// sequence is odd while the single writer copies data, readers copy
+// without waiting and retry if the sequence was odd or has changed
+struct block_seqlock_t
+{
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> words[BLOCK_DATA_SIZE_64];
+
+    // snapshots read and reads retried because of a concurrent write
+    mutable std::atomic<uint64_t> reads;
+    mutable std::atomic<uint64_t> retries;
+
+    block_seqlock_t(void);
+
+    // publish snapshot, one writer at a time
+    void Publish(const block_data_t * data);
+
+    // read consistent snapshot, returns its sequence
+    uint64_t Read(block_data_t * data) const;
+};
+
 // puzzle global info
 struct info_t
 {
@@ -241,9 +302,10 @@ struct info_t
     // not used now
     // std::mutex io_mutex;
 
+    // Block data of node, published without info_mutex
+    block_seqlock_t block;
+
     // Puzzle data to read
-    uint8_t bound[NUM_SIZE_8];
-    uint8_t mes[NUM_SIZE_8];
     uint8_t sk[NUM_SIZE_8];
     uint8_t pk[PK_SIZE_8];
     char skstr[NUM_SIZE_4];
@@ -251,8 +313,52 @@ struct info_t
     int keepPrehash;
     char to[MAX_URL_SIZE];
 
+    // Compute backend, number of its devices and host threads per device
+    int backend;
+    int devices;
+    int cpuThreads;
+
+    // Copy CPU hashes table to every NUMA node
+    int cpuNumaReplicate;
+
+    // CPU prehash contexts shared between processes: role and segment name
+    int cpuShared;
+    char cpuSharedName[64];
+
+    // Host threads placement on CPU cores
+    int threadPlacement;
+
+    // Simulated device model: prehash and iteration time, memory in MiB
+    int simPrehashMs;
+    int simIterMs;
+    int simMemory;
+
+    // Work size override, zero for default, and autotuning profile
+    uint32_t noncesPerIter;
+    uint32_t blockDim;
+    int autotune;
+    char tuneProfile[MAX_URL_SIZE];
+
+    // Duty-cycle controller temperature in C and power in W, zero if none
+    double targetTemp;
+    double targetPower;
+
+    // Journal file of found solutions
+    char journal[MAX_URL_SIZE];
+
+    // Candidate proxy host:port, empty if node is polled
+    char proxy[MAX_URL_SIZE];
+
+    // Total time spent waiting for info_mutex and number of its locks
+    std::atomic<uint64_t> lockWaitNs;
+    std::atomic<uint64_t> lockCount;
+
     // Increment when new block is sent by node
     std::atomic<uint_t> blockId; 
+
+    // Signaled on blockId increment for miners waiting for a new block
+    std::mutex blockMutex;
+    std::condition_variable blockSignal;
 };
 
 // json string for CURL http requests and config 
@@ -295,15 +401,69 @@ struct ctx_t
     uint32_t c;
 };
 
-// BLAKE2b-256 packed uncomplete hash state context 
+// bytes compressed into every uncomplete hash state context:
+// whole blocks of idx || M || pk, the last one is held back for completion
+#define UCTX_COUNT                                                             \
+    (                                                                          \
+        (INDEX_SIZE_8 + CONST_MES_SIZE_8 + PK_SIZE_8 - 1)                      \
+        / BUF_SIZE_8 * BUF_SIZE_8                                              \
+    )
+
+// BLAKE2b-256 packed uncomplete hash state context,
+// total number of bytes is UCTX_COUNT for any index
 struct uctx_t
 {
     // chained state
     uint64_t h[8];
-    // total number of bytes
-    uint64_t t[2];
 };
 
+////////////////////////////////////////////////////////////////////////////////
+//  Constant message schedule: idx || M as 64-bit message words
+////////////////////////////////////////////////////////////////////////////////
+// M is a sequence of BIG ENDIAN 64-bit counters 0, 1, ..., so that after
+// the 4 index bytes every block of idx || M is fixed
+
+// whole blocks of idx || M
+#define CONST_MES_BLOCKS   ((INDEX_SIZE_8 + CONST_MES_SIZE_8) / BUF_SIZE_8)
+
+// bytes of idx || M left in buffer after whole blocks
+#define CONST_MES_REM_8    ((INDEX_SIZE_8 + CONST_MES_SIZE_8) % BUF_SIZE_8)
+
+// words of whole blocks and one word of remaining bytes
+#define CONST_SCHEDULE_SIZE_64 (CONST_MES_BLOCKS * 16 + 1)
+
+// word w: last 4 bytes of counter w - 1 and first (zero) 4 bytes of
+// counter w, word 0 holds the index bytes and is zero in schedule
+#define CONST_MES_WORD(w)                                                      \
+    (                                                                          \
+        (((uint64_t)(w) - ((w) > 0)) >> 8 & 0xFF) << 16                        \
+        | (((uint64_t)(w) - ((w) > 0)) & 0xFF) << 24                           \
+    )
+
+#define CONST_MES_BLOCK_WORDS(k)                                               \
+    CONST_MES_WORD(16 * (k) +  0), CONST_MES_WORD(16 * (k) +  1),              \
+    CONST_MES_WORD(16 * (k) +  2), CONST_MES_WORD(16 * (k) +  3),              \
+    CONST_MES_WORD(16 * (k) +  4), CONST_MES_WORD(16 * (k) +  5),              \
+    CONST_MES_WORD(16 * (k) +  6), CONST_MES_WORD(16 * (k) +  7),              \
+    CONST_MES_WORD(16 * (k) +  8), CONST_MES_WORD(16 * (k) +  9),              \
+    CONST_MES_WORD(16 * (k) + 10), CONST_MES_WORD(16 * (k) + 11),              \
+    CONST_MES_WORD(16 * (k) + 12), CONST_MES_WORD(16 * (k) + 13),              \
+    CONST_MES_WORD(16 * (k) + 14), CONST_MES_WORD(16 * (k) + 15)
+
+#define CONST_MES_8_BLOCKS(k)                                                  \
+    CONST_MES_BLOCK_WORDS(8 * (k) + 0), CONST_MES_BLOCK_WORDS(8 * (k) + 1),    \
+    CONST_MES_BLOCK_WORDS(8 * (k) + 2), CONST_MES_BLOCK_WORDS(8 * (k) + 3),    \
+    CONST_MES_BLOCK_WORDS(8 * (k) + 4), CONST_MES_BLOCK_WORDS(8 * (k) + 5),    \
+    CONST_MES_BLOCK_WORDS(8 * (k) + 6), CONST_MES_BLOCK_WORDS(8 * (k) + 7)
+
+// initializer of CONST_SCHEDULE_SIZE_64 words,
+// written out for INDEX_SIZE_8 == 4 and CONST_MES_SIZE_8 == 8192
+#define CONST_MES_SCHEDULE                                                     \
+    CONST_MES_8_BLOCKS(0), CONST_MES_8_BLOCKS(1), CONST_MES_8_BLOCKS(2),       \
+    CONST_MES_8_BLOCKS(3), CONST_MES_8_BLOCKS(4), CONST_MES_8_BLOCKS(5),       \
+    CONST_MES_8_BLOCKS(6), CONST_MES_8_BLOCKS(7),                              \
+    CONST_MES_WORD(CONST_MES_BLOCKS * 16)
+
 ////////////////////////////////////////////////////////////////////////////////
 //  BLAKE2b-256 hashing procedures macros
 ////////////////////////////////////////////////////////////////////////////////
@@ -585,22 +745,16 @@ do                                                                             \
 }                                                                              \
 while (0)
 
-// blake2b intermediate mixing procedure
+// blake2b intermediate mixing procedure in kernels, see kernel.h
 #define DEVICE_B2B_H(ctx, aux)                                                 \
 do                                                                             \
 {                                                                              \
-    asm volatile (                                                             \
-        "add.cc.u32 %0, %0, 128;": "+r"(((uint32_t *)((ctx_t *)(ctx))->t)[0])  \
-    );                                                                         \
-    asm volatile (                                                             \
-        "addc.cc.u32 %0, %0, 0;": "+r"(((uint32_t *)((ctx_t *)(ctx))->t)[1])   \
-    );                                                                         \
-    asm volatile (                                                             \
-        "addc.cc.u32 %0, %0, 0;": "+r"(((uint32_t *)((ctx_t *)(ctx))->t)[2])   \
-    );                                                                         \
-    asm volatile (                                                             \
-        "addc.u32 %0, %0, 0;": "+r"(((uint32_t *)((ctx_t *)(ctx))->t)[3])      \
-    );                                                                         \
+    uint32_t * t_ = (uint32_t *)((ctx_t *)(ctx))->t;                           \
+                                                                               \
+    PTX_ADD_CC(t_[0], t_[0], BUF_SIZE_8);                                      \
+    PTX_ADDC_CC(t_[1], t_[1], 0);                                              \
+    PTX_ADDC_CC(t_[2], t_[2], 0);                                              \
+    PTX_ADDC(t_[3], t_[3], 0);                                                 \
                                                                                \
     B2B_INIT(ctx, aux);                                                        \
     B2B_FINAL(ctx, aux);                                                       \
@@ -609,27 +763,16 @@ do                                                                             \
 }                                                                              \
 while (0)
 
-// blake2b last mixing procedure
+// blake2b last mixing procedure in kernels, see kernel.h
 #define DEVICE_B2B_H_LAST(ctx, aux)                                            \
 do                                                                             \
 {                                                                              \
-    asm volatile (                                                             \
-        "add.cc.u32 %0, %0, %1;":                                              \
-        "+r"(((uint32_t *)((ctx_t *)(ctx))->t)[0]):                            \
-        "r"(((ctx_t *)(ctx))->c)                                               \
-    );                                                                         \
-    asm volatile (                                                             \
-        "addc.cc.u32 %0, %0, 0;":                                              \
-        "+r"(((uint32_t *)((ctx_t *)(ctx))->t)[1])                             \
-    );                                                                         \
-    asm volatile (                                                             \
-        "addc.cc.u32 %0, %0, 0;":                                              \
-        "+r"(((uint32_t *)((ctx_t *)(ctx))->t)[2])                             \
-    );                                                                         \
-    asm volatile (                                                             \
-        "addc.u32 %0, %0, 0;":                                                 \
-        "+r"(((uint32_t *)((ctx_t *)(ctx))->t)[3])                             \
-    );                                                                         \
+    uint32_t * t_ = (uint32_t *)((ctx_t *)(ctx))->t;                           \
+                                                                               \
+    PTX_ADD_CC(t_[0], t_[0], ((ctx_t *)(ctx))->c);                             \
+    PTX_ADDC_CC(t_[1], t_[1], 0);                                              \
+    PTX_ADDC_CC(t_[2], t_[2], 0);                                              \
+    PTX_ADDC(t_[3], t_[3], 0);                                                 \
                                                                                \
     while (((ctx_t *)(ctx))->c < BUF_SIZE_8)                                   \
     {                                                                          \
@@ -644,6 +787,130 @@ do                                                                             \
 }                                                                              \
 while (0)
 
+////////////////////////////////////////////////////////////////////////////////
+//  PTX carry-chain arithmetic emulation on host
+////////////////////////////////////////////////////////////////////////////////
+// cf is the emulated CC.CF flag (carry or borrow), always 0 or 1
+
+// add.cc.u32 d, a, b
+#define HOST_ADD_CC(d, a, b, cf)                                               \
+do                                                                             \
+{                                                                              \
+    uint64_t s_ = (uint64_t)(uint32_t)(a) + (uint32_t)(b);                     \
+    (d) = (uint32_t)s_;                                                        \
+    (cf) = (uint32_t)(s_ >> 32);                                               \
+}                                                                              \
+while (0)
+
+// addc.cc.u32 d, a, b
+#define HOST_ADDC_CC(d, a, b, cf)                                              \
+do                                                                             \
+{                                                                              \
+    uint64_t s_ = (uint64_t)(uint32_t)(a) + (uint32_t)(b) + (cf);              \
+    (d) = (uint32_t)s_;                                                        \
+    (cf) = (uint32_t)(s_ >> 32);                                               \
+}                                                                              \
+while (0)
+
+// addc.u32 d, a, b
+#define HOST_ADDC(d, a, b, cf)                                                 \
+do                                                                             \
+{                                                                              \
+    (d) = (uint32_t)((uint32_t)(a) + (uint32_t)(b) + (cf));                    \
+}                                                                              \
+while (0)
+
+// sub.cc.u32 d, a, b
+#define HOST_SUB_CC(d, a, b, cf)                                               \
+do                                                                             \
+{                                                                              \
+    uint64_t s_ = (uint64_t)(uint32_t)(a) - (uint32_t)(b);                     \
+    (d) = (uint32_t)s_;                                                        \
+    (cf) = (uint32_t)(s_ >> 63);                                               \
+}                                                                              \
+while (0)
+
+// subc.cc.u32 d, a, b
+#define HOST_SUBC_CC(d, a, b, cf)                                              \
+do                                                                             \
+{                                                                              \
+    uint64_t s_ = (uint64_t)(uint32_t)(a) - (uint32_t)(b) - (cf);              \
+    (d) = (uint32_t)s_;                                                        \
+    (cf) = (uint32_t)(s_ >> 63);                                               \
+}                                                                              \
+while (0)
+
+// subc.u32 d, a, b
+#define HOST_SUBC(d, a, b, cf)                                                 \
+do                                                                             \
+{                                                                              \
+    (d) = (uint32_t)((uint32_t)(a) - (uint32_t)(b) - (cf));                    \
+}                                                                              \
+while (0)
+
+// mul.lo.u32 d, a, b
+#define HOST_MUL_LO(d, a, b)                                                   \
+    ((d) = (uint32_t)((uint64_t)(uint32_t)(a) * (uint32_t)(b)))
+
+// mul.hi.u32 d, a, b
+#define HOST_MUL_HI(d, a, b)                                                   \
+    ((d) = (uint32_t)(((uint64_t)(uint32_t)(a) * (uint32_t)(b)) >> 32))
+
+// mad.lo.cc.u32 d, a, b, c
+#define HOST_MAD_LO_CC(d, a, b, c, cf)                                         \
+do                                                                             \
+{                                                                              \
+    uint64_t s_ = (uint64_t)(uint32_t)((uint64_t)(uint32_t)(a) * (uint32_t)(b))\
+        + (uint32_t)(c);                                                       \
+    (d) = (uint32_t)s_;                                                        \
+    (cf) = (uint32_t)(s_ >> 32);                                               \
+}                                                                              \
+while (0)
+
+// madc.lo.cc.u32 d, a, b, c
+#define HOST_MADC_LO_CC(d, a, b, c, cf)                                        \
+do                                                                             \
+{                                                                              \
+    uint64_t s_ = (uint64_t)(uint32_t)((uint64_t)(uint32_t)(a) * (uint32_t)(b))\
+        + (uint32_t)(c) + (cf);                                                \
+    (d) = (uint32_t)s_;                                                        \
+    (cf) = (uint32_t)(s_ >> 32);                                               \
+}                                                                              \
+while (0)
+
+// madc.lo.u32 d, a, b, c
+#define HOST_MADC_LO(d, a, b, c, cf)                                           \
+do                                                                             \
+{                                                                              \
+    (d) = (uint32_t)(                                                          \
+        (uint32_t)((uint64_t)(uint32_t)(a) * (uint32_t)(b))                    \
+        + (uint32_t)(c) + (cf)                                                 \
+    );                                                                         \
+}                                                                              \
+while (0)
+
+// madc.hi.cc.u32 d, a, b, c
+#define HOST_MADC_HI_CC(d, a, b, c, cf)                                        \
+do                                                                             \
+{                                                                              \
+    uint64_t s_ = (((uint64_t)(uint32_t)(a) * (uint32_t)(b)) >> 32)            \
+        + (uint32_t)(c) + (cf);                                                \
+    (d) = (uint32_t)s_;                                                        \
+    (cf) = (uint32_t)(s_ >> 32);                                               \
+}                                                                              \
+while (0)
+
+// madc.hi.u32 d, a, b, c
+#define HOST_MADC_HI(d, a, b, c, cf)                                           \
+do                                                                             \
+{                                                                              \
+    (d) = (uint32_t)(                                                          \
+        (((uint64_t)(uint32_t)(a) * (uint32_t)(b)) >> 32)                      \
+        + (uint32_t)(c) + (cf)                                                 \
+    );                                                                         \
+}                                                                              \
+while (0)
+
 ////////////////////////////////////////////////////////////////////////////////
 //  Little-Endian to Big-Endian convertation
 ////////////////////////////////////////////////////////////////////////////////
@@ -703,6 +970,22 @@ do                                                                             \
 }                                                                              \
 while (0)
 
+// CUDA call in recoverable code: log error and return failure
+#define CUDA_CHECK(x)                                                          \
+do                                                                             \
+{                                                                              \
+    cudaError_t error_ = (x);                                                  \
+                                                                               \
+    if (error_ != cudaSuccess)                                                 \
+    {                                                                          \
+        LOG(ERROR) << "CUDA failed at " << __FILE__ << ": " << __LINE__        \
+            << ", " << cudaGetErrorString(error_);                             \
+                                                                               \
+        return EXIT_FAILURE;                                                   \
+    }                                                                          \
+}                                                                              \
+while (0)
+
 #define CALL(func, name)                                                       \
 do                                                                             \
 {                                                                              \
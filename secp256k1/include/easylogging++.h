@@ -14,6 +14,8 @@
 //  http://muflihun.com
 //
 #define ELPP_THREAD_SAFE
+// dispatch callbacks do their own locking, async sink needs none
+#define ELPP_NO_GLOBAL_LOCK
 #define ELPP_WINSOCK2
 
 
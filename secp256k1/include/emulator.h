@@ -0,0 +1,69 @@
+#ifndef EMULATOR_H
+#define EMULATOR_H
+
+/*******************************************************************************
+
+    EMULATOR -- Local node stand-in with difficulty control
+
+********************************************************************************
+
+Serves /mining/candidate with the miner public key and a random message.
+The message rotates every blockSec seconds and after every valid solution,
+as if the solution made a block. The bound makes a nonce a solution with
+probability rate / hashrate, so that miners of the given hashrate find
+rate solutions per second. Every EMULATOR_RETARGET_SEC the probability is
+corrected by the ratio of expected and found valid solutions, at most by
+EMULATOR_MAX_RETARGET times, like a node adjusting difficulty.
+
+Posted /mining/solution bodies are checked with VerifySolution against
+the current candidate. Solutions valid for the previous candidate are
+counted stale, others invalid. /stats reports blocks, solutions, valid,
+stale and invalid ones, observed rate of valid solutions and probability.
+
+*******************************************************************************/
+
+#include "definitions.h"
+
+// difficulty correction period
+#define EMULATOR_RETARGET_SEC 10
+
+// maximal difficulty change per correction
+#define EMULATOR_MAX_RETARGET 4.0
+
+// default emulator port, the node one
+#define EMULATOR_PORT 9052
+
+// difficulty control, times in seconds since start
+struct bound_control_t
+{
+    // target valid solutions per second
+    double rate;
+    double probability;
+
+    uint64_t valid;
+    uint64_t validAtRetarget;
+    double retargetedSec;
+
+    bound_control_t(const double target, const double hashrate);
+
+    // correct probability if retarget period passed, 1 if corrected
+    int Retarget(const double nowSec);
+};
+
+// bound for probability of a nonce to be a solution
+void ProbabilityToBound(const double probability, uint8_t * bound);
+
+// serve candidates for public key and verify solutions
+int EmulateNode(
+    // public key string
+    const char * pkstr,
+    // target valid solutions per second
+    const double rate,
+    // message rotation period
+    const double blockSec,
+    // expected total hashrate of miners
+    const double hashrate,
+    const int port
+);
+
+#endif // EMULATOR_H
@@ -0,0 +1,195 @@
+#ifndef FANOUT_H
+#define FANOUT_H
+
+/*******************************************************************************
+
+    FANOUT -- Candidate fan-out proxy for miners of one site
+
+********************************************************************************
+
+Proxy polls node /mining/candidate for the whole site and pushes every new
+candidate to connected miners over persistent TCP connections, miners post
+solutions back the same way and the proxy posts them to the node. Frames
+are a 4-byte header followed by fixed-size little-endian payload:
+
+type, 0, size       1 + 1 + 2 bytes header, size of payload
+
+HELLO               miner -> proxy: version, public key
+CANDIDATE           proxy -> miner: sequence, changes, message, bound, node
+                    public key
+ACK                 miner -> proxy: sequence of published candidate
+SOLUTION            miner -> proxy: id, w, nonce, d
+RESULT              proxy -> miner: id, FANOUT_DELIVERED or FANOUT_FAILED
+
+The last candidate is sent to every miner on connection. Miners reconnect
+every FANOUT_RETRY_MS while the proxy is down and keep mining the last
+candidate meanwhile.
+
+Every FANOUT_REPORT_SEC the proxy logs upstream requests and their rate,
+candidates, connected miners, solutions and fan-out latency, the time
+from candidate detection to its ACK from a miner, mean and maximum.
+
+*******************************************************************************/
+
+#include "definitions.h"
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// default proxy port and node poll period
+#define FANOUT_PORT        9061
+#define FANOUT_POLL_MS     100
+
+// protocol version of HELLO
+#define FANOUT_VERSION     1
+
+// frame types
+#define FANOUT_HELLO       1
+#define FANOUT_CANDIDATE   2
+#define FANOUT_ACK         3
+#define FANOUT_SOLUTION    4
+#define FANOUT_RESULT      5
+
+// frame sizes
+#define FANOUT_HEADER_SIZE 4
+#define FANOUT_HELLO_SIZE  (1 + PK_SIZE_8)
+#define FANOUT_CAND_SIZE   (8 + 1 + 2 * NUM_SIZE_8 + PK_SIZE_8)
+#define FANOUT_ACK_SIZE    8
+#define FANOUT_SOL_SIZE    (8 + PK_SIZE_8 + NONCE_SIZE_8 + NUM_SIZE_8)
+#define FANOUT_RESULT_SIZE 9
+#define FANOUT_MAX_SIZE    FANOUT_CAND_SIZE
+
+// solution delivery status
+#define FANOUT_DELIVERED   0
+#define FANOUT_FAILED      1
+
+// miner reconnection period and solution answer timeout
+#define FANOUT_RETRY_MS    1000
+#define FANOUT_ANSWER_MS   60000
+
+// proxy statistics period
+#define FANOUT_REPORT_SEC  10
+
+#ifdef _WIN32
+typedef uintptr_t fanout_socket_t;
+#else
+typedef int fanout_socket_t;
+#endif
+
+// candidate pushed to miners, laid out as CANDIDATE payload
+struct fanout_candidate_t
+{
+    uint64_t seq;
+    uint8_t changed;
+    uint8_t mes[NUM_SIZE_8];
+    uint8_t bound[NUM_SIZE_8];
+    uint8_t pk[PK_SIZE_8];
+};
+
+// connected miner
+struct fanout_peer_t
+{
+    fanout_socket_t fd;
+    char name[64];
+    uint8_t pk[PK_SIZE_8];
+
+    // frames of peer are written by poller and its reader thread
+    std::mutex sendMutex;
+    int closed;
+    // sequence of the last candidate pushed by poller
+    std::atomic<uint64_t> pushed;
+};
+
+// proxy side
+struct fanout_server_t
+{
+    fanout_socket_t listener;
+    // solution URL of node
+    char to[MAX_URL_SIZE];
+
+    // peers, last candidate and latency statistics
+    std::mutex mutex;
+    std::vector<std::shared_ptr<fanout_peer_t> > peers;
+    fanout_candidate_t last;
+    int64_t detectedUs;
+
+    std::atomic<uint64_t> polls;
+    std::atomic<uint64_t> candidates;
+    std::atomic<uint64_t> solutions;
+    std::atomic<uint64_t> delivered;
+    uint64_t acks;
+    double latencySumUs;
+    double latencyMaxUs;
+
+    fanout_server_t(void);
+    ~fanout_server_t(void);
+
+    // listen on port and accept miners in a thread of its own
+    int Listen(const int port);
+
+    // push candidate detected now to all miners
+    void Broadcast(const fanout_candidate_t * cand);
+
+    // log statistics of period and reset them
+    void Report(const double sec);
+
+private:
+    std::thread acceptor;
+    std::atomic<int> closing;
+    // reader threads of miners
+    std::atomic<int> active;
+
+    void Accept(void);
+    void Serve(std::shared_ptr<fanout_peer_t> peer);
+};
+
+// miner side
+struct fanout_client_t
+{
+    char host[MAX_URL_SIZE];
+    int port;
+    fanout_socket_t fd;
+
+    std::mutex sendMutex;
+
+    // solution answers, one solution at a time
+    std::mutex mutex;
+    std::condition_variable answered;
+    uint64_t nextId;
+    uint64_t answerId;
+    int answer;
+    // connections lost so far
+    uint64_t epoch;
+
+    // candidates received
+    std::atomic<uint64_t> received;
+    std::atomic<int> stopped;
+
+    fanout_client_t(void);
+    ~fanout_client_t(void);
+
+    // parse "host:port" of proxy
+    int Init(const char * address);
+
+    // receive candidates into block data of info until stopped
+    void Run(info_t * info);
+
+    // post solution through proxy, fails if node did not answer
+    int PostSolution(
+        const uint8_t * w,
+        const uint8_t * nonce,
+        const uint8_t * d
+    );
+
+    // close connection, Run returns
+    void Stop(void);
+};
+
+// poll node for the site and serve candidates to miners on port
+int ServeFanout(const char * node, const int port, const int pollMs);
+
+#endif // FANOUT_H
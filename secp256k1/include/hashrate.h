@@ -0,0 +1,114 @@
+#ifndef HASHRATE_H
+#define HASHRATE_H
+
+/*******************************************************************************
+
+    HASHRATE -- Per-device hashrate accounting
+
+********************************************************************************
+
+Miner threads only add mined nonces to their own counter, counters are
+aligned to a cache line so that devices do not share one. A single
+sampling thread snapshots all counters every HASHRATE_SAMPLE_MS into a
+ring covering the longest window, rates over a window are the difference
+of two snapshots divided by their exact time difference.
+
+Add                 miner thread, lock-free
+Busy                miner thread, device is in a step longer than liveness
+                    limit allows, such as prehash or duty-cycle pause
+Sample              sampling thread
+Rate, Ewma, Alive   any thread, rates in hashes per second
+
+Miner threads show liveness by Add with every finished iteration and with
+every slice of waiting for a block, busy devices are alive. Time is read
+from 'clock', tests replace it with a model clock.
+
+hashrate_t must have static or automatic storage, heap allocation does not
+guarantee the alignment of counters in C++11.
+
+*******************************************************************************/
+
+#include "definitions.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// maximal number of devices
+#define HASHRATE_MAX_DEVICES 256
+
+// cache line size
+#define CACHE_LINE_SIZE    64
+
+// sampling period
+#define HASHRATE_SAMPLE_MS 1000
+
+// ring size for 15 min window
+#define HASHRATE_SAMPLES   (15 * 60 * 1000 / HASHRATE_SAMPLE_MS + 1)
+
+// EWMA time constant
+#define HASHRATE_EWMA_SEC  60
+
+// device is considered dead if it showed no liveness for
+#define HASHRATE_LIVENESS_MS 60000
+
+// per-device counter written by one miner thread
+struct alignas(CACHE_LINE_SIZE) device_counter_t
+{
+    std::atomic<uint64_t> nonces;
+    std::atomic<int64_t> updateMs;
+    std::atomic<int> busy;
+};
+
+// hashrate accounting of all devices
+struct hashrate_t
+{
+    int devices;
+    device_counter_t counters[HASHRATE_MAX_DEVICES];
+
+    // sampling state
+    std::mutex mutex;
+    std::vector<uint64_t> samples;
+    std::vector<int64_t> sampleMs;
+    std::vector<double> ewma;
+    int head;
+    int count;
+
+    // monotonic time in milliseconds
+    int64_t (* clock)(void);
+
+    hashrate_t(void);
+
+    // set number of devices and reset counters
+    int Init(const int n);
+
+    // account finished mining iteration
+    void Add(const int device, const uint64_t nonces)
+    {
+        counters[device].nonces.fetch_add(nonces, std::memory_order_relaxed);
+        counters[device].updateMs.store(clock(), std::memory_order_relaxed);
+    }
+
+    // enter or leave step longer than liveness limit, leaving shows liveness
+    void Busy(const int device, const int on)
+    {
+        counters[device].updateMs.store(clock(), std::memory_order_relaxed);
+        counters[device].busy.store(on, std::memory_order_release);
+    }
+
+    // take snapshot of counters if sampling period passed
+    void Sample(void);
+
+    // rate over window in seconds
+    double Rate(const int device, const int windowSec);
+
+    // exponentially weighted moving average rate
+    double Ewma(const int device);
+
+    // device is busy or showed liveness recently
+    int Alive(const int device);
+
+    // steady clock time in milliseconds
+    static int64_t NowMs(void);
+};
+
+#endif // HASHRATE_H
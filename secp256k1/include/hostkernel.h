@@ -0,0 +1,123 @@
+#ifndef HOSTKERNEL_H
+#define HOSTKERNEL_H
+
+/*******************************************************************************
+
+    HOSTKERNEL -- Host build of kernel sources
+
+********************************************************************************
+
+Kernels of mining.cu and prehash.cu compiled by the host compiler through
+kernel.h, in namespace hostkernel so that they link next to the device
+build. Results are bit-exact with the device and with the Host* functions
+of hostmining.h and hostprehash.h.
+
+HostLaunch
+    in:     kernel call, e.g. a lambda calling hostkernel::BlockMining
+
+    alt:    runs the call for every thread of grid of 'grid' blocks of
+            'block' threads
+
+Blocks are taken in turn by 'threads' host threads (all hardware threads
+if 0). A host thread runs the threads of its block as fibers, one after
+another up to the next __syncthreads, so shared memory of the block is
+thread_local of the host thread and the fiber switch is the barrier.
+
+*******************************************************************************/
+
+#include "definitions.h"
+#include <functional>
+
+// fiber stack size of kernel thread
+#define HOSTKERNEL_STACK_SIZE 0x20000
+
+namespace hostkernel
+{
+
+// block mining iteration
+void BlockMining(
+    // boundary for puzzle
+    const uint32_t * bound,
+    // data: pk || mes || w || padding || x || sk || ctx
+    const uint32_t * data,
+    // nonce base
+    const uint64_t base,
+    // number of nonces in iteration
+    const uint32_t nonces,
+    // precalculated hashes
+    const uint32_t * hashes,
+    // results
+    uint32_t * res,
+    // indices of valid solutions
+    uint32_t * valid
+);
+
+// first iteration of hashes precalculation
+void InitPrehash(
+    // data: pk || mes || w || padding || x || sk
+    const uint32_t * data,
+    // hashes
+    uint32_t * hashes,
+    // indices of invalid range hashes
+    uint32_t * invalid
+);
+
+// uncompleted first iteration of hashes precalculation
+void UncompleteInitPrehash(
+    // data: pk
+    const uint32_t * data,
+    // unfinalized hash contexts
+    uctx_t * uctxs
+);
+
+// complete first iteration of hashes precalculation
+void CompleteInitPrehash(
+    // data: pk || mes || w || padding || x || sk
+    const uint32_t * data,
+    // unfinalized hash contexts
+    const uctx_t * uctxs,
+    // hashes
+    uint32_t * hashes,
+    // indices of invalid range hashes
+    uint32_t * invalid
+);
+
+// unfinalized hashes update
+void UpdatePrehash(
+    // hashes
+    uint32_t * hashes,
+    // indices of invalid range hashes
+    uint32_t * invalid,
+    // length of invalid
+    const uint32_t len
+);
+
+// hashes modulo Q
+void FinalPrehash(
+    // hashes
+    uint32_t * hashes
+);
+
+// hashes by secret key multiplication modulo Q
+void FinalPrehashMultSecKey(
+    // data: pk || mes || w || padding || x || sk
+    const uint32_t * data,
+    // hashes
+    uint32_t * hashes
+);
+
+} // namespace hostkernel
+
+// run kernel call for every thread of grid
+void HostLaunch(
+    // blocks in grid
+    const uint32_t grid,
+    // threads in block
+    const uint32_t block,
+    // host threads, all hardware threads if 0
+    const int threads,
+    // kernel call
+    const std::function<void(void)> & kernel
+);
+
+#endif // HOSTKERNEL_H
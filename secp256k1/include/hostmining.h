@@ -0,0 +1,178 @@
+#ifndef HOSTMINING_H
+#define HOSTMINING_H
+
+/*******************************************************************************
+
+    HOSTMINING -- Autolykos blockMining procedure on host
+
+********************************************************************************
+
+Host counterparts of the mining.cu procedures, bit-exact with BlockMining.
+
+HostNonceIndices
+    in:     context 'ctx' of unfinalized hash of message
+
+    out:    K_LEN indices of precalculated hashes for nonce
+
+********************************************************************************
+
+HostNonceResult
+    in:     array 'hashes' of precalculated hashes (LITTLE ENDIAN words)
+
+    out:    res := sum(hashes[ind[k]]) - sk mod Q (LITTLE ENDIAN words)
+
+********************************************************************************
+
+HostNonceResults
+    in:     indices of HOST_MINING_LANES nonces
+
+    out:    results of HostNonceResult and mask of lanes below bound
+
+Summation is the vector part: words of rows are added into 64-bit lanes
+with carries deferred until all K_LEN rows are added, the loop is
+vectorized by the compiler at -O3, on x86-64 Linux for AVX-512, AVX2 or
+SSE2, whichever the CPU has. Carries of every lane are then normalized
+once, secret key subtraction and reduction modulo Q run per lane with the
+carry chains of HostNonceResult.
+
+********************************************************************************
+
+HostNonceIndicesFolded
+    in:     context 'nctx' of InitNonceHash
+
+    out:    same as HostNonceIndices
+
+The 32-byte message and the 8-byte nonce fill a single 128-byte block, so
+InitNonceHash keeps the message words and the initial state with the
+final counter once per block, and per nonce the block is compressed from
+registers with the nonce word and the zero words folded into mixing.
+Other contexts fall back to HostNonceIndices.
+
+********************************************************************************
+
+HostBlockMining
+    in:     nonces [base, base + count)
+
+    out:    first nonce with result below bound
+
+Each K_LEN lookup of a nonce is a cache and TLB miss in the 2 GiB table,
+so indices are computed for HOST_MINING_GROUP nonces at once and rows of
+each nonce are prefetched while indices of the next ones are hashed. Cache
+lines of a group, at most 64 KiB for 32 nonces, stay in L2 until summation.
+
+*******************************************************************************/
+
+#include "definitions.h"
+
+// nonces with indices computed before summation
+#define HOST_MINING_GROUP 32
+
+// nonces summed in vector lanes at once, HOST_MINING_GROUP is a multiple
+#define HOST_MINING_LANES 8
+
+// single block nonce hash context
+struct nctx_t
+{
+    // message words
+    uint64_t m[NUM_SIZE_64];
+    // initial state of compression
+    uint64_t v[16];
+    // message fits with nonce into a single block
+    int folded;
+    // context for other messages
+    ctx_t ctx;
+};
+
+// unfinalized hash of message
+void InitMining(
+    // context
+    ctx_t * ctx,
+    // message
+    const uint32_t * mes,
+    // message length in bytes
+    const uint32_t meslen
+);
+
+// indices of precalculated hashes for nonce
+void HostNonceIndices(
+    // context
+    const ctx_t * ctx,
+    // nonce
+    const uint64_t nonce,
+    // indices
+    uint32_t * ind
+);
+
+// constant part of single block nonce hash
+void InitNonceHash(
+    // context of unfinalized hash of message
+    const ctx_t * ctx,
+    // nonce hash context
+    nctx_t * nctx
+);
+
+// indices of precalculated hashes for nonce with single block hash
+void HostNonceIndicesFolded(
+    // nonce hash context
+    const nctx_t * nctx,
+    // nonce
+    const uint64_t nonce,
+    // indices
+    uint32_t * ind
+);
+
+// sum of precalculated hashes by indices minus secret key modulo Q
+void HostNonceResult(
+    // secret key
+    const uint32_t * sk,
+    // precalculated hashes
+    const uint32_t * hashes,
+    // indices
+    const uint32_t * ind,
+    // result
+    uint32_t * res
+);
+
+// results of HOST_MINING_LANES nonces, bit of lane is set if below bound
+uint32_t HostNonceResults(
+    // secret key
+    const uint32_t * sk,
+    // precalculated hashes
+    const uint32_t * hashes,
+    // indices, K_LEN per lane
+    const uint32_t * ind,
+    // boundary for puzzle
+    const uint32_t * bound,
+    // results, NUM_SIZE_32 words per lane
+    uint32_t * res
+);
+
+// check if result is below bound
+int HostIsSolution(
+    // result
+    const uint32_t * res,
+    // boundary for puzzle
+    const uint32_t * bound
+);
+
+// block mining over nonces [base, base + count)
+void HostBlockMining(
+    // boundary for puzzle
+    const uint32_t * bound,
+    // secret key
+    const uint32_t * sk,
+    // context
+    const ctx_t * ctx,
+    // nonce base
+    const uint64_t base,
+    // number of nonces
+    const uint32_t count,
+    // precalculated hashes
+    const uint32_t * hashes,
+    // result
+    uint32_t * res,
+    // index of the first valid solution plus one, zero if none
+    uint32_t * valid
+);
+
+#endif // HOSTMINING_H
@@ -0,0 +1,52 @@
+#ifndef HOSTMODQ_H
+#define HOSTMODQ_H
+
+/*******************************************************************************
+
+    HOSTMODQ -- Batched multiplication modulo Q on host
+
+********************************************************************************
+
+Second half of host prehash: every table entry is multiplied by the same
+one-time secret key x modulo the group order Q, results are bit-exact with
+HostFinalPrehashMultSecKey (BIG ENDIAN hash in, LITTLE ENDIAN words out).
+
+Engines are picked at runtime by CPU features:
+
+MODQ_64         4 x 64-bit limbs, 512-bit product reduced by the form of Q:
+                2^256 = 2^128 + c (mod Q) with c of 127 bits, so folds of
+                the high part bring it to 256 bits without division
+MODQ_MULX       same code compiled for BMI2/ADX, products by mulx
+MODQ_IFMA       AVX-512 IFMA, 8 entries per vector in 5 x 52-bit limbs,
+                Montgomery multiplication by x * 2^260 mod Q
+
+*******************************************************************************/
+
+#include <stdint.h>
+
+// engines of batched multiplication modulo Q
+#define MODQ_64      0
+#define MODQ_MULX    1
+#define MODQ_IFMA    2
+#define MODQ_ENGINES 3
+
+// CPU supports engine
+int ModQSupported(const int engine);
+
+// fastest engine supported by CPU
+int ModQBestEngine(void);
+
+// engine name for logs
+const char * ModQEngineName(const int engine);
+
+// hashes[i] := hashes[i] * x mod Q for count entries
+void HostMultSecKeyBatch(
+    const int engine,
+    // one-time secret key
+    const uint32_t * x,
+    // hashes
+    uint32_t * hashes,
+    const uint32_t count
+);
+
+#endif // HOSTMODQ_H
@@ -0,0 +1,120 @@
+#ifndef HOSTPREHASH_H
+#define HOSTPREHASH_H
+
+/*******************************************************************************
+
+    HOSTPREHASH -- precalculation of hashes on host
+
+********************************************************************************
+
+Host counterparts of the prehash.cu kernels, one table entry per call.
+Results are bit-exact with the device kernels and are stored in the same
+table layout, so that host and device tables are interchangeable.
+
+HostHashIndexConstMes
+    out:    ctx := unfinalized hash context for blake2b-256(idx || M),
+            absorbed from precomputed message words of M (schedule)
+            or byte by byte (reference)
+
+********************************************************************************
+
+HostInitPrehash
+    in:     array 'pnp' contains (pk || mes || w)
+
+    out:    hash := blake2b-256(idx || M || pk || mes || w),
+            rehashed until hash < Q (BIG ENDIAN bytes as on device)
+
+********************************************************************************
+
+HostUncompleteInitPrehash
+    in:     array 'pk' contains public key
+
+    out:    uctx := unfinalized hash context for blake2b-256(idx || M || pk),
+            chained state only, byte counter is UCTX_COUNT for any idx
+
+********************************************************************************
+
+HostCompleteInitPrehash
+    in:     array 'pnp' contains (pk || mes || w)
+
+    in:     uctx == unfinalized hash context for blake2b-256(idx || M || pk)
+
+    out:    same as HostInitPrehash, same as device CompleteInitPrehash
+            for a context of device UncompleteInitPrehash
+
+********************************************************************************
+
+HostFinalPrehashMultSecKey
+    in:     one-time secret key 'x'
+
+    alt:    hash := hash * x mod Q (LITTLE ENDIAN words as on device)
+
+*******************************************************************************/
+
+#include "definitions.h"
+
+// hash index and constant message, by schedule words or byte by byte
+void HostHashIndexConstMes(
+    // index
+    const uint32_t idx,
+    // use schedule words
+    const int schedule,
+    // hash context
+    ctx_t * ctx
+);
+
+// first iteration of hash precalculation for one index
+void HostInitPrehash(
+    // pk || mes || w
+    const uint8_t * pnp,
+    // index
+    const uint32_t idx,
+    // hash
+    uint32_t * hash
+);
+
+// uncompleted first iteration of hash precalculation for one index
+void HostUncompleteInitPrehash(
+    // public key
+    const uint8_t * pk,
+    // index
+    const uint32_t idx,
+    // unfinalized hash context
+    uctx_t * uctx
+);
+
+// complete first iteration of hash precalculation for one index
+void HostCompleteInitPrehash(
+    // pk || mes || w
+    const uint8_t * pnp,
+    // unfinalized hash context
+    const uctx_t * uctx,
+    // hash
+    uint32_t * hash
+);
+
+// hash by one-time secret key multiplication modulo Q
+void HostFinalPrehashMultSecKey(
+    // one-time secret key
+    const uint32_t * x,
+    // hash
+    uint32_t * hash
+);
+
+// precalculate hashes in range [from, to)
+int HostPrehash(
+    const int keep,
+    // pk || mes || w
+    const uint8_t * pnp,
+    // one-time secret key
+    const uint32_t * x,
+    // unfinalized hash contexts
+    const uctx_t * uctxs,
+    // hashes
+    uint32_t * hashes,
+    // range of indices
+    const uint32_t from,
+    const uint32_t to
+);
+
+#endif // HOSTPREHASH_H
@@ -1,6 +1,7 @@
 #ifndef HTTPAPI_H
 #define HTTPAPI_H
 
+#include "hashrate.h"
 #include "httplib.h"
 #include <vector>
 #include <string>
@@ -9,7 +10,7 @@
 #include <sstream>
 #include <chrono>
 
-void HttpApiThread(std::vector<double>* hashrates, std::vector<std::pair<int,int>>* props);
+void HttpApiThread(hashrate_t* hashrates, std::vector<std::pair<int,int>>* props);
 
 
 #endif
\ No newline at end of file
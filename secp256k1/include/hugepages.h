@@ -0,0 +1,50 @@
+#ifndef HUGEPAGES_H
+#define HUGEPAGES_H
+
+/*******************************************************************************
+
+    HUGEPAGES -- Host tables on huge pages
+
+********************************************************************************
+
+Random lookups in the 2 GiB hash table or the 4 GiB uctx_t table miss TLB
+on almost every access with 4 KiB pages. Allocation tries in order:
+
+1 GiB pages         Linux hugetlb pool (hugepages-1048576kB)
+2 MiB pages         Linux hugetlb pool (hugepages-2048kB), Windows large
+                    pages (needs "Lock pages in memory" privilege)
+transparent         Linux 4 KiB mapping advised to transparent huge pages,
+                    backed by 2 MiB pages if the kernel finds them
+4 KiB pages         anything else
+
+Memory is page aligned in any case.
+
+*******************************************************************************/
+
+#include <stddef.h>
+
+// host memory on the largest pages available
+struct huge_buffer_t
+{
+    void * ptr;
+    // mapped size
+    size_t size;
+    // page size
+    size_t page;
+    // 4 KiB pages advised to transparent huge pages
+    int transparent;
+
+    huge_buffer_t(void);
+    ~huge_buffer_t(void);
+
+    // allocate memory, NULL if there is not enough
+    void * Allocate(const size_t bytes);
+
+    // release memory
+    void Free(void);
+
+    // page kind for logs
+    const char * PageName(void) const;
+};
+
+#endif // HUGEPAGES_H
@@ -0,0 +1,124 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+/*******************************************************************************
+
+    JOURNAL -- Durable journal of found solutions
+
+********************************************************************************
+
+Miner thread appends a found solution to the journal file and hands it to
+the submitter thread. An entry stays pending until the node answers its
+POST. The submitter posts pending entries again every JOURNAL_REPLAY_MS
+while their candidate message is current and drops the rest, a solution
+is valid only for its block. Entries left pending by a previous run are
+read on startup and replayed the same way. Miners of a fan-out proxy post
+through it, the proxy answers once the node did.
+
+Append returns after the solution is synced to disk, appends of concurrent
+miner threads share one fsync. Posted marks are synced in batches by the
+submitter, losing one only repeats a POST. When the block changes the file
+is rewritten with pending entries only.
+
+Record lines:
+
+S id time mes pk w nonce d      solution found
+P id                            solution posted or stale
+
+Append              miner thread, returns after the record is on disk
+Replay, Compact     submitter thread
+
+*******************************************************************************/
+
+#include "definitions.h"
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+// pending entries repost period
+#define JOURNAL_REPLAY_MS 5000
+
+// maximal record line length
+#define JOURNAL_LINE_SIZE 512
+
+// found solution
+struct journal_entry_t
+{
+    uint64_t id;
+    int64_t time;
+    uint8_t mes[NUM_SIZE_8];
+    char pkstr[PK_SIZE_4 + 1];
+    uint8_t w[PK_SIZE_8];
+    uint8_t nonce[NONCE_SIZE_8];
+    uint8_t d[NUM_SIZE_8];
+};
+
+// journal file and pending entries
+struct journal_t
+{
+    char fileName[MAX_URL_SIZE];
+    int fd;
+
+    // entries, file descriptor and counters
+    std::mutex mutex;
+    std::condition_variable added;
+    std::vector<journal_entry_t> pending;
+    uint64_t nextId;
+    // entries appended since last replay
+    int fresh;
+    // records of finished entries since last compaction
+    uint64_t finished;
+
+    // group commit, records written and records on disk
+    std::mutex syncMutex;
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> synced;
+
+    // message of the last replay
+    uint8_t lastMes[NUM_SIZE_8];
+
+    // proxy posting solutions instead of node, NULL if none
+    struct fanout_client_t * proxy;
+
+    journal_t(void);
+    ~journal_t(void);
+
+    // read pending entries and open file for appending
+    int Open(const char * name);
+
+    // write solution to disk and queue it for posting
+    int Append(
+        const uint8_t * mes,
+        const char * pkstr,
+        const uint8_t * w,
+        const uint8_t * nonce,
+        const uint8_t * d
+    );
+
+    // post pending entries of current block, drop stale ones
+    int Replay(info_t * info);
+
+    // rewrite file with pending entries only
+    int Compact(void);
+
+    // number of pending entries
+    int Pending(void);
+
+private:
+
+    // write record line, mutex is held
+    int Write(const char * line);
+
+    // mark entry finished, mutex is held
+    int Finish(const uint64_t id);
+
+    // sync records up to seq to disk
+    int Sync(const uint64_t seq);
+};
+
+// submitter thread
+void JournalThread(journal_t * journal, info_t * info);
+
+#endif // JOURNAL_H
@@ -0,0 +1,151 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+/*******************************************************************************
+
+    KERNEL -- Portability layer of kernel sources for device and host
+
+********************************************************************************
+
+mining.cu and prehash.cu are the only implementation of the kernels. They
+are compiled by nvcc for the device and, through this layer, by the host
+compiler in hostkernel.cc, so that kernel changes are checked on hosts
+without GPU.
+
+Carry-chain intrinsics
+    PTX_* macros take the operands of the PTX instruction of the same
+    name. nvcc gets inline PTX, the host gets HOST_* emulation with the
+    CC.CF flag in 'kernelCarry' of the host thread.
+
+Loop unrolling
+    KERNEL_UNROLL stands before loops instead of #pragma unroll, so that
+    the host compiler sees no unknown pragma. nvcc gets the pragma, the
+    host leaves unrolling to the optimizer: GCC rejects unroll hints on
+    loops with several exit conditions, as most copy loops are.
+
+Thread index
+    threadIdx, blockIdx, blockDim and gridDim are set by HostLaunch for
+    the thread of block being run.
+
+Shared memory
+    __shared__ arrays are thread_local: HostLaunch runs one block at a
+    time on a host thread, all threads of the block as fibers of it, so
+    they see the same arrays. __syncthreads switches to the next fiber of
+    the block, the block goes on once all its threads have reached the
+    barrier.
+
+*******************************************************************************/
+
+#include "definitions.h"
+
+#ifdef __CUDACC__
+
+#include <cuda.h>
+
+#define KERNEL_UNROLL      _Pragma("unroll")
+
+//============================================================================//
+//  Carry-chain intrinsics on device
+//============================================================================//
+#define PTX_ADD_CC(d, a, b)                                                    \
+    asm volatile ("add.cc.u32 %0, %1, %2;": "=r"(d): "r"(a), "r"(b))
+
+#define PTX_ADDC_CC(d, a, b)                                                   \
+    asm volatile ("addc.cc.u32 %0, %1, %2;": "=r"(d): "r"(a), "r"(b))
+
+#define PTX_ADDC(d, a, b)                                                      \
+    asm volatile ("addc.u32 %0, %1, %2;": "=r"(d): "r"(a), "r"(b))
+
+#define PTX_SUB_CC(d, a, b)                                                    \
+    asm volatile ("sub.cc.u32 %0, %1, %2;": "=r"(d): "r"(a), "r"(b))
+
+#define PTX_SUBC_CC(d, a, b)                                                   \
+    asm volatile ("subc.cc.u32 %0, %1, %2;": "=r"(d): "r"(a), "r"(b))
+
+#define PTX_SUBC(d, a, b)                                                      \
+    asm volatile ("subc.u32 %0, %1, %2;": "=r"(d): "r"(a), "r"(b))
+
+#define PTX_MUL_LO(d, a, b)                                                    \
+    asm volatile ("mul.lo.u32 %0, %1, %2;": "=r"(d): "r"(a), "r"(b))
+
+#define PTX_MUL_HI(d, a, b)                                                    \
+    asm volatile ("mul.hi.u32 %0, %1, %2;": "=r"(d): "r"(a), "r"(b))
+
+#define PTX_MAD_LO_CC(d, a, b, c)                                              \
+    asm volatile (                                                             \
+        "mad.lo.cc.u32 %0, %1, %2, %3;": "=r"(d): "r"(a), "r"(b), "r"(c)       \
+    )
+
+#define PTX_MADC_LO_CC(d, a, b, c)                                             \
+    asm volatile (                                                             \
+        "madc.lo.cc.u32 %0, %1, %2, %3;": "=r"(d): "r"(a), "r"(b), "r"(c)      \
+    )
+
+#define PTX_MADC_LO(d, a, b, c)                                                \
+    asm volatile (                                                             \
+        "madc.lo.u32 %0, %1, %2, %3;": "=r"(d): "r"(a), "r"(b), "r"(c)         \
+    )
+
+#define PTX_MADC_HI_CC(d, a, b, c)                                             \
+    asm volatile (                                                             \
+        "madc.hi.cc.u32 %0, %1, %2, %3;": "=r"(d): "r"(a), "r"(b), "r"(c)      \
+    )
+
+#define PTX_MADC_HI(d, a, b, c)                                                \
+    asm volatile (                                                             \
+        "madc.hi.u32 %0, %1, %2, %3;": "=r"(d): "r"(a), "r"(b), "r"(c)         \
+    )
+
+#else
+
+//============================================================================//
+//  Execution model on host
+//============================================================================//
+#define __global__
+#define __device__
+#define __host__
+#define __forceinline__    inline
+#define __constant__
+#define __shared__         static thread_local
+
+#define __syncthreads()    KernelSync()
+#define KERNEL_UNROLL
+
+struct kernel_dim_t
+{
+    uint32_t x;
+    uint32_t y;
+    uint32_t z;
+};
+
+extern thread_local kernel_dim_t threadIdx;
+extern thread_local kernel_dim_t blockIdx;
+extern thread_local kernel_dim_t blockDim;
+extern thread_local kernel_dim_t gridDim;
+
+// CC.CF flag of carry-chain intrinsics
+extern thread_local uint32_t kernelCarry;
+
+// barrier of threads of block
+void KernelSync(void);
+
+//============================================================================//
+//  Carry-chain intrinsics on host
+//============================================================================//
+#define PTX_ADD_CC(d, a, b)        HOST_ADD_CC(d, a, b, kernelCarry)
+#define PTX_ADDC_CC(d, a, b)       HOST_ADDC_CC(d, a, b, kernelCarry)
+#define PTX_ADDC(d, a, b)          HOST_ADDC(d, a, b, kernelCarry)
+#define PTX_SUB_CC(d, a, b)        HOST_SUB_CC(d, a, b, kernelCarry)
+#define PTX_SUBC_CC(d, a, b)       HOST_SUBC_CC(d, a, b, kernelCarry)
+#define PTX_SUBC(d, a, b)          HOST_SUBC(d, a, b, kernelCarry)
+#define PTX_MUL_LO(d, a, b)        HOST_MUL_LO(d, a, b)
+#define PTX_MUL_HI(d, a, b)        HOST_MUL_HI(d, a, b)
+#define PTX_MAD_LO_CC(d, a, b, c)  HOST_MAD_LO_CC(d, a, b, c, kernelCarry)
+#define PTX_MADC_LO_CC(d, a, b, c) HOST_MADC_LO_CC(d, a, b, c, kernelCarry)
+#define PTX_MADC_LO(d, a, b, c)    HOST_MADC_LO(d, a, b, c, kernelCarry)
+#define PTX_MADC_HI_CC(d, a, b, c) HOST_MADC_HI_CC(d, a, b, c, kernelCarry)
+#define PTX_MADC_HI(d, a, b, c)    HOST_MADC_HI(d, a, b, c, kernelCarry)
+
+#endif // __CUDACC__
+
+#endif // KERNEL_H
@@ -8,16 +8,8 @@
 *******************************************************************************/
 
 #include "definitions.h"
-
-// unfinalized hash of message
-void InitMining(
-    // context
-    ctx_t * ctx,
-    // message
-    const uint32_t * mes,
-    // message length in bytes
-    const uint32_t meslen
-);
+#include "hostmining.h"
+#include "kernel.h"
 
 // block mining iteration
 __global__ void BlockMining(
@@ -27,6 +19,8 @@ __global__ void BlockMining(
     const uint32_t * data,
     // nonce base
     const uint64_t base,
+    // number of nonces in iteration
+    const uint32_t nonces,
     // precalculated hashes
     const uint32_t * hashes,
     // results
@@ -58,6 +58,7 @@ FinalPrehash
 *******************************************************************************/
 
 #include "definitions.h"
+#include "kernel.h"
 
 // first iteration of hashes precalculation
 __global__ void InitPrehash(
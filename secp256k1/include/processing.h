@@ -8,16 +8,25 @@
 
 #include "definitions.h"
 
+// slice of waiting for a new block, miners report being alive per slice
+#define MINER_WAIT_MS 100
+
 // read config file
 int ReadConfig(
     const char * fileName,
-    uint8_t * sk,
-    char * skstr,
     char * from,
-    char * to,
-    int * keep
+    info_t * info
 );
 
+// lock info mutex accounting wait time
+void LockInfo(info_t * info);
+
+// publish block data and wake miners waiting for it
+void PublishBlock(info_t * info, const block_data_t * block);
+
+// wait up to timeout for block other than blockId, returns current one
+uint_t WaitBlock(info_t * info, const uint_t blockId, const int ms);
+
 // print public key
 int PrintPublicKey(const char * pkstr, char * str);
 
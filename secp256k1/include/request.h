@@ -43,7 +43,7 @@ int GetLatestBlock(
     int checkPubKey
 );
 
-// CURL http POST request
+// CURL http POST request, fails if node did not answer
 int PostPuzzleSolution(
     const char * to,
     const char * pkstr,
@@ -52,4 +52,13 @@ int PostPuzzleSolution(
     const uint8_t * d
 );
 
+// parse body of solution POST request
+int ParseSolution(
+    const char * body,
+    uint8_t * pk,
+    uint8_t * w,
+    uint8_t * nonce,
+    uint8_t * d
+);
+
 #endif // REQUEST_H
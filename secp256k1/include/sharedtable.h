@@ -0,0 +1,106 @@
+#ifndef SHAREDTABLE_H
+#define SHAREDTABLE_H
+
+/*******************************************************************************
+
+    SHAREDTABLE -- Prehash contexts shared by miner processes on host
+
+********************************************************************************
+
+Hashes of a block are hash(idx || M || pk || mes || w) * x, so they are
+bound to the one-time key pair and a table mined by two processes would
+give two solutions with the same w, which reveal x and the secret key.
+Only the unfinalized contexts of hash(idx || M || pk) are shared: they
+depend on the public key alone and take most of the prehash work. Every
+device completes its own hashes from them with its own x and w, which
+never leave the process.
+
+One builder calculates the contexts into a named shared memory segment
+once per public key, readers map it read-only. Segment is a header
+followed by the contexts:
+
+magic, bytes        layout check
+generation          odd while contexts are written, even when published
+pk                  public key of published contexts
+
+Readers take the contexts of generation g built for their public key and
+check after every prehash that generation is still g, hashes completed
+from rewritten contexts are dropped.
+
+*******************************************************************************/
+
+#include "definitions.h"
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// shared table roles
+#define SHARED_NONE    0
+#define SHARED_BUILDER 1
+#define SHARED_READER  2
+
+// header size, Windows views need allocation granularity alignment
+#define SHARED_HEADER_SIZE 0x10000
+#define SHARED_MAGIC       0x325442544C4B5541
+
+// reader wait for contexts of public key in ms
+#define SHARED_WAIT_MS     60000
+
+// segment header
+struct shared_header_t
+{
+    uint64_t magic;
+    uint64_t bytes;
+    std::atomic<uint64_t> generation;
+
+    uint8_t pk[PK_SIZE_8];
+};
+
+// mapping of shared table
+struct shared_table_t
+{
+    int role;
+    shared_header_t * header;
+    uctx_t * uctxs;
+    size_t bytes;
+
+#ifdef _WIN32
+    void * handle;
+#else
+    int fd;
+#endif
+
+    shared_table_t(void);
+    ~shared_table_t(void);
+
+    // create or attach as builder, attach as reader
+    int Open(const char * name, const int kind, const size_t size);
+
+    // unmap segment, it stays for other processes
+    void Close(void);
+
+    // builder: mark contexts as being written
+    void BeginWrite(void);
+
+    // builder: publish contexts built for public key
+    void Publish(const uint8_t * pk);
+
+    // contexts of public key are published, get their generation
+    int Published(const uint8_t * pk, uint64_t * gen) const;
+
+    // reader: wait for contexts of public key, get their generation
+    int Acquire(const uint8_t * pk, uint64_t * gen, const int waitMs);
+
+    // contexts of generation are still published
+    int Valid(const uint64_t gen) const;
+
+private:
+
+    // consistent copy of published header, 0 if none
+    int Snapshot(uint8_t * pk, uint64_t * gen) const;
+};
+
+// remove segment, mappings stay valid until closed
+int RemoveSharedTable(const char * name);
+
+#endif // SHAREDTABLE_H
@@ -0,0 +1,110 @@
+#ifndef THROTTLE_H
+#define THROTTLE_H
+
+/*******************************************************************************
+
+    THROTTLE -- Temperature and power target duty-cycle controller
+
+********************************************************************************
+
+A device mines for an iteration and then pauses, duty is the fraction of
+time it is mining. Every THROTTLE_PERIOD_MS the controller reads device
+sensor and moves duty against the relative excess over the targets:
+
+    err  = max((T - targetTemp) / targetTemp, (P - targetPower) / targetPower)
+    duty = clamp(duty - THROTTLE_GAIN * err, THROTTLE_MIN_DUTY, 1)
+
+Pause after an iteration of length t is t * (1 - duty) / duty, the period
+accounts the time actually slept as a new block ends the pause. Zero target
+disables it, with both disabled the controller only accounts energy to
+report hashes per joule.
+
+Mock sensor is a first-order thermal model of a device for testing the
+control law without hardware:
+
+    P  = MOCK_IDLE_POWER + (MOCK_MAX_POWER - MOCK_IDLE_POWER) * duty
+    dT = (MOCK_AMBIENT + MOCK_THERMAL_RES * P - T) * dt / MOCK_THERMAL_TAU
+
+*******************************************************************************/
+
+#include "definitions.h"
+
+// sensor reading and control period
+#define THROTTLE_PERIOD_MS 500
+
+// duty change per unit of relative target excess
+#define THROTTLE_GAIN      0.1
+
+// minimal duty
+#define THROTTLE_MIN_DUTY  0.05
+
+// mock device model
+#define MOCK_AMBIENT       30.0  // C
+#define MOCK_THERMAL_RES   0.25  // C / W
+#define MOCK_THERMAL_TAU   5.0   // s
+#define MOCK_IDLE_POWER    50.0  // W
+#define MOCK_MAX_POWER     250.0 // W
+
+// device temperature and power sensor
+struct sensor_t
+{
+    virtual ~sensor_t(void) {}
+
+    // read temperature in C and power in W, duty and elapsed time in seconds
+    // since previous reading drive sensor models
+    virtual int Read(
+        const double duty,
+        const double sec,
+        double * temp,
+        double * power
+    ) = 0;
+};
+
+// NVML sensor of device with PCI bus id string
+sensor_t * CreateNvmlSensor(const char * pciBusId);
+
+// mock sensor of modelled device
+sensor_t * CreateMockSensor(void);
+
+// duty-cycle controller
+struct throttle_t
+{
+    sensor_t * sensor;
+
+    // targets, zero if disabled
+    double targetTemp;
+    double targetPower;
+
+    // current duty and pause
+    double duty;
+    double pause;
+
+    // time and duty accumulated since last sensor reading
+    double periodSec;
+    double periodBusy;
+
+    // last readings
+    double temp;
+    double power;
+
+    // energy and hashes accounting
+    double joules;
+    double hashes;
+
+    throttle_t(sensor_t * s, const double temp, const double power);
+    ~throttle_t(void);
+
+    // account iteration of given seconds and nonces and the time actually
+    // slept in the previous pause, that a new block may cut short, return
+    // pause in seconds
+    double Update(
+        const double iterSec,
+        const double sleptSec,
+        const uint32_t nonces
+    );
+
+    // hashes per joule since start
+    double HashesPerJoule(void) const;
+};
+
+#endif // THROTTLE_H
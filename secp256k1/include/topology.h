@@ -0,0 +1,98 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+/*******************************************************************************
+
+    TOPOLOGY -- Host NUMA nodes, CPU cores and thread placement
+
+********************************************************************************
+
+On Linux nodes are read from /sys/devices/system/node, only nodes having
+CPUs are counted. Memory binding and thread affinity are done by system
+calls, so that no libnuma is needed. Elsewhere the host is a single node
+and binding calls do nothing.
+
+Physical cores are read from /sys/devices/system/cpu, CPUs of a core are
+its SMT siblings. Placement gives host threads disjoint cores:
+
+service             poller, HTTP API and journal threads, first core
+feeders             miner thread of every device, next core each for GPUs,
+                    service core for CPU devices as they only wait
+workers             compute threads of CPU devices, remaining cores split
+                    between devices, first CPU of every core before its
+                    SMT siblings
+
+With fewer cores than devices, GPU feeders share cores round robin and
+CPU devices share the worker cores. A single core runs all threads.
+
+*******************************************************************************/
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// upper limit of NUMA nodes, node ids and CPU ids
+#define MAX_NUMA_NODES 64
+#define MAX_NODE_ID    1024
+#define MAX_CPU_ID     4096
+
+// thread placement modes
+#define PLACEMENT_NONE  0
+#define PLACEMENT_CORES 1
+
+// NUMA nodes with CPUs
+struct numa_t
+{
+    // number of nodes, at least one
+    int count;
+    // system node ids
+    int ids[MAX_NUMA_NODES];
+    // CPUs of nodes, empty if unknown
+    std::vector<int> cpus[MAX_NUMA_NODES];
+
+    numa_t(void);
+
+    // read nodes of host
+    void Read(void);
+
+    // node index of CPU, 0 if unknown
+    int NodeOf(const int cpu) const;
+};
+
+// host threads on disjoint cores
+struct placement_t
+{
+    numa_t numa;
+    // CPUs of physical cores, cores ordered by node
+    std::vector<std::vector<int> > cores;
+
+    // CPUs of service threads, empty if not placed
+    std::vector<int> service;
+    // CPUs of device miner threads
+    std::vector<std::vector<int> > feeders;
+    // CPU of every compute worker of CPU devices
+    std::vector<std::vector<int> > workers;
+
+    // read nodes and cores of host, EXIT_FAILURE if unknown
+    int Read(void);
+
+    // split cores between threads of devices, compute on host CPUs or not
+    void Plan(const int devices, const int compute);
+
+    // log decisions
+    void Report(void) const;
+};
+
+// parse list like "0-3,8,10-11", EXIT_FAILURE if malformed
+int ParseCpuList(const char * str, std::vector<int> * list);
+
+// bind memory not yet touched to node id, EXIT_FAILURE if not supported
+int BindMemory(void * ptr, const size_t size, const int node);
+
+// list in "0-3,8" form for logs
+std::string FormatCpuList(const std::vector<int> & list);
+
+// run calling thread on CPUs of list, EXIT_FAILURE if not supported
+int RunOnCpus(const std::vector<int> & cpus);
+
+#endif // TOPOLOGY_H
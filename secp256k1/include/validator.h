@@ -0,0 +1,158 @@
+#ifndef VALIDATOR_H
+#define VALIDATOR_H
+
+/*******************************************************************************
+
+    VALIDATOR -- Share validation service and its load generator
+
+********************************************************************************
+
+Validation server accepts batches of shares at POST /shares as JSON array
+
+[{"msg": "...", "b": ..., "pk": "...", "w": "...", "n": "...", "d": ...}, ...]
+
+with the encodings of node candidate (msg, b) and solution (pk, w, n, d)
+and answers with a verdict per share:
+
+{"valid":v,"verdicts":[1,0,-1,...]}
+
+1 for a valid share, 0 for a rejected one and -1 for a malformed one.
+Shares of all batches are verified in chunks of VALIDATOR_CHUNK by a pool
+of threads with a verifier each, in order of arrival. It reports at /stats
+the counts and latency histograms in microseconds:
+
+shareLatencyUs      verification time of one share
+batchLatencyUs      time from receipt of a batch to its answer
+
+Histogram bucket k counts latencies in [2^k, 2^(k+1)) us, bucket 0 also
+the ones below 1 us.
+
+Load generator posts batches of synthetic shares of random keys from
+several clients for a given time, a given fraction of them made invalid,
+checks the verdicts and reports throughput and client side latencies.
+
+*******************************************************************************/
+
+#include "verifyapi.h"
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// default validation server port
+#define VALIDATOR_PORT  9060
+
+// shares taken by a validation thread at once
+#define VALIDATOR_CHUNK 8
+
+// power of two latency buckets
+#define LATENCY_BUCKETS 32
+
+// histogram of latencies in microseconds
+struct latency_histogram_t
+{
+    std::atomic<uint64_t> counts[LATENCY_BUCKETS];
+
+    latency_histogram_t(void);
+
+    // count latency
+    void Add(const double us);
+
+    // upper bound of bucket of quantile q
+    double Quantile(const double q) const;
+
+    // JSON object with counts and quantiles
+    void Print(std::ostream & out) const;
+};
+
+// shares to verify by validation pool
+struct validation_batch_t
+{
+    const autolykos_share_t * shares;
+    int * verdicts;
+    int count;
+    // next share to take
+    int next;
+    // shares verified
+    int done;
+};
+
+// threads verifying batches of shares
+struct validation_pool_t
+{
+    std::mutex mutex;
+    std::condition_variable work;
+    std::condition_variable done;
+    std::deque<validation_batch_t *> queue;
+    std::vector<std::thread> workers;
+    int finished;
+
+    latency_histogram_t shareLatency;
+
+    validation_pool_t(const int threads);
+    ~validation_pool_t(void);
+
+    // verify shares with non-negative verdicts, block until done
+    int Validate(
+        const autolykos_share_t * shares,
+        const int count,
+        int * verdicts
+    );
+
+private:
+    void Work(void);
+};
+
+// share of keys for message and nonce, valid for any bound
+void GenerateShare(
+    // secret key (LITTLE ENDIAN)
+    const uint8_t * sk,
+    // public key
+    const uint8_t * pk,
+    // one-time secret key (LITTLE ENDIAN)
+    const uint8_t * x,
+    // one-time public key
+    const uint8_t * w,
+    // message
+    const uint8_t * mes,
+    const uint64_t nonce,
+    autolykos_share_t * share
+);
+
+// parse batch of shares, malformed ones get verdict -1 and others 0
+int ParseShares(
+    const char * body,
+    std::vector<autolykos_share_t> * shares,
+    std::vector<int> * verdicts
+);
+
+// JSON array of shares
+void PrintShares(
+    const autolykos_share_t * shares,
+    const int count,
+    std::string * body
+);
+
+// serve share validation with pool of threads, all hardware ones if zero
+int ServeValidation(const int threads, const int port);
+
+// post synthetic shares to validation server
+int LoadValidation(
+    // server URL
+    const char * url,
+    // shares per request
+    const int batch,
+    // concurrent clients
+    const int clients,
+    // duration of load
+    const double seconds,
+    // fraction of invalid shares
+    const double invalid
+);
+
+#endif // VALIDATOR_H
@@ -0,0 +1,93 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+/*******************************************************************************
+
+    VERIFY -- Autolykos solution verification on host
+
+********************************************************************************
+
+verifier_t::Verify
+    in:     message 'mes', public key 'pk', one-time public key 'w',
+            nonce 'nonce' and distance 'd' of a posted solution
+
+    out:    EXIT_SUCCESS if d < bound and w^f == g^d * pk, where
+            f := sum(hash[ind[k]]) mod Q is computed from the K_LEN hashes
+            selected by the nonce only, with the host prehash and mining
+            procedures bit-exact with the device
+
+verifier_t keeps the curve and scratch big numbers between calls and is
+used by one thread at a time. VerifySolution uses a verifier of the
+calling thread.
+
+Verification never terminates the process: VERIFY_ERROR is returned if
+OpenSSL fails to allocate the verifier or to compute, the allocation is
+retried on the next call.
+
+*******************************************************************************/
+
+#include "definitions.h"
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+
+// status of OpenSSL failure, neither valid nor invalid
+#define VERIFY_ERROR -1
+
+// solution verifier of one thread
+struct verifier_t
+{
+    // curve and scratch numbers are allocated
+    int ready;
+
+    EC_GROUP * group;
+    BN_CTX * bnctx;
+    BIGNUM * f;
+    BIGNUM * d;
+    EC_POINT * pk;
+    EC_POINT * w;
+    EC_POINT * left;
+    EC_POINT * right;
+
+    verifier_t(void);
+    ~verifier_t(void);
+
+    // allocate curve and scratch numbers
+    int Init(void);
+
+    // free curve and scratch numbers
+    void Free(void);
+
+    // check posted solution
+    int Verify(
+        // message
+        const uint8_t * mes,
+        // public key
+        const uint8_t * pk,
+        // one-time public key
+        const uint8_t * w,
+        // nonce (LITTLE ENDIAN)
+        const uint8_t * nonce,
+        // distance (LITTLE ENDIAN)
+        const uint8_t * d,
+        // boundary for puzzle (LITTLE ENDIAN)
+        const uint8_t * bound
+    );
+};
+
+// check posted solution with verifier of calling thread
+int VerifySolution(
+    // message
+    const uint8_t * mes,
+    // public key
+    const uint8_t * pk,
+    // one-time public key
+    const uint8_t * w,
+    // nonce (LITTLE ENDIAN)
+    const uint8_t * nonce,
+    // distance (LITTLE ENDIAN)
+    const uint8_t * d,
+    // boundary for puzzle (LITTLE ENDIAN)
+    const uint8_t * bound
+);
+
+#endif // VERIFY_H
@@ -0,0 +1,74 @@
+#ifndef VERIFYAPI_H
+#define VERIFYAPI_H
+
+/*******************************************************************************
+
+    VERIFYAPI -- C interface of Autolykos share verification library
+
+********************************************************************************
+
+Built as libautolykos_verify by "make verifylib", links to libcrypto only.
+Byte layouts are the ones of the miner:
+
+mes         message of the block candidate as in its hex string
+pk, w       compressed public keys
+nonce       64-bit nonce, little endian
+d, bound    256-bit numbers, little endian
+
+Functions return 1 for a valid share, 0 for an invalid one and
+AUTOLYKOS_VERIFY_ERROR if the share could not be checked, e.g. OpenSSL
+failed to allocate; the library never terminates the calling process. A
+batch is split between 'threads' threads, all hardware threads if
+'threads' is zero, fewer if threads cannot be started.
+
+Only the functions below are exported, the library is built with hidden
+visibility of everything else.
+
+*******************************************************************************/
+
+#include <stdint.h>
+
+// share could not be checked
+#define AUTOLYKOS_VERIFY_ERROR -1
+
+// exported symbols of the library
+#if defined(_WIN32) && defined(AUTOLYKOS_VERIFY_BUILD)
+#define AUTOLYKOS_VERIFY_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define AUTOLYKOS_VERIFY_API __attribute__((visibility("default")))
+#else
+#define AUTOLYKOS_VERIFY_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// share to verify
+typedef struct
+{
+    uint8_t mes[32];
+    uint8_t pk[33];
+    uint8_t w[33];
+    uint8_t nonce[8];
+    uint8_t d[32];
+    uint8_t bound[32];
+} autolykos_share_t;
+
+// verify one share
+AUTOLYKOS_VERIFY_API int AutolykosVerify(const autolykos_share_t * share);
+
+// verify shares in parallel, write verdicts, return number of valid ones
+// or AUTOLYKOS_VERIFY_ERROR if any share could not be checked
+AUTOLYKOS_VERIFY_API int AutolykosVerifyBatch(
+    const autolykos_share_t * shares,
+    const int count,
+    const int threads,
+    int * verdicts
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VERIFYAPI_H
@@ -0,0 +1,76 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+/*******************************************************************************
+
+    WATCHDOG -- Miner thread supervision and device recovery accounting
+
+********************************************************************************
+
+A device fails when a backend call returns an error, launched work takes
+the device longer than a timeout, or the main thread finds that the device
+showed no liveness for HASHRATE_LIVENESS_MS and requests recovery. Devices
+busy with prehash or pausing for duty cycle are not stalled, see hashrate.h. The miner thread then destroys the backend, which
+resets the device context, waits a backoff doubling from
+WATCHDOG_BACKOFF_MS up to WATCHDOG_MAX_BACKOFF_MS and creates the backend
+again. Other devices keep mining meanwhile.
+
+Down                miner thread, device failed
+Up                  miner thread, device mines again
+Check               main thread, request recovery of stalled devices
+
+Time is read from 'clock' as in hashrate_t.
+
+*******************************************************************************/
+
+#include "hashrate.h"
+#include <atomic>
+
+// limit of waiting for a mining iteration and for a prehash
+#define WATCHDOG_TIMEOUT_MS 10000
+#define WATCHDOG_PREHASH_TIMEOUT_MS 30000
+
+// delay before recreating failed device
+#define WATCHDOG_BACKOFF_MS 1000
+#define WATCHDOG_MAX_BACKOFF_MS 60000
+
+// per-device health
+struct device_health_t
+{
+    // recovery requested by supervisor
+    std::atomic<int> recover;
+    // number of recoveries
+    std::atomic<int> recoveries;
+    // total time of failures, start of current one or zero
+    std::atomic<int64_t> downtimeMs;
+    std::atomic<int64_t> downSinceMs;
+};
+
+// supervisor of all devices
+struct watchdog_t
+{
+    int devices;
+    device_health_t health[HASHRATE_MAX_DEVICES];
+
+    // monotonic time in milliseconds
+    int64_t (* clock)(void);
+
+    watchdog_t(void) { devices = 0; clock = hashrate_t::NowMs; }
+
+    // set number of devices
+    void Init(const int n);
+
+    // device failed
+    void Down(const int device);
+
+    // device mines again
+    void Up(const int device);
+
+    // request recovery of stalled devices
+    void Check(hashrate_t * hashrates);
+
+    // total downtime including current failure
+    int64_t DowntimeMs(const int device);
+};
+
+#endif // WATCHDOG_H
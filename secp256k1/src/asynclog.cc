@@ -0,0 +1,307 @@
+// asynclog.cc
+
+/*******************************************************************************
+
+    ASYNCLOG -- Asynchronous ring-buffer log sink
+
+*******************************************************************************/
+
+#include "../include/asynclog.h"
+#include "../include/easylogging++.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define ASYNCLOG_RING_MASK (ASYNCLOG_RING_SIZE - 1)
+
+////////////////////////////////////////////////////////////////////////////////
+//  Single-producer single-consumer byte ring of length-prefixed records
+////////////////////////////////////////////////////////////////////////////////
+struct log_ring_t
+{
+    // written by producer
+    std::atomic<uint64_t> head;
+    char padHead[64 - sizeof(uint64_t)];
+
+    // written by consumer
+    std::atomic<uint64_t> tail;
+    char padTail[64 - sizeof(uint64_t)];
+
+    std::atomic<uint64_t> dropped;
+    // producer exited, consumer frees ring once drained
+    std::atomic<int> retired;
+
+    char buf[ASYNCLOG_RING_SIZE];
+
+    log_ring_t(void) { head = 0; tail = 0; dropped = 0; retired = 0; }
+
+    void CopyIn(const uint64_t pos, const void * src, const size_t len)
+    {
+        size_t off = pos & ASYNCLOG_RING_MASK;
+        size_t first = (len < ASYNCLOG_RING_SIZE - off)?
+            len: ASYNCLOG_RING_SIZE - off;
+
+        memcpy(buf + off, src, first);
+        memcpy(buf, (const char *)src + first, len - first);
+    }
+
+    void CopyOut(const uint64_t pos, void * dst, const size_t len) const
+    {
+        size_t off = pos & ASYNCLOG_RING_MASK;
+        size_t first = (len < ASYNCLOG_RING_SIZE - off)?
+            len: ASYNCLOG_RING_SIZE - off;
+
+        memcpy(dst, buf + off, first);
+        memcpy((char *)dst + first, buf, len - first);
+    }
+};
+
+// rings of all logging threads
+static std::mutex ringsMutex;
+static std::vector<log_ring_t *> rings;
+
+// ring of current thread
+static thread_local log_ring_t * threadRing = NULL;
+
+// retires ring of current thread on its exit
+struct ring_owner_t
+{
+    ~ring_owner_t(void)
+    {
+        if (!threadRing) { return; }
+
+        threadRing->retired.store(1, std::memory_order_release);
+        threadRing = NULL;
+    }
+};
+
+static thread_local ring_owner_t ringOwner;
+
+// output
+static std::mutex drainMutex;
+static FILE * logFile = NULL;
+static int toStdout = 1;
+
+////////////////////////////////////////////////////////////////////////////////
+//  Push formatted record from current thread
+////////////////////////////////////////////////////////////////////////////////
+void AsyncLogPush(const char * str, const size_t len)
+{
+    if (!threadRing)
+    {
+        // odr-use constructs owner, its destructor runs at thread exit
+        (void)&ringOwner;
+
+        threadRing = new log_ring_t();
+
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.push_back(threadRing);
+    }
+
+    log_ring_t * ring = threadRing;
+    uint32_t size = (len < ASYNCLOG_MAX_RECORD)? len: ASYNCLOG_MAX_RECORD;
+
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    uint64_t tail = ring->tail.load(std::memory_order_acquire);
+
+    if (ASYNCLOG_RING_SIZE - (head - tail) < sizeof(uint32_t) + size)
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring->CopyIn(head, &size, sizeof(uint32_t));
+    ring->CopyIn(head + sizeof(uint32_t), str, size);
+
+    ring->head.store(head + sizeof(uint32_t) + size, std::memory_order_release);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Write out all pushed records
+////////////////////////////////////////////////////////////////////////////////
+void FlushAsyncLog(void)
+{
+    std::lock_guard<std::mutex> drainLock(drainMutex);
+
+    std::vector<log_ring_t *> snapshot;
+
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        snapshot = rings;
+    }
+
+    std::string batch;
+    std::vector<log_ring_t *> retired;
+
+    for (size_t i = 0; i < snapshot.size(); ++i)
+    {
+        log_ring_t * ring = snapshot[i];
+
+        // retirement is read first, records pushed before it are drained
+        if (ring->retired.load(std::memory_order_acquire))
+        {
+            retired.push_back(ring);
+        }
+
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+
+        while (tail < head)
+        {
+            uint32_t size;
+
+            ring->CopyOut(tail, &size, sizeof(uint32_t));
+
+            size_t pos = batch.size();
+            batch.resize(pos + size);
+            ring->CopyOut(tail + sizeof(uint32_t), &batch[pos], size);
+
+            tail += sizeof(uint32_t) + size;
+        }
+
+        ring->tail.store(tail, std::memory_order_release);
+
+        uint64_t dropped = ring->dropped.exchange(0);
+
+        if (dropped)
+        {
+            char str[64];
+
+            snprintf(
+                str, sizeof(str), "%llu log records dropped\n",
+                (unsigned long long)dropped
+            );
+
+            batch += str;
+        }
+    }
+
+    if (!retired.empty())
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+
+        for (size_t i = 0; i < retired.size(); ++i)
+        {
+            rings.erase(std::find(rings.begin(), rings.end(), retired[i]));
+            delete retired[i];
+        }
+    }
+
+    if (batch.empty()) { return; }
+
+    if (toStdout)
+    {
+        fwrite(batch.data(), 1, batch.size(), stdout);
+        fflush(stdout);
+    }
+
+    if (logFile)
+    {
+        fwrite(batch.data(), 1, batch.size(), logFile);
+        fflush(logFile);
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Redirect output to file and console
+////////////////////////////////////////////////////////////////////////////////
+void AsyncLogOutput(FILE * file, const int console)
+{
+    std::lock_guard<std::mutex> drainLock(drainMutex);
+
+    logFile = file;
+    toStdout = console;
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  easylogging++ dispatch callback
+////////////////////////////////////////////////////////////////////////////////
+class async_log_callback_t: public el::LogDispatchCallback
+{
+protected:
+    void handle(const el::LogDispatchData * data)
+    {
+        if (data->dispatchAction() != el::base::DispatchAction::NormalLog)
+        {
+            return;
+        }
+
+        el::base::type::string_t line
+            = data->logMessage()->logger()->logBuilder()->build(
+                data->logMessage(), true
+            );
+
+        AsyncLogPush(line.c_str(), line.size());
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//  Writer thread
+////////////////////////////////////////////////////////////////////////////////
+static void AsyncLogWriter(void)
+{
+    el::Helpers::setThreadName("log writer");
+
+    while (1)
+    {
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(ASYNCLOG_FLUSH_MS)
+        );
+
+        FlushAsyncLog();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Start writer thread and redirect easylogging++ output to it
+////////////////////////////////////////////////////////////////////////////////
+int StartAsyncLog(void)
+{
+    el::Logger * logger = el::Loggers::getLogger("default");
+    el::base::TypedConfigurations * conf = logger->typedConfigurations();
+
+    toStdout = conf->toStandardOutput(el::Level::Info);
+
+    if (conf->toFile(el::Level::Info))
+    {
+        const std::string & name = conf->filename(el::Level::Info);
+
+        logFile = fopen(name.c_str(), "a");
+
+        if (!logFile)
+        {
+            LOG(ERROR) << "Cannot open log file " << name;
+            return EXIT_FAILURE;
+        }
+    }
+
+    el::Helpers::installLogDispatchCallback<async_log_callback_t>(
+        "AsyncLogCallback"
+    );
+    el::Helpers::uninstallLogDispatchCallback<
+        el::base::DefaultLogDispatchCallback
+    >("DefaultLogDispatchCallback");
+
+    // records pushed before exit
+    atexit(FlushAsyncLog);
+
+    std::thread(AsyncLogWriter).detach();
+
+    return EXIT_SUCCESS;
+}
+
+// asynclog.cc
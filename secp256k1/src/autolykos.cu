@@ -13,16 +13,24 @@
 #endif
 
 #include "bip39/include/bip39/bip39.h"
+#include "../include/asynclog.h"
+#include "../include/autotune.h"
+#include "../include/backend.h"
 #include "../include/cryptography.h"
 #include "../include/definitions.h"
 #include "../include/easylogging++.h"
+#include "../include/fanout.h"
 #include "../include/jsmn.h"
 #include "../include/mining.h"
 #include "../include/prehash.h"
 #include "../include/processing.h"
 #include "../include/reduction.h"
 #include "../include/request.h"
+#include "../include/throttle.h"
+#include "../include/watchdog.h"
+#include "../include/hashrate.h"
 #include "../include/httpapi.h"
+#include "../include/journal.h"
 #include <ctype.h>
 #include <cuda.h>
 #include <curl/curl.h>
@@ -54,33 +62,27 @@
 INITIALIZE_EASYLOGGINGPP
 
 using namespace std::chrono;
-static volatile unsigned long g_delay_ms = 0;
 
 ////////////////////////////////////////////////////////////////////////////////
 //  Miner thread cycle
 ////////////////////////////////////////////////////////////////////////////////
-void MinerThread(int deviceId, info_t * info, std::vector<double>* hashrates, std::vector<int>* tstamps)
+void MinerThread(
+    int deviceId, info_t * info, hashrate_t * hashrates, watchdog_t * watchdog,
+    journal_t * journal, const placement_t * placement
+)
 {
-    CUDA_CALL(cudaSetDevice(deviceId));
-    CUDA_CALL(cudaSetDeviceFlags(cudaDeviceScheduleBlockingSync));
-
     char threadName[20];
     sprintf(threadName, "GPU %i miner", deviceId);
     el::Helpers::setThreadName(threadName);    
 
+    if (placement) { RunOnCpus(placement->feeders[deviceId]); }
+
     state_t state = STATE_KEYGEN;
     char logstr[1000];
 
     //========================================================================//
     //  Host memory allocation
     //========================================================================//
-    // CURL http request
-    json_t request(0, REQ_LEN);
-
-    // hash context
-    // (212 + 4) bytes
-    ctx_t ctx_h;
-
     // autolykos variables
     uint8_t bound_h[NUM_SIZE_8];
     uint8_t mes_h[NUM_SIZE_8];
@@ -91,273 +93,343 @@ void MinerThread(int deviceId, info_t * info, std::vector<double>* hashrates, st
     uint8_t res_h[NUM_SIZE_8];
     uint8_t nonce[NONCE_SIZE_8];
 
-    char skstr[NUM_SIZE_4];
     char pkstr[PK_SIZE_4 + 1];
-    char to[MAX_URL_SIZE];
     int keepPrehash = 0;
 
     // thread info variables
     uint_t blockId = 0;
-    milliseconds start; 
+    // block data snapshot and its sequence
+    block_data_t block;
+    uint64_t blockSeq = 0;
+    device_health_t * health = watchdog->health + deviceId;
     
     //========================================================================//
     //  Copy from global to thread local data
     //========================================================================//
-    info->info_mutex.lock();
+    LockInfo(info);
 
     memcpy(sk_h, info->sk, NUM_SIZE_8);
-    memcpy(mes_h, info->mes, NUM_SIZE_8);
-    memcpy(bound_h, info->bound, NUM_SIZE_8);
     memcpy(pk_h, info->pk, PK_SIZE_8);
     memcpy(pkstr, info->pkstr, (PK_SIZE_4 + 1) * sizeof(char));
-    memcpy(skstr, info->skstr, NUM_SIZE_4 * sizeof(char));
-    memcpy(to, info->to, MAX_URL_SIZE * sizeof(char));
     // blockId = info->blockId.load();
     keepPrehash = info->keepPrehash;
     
     info->info_mutex.unlock();
-    
-    //========================================================================//
-    //  Check GPU memory
-    //========================================================================//
-    size_t freeMem;
-    size_t totalMem;
 
-    CUDA_CALL(cudaMemGetInfo(&freeMem, &totalMem));
-    
-    if (freeMem < MIN_FREE_MEMORY)
-    {
-        LOG(ERROR) << "Not enough GPU memory for mining,"
-            << " minimum 2.8 GiB needed";
+    int tuned = !info->autotune;
 
-        return;
-    }
+    // device mined at least one iteration
+    int mined = 0;
+    int backoff = WATCHDOG_BACKOFF_MS;
 
-    if (keepPrehash && freeMem < MIN_FREE_MEMORY_PREHASH)
-    {
-        LOG(ERROR) << "Not enough memory for keeping prehashes, "
-                   << "setting keepPrehash to false";
+    uint32_t ind = 0;
+    uint64_t base = 0;
 
-        keepPrehash = 0;
-    }
+    int cntCycles = 0;
+    int NCycles = 500;
 
-    //========================================================================//
-    //  Device memory allocation
-    //========================================================================//
-    LOG(INFO) << "GPU " << deviceId << " allocating memory";
-
-    // boundary for puzzle
-    uint32_t * bound_d;
-    // (2 * PK_SIZE_8 + 2 + 4 * NUM_SIZE_8 + 212 + 4) bytes // ~0 MiB
-    CUDA_CALL(cudaMalloc(&bound_d, NUM_SIZE_8 + DATA_SIZE_8));
-    // data: pk || mes || w || padding || x || sk || ctx
-    uint32_t * data_d = bound_d + NUM_SIZE_32;
-
-    // precalculated hashes
-    // N_LEN * NUM_SIZE_8 bytes // 2 GiB
-    uint32_t * hashes_d;
-    CUDA_CALL(cudaMalloc(&hashes_d, (uint32_t)N_LEN * NUM_SIZE_8));
-
-    // place to handle result of the puzzle
-    uint32_t * res_d;
-    CUDA_CALL(cudaMalloc(&res_d, NUM_SIZE_8 + sizeof(uint32_t)));
-    // place to handle nonce if solution is found
-    uint32_t * indices_d = res_d + 8;
-
-    CUDA_CALL(cudaMemset(
-        indices_d, 0, sizeof(uint32_t)
-    ));
-
-    // unfinalized hash contexts
-    // if keepPrehash == true // N_LEN * 80 bytes // 5 GiB
-    uctx_t * uctxs_d = NULL;
-
-    if (keepPrehash)
+    // wait for the very first block to come before starting
+    while (WaitBlock(info, 0, MINER_WAIT_MS) == 0)
     {
-        CUDA_CALL(cudaMalloc(&uctxs_d, (uint32_t)N_LEN * sizeof(uctx_t)));
+        hashrates->Add(deviceId, 0);
     }
 
     //========================================================================//
-    //  Key-pair transfer form host to device
+    //  Device setup and recovery cycle
     //========================================================================//
-    // copy public key
-    CUDA_CALL(cudaMemcpy(
-        data_d, pk_h, PK_SIZE_8, cudaMemcpyHostToDevice
-    ));
+    do
+    {
+        int status = EXIT_SUCCESS;
+        int keep = keepPrehash;
+        // block data is not on the device yet
+        int prehashed = 0;
+        // solution was posted under current one-time key pair
+        int posted = 0;
 
-    // copy secret key
-    CUDA_CALL(cudaMemcpy(
-        data_d + COUPLED_PK_SIZE_32 + 2 * NUM_SIZE_32, sk_h, NUM_SIZE_8,
-        cudaMemcpyHostToDevice
-    ));
+        //====================================================================//
+        //  Device memory allocation
+        //====================================================================//
+        // setup is not a stall
+        hashrates->Busy(deviceId, 1);
 
-    //========================================================================//
-    //  Autolykos puzzle cycle
-    //========================================================================//
-    uint32_t ind = 0;
-    uint64_t base = 0;
+        backend_t * backend = CreateBackend(info, deviceId, placement);
 
-    // set unfinalized hash contexts if necessary
-    if (keepPrehash)
-    {
-        LOG(INFO) << "Preparing unfinalized hashes on GPU " << deviceId;
+        if (!backend) { hashrates->Busy(deviceId, 0); return; }
 
-        UncompleteInitPrehash<<<1 + (N_LEN - 1) / BLOCK_DIM, BLOCK_DIM>>>(
-            data_d, uctxs_d
-        );
+        LOG(INFO) << "Device " << deviceId << " is " << backend->Name();
 
-        CUDA_CALL(cudaDeviceSynchronize());
-    }
+        status = backend->Allocate(&keep);
 
-    int cntCycles = 0;
-    int NCycles = 50;
+        // contexts of keepPrehash did not fit after all, mine without them
+        if (status != EXIT_SUCCESS && keep)
+        {
+            LOG(ERROR) << "GPU " << deviceId << " cannot keep prehashes, "
+                << "retrying with keepPrehash set to false";
 
-    // wait for the very first block to come before starting
-    while (info->blockId.load() == 0) {}
+            delete backend;
 
-    start = duration_cast<milliseconds>(system_clock::now().time_since_epoch());
+            backend = CreateBackend(info, deviceId, placement);
 
-    do
-    {
-        ++cntCycles;
+            if (!backend) { hashrates->Busy(deviceId, 0); return; }
+
+            keep = keepPrehash = 0;
+            status = backend->Allocate(&keep);
+        }
 
-        if (!(cntCycles % NCycles))
+        //====================================================================//
+        //  Key-pair transfer form host to device
+        //====================================================================//
+        if (status == EXIT_SUCCESS) { status = backend->SetKeys(pk_h, sk_h); }
+
+        if (status == EXIT_SUCCESS && (info->noncesPerIter || info->blockDim))
         {
-            milliseconds timediff
-                = duration_cast<milliseconds>(
-                    system_clock::now().time_since_epoch()
-                ) - start;
-            
-            // change avg hashrate in global memory
+            if (
+                backend->SetWorkSize(
+                    (info->noncesPerIter)? info->noncesPerIter: NONCES_PER_ITER,
+                    (info->blockDim)? info->blockDim: backend->blockDim
+                ) != EXIT_SUCCESS
+            )
+            {
+                LOG(ERROR) << "Invalid work size for GPU " << deviceId
+                    << ", using default";
+            }
+        }
 
-            (*hashrates)[deviceId] = (double)NONCES_PER_ITER * (double)NCycles
-                / ((double)1000 * timediff.count());
-             
-            start = duration_cast<milliseconds>(
-                system_clock::now().time_since_epoch()
-            );
+        // set unfinalized hash contexts if necessary
+        if (status == EXIT_SUCCESS && keep)
+        {
+            LOG(INFO) << "Preparing unfinalized hashes on GPU " << deviceId;
 
-            (*tstamps)[deviceId] = start.count();
+            status = backend->UncompletePrehash();
         }
-    
-        // if solution was found by this thread wait for new block to come 
-        if (state == STATE_KEYGEN)
+
+        hashrates->Busy(deviceId, 0);
+
+        // device which never worked is not recovered
+        if (status != EXIT_SUCCESS && !mined)
         {
-            while (info->blockId.load() == blockId) {}
+            delete backend;
+            return;
+        }
+
+        //====================================================================//
+        //  Duty-cycle controller
+        //====================================================================//
+        throttle_t * throttle = NULL;
+        sensor_t * sensor = backend->CreateSensor();
+        // last pause as actually slept
+        double sleptSec = 0;
 
-            state = STATE_CONTINUE;
+        if (sensor)
+        {
+            throttle = new throttle_t(
+                sensor, info->targetTemp, info->targetPower
+            );
         }
 
-        uint_t controlId = info->blockId.load();
-        
-        if (blockId != controlId)
+        //====================================================================//
+        //  Autolykos puzzle cycle
+        //====================================================================//
+        while (status == EXIT_SUCCESS)
         {
-            // if info->blockId changed
-            // read new message and bound to thread-local mem
-            info->info_mutex.lock();
+            ++cntCycles;
 
-            memcpy(mes_h, info->mes, NUM_SIZE_8);
-            memcpy(bound_h, info->bound, NUM_SIZE_8);
+            if (throttle && !(cntCycles % NCycles))
+            {
+                LOG(INFO) << "GPU " << deviceId << " duty " << throttle->duty
+                    << ", " << throttle->temp << " C, " << throttle->power
+                    << " W, " << throttle->HashesPerJoule() << " H/J";
+            }
+        
+            // if solution was found by this thread wait for new block to come 
+            if (state == STATE_KEYGEN)
+            {
+                while (
+                    WaitBlock(info, blockId, MINER_WAIT_MS) == blockId
+                    && !health->recover
+                )
+                {
+                    hashrates->Add(deviceId, 0);
+                }
 
-            info->info_mutex.unlock();
+                state = STATE_CONTINUE;
+            }
 
-            LOG(INFO) << "GPU " << deviceId << " read new block data";
-            blockId = controlId;
-            
-            GenerateKeyPair(x_h, w_h);
-
-            VLOG(1) << "Generated new keypair,"
-                << " copying new data in device memory now";
-
-            // copy boundary
-            CUDA_CALL(cudaMemcpy(
-                bound_d, bound_h, NUM_SIZE_8, cudaMemcpyHostToDevice
-            ));
-
-            // copy message
-            CUDA_CALL(cudaMemcpy(
-                ((uint8_t *)data_d + PK_SIZE_8), mes_h, NUM_SIZE_8,
-                cudaMemcpyHostToDevice
-            ));
-
-            // copy one time secret key
-            CUDA_CALL(cudaMemcpy(
-                (data_d + COUPLED_PK_SIZE_32 + NUM_SIZE_32),
-                x_h, NUM_SIZE_8, cudaMemcpyHostToDevice
-            ));
-
-            // copy one time public key
-            CUDA_CALL(cudaMemcpy(
-                ((uint8_t *)data_d + PK_SIZE_8 + NUM_SIZE_8),
-                w_h, PK_SIZE_8, cudaMemcpyHostToDevice
-            ));
-
-            VLOG(1) << "Starting prehashing with new block data";
-            Prehash(keepPrehash, data_d, uctxs_d, hashes_d, res_d);
+            if (health->recover)
+            {
+                LOG(ERROR) << "GPU " << deviceId << " recovery requested";
+                status = EXIT_FAILURE;
+
+                break;
+            }
+
+            uint_t controlId = info->blockId.load();
             
-            // calculate unfinalized hash of message
+            if (blockId != controlId || !prehashed)
+            {
+                // if info->blockId changed
+                // read new message and bound without blocking the poller
+                uint64_t seq = info->block.Read(&block);
 
-            VLOG(1) << "Starting InitMining";
-            InitMining(&ctx_h, (uint32_t *)mes_h, NUM_SIZE_8);
+                blockId = controlId;
 
-            CUDA_CALL(cudaDeviceSynchronize());
-    
-            // copy context
-            CUDA_CALL(cudaMemcpy(
-                data_d + COUPLED_PK_SIZE_32 + 3 * NUM_SIZE_32, &ctx_h,
-                sizeof(ctx_t), cudaMemcpyHostToDevice
-            ));
+                // snapshot was read before its blockId increment
+                if (prehashed && seq == blockSeq) { continue; }
 
-            state = STATE_CONTINUE;
-        }
+                // change flags cover one publication only
+                int mesChanged = !prehashed || (
+                    (seq == blockSeq + 2)?
+                    (block.changed & BLOCK_MES_CHANGED):
+                    memcmp(block.mes, mes_h, NUM_SIZE_8)
+                );
 
-        VLOG(1) << "Starting main BlockMining procedure";
+                blockSeq = seq;
+                memcpy(bound_h, block.bound, NUM_SIZE_8);
 
-        // calculate solution candidates
-        BlockMining<<<1 + (THREADS_PER_ITER - 1) / BLOCK_DIM, BLOCK_DIM>>>(
-            bound_d, data_d, base, hashes_d, res_d, indices_d
-        );
+                // hashes and key pair stay for the same message until a
+                // solution is posted, two with one w reveal the secret key
+                if (!mesChanged && !posted)
+                {
+                    LOG(INFO) << "GPU " << deviceId << " read new bound";
 
-        VLOG(1) << "Trying to find solution";
+                    status = backend->SetBound(bound_h);
 
-        // restart iteration if new block was found
-        if (blockId != info->blockId.load()) { continue; }
+                    if (status != EXIT_SUCCESS) { break; }
 
-        CUDA_CALL(cudaMemcpy(
-            &ind, indices_d, sizeof(uint32_t),
-            cudaMemcpyDeviceToHost
-        ));
+                    continue;
+                }
 
+                memcpy(mes_h, block.mes, NUM_SIZE_8);
 
-        // solution found
-        if (ind)
-        {
-            CUDA_CALL(cudaMemcpy(
-                res_h, res_d , NUM_SIZE_8,
-                cudaMemcpyDeviceToHost
-            ));
-            
-            
-            *((uint64_t *)nonce) = base + ind - 1;
+                LOG(INFO) << "GPU " << deviceId << " read new block data";
 
-            
-            PrintPuzzleSolution(nonce, res_h, logstr);
-            LOG(INFO) << "GPU " << deviceId
-            << " found and trying to POST a solution:\n" << logstr;
+                GenerateKeyPair(x_h, w_h);
+                posted = 0;
 
-            PostPuzzleSolution(to, pkstr, w_h, nonce, res_h);
-    
-            state = STATE_KEYGEN;
-            CUDA_CALL(cudaMemset(
-                indices_d, 0, sizeof(uint32_t)
-            ));
-        }
+                VLOG(1) << "Generated new keypair,"
+                    << " copying new data in device memory now";
+
+                hashrates->Busy(deviceId, 1);
+
+                status = backend->SetBlock(mes_h, bound_h, x_h, w_h);
+
+                VLOG(1) << "Starting prehashing with new block data";
+                if (status == EXIT_SUCCESS) { status = backend->Prehash(); }
+
+                // tuning needs prehashed data
+                if (status == EXIT_SUCCESS && !tuned)
+                {
+                    Autotune(backend, info->tuneProfile);
+                    tuned = 1;
+                }
+
+                hashrates->Busy(deviceId, 0);
+
+                if (status != EXIT_SUCCESS) { break; }
+
+                prehashed = 1;
+
+                state = STATE_CONTINUE;
+            }
+
+            VLOG(1) << "Starting main BlockMining procedure";
+
+            steady_clock::time_point iterStart = steady_clock::now();
+
+            // calculate solution candidates
+            status = backend->Mine(base);
+
+            if (status != EXIT_SUCCESS) { break; }
+
+            VLOG(1) << "Trying to find solution";
+
+            // restart iteration if new block was found
+            if (blockId != info->blockId.load()) { continue; }
+
+            status = backend->GetResult(&ind, res_h);
+
+            if (status != EXIT_SUCCESS) { break; }
+
+            // nonces count and device is alive once iteration has finished
+            hashrates->Add(deviceId, backend->noncesPerIter);
+
+            // device works again after failure
+            if (!mined || health->downSinceMs.load())
+            {
+                watchdog->Up(deviceId);
+                mined = 1;
+                backoff = WATCHDOG_BACKOFF_MS;
+            }
+
+            // solution found
+            if (ind)
+            {
+                *((uint64_t *)nonce) = base + ind - 1;
+
+                
+                PrintPuzzleSolution(nonce, res_h, logstr);
+                LOG(INFO) << "GPU " << deviceId
+                << " found a solution:\n" << logstr;
 
-        base += NONCES_PER_ITER;
+                // submitter thread posts it and retries on node failure
+                journal->Append(mes_h, pkstr, w_h, nonce, res_h);
 
-        if (g_delay_ms>0) {
-          std::this_thread::sleep_for(std::chrono::milliseconds(g_delay_ms > 100 ? 100 : g_delay_ms));
+                posted = 1;
+                state = STATE_KEYGEN;
+            }
+
+            base += backend->noncesPerIter;
+
+            if (throttle)
+            {
+                double iterSec = duration_cast<duration<double>>(
+                    steady_clock::now() - iterStart
+                ).count();
+
+                int pauseMs = (int)(
+                    1000 * throttle->Update(
+                        iterSec, sleptSec, backend->noncesPerIter
+                    )
+                );
+
+                steady_clock::time_point pauseStart = steady_clock::now();
+
+                // new block ends the pause
+                if (pauseMs > 0)
+                {
+                    hashrates->Busy(deviceId, 1);
+                    WaitBlock(info, blockId, pauseMs);
+                    hashrates->Busy(deviceId, 0);
+                }
+
+                sleptSec = duration_cast<duration<double>>(
+                    steady_clock::now() - pauseStart
+                ).count();
+            }
         }
+
+        //====================================================================//
+        //  Device recovery
+        //====================================================================//
+        watchdog->Down(deviceId);
+
+        // backoff is not a stall
+        hashrates->Busy(deviceId, 1);
+
+        // backend destruction resets device
+        delete throttle;
+        delete backend;
+
+        // request is served, a new one needs a new stall
+        health->recover = 0;
+
+        LOG(ERROR) << "GPU " << deviceId << " failed, recreating it in "
+            << backoff << " ms";
+
+        std::this_thread::sleep_for(milliseconds(backoff));
+
+        backoff = (2 * backoff < WATCHDOG_MAX_BACKOFF_MS)?
+            2 * backoff: WATCHDOG_MAX_BACKOFF_MS;
     }
     while (1);
 
@@ -379,6 +451,9 @@ int main(int argc, char ** argv)
 
     el::Helpers::setThreadName("main thread");
 
+    // write log from a separate thread
+    StartAsyncLog();
+
     char logstr[1000];
 
     // Mnemonic generation mode
@@ -417,20 +492,6 @@ int main(int argc, char ** argv)
 
 
 
-    //========================================================================//
-    //  Check GPU availability
-    //========================================================================//
-    int deviceCount;
-    int status = EXIT_SUCCESS;
-
-    if (cudaGetDeviceCount(&deviceCount) != cudaSuccess)
-    {
-        LOG(ERROR) << "Error checking GPU";
-        return EXIT_FAILURE;
-    }
-
-    LOG(INFO) << "Using " << deviceCount << " GPU devices";
-
     //========================================================================//
     //  Read configuration file
     //========================================================================//
@@ -438,8 +499,11 @@ int main(int argc, char ** argv)
     char * fileName = (argc == 1)? confName: argv[1];
     char from[MAX_URL_SIZE];
     info_t info;
+    int status = EXIT_SUCCESS;
 
     info.blockId = 0;
+    info.lockWaitNs = 0;
+    info.lockCount = 0;
     info.keepPrehash = 0;
     
     LOG(INFO) << "Using configuration file " << fileName;
@@ -452,14 +516,65 @@ int main(int argc, char ** argv)
     }
 
     // read configuration from file
-    status = ReadConfig(
-        fileName, info.sk, info.skstr, from, info.to, &info.keepPrehash
-    );
+    status = ReadConfig(fileName, from, &info);
 
     if (status == EXIT_FAILURE) { return EXIT_FAILURE; }
 
-    LOG(INFO) << "Block getting URL:\n   " << from;
-    LOG(INFO) << "Solution posting URL:\n   " << info.to;
+    //========================================================================//
+    //  Check device availability
+    //========================================================================//
+    int deviceCount;
+
+    if (GetBackendDeviceCount(&info, &deviceCount) != EXIT_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    LOG(INFO) << "Using " << deviceCount << " devices";
+
+    //========================================================================//
+    //  Place host threads on cores
+    //========================================================================//
+    static placement_t placement;
+    const placement_t * placed = NULL;
+
+    if (info.threadPlacement == PLACEMENT_CORES)
+    {
+        if (placement.Read() != EXIT_SUCCESS)
+        {
+            LOG(WARNING) << "CPU topology is unknown, threads are not placed";
+        }
+        else
+        {
+            placement.Plan(deviceCount, info.backend == BACKEND_CPU);
+            placement.Report();
+
+            // threads started from now on inherit the service core
+            if (RunOnCpus(placement.service) == EXIT_SUCCESS)
+            {
+                placed = &placement;
+            }
+            else
+            {
+                LOG(WARNING) << "Thread affinity is not supported,"
+                    << " threads are not placed";
+            }
+        }
+    }
+
+    // candidates and solutions go through site proxy instead of node
+    int proxied = (info.proxy[0] != '\0');
+
+    if (proxied)
+    {
+        LOG(INFO) << "Block getting and solution posting proxy:\n   "
+            << info.proxy;
+    }
+    else
+    {
+        LOG(INFO) << "Block getting URL:\n   " << from;
+        LOG(INFO) << "Solution posting URL:\n   " << info.to;
+    }
 
     // generate public key from secret key
     GeneratePublicKey(info.skstr, info.pkstr, info.pk);
@@ -481,31 +596,58 @@ int main(int argc, char ** argv)
     //  Fork miner threads
     //========================================================================//
     std::vector<std::thread> miners(deviceCount);
-    std::vector<double> hashrates(deviceCount);
-    std::vector<int> lastTimestamps(deviceCount);
-    std::vector<int> timestamps(deviceCount);
+
+    // static storage keeps per-device counters cache line aligned
+    static hashrate_t hashrates;
+
+    if (hashrates.Init(deviceCount) != EXIT_SUCCESS) { return EXIT_FAILURE; }
+
+    static watchdog_t watchdog;
+
+    watchdog.Init(deviceCount);
+
+    static journal_t journal;
+
+    if (journal.Open(info.journal) != EXIT_SUCCESS) { return EXIT_FAILURE; }
+
+    static fanout_client_t proxy;
+
+    if (proxied)
+    {
+        if (proxy.Init(info.proxy) != EXIT_SUCCESS) { return EXIT_FAILURE; }
+
+        journal.proxy = &proxy;
+    }
     
     // PCI bus and device IDs
     std::vector<std::pair<int,int>> devinfos(deviceCount);
     for (int i = 0; i < deviceCount; ++i)
     {
         cudaDeviceProp props;
-        if(cudaGetDeviceProperties(&props, i) == cudaSuccess)
+        if(info.backend == BACKEND_CUDA
+            && cudaGetDeviceProperties(&props, i) == cudaSuccess)
         {
             devinfos[i] = std::make_pair(props.pciBusID, props.pciDeviceID);
         }
-        miners[i] = std::thread(MinerThread, i, &info, &hashrates, &timestamps);
-        hashrates[i] = 0;
-        lastTimestamps[i] = 1;
-        timestamps[i] = 0;
+        miners[i] = std::thread(
+            MinerThread, i, &info, &hashrates, &watchdog, &journal, placed
+        );
     }
 
 
+    // proxy pushes blocks, public key is checked on the first one
+    if (proxied)
+    {
+        std::thread(&fanout_client_t::Run, &proxy, &info).detach();
+    }
+
     // get first block 
     status = EXIT_FAILURE;
     while(status != EXIT_SUCCESS)
     {
-        status = GetLatestBlock(from, &request, &info, 1);
+        status = (proxied)?
+            ((info.blockId.load())? EXIT_SUCCESS: EXIT_FAILURE):
+            GetLatestBlock(from, &request, &info, 1);
         std::this_thread::sleep_for(std::chrono::milliseconds(800));
         if(status != EXIT_SUCCESS)
         {
@@ -514,6 +656,7 @@ int main(int argc, char ** argv)
     }
     
     std::thread httpApi = std::thread(HttpApiThread,&hashrates,&devinfos);    
+    std::thread submitter = std::thread(JournalThread, &journal, &info);
 
     //========================================================================//
     //  Main thread get-block cycle
@@ -521,7 +664,6 @@ int main(int argc, char ** argv)
     uint_t curlcnt = 0;
     const uint_t poll_delay_ms=100; // was 8
     const uint_t curltimes = 2000*8/poll_delay_ms;
-    const uint_t rereadtimes = 30;
 
     milliseconds ms = milliseconds::zero(); 
     
@@ -536,7 +678,8 @@ int main(int argc, char ** argv)
         );
         
         // get latest block
-        status = GetLatestBlock(from, &request, &info, 0);
+        status = (proxied)? EXIT_SUCCESS:
+            GetLatestBlock(from, &request, &info, 0);
         
         if (status != EXIT_SUCCESS) { LOG(INFO) << "Getting block error"; }
 
@@ -546,43 +689,78 @@ int main(int argc, char ** argv)
 
         ++curlcnt;
 
+        hashrates.Sample();
+        watchdog.Check(&hashrates);
+
         if (!(curlcnt % curltimes))
         {
-            LOG(INFO) << "Average curling time "
-                << ms.count() / (double)curltimes << " ms";
-            LOG(INFO) << "Current block candidate: " << request.ptr;
+            if (proxied)
+            {
+                LOG(INFO) << "Candidates from proxy: "
+                    << proxy.received.load();
+            }
+            else
+            {
+                LOG(INFO) << "Average curling time "
+                    << ms.count() / (double)curltimes << " ms";
+                LOG(INFO) << "Current block candidate: " << request.ptr;
+            }
+
             ms = milliseconds::zero();
             std::stringstream hrBuffer;
-            hrBuffer << "Average hashrates: ";
-            double totalHr = 0;
+            hrBuffer << "Average hashrates 10s/1m/15m: ";
+            const int windows[3] = { 10, 60, 900 };
+            double totalHr[3] = { 0, 0, 0 };
             for(int i = 0; i < deviceCount; ++i)
             {
-                // check if miner thread is updating hashrate, e.g. alive
-                if(!(curlcnt % (5*curltimes)))
+                hrBuffer << "GPU" << i << " ";
+
+                for (int k = 0; k < 3; ++k)
                 {
-                    if(lastTimestamps[i] == timestamps[i])
-                    {
-                        hashrates[i] = 0;
-                    }
-                    lastTimestamps[i] = timestamps[i];
+                    double hr = hashrates.Rate(i, windows[k]) / 1e6;
+
+                    hrBuffer << hr << ((k < 2)? "/": " MH/s ");
+                    totalHr[k] += hr;
+                }
+
+                // miner thread is not finishing iterations
+                if (!hashrates.Alive(i)) { hrBuffer << "(stalled) "; }
+
+                if (watchdog.health[i].recoveries.load())
+                {
+                    hrBuffer << "(" << watchdog.health[i].recoveries.load()
+                        << " recoveries, down " << watchdog.DowntimeMs(i) / 1000
+                        << " s) ";
                 }
-                hrBuffer << "GPU" << i << " " << hashrates[i] << " MH/s ";
-                totalHr += hashrates[i];
-                
             }
-            hrBuffer << "Total " << totalHr << " MH/s ";
+            hrBuffer << "Total " << totalHr[0] << "/" << totalHr[1] << "/"
+                << totalHr[2] << " MH/s ";
             LOG(INFO) << hrBuffer.str();
-        }
 
-        if (!(curlcnt % rereadtimes)) {
-          FILE *f = fopen("/var/run/autolykos_delay","r");
-          if(f) {
-            char buf[100];
-            size_t ret=fread(buf,1,sizeof(buf),f);
-            buf[ret]='\0';
-            g_delay_ms=(unsigned long)atoi(buf);
-            fclose(f);
-          }
+            uint64_t lockCount = info.lockCount.exchange(0);
+            uint64_t lockWaitNs = info.lockWaitNs.exchange(0);
+
+            if (lockCount)
+            {
+                LOG(INFO) << "Info lock: " << lockCount << " locks, average wait "
+                    << lockWaitNs / (1000.0 * lockCount) << " us";
+            }
+
+            uint64_t blockReads = info.block.reads.exchange(0);
+            uint64_t blockRetries = info.block.retries.exchange(0);
+
+            if (blockReads)
+            {
+                LOG(INFO) << "Block data: " << blockReads << " reads, "
+                    << blockRetries << " retries";
+            }
+
+            int unposted = journal.Pending();
+
+            if (unposted)
+            {
+                LOG(INFO) << unposted << " solutions are waiting for the node";
+            }
         }
 
         std::this_thread::sleep_for(std::chrono::milliseconds(poll_delay_ms));
@@ -0,0 +1,254 @@
+// autotune.cc
+
+/*******************************************************************************
+
+    AUTOTUNE -- Per-device work size search and tuning profile
+
+*******************************************************************************/
+
+#include "../include/autotune.h"
+#include "../include/easylogging++.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+// profile file is shared by all miner threads
+static std::mutex profileMutex;
+
+// measured work size
+struct tune_point_t
+{
+    uint32_t nonces;
+    uint32_t dim;
+    double rate;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//  Measure backend throughput in nonces per second
+////////////////////////////////////////////////////////////////////////////////
+static int MeasureRate(backend_t * backend, double * rate, double * iterMs)
+{
+    using namespace std::chrono;
+
+    uint32_t ind;
+    uint8_t res[NUM_SIZE_8];
+    uint64_t base = 0;
+
+    // warm up
+    if (backend->Mine(base) != EXIT_SUCCESS) { return EXIT_FAILURE; }
+    if (backend->GetResult(&ind, res) != EXIT_SUCCESS) { return EXIT_FAILURE; }
+
+    steady_clock::time_point start = steady_clock::now();
+
+    for (int i = 0; i < TUNE_ITERS; ++i)
+    {
+        base += backend->noncesPerIter;
+
+        if (backend->Mine(base) != EXIT_SUCCESS) { return EXIT_FAILURE; }
+
+        if (backend->GetResult(&ind, res) != EXIT_SUCCESS)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    double sec = duration_cast<duration<double>>(
+        steady_clock::now() - start
+    ).count();
+
+    *rate = (double)backend->noncesPerIter * TUNE_ITERS / sec;
+    *iterMs = 1000 * sec / TUNE_ITERS;
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Search best work size and set it to backend
+////////////////////////////////////////////////////////////////////////////////
+int TuneWorkSize(backend_t * backend, uint32_t * nonces, uint32_t * dim)
+{
+    std::vector<tune_point_t> points;
+
+    uint32_t minDim = TUNE_MIN_BLOCK_DIM;
+    uint32_t maxDim = TUNE_MAX_BLOCK_DIM;
+
+    if (backend->maxBlockDim < maxDim) { maxDim = backend->maxBlockDim; }
+    if (maxDim < minDim) { minDim = maxDim; }
+
+    for (uint32_t d = minDim; d <= maxDim; d <<= 1)
+    {
+        for (uint32_t n = TUNE_MIN_NONCES; n <= TUNE_MAX_NONCES; n <<= 1)
+        {
+            tune_point_t point;
+            double iterMs;
+
+            point.nonces = n;
+            point.dim = d;
+
+            if (
+                backend->SetWorkSize(n, d) != EXIT_SUCCESS
+                || MeasureRate(backend, &point.rate, &iterMs) != EXIT_SUCCESS
+            )
+            {
+                break;
+            }
+
+            VLOG(1) << backend->Name() << ": " << n << " nonces, block " << d
+                << ", " << point.rate / 1e6 << " MH/s";
+
+            points.push_back(point);
+
+            // larger iterations only add latency
+            if (iterMs > TUNE_MAX_ITER_MS) { break; }
+        }
+    }
+
+    if (points.empty())
+    {
+        LOG(ERROR) << "Autotuning of " << backend->Name() << " failed";
+
+        backend->SetWorkSize(NONCES_PER_ITER, BLOCK_DIM);
+
+        return EXIT_FAILURE;
+    }
+
+    double best = 0;
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        if (points[i].rate > best) { best = points[i].rate; }
+    }
+
+    // smallest work size close to the best throughput
+    const tune_point_t * choice = NULL;
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        const tune_point_t * p = &points[i];
+
+        if (p->rate * 100 < best * (100 - TUNE_TOLERANCE)) { continue; }
+
+        if (
+            !choice || p->nonces < choice->nonces
+            || (p->nonces == choice->nonces && p->rate > choice->rate)
+        )
+        {
+            choice = p;
+        }
+    }
+
+    *nonces = choice->nonces;
+    *dim = choice->dim;
+
+    return backend->SetWorkSize(*nonces, *dim);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Find device work size in profile
+////////////////////////////////////////////////////////////////////////////////
+int ReadTuneProfile(
+    const char * fileName,
+    const char * device,
+    uint32_t * nonces,
+    uint32_t * dim
+)
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+
+    FILE * in = fopen(fileName, "r");
+
+    if (!in) { return EXIT_FAILURE; }
+
+    char line[512];
+    int status = EXIT_FAILURE;
+
+    while (fgets(line, sizeof(line), in))
+    {
+        unsigned int n;
+        unsigned int d;
+        int pos = 0;
+
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if (sscanf(line, "%u %u %n", &n, &d, &pos) < 2 || !pos) { continue; }
+
+        if (!strcmp(line + pos, device))
+        {
+            *nonces = n;
+            *dim = d;
+            status = EXIT_SUCCESS;
+        }
+    }
+
+    fclose(in);
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Append device work size to profile
+////////////////////////////////////////////////////////////////////////////////
+int WriteTuneProfile(
+    const char * fileName,
+    const char * device,
+    const uint32_t nonces,
+    const uint32_t dim
+)
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+
+    FILE * out = fopen(fileName, "a");
+
+    if (!out)
+    {
+        LOG(ERROR) << "Cannot open tuning profile " << fileName;
+        return EXIT_FAILURE;
+    }
+
+    fprintf(out, "%u %u %s\n", nonces, dim, device);
+    fclose(out);
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Set work size from profile, tune and store it if device is not there
+////////////////////////////////////////////////////////////////////////////////
+int Autotune(backend_t * backend, const char * fileName)
+{
+    uint32_t nonces;
+    uint32_t dim;
+
+    if (
+        ReadTuneProfile(fileName, backend->Name(), &nonces, &dim)
+        == EXIT_SUCCESS
+    )
+    {
+        if (backend->SetWorkSize(nonces, dim) == EXIT_SUCCESS)
+        {
+            LOG(INFO) << backend->Name() << " work size from profile: "
+                << nonces << " nonces, block " << dim;
+
+            return EXIT_SUCCESS;
+        }
+
+        LOG(ERROR) << "Invalid work size in profile for " << backend->Name();
+    }
+
+    LOG(INFO) << "Autotuning " << backend->Name();
+
+    if (TuneWorkSize(backend, &nonces, &dim) != EXIT_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    LOG(INFO) << backend->Name() << " tuned work size: "
+        << nonces << " nonces, block " << dim;
+
+    return WriteTuneProfile(fileName, backend->Name(), nonces, dim);
+}
+
+// autotune.cc
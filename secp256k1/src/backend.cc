@@ -0,0 +1,78 @@
+// backend.cc
+
+/*******************************************************************************
+
+    BACKEND -- Compute device abstraction for miner threads
+
+*******************************************************************************/
+
+#include "../include/backend.h"
+#include "../include/definitions.h"
+#include "../include/easylogging++.h"
+#include <stdlib.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+//  Parse backend type name
+////////////////////////////////////////////////////////////////////////////////
+int ParseBackendType(const char * str, const int len, int * type)
+{
+    if (len == 4 && !strncmp(str, "cuda", 4)) { *type = BACKEND_CUDA; }
+    else if (len == 3 && !strncmp(str, "cpu", 3)) { *type = BACKEND_CPU; }
+    else if (len == 3 && !strncmp(str, "sim", 3)) { *type = BACKEND_SIM; }
+    else { return EXIT_FAILURE; }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Number of devices available to backend
+////////////////////////////////////////////////////////////////////////////////
+int GetBackendDeviceCount(const info_t * info, int * count)
+{
+    switch (info->backend)
+    {
+        case BACKEND_CUDA:
+            return GetCudaDeviceCount(count);
+
+        case BACKEND_CPU:
+        case BACKEND_SIM:
+            *count = info->devices;
+            return EXIT_SUCCESS;
+
+        default:
+            LOG(ERROR) << "Unknown backend type " << info->backend;
+            return EXIT_FAILURE;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Create backend for device
+////////////////////////////////////////////////////////////////////////////////
+backend_t * CreateBackend(
+    const info_t * info,
+    const int deviceId,
+    const placement_t * placement
+)
+{
+    switch (info->backend)
+    {
+        case BACKEND_CUDA:
+            return CreateCudaBackend(deviceId);
+
+        case BACKEND_CPU:
+            return CreateCpuBackend(
+                deviceId, info,
+                (placement)? &placement->workers[deviceId]: NULL
+            );
+
+        case BACKEND_SIM:
+            return CreateSimBackend(deviceId, info);
+
+        default:
+            LOG(ERROR) << "Unknown backend type " << info->backend;
+            return NULL;
+    }
+}
+
+// backend.cc
@@ -0,0 +1,319 @@
+// candidates.cc
+
+/*******************************************************************************
+
+    CANDIDATES -- Candidate stream recording and replay
+
+*******************************************************************************/
+
+#include "../include/candidates.h"
+#include "../include/definitions.h"
+#include "../include/easylogging++.h"
+#include "../include/httplib.h"
+#include "../include/request.h"
+#include <curl/curl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace std::chrono;
+
+////////////////////////////////////////////////////////////////////////////////
+//  Start replay of recorded stream at speed x
+////////////////////////////////////////////////////////////////////////////////
+replay_t::replay_t(const std::vector<candidate_t> & recorded, const double x):
+    stream(recorded)
+{
+    speed = x;
+    served = -1;
+    polls = 0;
+    switches = 0;
+    latencySum = 0;
+    latencyMax = 0;
+    solutions = 0;
+    stale = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Time of candidate switch
+////////////////////////////////////////////////////////////////////////////////
+double replay_t::SwitchMs(const int ind) const
+{
+    return (stream[ind].ms - stream[0].ms) / speed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Candidate scheduled for time
+////////////////////////////////////////////////////////////////////////////////
+int replay_t::Current(const double nowMs) const
+{
+    int ind = 0;
+
+    while (ind + 1 < (int)stream.size() && SwitchMs(ind + 1) <= nowMs)
+    {
+        ++ind;
+    }
+
+    return ind;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Candidate served to poll
+////////////////////////////////////////////////////////////////////////////////
+int replay_t::Poll(const double nowMs)
+{
+    int ind = Current(nowMs);
+
+    ++polls;
+
+    if (ind > served)
+    {
+        double latency = nowMs - SwitchMs(ind);
+
+        latencySum += latency;
+        latencyMax = std::max(latencyMax, latency);
+        ++switches;
+        served = ind;
+
+        if (ind + 1 == (int)stream.size())
+        {
+            LOG(INFO) << "Serving last recorded candidate";
+        }
+    }
+
+    return ind;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Count posted solution
+////////////////////////////////////////////////////////////////////////////////
+void replay_t::Post(const double nowMs)
+{
+    ++solutions;
+
+    // miner has not seen the switch yet and mines old block
+    if (Current(nowMs) > served) { ++stale; }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Append response received at ms since start of recording
+////////////////////////////////////////////////////////////////////////////////
+void WriteCandidate(FILE * out, const int64_t ms, const std::string & body)
+{
+    fprintf(out, "T %lld %zu\n", (long long)ms, body.size());
+    fwrite(body.data(), 1, body.size(), out);
+    fputc('\n', out);
+    fflush(out);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Record node candidate stream to file until interrupted
+////////////////////////////////////////////////////////////////////////////////
+int RecordCandidates(const char * node, const char * fileName)
+{
+    std::string from = std::string(node) + "/mining/candidate";
+
+    FILE * out = fopen(fileName, "ab");
+
+    if (!out)
+    {
+        LOG(ERROR) << "Cannot open candidate record " << fileName;
+        return EXIT_FAILURE;
+    }
+
+    CURL * curl = curl_easy_init();
+
+    if (!curl)
+    {
+        LOG(ERROR) << "CURL initialization failed in RecordCandidates";
+        fclose(out);
+
+        return EXIT_FAILURE;
+    }
+
+    json_t response(0, REQ_LEN);
+    std::string last;
+    int records = 0;
+
+    CurlLogError(curl_easy_setopt(curl, CURLOPT_URL, from.c_str()));
+    CurlLogError(curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteFunc));
+    CurlLogError(curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response));
+    CurlLogError(curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L));
+    CurlLogError(curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L));
+
+    steady_clock::time_point start = steady_clock::now();
+
+    LOG(INFO) << "Recording " << from << " to " << fileName;
+
+    while (1)
+    {
+        steady_clock::time_point poll = steady_clock::now();
+
+        response.Reset();
+
+        if (curl_easy_perform(curl) == CURLE_OK && response.len
+            && last.compare(0, std::string::npos, response.ptr, response.len))
+        {
+            last.assign(response.ptr, response.len);
+
+            WriteCandidate(
+                out, duration_cast<milliseconds>(poll - start).count(), last
+            );
+
+            LOG(INFO) << "Recorded candidate " << ++records;
+        }
+
+        std::this_thread::sleep_until(
+            poll + milliseconds(CANDIDATES_POLL_MS)
+        );
+    }
+
+    curl_easy_cleanup(curl);
+    fclose(out);
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Read recorded candidate stream
+////////////////////////////////////////////////////////////////////////////////
+int ReadCandidates(const char * fileName, std::vector<candidate_t> * stream)
+{
+    FILE * in = fopen(fileName, "rb");
+
+    if (!in)
+    {
+        LOG(ERROR) << "Cannot open candidate record " << fileName;
+        return EXIT_FAILURE;
+    }
+
+    long long ms;
+    size_t len;
+
+    stream->clear();
+
+    while (fscanf(in, "T %lld %zu", &ms, &len) == 2 && fgetc(in) == '\n')
+    {
+        candidate_t candidate;
+
+        candidate.ms = ms;
+        candidate.body.resize(len);
+
+        // recorder stopped in the middle of a record
+        if (fread(&candidate.body[0], 1, len, in) != len || fgetc(in) != '\n')
+        {
+            break;
+        }
+
+        stream->push_back(candidate);
+    }
+
+    fclose(in);
+
+    if (stream->empty())
+    {
+        LOG(ERROR) << "No candidates in record " << fileName;
+        return EXIT_FAILURE;
+    }
+
+    LOG(INFO) << "Read " << stream->size() << " candidates over "
+        << (stream->back().ms - stream->front().ms) / 1000 << " s";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Serve recorded candidate stream at speed times real time
+////////////////////////////////////////////////////////////////////////////////
+int ServeCandidates(
+    const std::vector<candidate_t> & stream,
+    const double speed,
+    const int port
+)
+{
+    std::mutex mutex;
+    steady_clock::time_point start = steady_clock::now();
+
+    replay_t replay(stream, speed);
+
+    // real time in ms since start
+    auto now = [&](void) -> double
+    {
+        return duration<double, std::milli>(
+            steady_clock::now() - start
+        ).count();
+    };
+
+    httplib::Server svr;
+
+    svr.Get(
+        "/mining/candidate",
+        [&](const httplib::Request & req, httplib::Response & res)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            int ind = replay.Poll(now());
+
+            res.set_content(stream[ind].body, "application/json");
+        }
+    );
+
+    svr.Post(
+        "/mining/solution",
+        [&](const httplib::Request & req, httplib::Response & res)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            replay.Post(now());
+
+            LOG(INFO) << "Solution posted: " << req.body;
+
+            res.set_content("{}", "application/json");
+        }
+    );
+
+    svr.Get(
+        "/stats",
+        [&](const httplib::Request & req, httplib::Response & res)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            std::stringstream strBuf;
+
+            strBuf << "{ \"speed\": " << speed
+                << ", \"polls\": " << replay.polls
+                << ", \"pollsPerSec\": " << replay.polls * 1000.0 / now()
+                << ", \"switches\": " << replay.switches
+                << ", \"switchLatencyMs\": "
+                << ((replay.switches)?
+                    replay.latencySum / replay.switches: 0)
+                << ", \"maxSwitchLatencyMs\": " << replay.latencyMax
+                << ", \"solutions\": " << replay.solutions
+                << ", \"staleSolutions\": " << replay.stale << " }";
+
+            res.set_content(strBuf.str(), "application/json");
+        }
+    );
+
+    LOG(INFO) << "Serving " << stream.size() << " candidates at " << speed
+        << "x speed on port " << port;
+
+    if (!svr.listen("0.0.0.0", port))
+    {
+        LOG(ERROR) << "Cannot listen on port " << port;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// candidates.cc
@@ -0,0 +1,638 @@
+// cpubackend.cc
+
+/*******************************************************************************
+
+    CPUBACKEND -- Host CPU device backend
+
+*******************************************************************************/
+
+#include "../include/backend.h"
+#include "../include/definitions.h"
+#include "../include/easylogging++.h"
+#include "../include/hostmining.h"
+#include "../include/hostmodq.h"
+#include "../include/hostprehash.h"
+#include "../include/hugepages.h"
+#include "../include/sharedtable.h"
+#include "../include/topology.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//  Worker threads placed once, every step splits an index range among them
+////////////////////////////////////////////////////////////////////////////////
+struct worker_pool_t
+{
+    typedef std::function<void(int, uint32_t, uint32_t)> step_t;
+
+    std::mutex mutex;
+    std::condition_variable work;
+    std::condition_variable done;
+    std::vector<std::thread> workers;
+    // current step, its index range and workers still running it
+    step_t func;
+    uint32_t count;
+    uint64_t step;
+    int running;
+    int finished;
+
+    worker_pool_t(void): count(0), step(0), running(0), finished(0) {}
+    ~worker_pool_t(void) { Stop(); }
+
+    // start threads, each one calls place once before its first step
+    void Start(const int threads, std::function<void(int)> place);
+
+    // run step on [0, count) split between threads, block until done
+    void Run(const uint32_t n, step_t f);
+
+    // join threads
+    void Stop(void);
+
+private:
+    void Work(const int t, std::function<void(int)> place);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//  Start threads
+////////////////////////////////////////////////////////////////////////////////
+void worker_pool_t::Start(const int threads, std::function<void(int)> place)
+{
+    Stop();
+
+    finished = 0;
+
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.push_back(std::thread(&worker_pool_t::Work, this, t, place));
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Run step split between threads
+////////////////////////////////////////////////////////////////////////////////
+void worker_pool_t::Run(const uint32_t n, step_t f)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    func = f;
+    count = n;
+    running = (int)workers.size();
+    ++step;
+
+    work.notify_all();
+    done.wait(lock, [&] { return !running; });
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Join threads
+////////////////////////////////////////////////////////////////////////////////
+void worker_pool_t::Stop(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        finished = 1;
+        work.notify_all();
+    }
+
+    for (size_t t = 0; t < workers.size(); ++t) { workers[t].join(); }
+
+    workers.clear();
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Worker thread
+////////////////////////////////////////////////////////////////////////////////
+void worker_pool_t::Work(const int t, std::function<void(int)> place)
+{
+    uint64_t seen = 0;
+
+    place(t);
+
+    while (1)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        work.wait(lock, [&] { return finished || step != seen; });
+
+        if (finished) { return; }
+
+        seen = step;
+
+        uint32_t threads = (uint32_t)workers.size();
+        uint32_t chunk = (count + threads - 1) / threads;
+        uint32_t from = t * chunk;
+        uint32_t to = (from + chunk < count)? from + chunk: count;
+        step_t f = func;
+
+        lock.unlock();
+
+        if (from < to) { f(t, from, to); }
+
+        lock.lock();
+
+        if (!--running) { done.notify_all(); }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  CPU device backend
+////////////////////////////////////////////////////////////////////////////////
+struct cpu_backend_t: backend_t
+{
+    int deviceId;
+    int threads;
+    int keepPrehash;
+    int replicate;
+    int shared;
+    char sharedName[64];
+    char name[64];
+
+    // pk || mes || w
+    uint8_t pnp[2 * PK_SIZE_8 + NUM_SIZE_8];
+    uint32_t bound[NUM_SIZE_32];
+    uint32_t sk[NUM_SIZE_32];
+    uint32_t x[NUM_SIZE_32];
+
+    // precalculated hashes
+    uint32_t * hashes;
+    huge_buffer_t hashesBuffer;
+    // prehash contexts shared between processes and their generation
+    shared_table_t table;
+    uint64_t generation;
+    // NUMA nodes holding hashes replicas, hashes on the first one
+    numa_t numa;
+    int nodes;
+    int copies;
+    uint32_t * replicas[MAX_NUMA_NODES];
+    huge_buffer_t replicaBuffers[MAX_NUMA_NODES];
+    // CPUs, node and rank in node of every thread, threads of node
+    std::vector<std::vector<int> > threadCpus;
+    std::vector<int> threadNode;
+    std::vector<int> threadRank;
+    int nodeThreads[MAX_NUMA_NODES];
+    // unfinalized hash contexts
+    uctx_t * uctxs;
+    huge_buffer_t uctxsBuffer;
+    // threads of all steps, placed on their CPUs once
+    worker_pool_t pool;
+    // hash context
+    ctx_t ctx;
+
+    // result of the last iteration
+    uint32_t ind;
+    uint32_t res[NUM_SIZE_32];
+
+    cpu_backend_t(
+        const int id,
+        const info_t * info,
+        const std::vector<int> * cpus
+    );
+    ~cpu_backend_t(void);
+
+    const char * Name(void) { return name; }
+
+    int Allocate(int * keep);
+    int SetKeys(const uint8_t * pk, const uint8_t * seckey);
+    int UncompletePrehash(void);
+
+    int SetBlock(
+        const uint8_t * mes,
+        const uint8_t * bnd,
+        const uint8_t * onetimesk,
+        const uint8_t * w
+    );
+
+    int SetBound(const uint8_t * bnd)
+    {
+        memcpy(bound, bnd, NUM_SIZE_8);
+        return EXIT_SUCCESS;
+    }
+
+    int Prehash(void);
+    int Replicate(void);
+    int Mine(const uint64_t base);
+    int GetResult(uint32_t * valid, uint8_t * result);
+
+    // run calling worker thread on its CPUs
+    void Place(const int t);
+};
+
+cpu_backend_t::cpu_backend_t(
+    const int id,
+    const info_t * info,
+    const std::vector<int> * cpus
+)
+{
+    // placed threads default to one per CPU given
+    int placed = cpus && !cpus->empty();
+
+    deviceId = id;
+    threads = (info->cpuThreads > 0)? info->cpuThreads
+        : (placed)? (int)cpus->size(): std::thread::hardware_concurrency();
+    if (threads <= 0) { threads = 1; }
+
+    // first device of builder process builds, others read its contexts
+    shared = (info->cpuShared == SHARED_BUILDER && id)?
+        SHARED_READER: info->cpuShared;
+    strcpy(sharedName, info->cpuSharedName);
+    generation = 0;
+
+    replicate = info->cpuNumaReplicate;
+    if (replicate) { numa.Read(); }
+
+    nodes = numa.count;
+    threadCpus.resize(threads);
+    threadNode.resize(threads);
+    threadRank.resize(threads);
+
+    for (int n = 0; n < nodes; ++n) { nodeThreads[n] = 0; }
+
+    // threads go to CPUs given or to nodes in contiguous groups
+    for (int t = 0; t < threads; ++t)
+    {
+        int n = (int)((int64_t)t * nodes / threads);
+
+        if (placed)
+        {
+            threadCpus[t].assign(1, (*cpus)[t % cpus->size()]);
+            n = numa.NodeOf(threadCpus[t][0]);
+        }
+        else if (nodes > 1)
+        {
+            threadCpus[t] = numa.cpus[n];
+        }
+
+        threadNode[t] = n;
+        threadRank[t] = nodeThreads[n]++;
+    }
+
+    copies = 0;
+    keepPrehash = 0;
+    hashes = NULL;
+    uctxs = NULL;
+    ind = 0;
+    blockDim = maxBlockDim = 1;
+
+    snprintf(name, sizeof(name), "CPU %i threads", threads);
+}
+
+cpu_backend_t::~cpu_backend_t(void)
+{
+    pool.Stop();
+
+    for (int n = 1; n < nodes; ++n) { replicaBuffers[n].Free(); }
+
+    hashesBuffer.Free();
+    uctxsBuffer.Free();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Memory allocation
+////////////////////////////////////////////////////////////////////////////////
+int cpu_backend_t::Allocate(int * keep)
+{
+    LOG(INFO) << "CPU " << deviceId << " allocating memory";
+
+    // pages touched first by placed threads stay on their nodes
+    pool.Start(threads, [this](int t) { Place(t); });
+
+    // N_LEN * NUM_SIZE_8 bytes // 2 GiB
+    hashes = (uint32_t *)hashesBuffer.Allocate((size_t)N_LEN * NUM_SIZE_8);
+
+    if (!hashes)
+    {
+        LOG(ERROR) << "Not enough host memory for mining,"
+            << " minimum 2 GiB needed";
+
+        return EXIT_FAILURE;
+    }
+
+    LOG(INFO) << "CPU " << deviceId << " hashes on "
+        << hashesBuffer.PageName() << ", multiplied modulo Q by "
+        << ModQEngineName(ModQBestEngine()) << " code";
+
+    // hashes are completed from shared contexts with the own key pair
+    if (shared != SHARED_NONE)
+    {
+        if (table.Open(sharedName, shared, PREHASH_MEMORY_8) != EXIT_SUCCESS)
+        {
+            return EXIT_FAILURE;
+        }
+
+        uctxs = table.uctxs;
+        *keep = 1;
+
+        LOG(INFO) << "CPU " << deviceId
+            << ((shared == SHARED_BUILDER)? " builds": " reads")
+            << " shared prehash contexts " << sharedName;
+    }
+
+    copies = 0;
+
+    for (int n = 0; n < nodes; ++n)
+    {
+        replicas[n] = hashes;
+        copies += n && nodeThreads[n];
+    }
+
+    if (replicate && !copies)
+    {
+        LOG(INFO) << "CPU " << deviceId << " single NUMA node in use,"
+            << " hashes are not replicated";
+    }
+    else if (copies)
+    {
+        // placement by first touch is kept if binding is not permitted
+        if (BindMemory(hashes, hashesBuffer.size, numa.ids[0]))
+        {
+            LOG(WARNING) << "CPU " << deviceId << " cannot bind memory"
+                << " to NUMA nodes, pages are placed on first touch";
+        }
+
+        for (int n = 1; n < nodes; ++n)
+        {
+            if (!nodeThreads[n]) { continue; }
+
+            replicas[n] = (uint32_t *)replicaBuffers[n].Allocate(
+                (size_t)N_LEN * NUM_SIZE_8
+            );
+
+            if (!replicas[n])
+            {
+                LOG(WARNING) << "Not enough host memory for hashes replica"
+                    << " on NUMA node " << numa.ids[n]
+                    << ", its threads read node " << numa.ids[0];
+
+                replicas[n] = hashes;
+            }
+            else
+            {
+                BindMemory(replicas[n], replicaBuffers[n].size, numa.ids[n]);
+            }
+        }
+
+        LOG(INFO) << "CPU " << deviceId << " hashes replicated on "
+            << copies + 1 << " NUMA nodes";
+    }
+
+    // N_LEN * 64 bytes // 4 GiB
+    if (*keep && shared == SHARED_NONE)
+    {
+        uctxs = (uctx_t *)uctxsBuffer.Allocate((size_t)N_LEN * sizeof(uctx_t));
+
+        if (!uctxs)
+        {
+            LOG(ERROR) << "Not enough memory for keeping prehashes, "
+                       << "setting keepPrehash to false";
+
+            *keep = 0;
+        }
+        else
+        {
+            LOG(INFO) << "CPU " << deviceId << " prehashes on "
+                << uctxsBuffer.PageName();
+        }
+    }
+
+    keepPrehash = *keep;
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Key-pair setting
+////////////////////////////////////////////////////////////////////////////////
+int cpu_backend_t::SetKeys(const uint8_t * pk, const uint8_t * seckey)
+{
+    memcpy(pnp, pk, PK_SIZE_8);
+    memcpy(sk, seckey, NUM_SIZE_8);
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Unfinalized hash contexts precalculation
+////////////////////////////////////////////////////////////////////////////////
+int cpu_backend_t::UncompletePrehash(void)
+{
+    // contexts depend on public key only, they are built once for it
+    if (shared == SHARED_READER)
+    {
+        return table.Acquire(pnp, &generation, SHARED_WAIT_MS);
+    }
+
+    if (shared == SHARED_BUILDER)
+    {
+        if (table.Published(pnp, &generation))
+        {
+            LOG(INFO) << "CPU " << deviceId << " shared prehash contexts "
+                << sharedName << " are already built";
+
+            return EXIT_SUCCESS;
+        }
+
+        table.BeginWrite();
+    }
+
+    pool.Run(
+        N_LEN,
+        [this](int, uint32_t from, uint32_t to)
+        {
+            for (uint32_t i = from; i < to; ++i)
+            {
+                HostUncompleteInitPrehash(pnp, i, uctxs + i);
+            }
+        }
+    );
+
+    if (shared == SHARED_BUILDER) { table.Publish(pnp); }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Block data setting
+////////////////////////////////////////////////////////////////////////////////
+int cpu_backend_t::SetBlock(
+    const uint8_t * mes,
+    const uint8_t * bnd,
+    const uint8_t * onetimesk,
+    const uint8_t * w
+)
+{
+    memcpy(pnp + PK_SIZE_8, mes, NUM_SIZE_8);
+    memcpy(pnp + PK_SIZE_8 + NUM_SIZE_8, w, PK_SIZE_8);
+    memcpy(bound, bnd, NUM_SIZE_8);
+    memcpy(x, onetimesk, NUM_SIZE_8);
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Hashes precalculation
+////////////////////////////////////////////////////////////////////////////////
+int cpu_backend_t::Prehash(void)
+{
+    uint8_t * mes = pnp + PK_SIZE_8;
+
+    pool.Run(
+        N_LEN,
+        [this](int, uint32_t from, uint32_t to)
+        {
+            HostPrehash(keepPrehash, pnp, x, uctxs, hashes, from, to);
+        }
+    );
+
+    // builder of another public key rewrote contexts meanwhile
+    if (shared == SHARED_READER && !table.Valid(generation))
+    {
+        LOG(ERROR) << "CPU " << deviceId << " shared prehash contexts "
+            << sharedName << " changed during prehash";
+
+        return EXIT_FAILURE;
+    }
+
+    // calculate unfinalized hash of message
+    InitMining(&ctx, (uint32_t *)mes, NUM_SIZE_8);
+
+    return (copies)? Replicate(): EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Hashes copy to NUMA nodes by threads of every node
+////////////////////////////////////////////////////////////////////////////////
+int cpu_backend_t::Replicate(void)
+{
+    using namespace std::chrono;
+
+    steady_clock::time_point start = steady_clock::now();
+
+    pool.Run(
+        threads,
+        [this](int t, uint32_t, uint32_t)
+        {
+            int n = threadNode[t];
+
+            if (!n || replicas[n] == hashes) { return; }
+
+            int k = threadRank[t];
+            size_t from = (size_t)N_LEN * k / nodeThreads[n];
+            size_t to = (size_t)N_LEN * (k + 1) / nodeThreads[n];
+
+            memcpy(
+                replicas[n] + from * NUM_SIZE_32,
+                hashes + from * NUM_SIZE_32, (to - from) * NUM_SIZE_8
+            );
+        }
+    );
+
+    double ms = duration_cast<microseconds>(
+        steady_clock::now() - start
+    ).count() / 1e3;
+
+    int done = 0;
+
+    for (int n = 1; n < nodes; ++n) { done += replicas[n] != hashes; }
+
+    LOG(INFO) << "CPU " << deviceId << " hashes replicated to " << done
+        << " NUMA nodes in " << ms << " ms, "
+        << (ms > 0? done * (double)N_LEN * NUM_SIZE_8 / ms / 1e6: 0)
+        << " GB/s";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Mining iteration
+////////////////////////////////////////////////////////////////////////////////
+int cpu_backend_t::Mine(const uint64_t base)
+{
+    std::vector<uint32_t> valid(threads, 0);
+    std::vector<uint32_t> results(threads * NUM_SIZE_32);
+
+    pool.Run(
+        noncesPerIter,
+        [&](int t, uint32_t from, uint32_t to)
+        {
+            // threads read the replica of their node
+            HostBlockMining(
+                bound, sk, &ctx, base + from, to - from,
+                replicas[threadNode[t]],
+                results.data() + t * NUM_SIZE_32, &valid[t]
+            );
+
+            if (valid[t]) { valid[t] += from; }
+        }
+    );
+
+    // keep the solution with the smallest nonce
+    ind = 0;
+
+    for (int t = 0; t < threads; ++t)
+    {
+        if (valid[t])
+        {
+            ind = valid[t];
+            memcpy(res, results.data() + t * NUM_SIZE_32, NUM_SIZE_8);
+
+            break;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Mining iteration result
+////////////////////////////////////////////////////////////////////////////////
+int cpu_backend_t::GetResult(uint32_t * valid, uint8_t * result)
+{
+    *valid = ind;
+
+    if (ind)
+    {
+        memcpy(result, res, NUM_SIZE_8);
+        ind = 0;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Run calling worker thread on its CPUs
+////////////////////////////////////////////////////////////////////////////////
+void cpu_backend_t::Place(const int t)
+{
+    // affinity is a hint, results are the same on any CPU
+    if (!threadCpus[t].empty()) { RunOnCpus(threadCpus[t]); }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Create CPU backend
+////////////////////////////////////////////////////////////////////////////////
+backend_t * CreateCpuBackend(
+    const int deviceId,
+    const info_t * info,
+    const std::vector<int> * cpus
+)
+{
+    return new cpu_backend_t(deviceId, info, cpus);
+}
+
+// cpubackend.cc
@@ -0,0 +1,406 @@
+// cudabackend.cu
+
+/*******************************************************************************
+
+    CUDABACKEND -- CUDA device backend
+
+*******************************************************************************/
+
+#include "../include/backend.h"
+#include "../include/definitions.h"
+#include "../include/easylogging++.h"
+#include "../include/mining.h"
+#include "../include/prehash.h"
+#include "../include/watchdog.h"
+#include <cuda.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+////////////////////////////////////////////////////////////////////////////////
+//  CUDA device backend
+////////////////////////////////////////////////////////////////////////////////
+struct cuda_backend_t: backend_t
+{
+    int deviceId;
+    int keepPrehash;
+    char name[256];
+
+    // boundary for puzzle
+    uint32_t * bound_d;
+    // data: pk || mes || w || padding || x || sk || ctx
+    uint32_t * data_d;
+    // precalculated hashes
+    uint32_t * hashes_d;
+    // place to handle result of the puzzle
+    uint32_t * res_d;
+    // place to handle nonce if solution is found
+    uint32_t * indices_d;
+    // unfinalized hash contexts
+    uctx_t * uctxs_d;
+    // completion of the last launched work
+    cudaEvent_t done;
+    int hasEvent;
+
+    // hash context
+    ctx_t ctx_h;
+    uint8_t mes_h[NUM_SIZE_8];
+
+    cuda_backend_t(const int id);
+    ~cuda_backend_t(void);
+
+    const char * Name(void) { return name; }
+
+    int Allocate(int * keep);
+    int SetKeys(const uint8_t * pk, const uint8_t * sk);
+    int UncompletePrehash(void);
+
+    int SetBlock(
+        const uint8_t * mes,
+        const uint8_t * bound,
+        const uint8_t * x,
+        const uint8_t * w
+    );
+
+    int SetBound(const uint8_t * bound);
+    int Prehash(void);
+    int Mine(const uint64_t base);
+    int GetResult(uint32_t * ind, uint8_t * res);
+
+    sensor_t * CreateSensor(void);
+
+    // wait for launched work, fail if it took longer than timeout
+    int Wait(const int timeoutMs);
+};
+
+cuda_backend_t::cuda_backend_t(const int id)
+{
+    deviceId = id;
+    keepPrehash = 0;
+    bound_d = NULL;
+    data_d = NULL;
+    hashes_d = NULL;
+    res_d = NULL;
+    indices_d = NULL;
+    uctxs_d = NULL;
+    hasEvent = 0;
+
+    cudaDeviceProp props;
+
+    if (cudaGetDeviceProperties(&props, deviceId) == cudaSuccess)
+    {
+        snprintf(name, sizeof(name), "%s", props.name);
+        maxBlockDim = props.maxThreadsPerBlock;
+    }
+    else
+    {
+        snprintf(name, sizeof(name), "CUDA device %i", deviceId);
+    }
+}
+
+// device is reset, so that a failed or hung context is destroyed and the
+// next backend of this device starts clean
+cuda_backend_t::~cuda_backend_t(void)
+{
+    if (cudaSetDevice(deviceId) != cudaSuccess) { return; }
+
+    if (hasEvent) { cudaEventDestroy(done); }
+    if (bound_d) { cudaFree(bound_d); }
+    if (hashes_d) { cudaFree(hashes_d); }
+    if (res_d) { cudaFree(res_d); }
+    if (uctxs_d) { cudaFree(uctxs_d); }
+
+    cudaDeviceReset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Wait for launched work, fail if it took longer than timeout
+////////////////////////////////////////////////////////////////////////////////
+int cuda_backend_t::Wait(const int timeoutMs)
+{
+    using namespace std::chrono;
+
+    CUDA_CHECK(cudaEventRecord(done));
+
+    steady_clock::time_point start = steady_clock::now();
+
+    // thread sleeps until the event is woken by the driver, a device
+    // which never gets there is reported by the liveness check
+    cudaError_t status = cudaEventSynchronize(done);
+
+    if (status != cudaSuccess)
+    {
+        LOG(ERROR) << "GPU " << deviceId << " failed: "
+            << cudaGetErrorString(status);
+
+        return EXIT_FAILURE;
+    }
+
+    int64_t ms = duration_cast<milliseconds>(
+        steady_clock::now() - start
+    ).count();
+
+    if (ms > timeoutMs)
+    {
+        LOG(ERROR) << "GPU " << deviceId << " responded in " << ms
+            << " ms, limit is " << timeoutMs << " ms";
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Memory check and allocation
+////////////////////////////////////////////////////////////////////////////////
+int cuda_backend_t::Allocate(int * keep)
+{
+    CUDA_CHECK(cudaSetDevice(deviceId));
+    CUDA_CHECK(cudaSetDeviceFlags(cudaDeviceScheduleBlockingSync));
+
+    CUDA_CHECK(cudaEventCreateWithFlags(
+        &done, cudaEventBlockingSync | cudaEventDisableTiming
+    ));
+    hasEvent = 1;
+
+    //========================================================================//
+    //  Check GPU memory
+    //========================================================================//
+    size_t freeMem;
+    size_t totalMem;
+
+    CUDA_CHECK(cudaMemGetInfo(&freeMem, &totalMem));
+
+    if (freeMem < MIN_FREE_MEMORY)
+    {
+        LOG(ERROR) << "Not enough GPU memory for mining, minimum "
+            << (MIN_FREE_MEMORY >> 20) << " MiB needed";
+
+        return EXIT_FAILURE;
+    }
+
+    if (*keep && freeMem < MIN_FREE_MEMORY_PREHASH)
+    {
+        LOG(ERROR) << "Not enough memory for keeping prehashes, "
+                   << "setting keepPrehash to false";
+
+        *keep = 0;
+    }
+
+    keepPrehash = *keep;
+
+    //========================================================================//
+    //  Device memory allocation
+    //========================================================================//
+    LOG(INFO) << "GPU " << deviceId << " allocating memory";
+
+    // (2 * PK_SIZE_8 + 2 + 4 * NUM_SIZE_8 + 212 + 4) bytes // ~0 MiB
+    CUDA_CHECK(cudaMalloc(&bound_d, NUM_SIZE_8 + DATA_SIZE_8));
+    data_d = bound_d + NUM_SIZE_32;
+
+    // N_LEN * NUM_SIZE_8 bytes // 2 GiB
+    CUDA_CHECK(cudaMalloc(&hashes_d, (uint32_t)N_LEN * NUM_SIZE_8));
+
+    CUDA_CHECK(cudaMalloc(&res_d, NUM_SIZE_8 + sizeof(uint32_t)));
+    indices_d = res_d + NUM_SIZE_32;
+
+    CUDA_CHECK(cudaMemset(indices_d, 0, sizeof(uint32_t)));
+
+    // if keepPrehash == true // N_LEN * 64 bytes // 4 GiB
+    if (keepPrehash)
+    {
+        CUDA_CHECK(cudaMalloc(&uctxs_d, (uint32_t)N_LEN * sizeof(uctx_t)));
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Key-pair transfer form host to device
+////////////////////////////////////////////////////////////////////////////////
+int cuda_backend_t::SetKeys(const uint8_t * pk, const uint8_t * sk)
+{
+    // copy public key
+    CUDA_CHECK(cudaMemcpy(data_d, pk, PK_SIZE_8, cudaMemcpyHostToDevice));
+
+    // copy secret key
+    CUDA_CHECK(cudaMemcpy(
+        data_d + COUPLED_PK_SIZE_32 + 2 * NUM_SIZE_32, sk, NUM_SIZE_8,
+        cudaMemcpyHostToDevice
+    ));
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Unfinalized hash contexts precalculation
+////////////////////////////////////////////////////////////////////////////////
+int cuda_backend_t::UncompletePrehash(void)
+{
+    UncompleteInitPrehash<<<1 + (N_LEN - 1) / BLOCK_DIM, BLOCK_DIM>>>(
+        data_d, uctxs_d
+    );
+
+    CUDA_CHECK(cudaPeekAtLastError());
+
+    return Wait(WATCHDOG_PREHASH_TIMEOUT_MS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Block data transfer from host to device
+////////////////////////////////////////////////////////////////////////////////
+int cuda_backend_t::SetBlock(
+    const uint8_t * mes,
+    const uint8_t * bound,
+    const uint8_t * x,
+    const uint8_t * w
+)
+{
+    memcpy(mes_h, mes, NUM_SIZE_8);
+
+    // copy boundary
+    CUDA_CHECK(cudaMemcpy(bound_d, bound, NUM_SIZE_8, cudaMemcpyHostToDevice));
+
+    // copy message
+    CUDA_CHECK(cudaMemcpy(
+        ((uint8_t *)data_d + PK_SIZE_8), mes, NUM_SIZE_8,
+        cudaMemcpyHostToDevice
+    ));
+
+    // copy one time secret key
+    CUDA_CHECK(cudaMemcpy(
+        (data_d + COUPLED_PK_SIZE_32 + NUM_SIZE_32), x, NUM_SIZE_8,
+        cudaMemcpyHostToDevice
+    ));
+
+    // copy one time public key
+    CUDA_CHECK(cudaMemcpy(
+        ((uint8_t *)data_d + PK_SIZE_8 + NUM_SIZE_8), w, PK_SIZE_8,
+        cudaMemcpyHostToDevice
+    ));
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Bound transfer from host to device
+////////////////////////////////////////////////////////////////////////////////
+int cuda_backend_t::SetBound(const uint8_t * bound)
+{
+    CUDA_CHECK(cudaMemcpy(bound_d, bound, NUM_SIZE_8, cudaMemcpyHostToDevice));
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Hashes precalculation
+////////////////////////////////////////////////////////////////////////////////
+int cuda_backend_t::Prehash(void)
+{
+    if (::Prehash(keepPrehash, data_d, uctxs_d, hashes_d, res_d) != EXIT_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    // calculate unfinalized hash of message
+    VLOG(1) << "Starting InitMining";
+    InitMining(&ctx_h, (uint32_t *)mes_h, NUM_SIZE_8);
+
+    if (Wait(WATCHDOG_PREHASH_TIMEOUT_MS) != EXIT_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    // copy context
+    CUDA_CHECK(cudaMemcpy(
+        data_d + COUPLED_PK_SIZE_32 + 3 * NUM_SIZE_32, &ctx_h, sizeof(ctx_t),
+        cudaMemcpyHostToDevice
+    ));
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Mining iteration start
+////////////////////////////////////////////////////////////////////////////////
+int cuda_backend_t::Mine(const uint64_t base)
+{
+    uint32_t threads = noncesPerIter / NONCES_PER_THREAD;
+
+    BlockMining<<<1 + (threads - 1) / blockDim, blockDim>>>(
+        bound_d, data_d, base, noncesPerIter, hashes_d, res_d, indices_d
+    );
+
+    // block size may exceed kernel resources
+    cudaError_t err = cudaGetLastError();
+
+    if (err != cudaSuccess)
+    {
+        LOG(ERROR) << "GPU " << deviceId << " BlockMining launch failed with "
+            << blockDim << " threads per block: " << cudaGetErrorString(err);
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Mining iteration result
+////////////////////////////////////////////////////////////////////////////////
+int cuda_backend_t::GetResult(uint32_t * ind, uint8_t * res)
+{
+    if (Wait(WATCHDOG_TIMEOUT_MS) != EXIT_SUCCESS) { return EXIT_FAILURE; }
+
+    CUDA_CHECK(cudaMemcpy(
+        ind, indices_d, sizeof(uint32_t), cudaMemcpyDeviceToHost
+    ));
+
+    if (*ind)
+    {
+        CUDA_CHECK(cudaMemcpy(res, res_d, NUM_SIZE_8, cudaMemcpyDeviceToHost));
+        CUDA_CHECK(cudaMemset(indices_d, 0, sizeof(uint32_t)));
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Device sensor
+////////////////////////////////////////////////////////////////////////////////
+sensor_t * cuda_backend_t::CreateSensor(void)
+{
+    char busId[32];
+
+    if (cudaDeviceGetPCIBusId(busId, sizeof(busId), deviceId) != cudaSuccess)
+    {
+        return NULL;
+    }
+
+    return CreateNvmlSensor(busId);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Number of CUDA devices
+////////////////////////////////////////////////////////////////////////////////
+int GetCudaDeviceCount(int * count)
+{
+    if (cudaGetDeviceCount(count) != cudaSuccess)
+    {
+        LOG(ERROR) << "Error checking GPU";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Create CUDA backend
+////////////////////////////////////////////////////////////////////////////////
+backend_t * CreateCudaBackend(const int deviceId)
+{
+    return new cuda_backend_t(deviceId);
+}
+
+// cudabackend.cu
@@ -9,6 +9,7 @@
 #include "../include/definitions.h"
 #include "../include/jsmn.h"
 #include <stddef.h>
+#include <thread>
 
 ////////////////////////////////////////////////////////////////////////////////
 //  Initialize JSON string
@@ -74,4 +75,73 @@ int json_t::jsoneq(const int pos, const char * str)
     return 0;
 }
 
+block_seqlock_t::block_seqlock_t(void)
+{
+    seq = 0;
+    reads = 0;
+    retries = 0;
+
+    for (unsigned i = 0; i < BLOCK_DATA_SIZE_64; ++i) { words[i] = 0; }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Publish block data snapshot
+////////////////////////////////////////////////////////////////////////////////
+void block_seqlock_t::Publish(const block_data_t * data)
+{
+    uint64_t buf[BLOCK_DATA_SIZE_64];
+    uint64_t s = seq.load(std::memory_order_relaxed);
+
+    memcpy(buf, data, sizeof(block_data_t));
+
+    // odd sequence is stored before any word
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (unsigned i = 0; i < BLOCK_DATA_SIZE_64; ++i)
+    {
+        words[i].store(buf[i], std::memory_order_relaxed);
+    }
+
+    seq.store(s + 2, std::memory_order_release);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Read consistent block data snapshot
+////////////////////////////////////////////////////////////////////////////////
+uint64_t block_seqlock_t::Read(block_data_t * data) const
+{
+    uint64_t buf[BLOCK_DATA_SIZE_64];
+
+    reads.fetch_add(1, std::memory_order_relaxed);
+
+    while (1)
+    {
+        uint64_t s = seq.load(std::memory_order_acquire);
+
+        if (!(s & 1))
+        {
+            for (unsigned i = 0; i < BLOCK_DATA_SIZE_64; ++i)
+            {
+                buf[i] = words[i].load(std::memory_order_relaxed);
+            }
+
+            // words are read before sequence is checked again
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (seq.load(std::memory_order_relaxed) == s)
+            {
+                memcpy(data, buf, sizeof(block_data_t));
+
+                return s;
+            }
+        }
+
+        retries.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::yield();
+    }
+}
+
 // definitions.cc
@@ -0,0 +1,284 @@
+// emulator.cc
+
+/*******************************************************************************
+
+    EMULATOR -- Local node stand-in with difficulty control
+
+*******************************************************************************/
+
+#include "../include/emulator.h"
+#include "../include/conversion.h"
+#include "../include/easylogging++.h"
+#include "../include/httplib.h"
+#include "../include/request.h"
+#include "../include/verify.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace std::chrono;
+
+// served candidate
+struct emulated_block_t
+{
+    uint8_t mes[NUM_SIZE_8];
+    uint8_t bound[NUM_SIZE_8];
+    std::string body;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//  Start with probability expected for hashrate
+////////////////////////////////////////////////////////////////////////////////
+bound_control_t::bound_control_t(const double target, const double hashrate)
+{
+    rate = target;
+    probability = rate / hashrate;
+    valid = 0;
+    validAtRetarget = 0;
+    retargetedSec = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Correct probability if retarget period passed
+////////////////////////////////////////////////////////////////////////////////
+int bound_control_t::Retarget(const double nowSec)
+{
+    double sec = nowSec - retargetedSec;
+
+    if (sec < EMULATOR_RETARGET_SEC) { return 0; }
+
+    double found = (double)(valid - validAtRetarget);
+    double factor = (found)? rate * sec / found: EMULATOR_MAX_RETARGET;
+
+    factor = std::min(
+        std::max(factor, 1 / EMULATOR_MAX_RETARGET), EMULATOR_MAX_RETARGET
+    );
+
+    probability = std::min(probability * factor, 1.0);
+
+    LOG(INFO) << "Found " << found / sec << " valid solutions/s, "
+        << "target " << rate << ", probability set to " << probability;
+
+    retargetedSec = nowSec;
+    validAtRetarget = valid;
+
+    return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Bound for probability of a nonce to be a solution
+////////////////////////////////////////////////////////////////////////////////
+void ProbabilityToBound(const double probability, uint8_t * bound)
+{
+    if (probability >= 1)
+    {
+        memset(bound, 0xFF, NUM_SIZE_8);
+        return;
+    }
+
+    // Q differs from 2^256 in the lowest 129 bits only
+    double p = (probability > 0)? probability: 0;
+
+    for (int i = NUM_SIZE_8 - 1; i >= 0; --i)
+    {
+        p *= 256;
+        bound[i] = (uint8_t)p;
+        p -= bound[i];
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Serve candidates for public key and verify solutions
+////////////////////////////////////////////////////////////////////////////////
+int EmulateNode(
+    // public key string
+    const char * pkstr,
+    // target valid solutions per second
+    const double rate,
+    // message rotation period
+    const double blockSec,
+    // expected total hashrate of miners
+    const double hashrate,
+    const int port
+)
+{
+    std::mutex mutex;
+    std::mt19937_64 generator(std::random_device{}());
+
+    emulated_block_t current;
+    emulated_block_t previous;
+
+    bound_control_t control(rate, hashrate);
+
+    uint64_t blocks = 0;
+    uint64_t solutions = 0;
+    uint64_t stale = 0;
+    uint64_t invalid = 0;
+
+    steady_clock::time_point start = steady_clock::now();
+    steady_clock::time_point rotated = start;
+
+    // new message, mutex is held
+    auto rotate = [&](void)
+    {
+        char mes[NUM_SIZE_4 + 1];
+        char bound[NUM_SIZE_8 * 3];
+        uint32_t len;
+
+        previous = current;
+
+        for (int i = 0; i < NUM_SIZE_8; i += 8)
+        {
+            uint64_t r = generator();
+            memcpy(current.mes + i, &r, 8);
+        }
+
+        ProbabilityToBound(control.probability, current.bound);
+
+        BigEndianToHexStr(current.mes, NUM_SIZE_8, mes);
+        LittleEndianOf256ToDecStr(current.bound, bound, &len);
+        bound[len] = '\0';
+
+        current.body = std::string("{\"msg\":\"") + mes + "\",\"b\":" + bound
+            + ",\"pk\":\"" + pkstr + "\"}";
+
+        rotated = steady_clock::now();
+        ++blocks;
+
+        VLOG(1) << "Emulated block " << blocks << ": " << current.body;
+    };
+
+    // rotation by schedule and difficulty correction, mutex is held
+    auto update = [&](void)
+    {
+        steady_clock::time_point now = steady_clock::now();
+
+        control.Retarget(duration<double>(now - start).count());
+
+        if (duration<double>(now - rotated).count() >= blockSec) { rotate(); }
+    };
+
+    rotate();
+    previous = current;
+
+    httplib::Server svr;
+
+    svr.Get(
+        "/mining/candidate",
+        [&](const httplib::Request & req, httplib::Response & res)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            update();
+
+            res.set_content(current.body, "application/json");
+        }
+    );
+
+    svr.Post(
+        "/mining/solution",
+        [&](const httplib::Request & req, httplib::Response & res)
+        {
+            uint8_t pk[PK_SIZE_8];
+            uint8_t w[PK_SIZE_8];
+            uint8_t nonce[NONCE_SIZE_8];
+            uint8_t d[NUM_SIZE_8];
+
+            emulated_block_t cur;
+            emulated_block_t prev;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                ++solutions;
+                cur = current;
+                prev = previous;
+            }
+
+            // verification runs outside the lock
+            int status
+                = ParseSolution(req.body.c_str(), pk, w, nonce, d);
+
+            int isValid = status == EXIT_SUCCESS && VerifySolution(
+                cur.mes, pk, w, nonce, d, cur.bound
+            ) == EXIT_SUCCESS;
+
+            int isStale = !isValid && status == EXIT_SUCCESS && VerifySolution(
+                prev.mes, pk, w, nonce, d, prev.bound
+            ) == EXIT_SUCCESS;
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (isValid)
+            {
+                ++control.valid;
+
+                LOG(INFO) << "Valid solution " << control.valid
+                    << " for block " << blocks;
+
+                // solution makes a block, unless it was already rotated
+                if (!memcmp(cur.mes, current.mes, NUM_SIZE_8)) { rotate(); }
+
+                res.set_content("{}", "application/json");
+            }
+            else
+            {
+                if (isStale) { ++stale; } else { ++invalid; }
+
+                LOG(INFO) << ((isStale)? "Stale": "Invalid")
+                    << " solution: " << req.body;
+
+                res.status = 400;
+                res.set_content(
+                    "{\"error\":400,\"reason\":\"invalid solution\"}",
+                    "application/json"
+                );
+            }
+        }
+    );
+
+    svr.Get(
+        "/stats",
+        [&](const httplib::Request & req, httplib::Response & res)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            double sec = duration<double>(steady_clock::now() - start).count();
+
+            std::stringstream strBuf;
+
+            strBuf << "{ \"blocks\": " << blocks
+                << ", \"solutions\": " << solutions
+                << ", \"valid\": " << control.valid
+                << ", \"stale\": " << stale
+                << ", \"invalid\": " << invalid
+                << ", \"validPerSec\": " << control.valid / sec
+                << ", \"targetPerSec\": " << rate
+                << ", \"probability\": " << control.probability << " }";
+
+            res.set_content(strBuf.str(), "application/json");
+        }
+    );
+
+    LOG(INFO) << "Emulating node on port " << port << ", " << rate
+        << " solutions/s at " << hashrate << " H/s, block every "
+        << blockSec << " s";
+
+    if (!svr.listen("0.0.0.0", port))
+    {
+        LOG(ERROR) << "Cannot listen on port " << port;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// emulator.cc
@@ -0,0 +1,912 @@
+// fanout.cc
+
+/*******************************************************************************
+
+    FANOUT -- Candidate fan-out proxy for miners of one site
+
+*******************************************************************************/
+
+#include "../include/fanout.h"
+#include "../include/conversion.h"
+#include "../include/easylogging++.h"
+#include "../include/processing.h"
+#include "../include/request.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#ifdef _WIN32
+#define SHUT_RDWR SD_BOTH
+#endif
+
+#define FANOUT_INVALID ((fanout_socket_t)-1)
+
+using namespace std::chrono;
+
+//============================================================================//
+//  Sockets
+//============================================================================//
+static void StartSockets(void)
+{
+#ifdef _WIN32
+    static std::once_flag started;
+
+    std::call_once(started, []
+    {
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+    });
+#endif
+
+    return;
+}
+
+static void CloseSocket(const fanout_socket_t fd)
+{
+#ifdef _WIN32
+    closesocket(fd);
+#else
+    close(fd);
+#endif
+
+    return;
+}
+
+// frames are small, they go out without Nagle delay
+static void SetNoDelay(const fanout_socket_t fd)
+{
+    int one = 1;
+
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (const char *)&one, sizeof(one));
+
+    return;
+}
+
+// stuck miner must not hold the poller
+static void SetSendTimeout(const fanout_socket_t fd, const int ms)
+{
+#ifdef _WIN32
+    DWORD timeout = ms;
+#else
+    struct timeval timeout;
+
+    timeout.tv_sec = ms / 1000;
+    timeout.tv_usec = (ms % 1000) * 1000;
+#endif
+
+    setsockopt(
+        fd, SOL_SOCKET, SO_SNDTIMEO, (const char *)&timeout, sizeof(timeout)
+    );
+
+    return;
+}
+
+static int SendAll(const fanout_socket_t fd, const uint8_t * buf, int len)
+{
+    while (len > 0)
+    {
+        int sent = send(fd, (const char *)buf, len, MSG_NOSIGNAL);
+
+        if (sent <= 0) { return EXIT_FAILURE; }
+
+        buf += sent;
+        len -= sent;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static int RecvAll(const fanout_socket_t fd, uint8_t * buf, int len)
+{
+    while (len > 0)
+    {
+        int got = recv(fd, (char *)buf, len, 0);
+
+        if (got <= 0) { return EXIT_FAILURE; }
+
+        buf += got;
+        len -= got;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Write frame in one send
+////////////////////////////////////////////////////////////////////////////////
+static int SendFrame(
+    const fanout_socket_t fd,
+    const int type,
+    const uint8_t * payload,
+    const int size
+)
+{
+    uint8_t buf[FANOUT_HEADER_SIZE + FANOUT_MAX_SIZE];
+
+    buf[0] = type;
+    buf[1] = 0;
+    buf[2] = size & 0xFF;
+    buf[3] = size >> 8;
+
+    memcpy(buf + FANOUT_HEADER_SIZE, payload, size);
+
+    return SendAll(fd, buf, FANOUT_HEADER_SIZE + size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Read frame, payload of unknown size is skipped
+////////////////////////////////////////////////////////////////////////////////
+static int ReadFrame(
+    const fanout_socket_t fd,
+    int * type,
+    uint8_t * payload,
+    int * size
+)
+{
+    uint8_t header[FANOUT_HEADER_SIZE];
+
+    if (RecvAll(fd, header, FANOUT_HEADER_SIZE) != EXIT_SUCCESS)
+    {
+        return EXIT_FAILURE;
+    }
+
+    *type = header[0];
+    *size = header[2] | (header[3] << 8);
+
+    if (*size <= FANOUT_MAX_SIZE) { return RecvAll(fd, payload, *size); }
+
+    // frame of a newer protocol version
+    uint8_t skip[256];
+
+    for (int left = *size; left > 0; left -= sizeof(skip))
+    {
+        int len = (left < (int)sizeof(skip))? left: sizeof(skip);
+
+        if (RecvAll(fd, skip, len) != EXIT_SUCCESS) { return EXIT_FAILURE; }
+    }
+
+    *type = 0;
+
+    return EXIT_SUCCESS;
+}
+
+static int64_t NowUs(void)
+{
+    return duration_cast<microseconds>(
+        steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+//============================================================================//
+//  Proxy side
+//============================================================================//
+fanout_server_t::fanout_server_t(void)
+{
+    listener = FANOUT_INVALID;
+    to[0] = '\0';
+    memset(&last, 0, sizeof(last));
+    detectedUs = 0;
+
+    polls = 0;
+    candidates = 0;
+    solutions = 0;
+    delivered = 0;
+    acks = 0;
+    latencySumUs = 0;
+    latencyMaxUs = 0;
+
+    closing = 0;
+    active = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Stop accepting and disconnect miners
+////////////////////////////////////////////////////////////////////////////////
+fanout_server_t::~fanout_server_t(void)
+{
+    closing = 1;
+
+    if (listener != FANOUT_INVALID) { shutdown(listener, SHUT_RDWR); }
+
+    if (acceptor.joinable()) { acceptor.join(); }
+
+    if (listener != FANOUT_INVALID) { CloseSocket(listener); }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (size_t i = 0; i < peers.size(); ++i)
+        {
+            shutdown(peers[i]->fd, SHUT_RDWR);
+        }
+    }
+
+    // reader threads use statistics until they finish
+    while (active.load())
+    {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Listen on port
+////////////////////////////////////////////////////////////////////////////////
+int fanout_server_t::Listen(const int port)
+{
+    struct sockaddr_in addr;
+    int one = 1;
+
+    StartSockets();
+
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (listener == FANOUT_INVALID)
+    {
+        LOG(ERROR) << "Cannot create proxy socket";
+        return EXIT_FAILURE;
+    }
+
+    setsockopt(
+        listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&one, sizeof(one)
+    );
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (
+        bind(listener, (struct sockaddr *)&addr, sizeof(addr))
+        || listen(listener, SOMAXCONN)
+    )
+    {
+        LOG(ERROR) << "Cannot listen for miners on port " << port;
+
+        CloseSocket(listener);
+        listener = FANOUT_INVALID;
+
+        return EXIT_FAILURE;
+    }
+
+    acceptor = std::thread(&fanout_server_t::Accept, this);
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Accept miners
+////////////////////////////////////////////////////////////////////////////////
+void fanout_server_t::Accept(void)
+{
+    el::Helpers::setThreadName("proxy acceptor");
+
+    while (!closing.load())
+    {
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+
+        fanout_socket_t fd = accept(listener, (struct sockaddr *)&addr, &len);
+
+        if (fd == FANOUT_INVALID)
+        {
+            if (!closing.load())
+            {
+                std::this_thread::sleep_for(milliseconds(100));
+            }
+
+            continue;
+        }
+
+        SetNoDelay(fd);
+        SetSendTimeout(fd, FANOUT_RETRY_MS);
+
+        std::shared_ptr<fanout_peer_t> peer(new fanout_peer_t);
+
+        peer->fd = fd;
+        peer->closed = 0;
+        peer->pushed = 0;
+        snprintf(
+            peer->name, sizeof(peer->name), "%s:%i", inet_ntoa(addr.sin_addr),
+            ntohs(addr.sin_port)
+        );
+
+        ++active;
+        std::thread(&fanout_server_t::Serve, this, peer).detach();
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Read frames of miner
+////////////////////////////////////////////////////////////////////////////////
+void fanout_server_t::Serve(std::shared_ptr<fanout_peer_t> peer)
+{
+    uint8_t payload[FANOUT_MAX_SIZE];
+    int type;
+    int size;
+
+    el::Helpers::setThreadName("proxy peer");
+
+    if (
+        ReadFrame(peer->fd, &type, payload, &size) != EXIT_SUCCESS
+        || type != FANOUT_HELLO || size != FANOUT_HELLO_SIZE
+        || payload[0] != FANOUT_VERSION
+    )
+    {
+        LOG(INFO) << "Miner " << peer->name << " did not say hello";
+
+        CloseSocket(peer->fd);
+        --active;
+
+        return;
+    }
+
+    memcpy(peer->pk, payload + 1, PK_SIZE_8);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        peers.push_back(peer);
+
+        // miner starts with the current candidate
+        if (last.seq)
+        {
+            fanout_candidate_t cand = last;
+            std::lock_guard<std::mutex> sendLock(peer->sendMutex);
+
+            SendFrame(
+                peer->fd, FANOUT_CANDIDATE, (const uint8_t *)&cand,
+                FANOUT_CAND_SIZE
+            );
+        }
+
+        LOG(INFO) << "Miner " << peer->name << " connected, "
+            << peers.size() << " miners";
+    }
+
+    while (ReadFrame(peer->fd, &type, payload, &size) == EXIT_SUCCESS)
+    {
+        if (type == FANOUT_ACK && size == FANOUT_ACK_SIZE)
+        {
+            uint64_t seq;
+            int64_t now = NowUs();
+
+            memcpy(&seq, payload, 8);
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            // candidates sent on connection are not counted
+            if (seq == last.seq && seq == peer->pushed.load())
+            {
+                double us = (double)(now - detectedUs);
+
+                ++acks;
+                latencySumUs += us;
+                if (us > latencyMaxUs) { latencyMaxUs = us; }
+            }
+        }
+        else if (type == FANOUT_SOLUTION && size == FANOUT_SOL_SIZE)
+        {
+            char pkstr[PK_SIZE_4 + 1];
+            uint8_t result[FANOUT_RESULT_SIZE];
+
+            ++solutions;
+
+            BigEndianToHexStr(peer->pk, PK_SIZE_8, pkstr);
+            pkstr[PK_SIZE_4] = '\0';
+
+            // id, w, nonce, d
+            int status = PostPuzzleSolution(
+                to, pkstr, payload + 8, payload + 8 + PK_SIZE_8,
+                payload + 8 + PK_SIZE_8 + NONCE_SIZE_8
+            );
+
+            if (status == EXIT_SUCCESS) { ++delivered; }
+
+            memcpy(result, payload, 8);
+            result[8] = (status == EXIT_SUCCESS)?
+                FANOUT_DELIVERED: FANOUT_FAILED;
+
+            std::lock_guard<std::mutex> sendLock(peer->sendMutex);
+
+            SendFrame(peer->fd, FANOUT_RESULT, result, FANOUT_RESULT_SIZE);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (size_t i = 0; i < peers.size(); ++i)
+        {
+            if (peers[i] == peer)
+            {
+                peers.erase(peers.begin() + i);
+                break;
+            }
+        }
+
+        LOG(INFO) << "Miner " << peer->name << " disconnected, "
+            << peers.size() << " miners";
+    }
+
+    {
+        std::lock_guard<std::mutex> sendLock(peer->sendMutex);
+
+        CloseSocket(peer->fd);
+        peer->closed = 1;
+    }
+
+    --active;
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Push candidate to all miners
+////////////////////////////////////////////////////////////////////////////////
+void fanout_server_t::Broadcast(const fanout_candidate_t * cand)
+{
+    std::vector<std::shared_ptr<fanout_peer_t> > targets;
+    uint8_t payload[FANOUT_CAND_SIZE];
+
+    memcpy(payload, cand, FANOUT_CAND_SIZE);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        last = *cand;
+        detectedUs = NowUs();
+        ++candidates;
+        targets = peers;
+    }
+
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        std::lock_guard<std::mutex> sendLock(targets[i]->sendMutex);
+
+        if (targets[i]->closed) { continue; }
+
+        // acknowledgement may come before send returns
+        targets[i]->pushed = cand->seq;
+
+        if (
+            SendFrame(
+                targets[i]->fd, FANOUT_CANDIDATE, payload, FANOUT_CAND_SIZE
+            ) != EXIT_SUCCESS
+        )
+        {
+            // reader thread drops the miner
+            shutdown(targets[i]->fd, SHUT_RDWR);
+        }
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Log statistics of period
+////////////////////////////////////////////////////////////////////////////////
+void fanout_server_t::Report(const double sec)
+{
+    uint64_t requests = polls.exchange(0);
+    uint64_t cands = candidates.exchange(0);
+    uint64_t sols = solutions.exchange(0);
+    uint64_t posted = delivered.exchange(0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    LOG(INFO) << "Proxy: " << requests << " upstream requests, "
+        << requests / sec << "/s, " << cands << " candidates to "
+        << peers.size() << " miners, " << sols << " solutions, " << posted
+        << " delivered, fan-out latency mean "
+        << ((acks)? latencySumUs / acks / 1000: 0) << " ms, max "
+        << latencyMaxUs / 1000 << " ms";
+
+    acks = 0;
+    latencySumUs = 0;
+    latencyMaxUs = 0;
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Public key of node candidate
+////////////////////////////////////////////////////////////////////////////////
+static int ReadCandidatePk(json_t * request, uint8_t * pk)
+{
+    jsmn_parser parser;
+
+    jsmn_init(&parser);
+
+    int numtoks = jsmn_parse(
+        &parser, request->ptr, request->len, request->toks, REQ_LEN
+    );
+
+    // keys are uppercased by ParseRequest
+    for (int i = 1; i + 1 < numtoks; i += 2)
+    {
+        if (
+            request->jsoneq(i, "PK") && request->GetTokenLen(i + 1) == PK_SIZE_4
+        )
+        {
+            HexStrToBigEndian(
+                request->GetTokenStart(i + 1), PK_SIZE_4, pk, PK_SIZE_8
+            );
+
+            return EXIT_SUCCESS;
+        }
+    }
+
+    return EXIT_FAILURE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Poll node for the site and serve candidates to miners
+////////////////////////////////////////////////////////////////////////////////
+int ServeFanout(const char * node, const int port, const int pollMs)
+{
+    static fanout_server_t server;
+    char from[MAX_URL_SIZE];
+    info_t info;
+    json_t request(0, REQ_LEN);
+    uint_t blockId = 0;
+    uint64_t seq = 0;
+
+    info.blockId = 0;
+    info.lockWaitNs = 0;
+    info.lockCount = 0;
+
+    snprintf(from, MAX_URL_SIZE, "%s/mining/candidate", node);
+    snprintf(server.to, MAX_URL_SIZE, "%s/mining/solution", node);
+
+    if (server.Listen(port) != EXIT_SUCCESS) { return EXIT_FAILURE; }
+
+    LOG(INFO) << "Proxying " << node << " to miners on port " << port
+        << ", polling every " << pollMs << " ms";
+
+    steady_clock::time_point reported = steady_clock::now();
+
+    while (1)
+    {
+        steady_clock::time_point start = steady_clock::now();
+
+        int status = GetLatestBlock(from, &request, &info, 0);
+
+        ++server.polls;
+
+        if (status == EXIT_SUCCESS && info.blockId.load() != blockId)
+        {
+            block_data_t block;
+            fanout_candidate_t cand;
+
+            blockId = info.blockId.load();
+            info.block.Read(&block);
+
+            cand.seq = ++seq;
+            cand.changed = block.changed;
+            memcpy(cand.mes, block.mes, NUM_SIZE_8);
+            memcpy(cand.bound, block.bound, NUM_SIZE_8);
+
+            if (ReadCandidatePk(&request, cand.pk) == EXIT_SUCCESS)
+            {
+                server.Broadcast(&cand);
+            }
+        }
+
+        steady_clock::time_point now = steady_clock::now();
+        double sec = duration<double>(now - reported).count();
+
+        if (sec >= FANOUT_REPORT_SEC)
+        {
+            server.Report(sec);
+            reported = now;
+        }
+
+        std::this_thread::sleep_until(start + milliseconds(pollMs));
+    }
+}
+
+//============================================================================//
+//  Miner side
+//============================================================================//
+fanout_client_t::fanout_client_t(void)
+{
+    host[0] = '\0';
+    port = FANOUT_PORT;
+    fd = FANOUT_INVALID;
+
+    nextId = 0;
+    answerId = 0;
+    answer = FANOUT_FAILED;
+    epoch = 0;
+
+    received = 0;
+    stopped = 0;
+}
+
+fanout_client_t::~fanout_client_t(void)
+{
+    Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Parse "host:port" of proxy
+////////////////////////////////////////////////////////////////////////////////
+int fanout_client_t::Init(const char * address)
+{
+    const char * colon = strrchr(address, ':');
+    size_t len = (colon)? (size_t)(colon - address): strlen(address);
+
+    if (!len || len >= MAX_URL_SIZE)
+    {
+        LOG(ERROR) << "Proxy address should be host:port";
+        return EXIT_FAILURE;
+    }
+
+    memcpy(host, address, len);
+    host[len] = '\0';
+    port = (colon)? atoi(colon + 1): FANOUT_PORT;
+
+    if (port <= 0 || port > 0xFFFF)
+    {
+        LOG(ERROR) << "Proxy address should be host:port";
+        return EXIT_FAILURE;
+    }
+
+    StartSockets();
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Connect to proxy
+////////////////////////////////////////////////////////////////////////////////
+static fanout_socket_t Connect(const char * host, const int port)
+{
+    struct addrinfo hints;
+    struct addrinfo * res = NULL;
+    char service[16];
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    snprintf(service, sizeof(service), "%i", port);
+
+    if (getaddrinfo(host, service, &hints, &res)) { return FANOUT_INVALID; }
+
+    fanout_socket_t fd = FANOUT_INVALID;
+
+    for (struct addrinfo * ai = res; ai; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+        if (fd == FANOUT_INVALID) { continue; }
+
+        if (!connect(fd, ai->ai_addr, ai->ai_addrlen)) { break; }
+
+        CloseSocket(fd);
+        fd = FANOUT_INVALID;
+    }
+
+    freeaddrinfo(res);
+
+    return fd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Receive candidates into block data
+////////////////////////////////////////////////////////////////////////////////
+void fanout_client_t::Run(info_t * info)
+{
+    uint8_t payload[FANOUT_MAX_SIZE];
+    int waiting = 0;
+    int type;
+    int size;
+
+    while (!stopped.load())
+    {
+        fanout_socket_t conn = Connect(host, port);
+
+        if (conn == FANOUT_INVALID)
+        {
+            if (!waiting)
+            {
+                LOG(INFO) << "Waiting for proxy " << host << ":" << port;
+                waiting = 1;
+            }
+
+            std::this_thread::sleep_for(milliseconds(FANOUT_RETRY_MS));
+
+            continue;
+        }
+
+        SetNoDelay(conn);
+
+        payload[0] = FANOUT_VERSION;
+        memcpy(payload + 1, info->pk, PK_SIZE_8);
+
+        {
+            std::lock_guard<std::mutex> sendLock(sendMutex);
+
+            fd = conn;
+            SendFrame(fd, FANOUT_HELLO, payload, FANOUT_HELLO_SIZE);
+
+            // stopped while connecting
+            if (stopped.load()) { shutdown(fd, SHUT_RDWR); }
+        }
+
+        LOG(INFO) << "Connected to proxy " << host << ":" << port;
+        waiting = 0;
+
+        while (ReadFrame(conn, &type, payload, &size) == EXIT_SUCCESS)
+        {
+            if (type == FANOUT_CANDIDATE && size == FANOUT_CAND_SIZE)
+            {
+                fanout_candidate_t cand;
+                block_data_t block;
+
+                memcpy(&cand, payload, FANOUT_CAND_SIZE);
+
+                if (memcmp(cand.pk, info->pk, PK_SIZE_8))
+                {
+                    LOG(ERROR) << "Proxy candidate is for another public key";
+                    exit(EXIT_FAILURE);
+                }
+
+                // candidate sent again after reconnection is not new
+                info->block.Read(&block);
+
+                int first = !info->blockId.load();
+
+                block.changed = 0;
+
+                if (first || memcmp(block.mes, cand.mes, NUM_SIZE_8))
+                {
+                    block.changed |= BLOCK_MES_CHANGED;
+                }
+
+                if (first || memcmp(block.bound, cand.bound, NUM_SIZE_8))
+                {
+                    block.changed |= BLOCK_BOUND_CHANGED;
+                }
+
+                if (block.changed)
+                {
+                    memcpy(block.mes, cand.mes, NUM_SIZE_8);
+                    memcpy(block.bound, cand.bound, NUM_SIZE_8);
+
+                    PublishBlock(info, &block);
+                }
+
+                ++received;
+
+                std::lock_guard<std::mutex> sendLock(sendMutex);
+
+                SendFrame(fd, FANOUT_ACK, (const uint8_t *)&cand.seq, 8);
+            }
+            else if (type == FANOUT_RESULT && size == FANOUT_RESULT_SIZE)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                memcpy(&answerId, payload, 8);
+                answer = payload[8];
+                answered.notify_all();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> sendLock(sendMutex);
+
+            CloseSocket(fd);
+            fd = FANOUT_INVALID;
+        }
+
+        // solution in flight is not answered on this connection
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            ++epoch;
+            answered.notify_all();
+        }
+
+        if (!stopped.load())
+        {
+            LOG(ERROR) << "Proxy connection lost";
+        }
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Post solution through proxy
+////////////////////////////////////////////////////////////////////////////////
+int fanout_client_t::PostSolution(
+    const uint8_t * w,
+    const uint8_t * nonce,
+    const uint8_t * d
+)
+{
+    uint8_t payload[FANOUT_SOL_SIZE];
+    uint64_t id;
+    uint64_t conn;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        id = ++nextId;
+        conn = epoch;
+    }
+
+    memcpy(payload, &id, 8);
+    memcpy(payload + 8, w, PK_SIZE_8);
+    memcpy(payload + 8 + PK_SIZE_8, nonce, NONCE_SIZE_8);
+    memcpy(payload + 8 + PK_SIZE_8 + NONCE_SIZE_8, d, NUM_SIZE_8);
+
+    {
+        std::lock_guard<std::mutex> sendLock(sendMutex);
+
+        if (
+            fd == FANOUT_INVALID
+            || SendFrame(fd, FANOUT_SOLUTION, payload, FANOUT_SOL_SIZE)
+            != EXIT_SUCCESS
+        )
+        {
+            LOG(ERROR) << "Solution was not delivered to proxy";
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    answered.wait_for(
+        lock, milliseconds(FANOUT_ANSWER_MS),
+        [&]{ return answerId == id || epoch != conn; }
+    );
+
+    if (answerId != id || answer != FANOUT_DELIVERED)
+    {
+        LOG(ERROR) << "Solution was not delivered to node by proxy";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Close connection
+////////////////////////////////////////////////////////////////////////////////
+void fanout_client_t::Stop(void)
+{
+    stopped = 1;
+
+    std::lock_guard<std::mutex> sendLock(sendMutex);
+
+    if (fd != FANOUT_INVALID) { shutdown(fd, SHUT_RDWR); }
+
+    return;
+}
+
+// fanout.cc
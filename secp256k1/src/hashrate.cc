@@ -0,0 +1,159 @@
+// hashrate.cc
+
+/*******************************************************************************
+
+    HASHRATE -- Per-device hashrate accounting
+
+*******************************************************************************/
+
+#include "../include/hashrate.h"
+#include "../include/easylogging++.h"
+#include <math.h>
+#include <stdlib.h>
+#include <chrono>
+
+////////////////////////////////////////////////////////////////////////////////
+//  Steady clock time in milliseconds
+////////////////////////////////////////////////////////////////////////////////
+int64_t hashrate_t::NowMs(void)
+{
+    using namespace std::chrono;
+
+    return duration_cast<milliseconds>(
+        steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Construct with no devices
+////////////////////////////////////////////////////////////////////////////////
+hashrate_t::hashrate_t(void)
+{
+    devices = 0;
+    head = 0;
+    count = 0;
+    clock = NowMs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Set number of devices and reset counters
+////////////////////////////////////////////////////////////////////////////////
+int hashrate_t::Init(const int n)
+{
+    if (n > HASHRATE_MAX_DEVICES)
+    {
+        LOG(ERROR) << "Too many devices, maximum is " << HASHRATE_MAX_DEVICES;
+        return EXIT_FAILURE;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    devices = n;
+    int64_t now = clock();
+
+    for (int i = 0; i < n; ++i)
+    {
+        counters[i].nonces = 0;
+        counters[i].updateMs = now;
+        counters[i].busy = 0;
+    }
+
+    samples.assign((size_t)HASHRATE_SAMPLES * n, 0);
+    sampleMs.assign(HASHRATE_SAMPLES, now);
+    ewma.assign(n, 0);
+
+    // first snapshot at zero
+    head = 0;
+    count = 1;
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Take snapshot of counters if sampling period passed
+////////////////////////////////////////////////////////////////////////////////
+void hashrate_t::Sample(void)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    int64_t now = clock();
+    int64_t dt = now - sampleMs[head];
+
+    if (dt < HASHRATE_SAMPLE_MS) { return; }
+
+    int prev = head;
+    head = (head + 1) % HASHRATE_SAMPLES;
+    if (count < HASHRATE_SAMPLES) { ++count; }
+
+    sampleMs[head] = now;
+
+    double alpha = -expm1(-dt / (1000.0 * HASHRATE_EWMA_SEC));
+
+    for (int i = 0; i < devices; ++i)
+    {
+        uint64_t n = counters[i].nonces.load(std::memory_order_relaxed);
+
+        samples[(size_t)head * devices + i] = n;
+
+        double rate = 1000.0 * (n - samples[(size_t)prev * devices + i]) / dt;
+
+        ewma[i] += alpha * (rate - ewma[i]);
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Rate over window in seconds
+////////////////////////////////////////////////////////////////////////////////
+double hashrate_t::Rate(const int device, const int windowSec)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (count < 2) { return 0; }
+
+    int64_t from = sampleMs[head] - 1000 * (int64_t)windowSec;
+
+    // find the latest snapshot not newer than window start, or the oldest
+    int k = head;
+
+    for (int i = 1; i < count; ++i)
+    {
+        k = (head - i + HASHRATE_SAMPLES) % HASHRATE_SAMPLES;
+
+        if (sampleMs[k] <= from) { break; }
+    }
+
+    int64_t dt = sampleMs[head] - sampleMs[k];
+
+    if (dt <= 0) { return 0; }
+
+    return 1000.0 * (
+        samples[(size_t)head * devices + device]
+        - samples[(size_t)k * devices + device]
+    ) / dt;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Exponentially weighted moving average rate
+////////////////////////////////////////////////////////////////////////////////
+double hashrate_t::Ewma(const int device)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return ewma[device];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Device is busy or showed liveness recently
+////////////////////////////////////////////////////////////////////////////////
+int hashrate_t::Alive(const int device)
+{
+    // liveness stamp of leaving busy state is seen with it
+    if (counters[device].busy.load(std::memory_order_acquire)) { return 1; }
+
+    return clock() - counters[device].updateMs.load(std::memory_order_relaxed)
+        < HASHRATE_LIVENESS_MS;
+}
+
+// hashrate.cc
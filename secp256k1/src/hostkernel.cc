@@ -0,0 +1,249 @@
+// hostkernel.cc
+
+/*******************************************************************************
+
+    HOSTKERNEL -- Host build of kernel sources
+
+*******************************************************************************/
+
+#include "../include/hostkernel.h"
+#include "../include/compaction.h"
+#include "../include/definitions.h"
+#include "../include/easylogging++.h"
+#include "../include/hostmining.h"
+#include "../include/kernel.h"
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <ucontext.h>
+#endif
+
+// kernel sources compiled for host, see kernel.h
+namespace hostkernel
+{
+#include "mining.cu"
+#include "prehash.cu"
+}
+
+thread_local kernel_dim_t threadIdx;
+thread_local kernel_dim_t blockIdx;
+thread_local kernel_dim_t blockDim;
+thread_local kernel_dim_t gridDim;
+
+thread_local uint32_t kernelCarry;
+
+// threads of block run by host thread
+struct fibers_t
+{
+    const std::function<void(void)> * kernel;
+    uint32_t count;
+    // thread being run
+    uint32_t current;
+    std::vector<int> done;
+
+#ifdef _WIN32
+    void * main;
+    std::vector<void *> threads;
+#else
+    ucontext_t main;
+    std::vector<ucontext_t> threads;
+    char * stacks;
+#endif
+};
+
+// fibers of host thread, NULL outside HostLaunch
+static thread_local fibers_t * fibers = NULL;
+
+////////////////////////////////////////////////////////////////////////////////
+//  Fiber of kernel thread, runs kernel once per block
+////////////////////////////////////////////////////////////////////////////////
+#ifdef _WIN32
+static void CALLBACK RunThread(void * param)
+{
+    fibers_t * f = (fibers_t *)param;
+
+    while (1)
+    {
+        (*f->kernel)();
+
+        f->done[f->current] = 1;
+        SwitchToFiber(f->main);
+    }
+}
+#else
+static void RunThread(void)
+{
+    fibers_t * f = fibers;
+
+    while (1)
+    {
+        (*f->kernel)();
+
+        f->done[f->current] = 1;
+        swapcontext(&f->threads[f->current], &f->main);
+    }
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//  Barrier of threads of block
+////////////////////////////////////////////////////////////////////////////////
+void KernelSync(void)
+{
+    fibers_t * f = fibers;
+
+    // kernel called directly runs as a single thread
+    if (!f) { return; }
+
+#ifdef _WIN32
+    SwitchToFiber(f->main);
+#else
+    swapcontext(&f->threads[f->current], &f->main);
+#endif
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Run threads of block up to every barrier in turn
+////////////////////////////////////////////////////////////////////////////////
+static void RunBlock(fibers_t * f)
+{
+    uint32_t left = f->count;
+
+    for (uint32_t t = 0; t < f->count; ++t) { f->done[t] = 0; }
+
+    while (left)
+    {
+        left = 0;
+
+        for (uint32_t t = 0; t < f->count; ++t)
+        {
+            if (f->done[t]) { continue; }
+
+            f->current = t;
+            threadIdx.x = t;
+
+#ifdef _WIN32
+            SwitchToFiber(f->threads[t]);
+#else
+            swapcontext(&f->main, &f->threads[t]);
+#endif
+
+            left += !f->done[t];
+        }
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Take blocks of grid in turn
+////////////////////////////////////////////////////////////////////////////////
+static void RunBlocks(
+    const uint32_t grid,
+    const uint32_t block,
+    const std::function<void(void)> * kernel,
+    std::atomic<uint32_t> * next
+)
+{
+    fibers_t f;
+
+    f.kernel = kernel;
+    f.count = block;
+    f.current = 0;
+    f.done.assign(block, 0);
+    f.threads.resize(block);
+
+#ifdef _WIN32
+    f.main = ConvertThreadToFiber(NULL);
+
+    for (uint32_t t = 0; t < block; ++t)
+    {
+        f.threads[t] = CreateFiber(HOSTKERNEL_STACK_SIZE, RunThread, &f);
+    }
+#else
+    // pages of stacks are touched only as deep as kernels go
+    f.stacks = (char *)malloc((size_t)block * HOSTKERNEL_STACK_SIZE);
+
+    for (uint32_t t = 0; t < block; ++t)
+    {
+        getcontext(&f.threads[t]);
+
+        f.threads[t].uc_stack.ss_sp = f.stacks + t * HOSTKERNEL_STACK_SIZE;
+        f.threads[t].uc_stack.ss_size = HOSTKERNEL_STACK_SIZE;
+        f.threads[t].uc_link = &f.main;
+
+        makecontext(&f.threads[t], RunThread, 0);
+    }
+#endif
+
+    fibers = &f;
+
+    threadIdx.y = threadIdx.z = 0;
+    blockIdx.y = blockIdx.z = 0;
+    blockDim.x = block;
+    blockDim.y = blockDim.z = 1;
+    gridDim.x = grid;
+    gridDim.y = gridDim.z = 1;
+
+    for (uint32_t b = (*next)++; b < grid; b = (*next)++)
+    {
+        blockIdx.x = b;
+
+        RunBlock(&f);
+    }
+
+    fibers = NULL;
+
+#ifdef _WIN32
+    for (uint32_t t = 0; t < block; ++t) { DeleteFiber(f.threads[t]); }
+
+    ConvertFiberToThread();
+#else
+    free(f.stacks);
+#endif
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Run kernel call for every thread of grid
+////////////////////////////////////////////////////////////////////////////////
+void HostLaunch(
+    const uint32_t grid,
+    const uint32_t block,
+    const int threads,
+    const std::function<void(void)> & kernel
+)
+{
+    std::atomic<uint32_t> next(0);
+    std::vector<std::thread> workers;
+    uint32_t count = (threads > 0)?
+        threads: std::thread::hardware_concurrency();
+
+    if (!count) { count = 1; }
+    if (count > grid) { count = grid; }
+
+    for (uint32_t w = 1; w < count; ++w)
+    {
+        workers.push_back(
+            std::thread(RunBlocks, grid, block, &kernel, &next)
+        );
+    }
+
+    // calling thread takes blocks too
+    RunBlocks(grid, block, &kernel, &next);
+
+    for (size_t w = 0; w < workers.size(); ++w) { workers[w].join(); }
+
+    return;
+}
+
+// hostkernel.cc
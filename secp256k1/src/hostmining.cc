@@ -0,0 +1,564 @@
+// hostmining.cc
+
+/*******************************************************************************
+
+    HOSTMINING -- Autolykos blockMining procedure on host
+
+*******************************************************************************/
+
+#include "../include/hostmining.h"
+#include "../include/definitions.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <stdlib.h>
+#include <xmmintrin.h>
+// prefetch of cache line for read
+#define HOST_PREFETCH(ptr) _mm_prefetch((const char *)(ptr), _MM_HINT_T0)
+// byte order reversal
+#define HOST_BSWAP64(x) _byteswap_uint64(x)
+#else
+// prefetch of cache line for read
+#define HOST_PREFETCH(ptr) __builtin_prefetch((ptr), 0, 3)
+// byte order reversal
+#define HOST_BSWAP64(x) __builtin_bswap64(x)
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+// lanes on widest vectors of CPU, clone is picked at load time
+#define HOST_LANES_TARGETS                                                     \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define HOST_LANES_TARGETS
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//  Unfinalized hash of message
+////////////////////////////////////////////////////////////////////////////////
+void InitMining(
+    // context
+    ctx_t * ctx,
+    // message
+    const uint32_t * mes,
+    // message length in bytes
+    const uint32_t meslen
+)
+{
+    uint64_t aux[32];
+
+    //========================================================================//
+    //  Initialize context
+    //========================================================================//
+    memset(ctx->b, 0, BUF_SIZE_8);
+    B2B_IV(ctx->h);
+    ctx->h[0] ^= 0x01010000 ^ NUM_SIZE_8;
+    memset(ctx->t, 0, 16);
+    ctx->c = 0;
+
+    //========================================================================//
+    //  Hash message
+    //========================================================================//
+    for (uint_t j = 0; j < meslen; ++j)
+    {
+        if (ctx->c == BUF_SIZE_8) { HOST_B2B_H(ctx, aux); }
+
+        ctx->b[ctx->c++] = ((const uint8_t *)mes)[j];
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Indices of precalculated hashes from hash of nonce
+////////////////////////////////////////////////////////////////////////////////
+static void HashToIndices(const uint64_t * h, uint32_t * ind)
+{
+    uint32_t r[NUM_SIZE_32 + 1];
+
+    for (int j = 0; j < NUM_SIZE_8; ++j)
+    {
+        ((uint8_t *)r)[(j & 0xFFFFFFFC) + (3 - (j & 3))]
+            = (h[j >> 3] >> ((j & 7) << 3)) & 0xFF;
+    }
+
+    //========================================================================//
+    //  Generate indices
+    //========================================================================//
+    for (int i = 1; i < INDEX_SIZE_8; ++i)
+    {
+        ((uint8_t *)r)[NUM_SIZE_8 + i] = ((uint8_t *)r)[i];
+    }
+
+    for (int k = 0; k < K_LEN; k += INDEX_SIZE_8)
+    {
+        ind[k] = r[k >> 2] & N_MASK;
+
+        for (int i = 1; i < INDEX_SIZE_8; ++i)
+        {
+            ind[k + i]
+                = (
+                    (r[k >> 2] << (i << 3))
+                    | (r[(k >> 2) + 1] >> (32 - (i << 3)))
+                ) & N_MASK;
+        }
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Indices of precalculated hashes for nonce
+////////////////////////////////////////////////////////////////////////////////
+void HostNonceIndices(
+    // context
+    const ctx_t * ctx,
+    // nonce
+    const uint64_t nonce,
+    // indices
+    uint32_t * ind
+)
+{
+    ctx_t lctx = *ctx;
+    uint64_t aux[32];
+
+    //========================================================================//
+    //  Hash nonce
+    //========================================================================//
+    for (int j = 0; j < NONCE_SIZE_8; ++j)
+    {
+        if (lctx.c == BUF_SIZE_8) { HOST_B2B_H(&lctx, aux); }
+
+        lctx.b[lctx.c++] = ((const uint8_t *)&nonce)[NONCE_SIZE_8 - j - 1];
+    }
+
+    //========================================================================//
+    //  Finalize hashes
+    //========================================================================//
+    HOST_B2B_H_LAST(&lctx, aux);
+
+    HashToIndices(lctx.h, ind);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Constant part of single block nonce hash
+////////////////////////////////////////////////////////////////////////////////
+void InitNonceHash(
+    // context of unfinalized hash of message
+    const ctx_t * ctx,
+    // nonce hash context
+    nctx_t * nctx
+)
+{
+    nctx->ctx = *ctx;
+
+    // message and nonce fill the only block
+    nctx->folded = ctx->c == NUM_SIZE_8 && !ctx->t[0] && !ctx->t[1];
+
+    if (!nctx->folded) { return; }
+
+    for (int i = 0; i < NUM_SIZE_64; ++i)
+    {
+        memcpy(nctx->m + i, ctx->b + (i << 3), 8);
+    }
+
+    // state before mixing with counter of the last block
+    memcpy(nctx->v, ctx->h, 8 * 8);
+    B2B_IV(nctx->v + 8);
+
+    nctx->v[12] ^= NUM_SIZE_8 + NONCE_SIZE_8;
+    nctx->v[14] = ~nctx->v[14];
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Indices of precalculated hashes for nonce with single block hash
+////////////////////////////////////////////////////////////////////////////////
+void HostNonceIndicesFolded(
+    // nonce hash context
+    const nctx_t * nctx,
+    // nonce
+    const uint64_t nonce,
+    // indices
+    uint32_t * ind
+)
+{
+    if (!nctx->folded)
+    {
+        HostNonceIndices(&nctx->ctx, nonce, ind);
+        return;
+    }
+
+    uint64_t v[16];
+    uint64_t m[16];
+    uint64_t h[8];
+
+    memcpy(v, nctx->v, sizeof(v));
+
+    // zero words are compile time constants and drop out of mixing
+    for (int i = 0; i < NUM_SIZE_64; ++i) { m[i] = nctx->m[i]; }
+
+    // nonce bytes are absorbed from the most significant one
+    m[4] = HOST_BSWAP64(nonce);
+
+    for (int i = 5; i < 16; ++i) { m[i] = 0; }
+
+    B2B_MIX(v, m);
+
+    for (int i = 0; i < 8; ++i) { h[i] = nctx->ctx.h[i] ^ v[i] ^ v[i + 8]; }
+
+    HashToIndices(h, ind);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Subtraction of secret key from 288-bit sum and reduction modulo Q
+////////////////////////////////////////////////////////////////////////////////
+// literal port of BlockMining carry chains
+static inline void SubSecKeyModQ(
+    // secret key
+    const uint32_t * sk,
+    // sum of hashes, result in first NUM_SIZE_32 words
+    uint32_t * r
+)
+{
+    uint32_t cf = 0;
+
+    // subtraction of secret key
+    HOST_SUB_CC(r[0], r[0], sk[0], cf);
+
+    for (int i = 1; i < 8; ++i)
+    {
+        HOST_SUBC_CC(r[i], r[i], sk[i], cf);
+    }
+
+    HOST_SUBC(r[8], r[8], 0, cf);
+
+    //========================================================================//
+    //  Result mod Q
+    //========================================================================//
+    uint32_t med[5];
+    uint32_t d[2];
+    uint32_t carry;
+
+    d[0] = r[8];
+
+    //========================================================================//
+    HOST_MUL_LO(med[0], d[0], (uint32_t)Q0);
+    HOST_MUL_HI(med[1], d[0], (uint32_t)Q0);
+    HOST_MUL_LO(med[2], d[0], (uint32_t)Q1);
+    HOST_MUL_HI(med[3], d[0], (uint32_t)Q1);
+
+    HOST_MAD_LO_CC(med[1], d[0], (uint32_t)(Q0 >> 32), med[1], cf);
+    HOST_MADC_HI_CC(med[2], d[0], (uint32_t)(Q0 >> 32), med[2], cf);
+    HOST_MADC_LO_CC(med[3], d[0], (uint32_t)(Q1 >> 32), med[3], cf);
+    HOST_MADC_HI(med[4], d[0], (uint32_t)(Q1 >> 32), 0, cf);
+
+    //========================================================================//
+    HOST_SUB_CC(r[0], r[0], med[0], cf);
+
+    for (int i = 1; i < 5; ++i)
+    {
+        HOST_SUBC_CC(r[i], r[i], med[i], cf);
+    }
+
+    for (int i = 5; i < 7; ++i)
+    {
+        HOST_SUBC_CC(r[i], r[i], 0, cf);
+    }
+
+    HOST_SUBC(r[7], r[7], 0, cf);
+
+    //========================================================================//
+    d[1] = d[0] >> 31;
+    d[0] <<= 1;
+
+    HOST_ADD_CC(r[4], r[4], d[0], cf);
+    HOST_ADDC_CC(r[5], r[5], d[1], cf);
+    HOST_ADDC_CC(r[6], r[6], 0, cf);
+    HOST_ADDC(r[7], r[7], 0, cf);
+
+    //========================================================================//
+    HOST_SUB_CC(r[0], r[0], (uint32_t)Q0, cf);
+    HOST_SUBC_CC(r[1], r[1], (uint32_t)(Q0 >> 32), cf);
+    HOST_SUBC_CC(r[2], r[2], (uint32_t)Q1, cf);
+    HOST_SUBC_CC(r[3], r[3], (uint32_t)(Q1 >> 32), cf);
+    HOST_SUBC_CC(r[4], r[4], (uint32_t)Q2, cf);
+
+    for (int i = 5; i < 8; ++i)
+    {
+        HOST_SUBC_CC(r[i], r[i], 0xFFFFFFFF, cf);
+    }
+
+    HOST_SUBC(carry, 0, 0, cf);
+
+    carry = 0 - carry;
+
+    //========================================================================//
+    HOST_MAD_LO_CC(r[0], carry, (uint32_t)Q0, r[0], cf);
+    HOST_MADC_LO_CC(r[1], carry, (uint32_t)(Q0 >> 32), r[1], cf);
+    HOST_MADC_LO_CC(r[2], carry, (uint32_t)Q1, r[2], cf);
+    HOST_MADC_LO_CC(r[3], carry, (uint32_t)(Q1 >> 32), r[3], cf);
+    HOST_MADC_LO_CC(r[4], carry, (uint32_t)Q2, r[4], cf);
+
+    for (int i = 5; i < 7; ++i)
+    {
+        HOST_MADC_LO_CC(r[i], carry, 0xFFFFFFFF, r[i], cf);
+    }
+
+    HOST_MADC_LO(r[7], carry, 0xFFFFFFFF, r[7], cf);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Sum of precalculated hashes minus secret key modulo Q
+////////////////////////////////////////////////////////////////////////////////
+// literal port of BlockMining carry chains
+void HostNonceResult(
+    // secret key
+    const uint32_t * sk,
+    // precalculated hashes
+    const uint32_t * hashes,
+    // indices
+    const uint32_t * ind,
+    // result
+    uint32_t * res
+)
+{
+    uint32_t r[NUM_SIZE_32 + 1];
+    uint32_t cf = 0;
+
+    //========================================================================//
+    //  Calculate result
+    //========================================================================//
+    // first addition of hashes -> r
+    HOST_ADD_CC(r[0], hashes[ind[0] << 3], hashes[ind[1] << 3], cf);
+
+    for (int i = 1; i < 8; ++i)
+    {
+        HOST_ADDC_CC(
+            r[i], hashes[(ind[0] << 3) + i], hashes[(ind[1] << 3) + i], cf
+        );
+    }
+
+    HOST_ADDC(r[8], 0, 0, cf);
+
+    // remaining additions
+    for (int k = 2; k < K_LEN; ++k)
+    {
+        HOST_ADD_CC(r[0], r[0], hashes[ind[k] << 3], cf);
+
+        for (int i = 1; i < 8; ++i)
+        {
+            HOST_ADDC_CC(r[i], r[i], hashes[(ind[k] << 3) + i], cf);
+        }
+
+        HOST_ADDC(r[8], r[8], 0, cf);
+    }
+
+    SubSecKeyModQ(sk, r);
+
+    memcpy(res, r, NUM_SIZE_8);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Results of nonces in lanes, bit of lane is set if result is below bound
+////////////////////////////////////////////////////////////////////////////////
+HOST_LANES_TARGETS
+uint32_t HostNonceResults(
+    // secret key
+    const uint32_t * sk,
+    // precalculated hashes
+    const uint32_t * hashes,
+    // indices, K_LEN per lane
+    const uint32_t * ind,
+    // boundary for puzzle
+    const uint32_t * bound,
+    // results, NUM_SIZE_32 words per lane
+    uint32_t * res
+)
+{
+    uint64_t acc[HOST_MINING_LANES][NUM_SIZE_32];
+    uint32_t below = 0;
+
+    //========================================================================//
+    //  Sums with deferred carries, K_LEN words of 32 bits stay below 2^37
+    //========================================================================//
+    for (int l = 0; l < HOST_MINING_LANES; ++l)
+    {
+        for (int i = 0; i < NUM_SIZE_32; ++i) { acc[l][i] = 0; }
+    }
+
+    for (int k = 0; k < K_LEN; ++k)
+    {
+        for (int l = 0; l < HOST_MINING_LANES; ++l)
+        {
+            const uint32_t * row = hashes + (ind[l * K_LEN + k] << 3);
+
+            for (int i = 0; i < NUM_SIZE_32; ++i) { acc[l][i] += row[i]; }
+        }
+    }
+
+    //========================================================================//
+    //  Carry normalization, secret key subtraction, reduction and bound
+    //  comparison of every lane
+    //========================================================================//
+    for (int l = 0; l < HOST_MINING_LANES; ++l)
+    {
+        uint32_t t[NUM_SIZE_32 + 1];
+        uint64_t carry = 0;
+
+        // 288-bit sum
+        for (int i = 0; i < NUM_SIZE_32; ++i)
+        {
+            carry += acc[l][i];
+            t[i] = (uint32_t)carry;
+            carry >>= 32;
+        }
+
+        t[NUM_SIZE_32] = (uint32_t)carry;
+
+        SubSecKeyModQ(sk, t);
+
+        uint32_t less = 0;
+
+        // from least significant word, a higher word decides unless equal
+        for (int i = 0; i < NUM_SIZE_32; ++i)
+        {
+            less = (t[i] < bound[i]) | ((t[i] == bound[i]) & less);
+        }
+
+        below |= less << l;
+
+        for (int i = 0; i < NUM_SIZE_32; ++i)
+        {
+            res[l * NUM_SIZE_32 + i] = t[i];
+        }
+    }
+
+    return below;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Check if result is below bound
+////////////////////////////////////////////////////////////////////////////////
+int HostIsSolution(
+    // result
+    const uint32_t * res,
+    // boundary for puzzle
+    const uint32_t * bound
+)
+{
+    const uint64_t * r = (const uint64_t *)res;
+    const uint64_t * b = (const uint64_t *)bound;
+
+    return r[3] < b[3]
+        || (r[3] == b[3] && (
+            r[2] < b[2]
+            || (r[2] == b[2] && (r[1] < b[1] || (r[1] == b[1] && r[0] < b[0])))
+        ));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Block mining
+////////////////////////////////////////////////////////////////////////////////
+void HostBlockMining(
+    // boundary for puzzle
+    const uint32_t * bound,
+    // secret key
+    const uint32_t * sk,
+    // context
+    const ctx_t * ctx,
+    // nonce base
+    const uint64_t base,
+    // number of nonces
+    const uint32_t count,
+    // precalculated hashes
+    const uint32_t * hashes,
+    // result
+    uint32_t * res,
+    // index of the first valid solution plus one, zero if none
+    uint32_t * valid
+)
+{
+    uint32_t ind[HOST_MINING_GROUP * K_LEN];
+    uint32_t r[HOST_MINING_LANES * NUM_SIZE_32];
+    nctx_t nctx;
+
+    *valid = 0;
+
+    InitNonceHash(ctx, &nctx);
+
+    for (uint32_t group = 0; group < count; group += HOST_MINING_GROUP)
+    {
+        uint32_t size = (count - group < HOST_MINING_GROUP)?
+            count - group: HOST_MINING_GROUP;
+
+        //====================================================================//
+        //  Indices of the group, rows are fetched while next nonces hash
+        //====================================================================//
+        for (uint32_t j = 0; j < size; ++j)
+        {
+            uint32_t * nind = ind + j * K_LEN;
+
+            HostNonceIndicesFolded(&nctx, base + group + j, nind);
+
+            for (int k = 0; k < K_LEN; ++k)
+            {
+                // row may cross cache line if table is not 32 bytes aligned
+                HOST_PREFETCH(hashes + (nind[k] << 3));
+                HOST_PREFETCH(hashes + (nind[k] << 3) + 7);
+            }
+        }
+
+        //====================================================================//
+        //  Results of the group from cache, lanes first
+        //====================================================================//
+        uint32_t j = 0;
+
+        for ( ; j + HOST_MINING_LANES <= size; j += HOST_MINING_LANES)
+        {
+            uint32_t below = HostNonceResults(
+                sk, hashes, ind + j * K_LEN, bound, r
+            );
+
+            if (below)
+            {
+                // first nonce of lanes below bound
+                uint32_t l = 0;
+
+                while (!((below >> l) & 1)) { ++l; }
+
+                *valid = group + j + l + 1;
+                memcpy(res, r + l * NUM_SIZE_32, NUM_SIZE_8);
+
+                return;
+            }
+        }
+
+        for ( ; j < size; ++j)
+        {
+            HostNonceResult(sk, hashes, ind + j * K_LEN, r);
+
+            if (HostIsSolution(r, bound))
+            {
+                *valid = group + j + 1;
+                memcpy(res, r, NUM_SIZE_8);
+
+                return;
+            }
+        }
+    }
+
+    return;
+}
+
+// hostmining.cc
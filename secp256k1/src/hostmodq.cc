@@ -0,0 +1,537 @@
+// hostmodq.cc
+
+/*******************************************************************************
+
+    HOSTMODQ -- Batched multiplication modulo Q on host
+
+*******************************************************************************/
+
+#include "../include/hostmodq.h"
+#include "../include/definitions.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MODQ_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef _MSC_VER
+// intrinsics of any instruction set are available everywhere
+#define MODQ_TARGET(isa)
+#define MODQ_INLINE __forceinline
+// byte order reversal
+#define MODQ_BSWAP64(x) _byteswap_uint64(x)
+// lo := low word of a * b, hi := high word
+#define MODQ_MUL64(lo, hi, a, b) ((lo) = _umul128((a), (b), &(hi)))
+#else
+// code generation for instruction set
+#define MODQ_TARGET(isa) __attribute__((target(isa)))
+#define MODQ_INLINE inline __attribute__((always_inline))
+// byte order reversal
+#define MODQ_BSWAP64(x) __builtin_bswap64(x)
+// lo := low word of a * b, hi := high word
+#define MODQ_MUL64(lo, hi, a, b)                                               \
+do                                                                             \
+{                                                                              \
+    unsigned __int128 p = (unsigned __int128)(a) * (b);                        \
+    (lo) = (uint64_t)p;                                                        \
+    (hi) = (uint64_t)(p >> 64);                                                \
+}                                                                              \
+while (0)
+#endif
+
+// 2^256 - Q = 2^128 + QC1 * 2^64 + QC0
+#define QC0 (~Q0 + 1)
+#define QC1 (~Q1)
+
+// 52-bit limb mask
+#define MASK52 (((uint64_t)1 << 52) - 1)
+
+// lane shift, zero-masked form keeps GCC from warning on undefined source
+#define SRLI512(v, n) _mm512_maskz_srli_epi64((__mmask8)0xFF, (v), (n))
+
+//============================================================================//
+//  192-bit accumulator
+//============================================================================//
+// c += a * b
+static MODQ_INLINE void MulAdd(
+    uint64_t * c,
+    const uint64_t a,
+    const uint64_t b
+)
+{
+    uint64_t lo;
+    uint64_t hi;
+
+    MODQ_MUL64(lo, hi, a, b);
+
+    c[0] += lo;
+    hi += c[0] < lo;
+    c[1] += hi;
+    c[2] += c[1] < hi;
+
+    return;
+}
+
+// c += a
+static MODQ_INLINE void Add(uint64_t * c, const uint64_t a)
+{
+    uint64_t over;
+
+    c[0] += a;
+    over = c[0] < a;
+    c[1] += over;
+    c[2] += c[1] < over;
+
+    return;
+}
+
+// low word of c, c >>= 64
+static MODQ_INLINE uint64_t Extract(uint64_t * c)
+{
+    uint64_t r = c[0];
+
+    c[0] = c[1];
+    c[1] = c[2];
+    c[2] = 0;
+
+    return r;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  r[0, ..., 7] = a * b
+////////////////////////////////////////////////////////////////////////////////
+static MODQ_INLINE void Mul256(
+    const uint64_t * a,
+    const uint64_t * b,
+    uint64_t * r
+)
+{
+    uint64_t c[3] = { 0, 0, 0 };
+
+    for (int k = 0; k < 7; ++k)
+    {
+        for (int i = (k < 4)? 0: k - 3; i <= k && i < 4; ++i)
+        {
+            MulAdd(c, a[i], b[k - i]);
+        }
+
+        r[k] = Extract(c);
+    }
+
+    r[7] = c[0];
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  out[0, ..., m - 1] = lo[0, ..., 3] + hi[0, ..., n - 1] * (2^256 - Q)
+////////////////////////////////////////////////////////////////////////////////
+static MODQ_INLINE void FoldQ(
+    const uint64_t * lo,
+    const uint64_t * hi,
+    const int n,
+    uint64_t * out,
+    const int m
+)
+{
+    uint64_t c[3] = { 0, 0, 0 };
+
+    for (int k = 0; k < m; ++k)
+    {
+        if (k < 4) { Add(c, lo[k]); }
+        if (k < n) { MulAdd(c, hi[k], QC0); }
+        if (k >= 1 && k - 1 < n) { MulAdd(c, hi[k - 1], QC1); }
+        if (k >= 2 && k - 2 < n) { Add(c, hi[k - 2]); }
+
+        out[k] = Extract(c);
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  out = r mod Q for 512-bit r
+////////////////////////////////////////////////////////////////////////////////
+static MODQ_INLINE void ReduceQ(const uint64_t * r, uint64_t * out)
+{
+    const uint64_t one = 1;
+    uint64_t m[7];
+    uint64_t p[5];
+    uint64_t s[5];
+
+    // 2^256 = 2^256 - Q (mod Q), each fold drops 127 bits
+    // < 2^386
+    FoldQ(r, r + 4, 4, m, 7);
+    // < 2^260
+    FoldQ(m, m + 4, 3, p, 5);
+    // < 2^256 + 2^133
+    FoldQ(p, p + 4, 1, s, 5);
+    // < 2^256, low part is small if there was an overflow
+    FoldQ(s, s + 4, 1, out, 4);
+
+    // s := out + 2^256 - Q overflows if and only if out >= Q
+    FoldQ(out, &one, 1, s, 5);
+
+    if (s[4]) { memcpy(out, s, 4 * sizeof(uint64_t)); }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  BIG ENDIAN hash to 64-bit limbs
+////////////////////////////////////////////////////////////////////////////////
+static MODQ_INLINE void LoadHash(const uint32_t * hash, uint64_t * h)
+{
+    uint64_t w[4];
+
+    memcpy(w, hash, NUM_SIZE_8);
+
+    for (int k = 0; k < 4; ++k) { h[k] = MODQ_BSWAP64(w[3 - k]); }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Batch of 64-bit limb multiplications
+////////////////////////////////////////////////////////////////////////////////
+static MODQ_INLINE void MultBatch(
+    const uint64_t * x,
+    uint32_t * hashes,
+    const uint32_t count
+)
+{
+    uint64_t h[4];
+    uint64_t r[8];
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        LoadHash(hashes + i * NUM_SIZE_32, h);
+        Mul256(h, x, r);
+        ReduceQ(r, h);
+
+        // LITTLE ENDIAN
+        memcpy(hashes + i * NUM_SIZE_32, h, NUM_SIZE_8);
+    }
+
+    return;
+}
+
+static void MultBatch64(
+    const uint64_t * x,
+    uint32_t * hashes,
+    const uint32_t count
+)
+{
+    MultBatch(x, hashes, count);
+
+    return;
+}
+
+#ifdef MODQ_X86
+MODQ_TARGET("bmi2,adx")
+static void MultBatchMulx(
+    const uint64_t * x,
+    uint32_t * hashes,
+    const uint32_t count
+)
+{
+    MultBatch(x, hashes, count);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  256-bit number to 52-bit limbs and back
+////////////////////////////////////////////////////////////////////////////////
+static inline void To52(const uint64_t * a, uint64_t * l)
+{
+    l[0] = a[0] & MASK52;
+    l[1] = ((a[0] >> 52) | (a[1] << 12)) & MASK52;
+    l[2] = ((a[1] >> 40) | (a[2] << 24)) & MASK52;
+    l[3] = ((a[2] >> 28) | (a[3] << 36)) & MASK52;
+    l[4] = a[3] >> 16;
+
+    return;
+}
+
+static inline void From52(const uint64_t * l, uint64_t * a)
+{
+    a[0] = l[0] | (l[1] << 52);
+    a[1] = (l[1] >> 12) | (l[2] << 40);
+    a[2] = (l[2] >> 24) | (l[3] << 28);
+    a[3] = (l[3] >> 36) | (l[4] << 16);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Batch of Montgomery multiplications, 8 entries per vector
+////////////////////////////////////////////////////////////////////////////////
+MODQ_TARGET("avx512f,avx512ifma")
+static void MultBatchIfma(
+    const uint64_t * x,
+    uint32_t * hashes,
+    const uint32_t count
+)
+{
+    const uint64_t q[4] = { Q0, Q1, Q2, Q3 };
+    // 2^260 mod Q = 16 * (2^256 - Q)
+    const uint64_t r[4] = {
+        QC0 << 4, (QC1 << 4) | (QC0 >> 60), 16 | (QC1 >> 60), 0
+    };
+
+    uint64_t l[8];
+    uint64_t xr[4];
+    uint64_t inv = Q0;
+
+    // x in Montgomery form: x * 2^260 mod Q
+    Mul256(x, r, l);
+    ReduceQ(l, xr);
+
+    // Q^-1 mod 2^64 by Newton iterations
+    for (int i = 0; i < 5; ++i) { inv *= 2 - Q0 * inv; }
+
+    __m512i xv[5];
+    __m512i qv[5];
+    __m512i t[6];
+    __m512i d[5];
+
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i mask = _mm512_set1_epi64(MASK52);
+    // -Q^-1 mod 2^52
+    const __m512i qinv = _mm512_set1_epi64((0 - inv) & MASK52);
+
+    To52(xr, l);
+    for (int k = 0; k < 5; ++k) { xv[k] = _mm512_set1_epi64(l[k]); }
+
+    To52(q, l);
+    for (int k = 0; k < 5; ++k) { qv[k] = _mm512_set1_epi64(l[k]); }
+
+    // limb k of entry e at a[k * 8 + e]
+    alignas(64) uint64_t a[5 * 8];
+    uint64_t h[4];
+    uint32_t i;
+
+    for (i = 0; i + 8 <= count; i += 8)
+    {
+        for (int e = 0; e < 8; ++e)
+        {
+            LoadHash(hashes + (i + e) * NUM_SIZE_32, h);
+            To52(h, l);
+
+            for (int k = 0; k < 5; ++k) { a[k * 8 + e] = l[k]; }
+        }
+
+        for (int k = 0; k < 6; ++k) { t[k] = zero; }
+
+        //====================================================================//
+        //  t = (h * xr + m * Q) / 2^260, limbs are summed lazily
+        //====================================================================//
+        for (int j = 0; j < 5; ++j)
+        {
+            __m512i aj = _mm512_load_si512(a + j * 8);
+
+            for (int k = 0; k < 5; ++k)
+            {
+                t[k] = _mm512_madd52lo_epu64(t[k], aj, xv[k]);
+                t[k + 1] = _mm512_madd52hi_epu64(t[k + 1], aj, xv[k]);
+            }
+
+            __m512i m = _mm512_madd52lo_epu64(zero, t[0], qinv);
+
+            for (int k = 0; k < 5; ++k)
+            {
+                t[k] = _mm512_madd52lo_epu64(t[k], m, qv[k]);
+                t[k + 1] = _mm512_madd52hi_epu64(t[k + 1], m, qv[k]);
+            }
+
+            // low 52 bits of t[0] are zero
+            t[1] = _mm512_add_epi64(t[1], SRLI512(t[0], 52));
+
+            for (int k = 0; k < 5; ++k) { t[k] = t[k + 1]; }
+
+            t[5] = zero;
+        }
+
+        for (int k = 0; k < 4; ++k)
+        {
+            t[k + 1] = _mm512_add_epi64(t[k + 1], SRLI512(t[k], 52));
+            t[k] = _mm512_and_si512(t[k], mask);
+        }
+
+        //====================================================================//
+        //  t < 2 * Q, subtract Q if there is no borrow
+        //====================================================================//
+        __m512i borrow = zero;
+
+        for (int k = 0; k < 5; ++k)
+        {
+            d[k] = _mm512_sub_epi64(_mm512_sub_epi64(t[k], qv[k]), borrow);
+            borrow = SRLI512(d[k], 63);
+            d[k] = _mm512_and_si512(d[k], mask);
+        }
+
+        __mmask8 ge = _mm512_cmpeq_epi64_mask(borrow, zero);
+
+        for (int k = 0; k < 5; ++k)
+        {
+            _mm512_store_si512(
+                a + k * 8, _mm512_mask_blend_epi64(ge, t[k], d[k])
+            );
+        }
+
+        //====================================================================//
+        //  Dump result -- LITTLE ENDIAN
+        //====================================================================//
+        for (int e = 0; e < 8; ++e)
+        {
+            for (int k = 0; k < 5; ++k) { l[k] = a[k * 8 + e]; }
+
+            From52(l, h);
+            memcpy(hashes + (i + e) * NUM_SIZE_32, h, NUM_SIZE_8);
+        }
+    }
+
+    MultBatch64(x, hashes + i * NUM_SIZE_32, count - i);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  CPUID leaf registers
+////////////////////////////////////////////////////////////////////////////////
+static void Cpuid(const unsigned int leaf, unsigned int * regs)
+{
+#ifdef _MSC_VER
+    __cpuidex((int *)regs, leaf, 0);
+#else
+    if (!__get_cpuid_count(leaf, 0, regs, regs + 1, regs + 2, regs + 3))
+    {
+        memset(regs, 0, 4 * sizeof(unsigned int));
+    }
+#endif
+
+    return;
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//  CPU supports engine
+////////////////////////////////////////////////////////////////////////////////
+int ModQSupported(const int engine)
+{
+    if (engine == MODQ_64) { return 1; }
+
+#ifdef MODQ_X86
+    unsigned int regs[4];
+
+    Cpuid(7, regs);
+
+    // EBX: bit 8 BMI2, bit 19 ADX
+    if (engine == MODQ_MULX)
+    {
+        return (regs[1] >> 8 & 1) & (regs[1] >> 19 & 1);
+    }
+
+    // EBX: bit 16 AVX512F, bit 21 AVX512IFMA
+    if (engine != MODQ_IFMA || !(regs[1] >> 16 & 1) || !(regs[1] >> 21 & 1))
+    {
+        return 0;
+    }
+
+    // ECX: bit 27 OSXSAVE
+    Cpuid(1, regs);
+
+    if (!(regs[2] >> 27 & 1)) { return 0; }
+
+    // operating system saves SSE, AVX and AVX-512 state
+#ifdef _MSC_VER
+    uint64_t xcr0 = _xgetbv(0);
+#else
+    uint32_t lo;
+    uint32_t hi;
+
+    __asm__ volatile ("xgetbv": "=a"(lo), "=d"(hi): "c"(0));
+
+    uint64_t xcr0 = ((uint64_t)hi << 32) | lo;
+#endif
+
+    return (xcr0 & 0xE6) == 0xE6;
+#else
+    return 0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Fastest engine supported by CPU
+////////////////////////////////////////////////////////////////////////////////
+int ModQBestEngine(void)
+{
+    static const int best
+        = ModQSupported(MODQ_IFMA)? MODQ_IFMA:
+        ModQSupported(MODQ_MULX)? MODQ_MULX: MODQ_64;
+
+    return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Engine name for logs
+////////////////////////////////////////////////////////////////////////////////
+const char * ModQEngineName(const int engine)
+{
+    if (engine == MODQ_IFMA) { return "AVX-512 IFMA"; }
+    if (engine == MODQ_MULX) { return "BMI2/ADX 64-bit"; }
+
+    return "portable 64-bit";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Batch of hash multiplications modulo Q by one time secret key
+////////////////////////////////////////////////////////////////////////////////
+void HostMultSecKeyBatch(
+    const int engine,
+    // one-time secret key
+    const uint32_t * x,
+    // hashes
+    uint32_t * hashes,
+    const uint32_t count
+)
+{
+    uint64_t x64[4];
+
+    memcpy(x64, x, NUM_SIZE_8);
+
+#ifdef MODQ_X86
+    // CPU features are read once, not for every batch
+    static const int supported[MODQ_ENGINES] = {
+        1, ModQSupported(MODQ_MULX), ModQSupported(MODQ_IFMA)
+    };
+
+    if (engine == MODQ_IFMA && supported[MODQ_IFMA])
+    {
+        MultBatchIfma(x64, hashes, count);
+
+        return;
+    }
+
+    if (engine == MODQ_MULX && supported[MODQ_MULX])
+    {
+        MultBatchMulx(x64, hashes, count);
+
+        return;
+    }
+#endif
+
+    MultBatch64(x64, hashes, count);
+
+    return;
+}
+
+// hostmodq.cc
@@ -0,0 +1,502 @@
+// hostprehash.cc
+
+/*******************************************************************************
+
+    HOSTPREHASH -- precalculation of hashes on host
+
+*******************************************************************************/
+
+#include "../include/hostprehash.h"
+#include "../include/definitions.h"
+#include "../include/hostmodq.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+//  Constant message byte
+////////////////////////////////////////////////////////////////////////////////
+static inline uint8_t ConstMesByte(const uint32_t j)
+{
+    return (
+        !((7 - (j & 7)) >> 1) * ((j >> 3) >> (((~(j & 7)) & 1) << 3))
+    ) & 0xFF;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Initialize hash context
+////////////////////////////////////////////////////////////////////////////////
+static inline void InitContext(ctx_t * ctx)
+{
+    memset(ctx->b, 0, BUF_SIZE_8);
+    B2B_IV(ctx->h);
+    ctx->h[0] ^= 0x01010000 ^ NUM_SIZE_8;
+    memset(ctx->t, 0, 16);
+    ctx->c = 0;
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Hash bytes
+////////////////////////////////////////////////////////////////////////////////
+static inline void UpdateContext(
+    ctx_t * ctx,
+    uint64_t * aux,
+    const uint8_t * in,
+    const uint32_t len
+)
+{
+    for (uint32_t j = 0; j < len; ++j)
+    {
+        if (ctx->c == BUF_SIZE_8) { HOST_B2B_H(ctx, aux); }
+
+        ctx->b[ctx->c++] = in[j];
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Finalize hash, rehash out of bounds hash and dump result
+////////////////////////////////////////////////////////////////////////////////
+static void FinalizeContext(ctx_t * ctx, uint64_t * aux, uint32_t * hash)
+{
+    uint64_t h[NUM_SIZE_64];
+    uint32_t j;
+
+    do
+    {
+        HOST_B2B_H_LAST(ctx, aux);
+
+        for (j = 0; j < NUM_SIZE_8; ++j)
+        {
+            ((uint8_t *)h)[NUM_SIZE_8 - j - 1]
+                = (ctx->h[j >> 3] >> ((j & 7) << 3)) & 0xFF;
+        }
+
+        //====================================================================//
+        //  Dump result -- BIG ENDIAN
+        //====================================================================//
+        j = h[3] < Q3
+            || (h[3] == Q3 && (
+                h[2] < Q2
+                || (h[2] == Q2 && (h[1] < Q1 || (h[1] == Q1 && h[0] < Q0)))
+            ));
+
+        for (int i = 0; i < NUM_SIZE_8; ++i)
+        {
+            ((uint8_t *)hash)[NUM_SIZE_8 - i - 1] = ((uint8_t *)h)[i];
+        }
+
+        // rehash out of bounds hash
+        if (!j)
+        {
+            InitContext(ctx);
+            UpdateContext(ctx, aux, (const uint8_t *)hash, NUM_SIZE_8);
+        }
+    }
+    while (!j);
+
+    return;
+}
+
+// hashes multiplied by one-time secret key at once
+#define PREHASH_CHUNK 1024
+
+// idx || M with zero index bytes as message words
+static const uint64_t constMesSchedule[CONST_SCHEDULE_SIZE_64] = {
+    CONST_MES_SCHEDULE
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//  Hash index and constant message byte by byte
+////////////////////////////////////////////////////////////////////////////////
+static void HashIndexConstMesBytes(
+    ctx_t * ctx,
+    uint64_t * aux,
+    const uint32_t idx
+)
+{
+    uint32_t j;
+
+    InitContext(ctx);
+
+    for (j = 0; j < INDEX_SIZE_8; ++j)
+    {
+        ctx->b[ctx->c++] = ((const uint8_t *)&idx)[INDEX_SIZE_8 - j - 1];
+    }
+
+    for (j = 0; j < CONST_MES_SIZE_8; ++j)
+    {
+        if (ctx->c == BUF_SIZE_8) { HOST_B2B_H(ctx, aux); }
+
+        ctx->b[ctx->c++] = ConstMesByte(j);
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Hash index and constant message by schedule words
+////////////////////////////////////////////////////////////////////////////////
+static void HashIndexConstMes(ctx_t * ctx, uint64_t * aux, const uint32_t idx)
+{
+    InitContext(ctx);
+
+    for (uint32_t k = 0; k < CONST_MES_BLOCKS; ++k)
+    {
+        memcpy(ctx->b, constMesSchedule + k * 16, BUF_SIZE_8);
+
+        if (!k)
+        {
+            for (uint32_t j = 0; j < INDEX_SIZE_8; ++j)
+            {
+                ctx->b[j] = ((const uint8_t *)&idx)[INDEX_SIZE_8 - j - 1];
+            }
+        }
+
+        // there are remaining bytes, so every whole block is compressed
+        HOST_B2B_H(ctx, aux);
+    }
+
+    memcpy(ctx->b, constMesSchedule + CONST_MES_BLOCKS * 16, 8);
+    ctx->c = CONST_MES_REM_8;
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Hash index and constant message, by schedule words or byte by byte
+////////////////////////////////////////////////////////////////////////////////
+void HostHashIndexConstMes(
+    // index
+    const uint32_t idx,
+    // use schedule words
+    const int schedule,
+    // hash context
+    ctx_t * ctx
+)
+{
+    uint64_t aux[32];
+
+    if (schedule) { HashIndexConstMes(ctx, aux, idx); }
+    else { HashIndexConstMesBytes(ctx, aux, idx); }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  First iteration of hash precalculation for one index
+////////////////////////////////////////////////////////////////////////////////
+void HostInitPrehash(
+    // pk || mes || w
+    const uint8_t * pnp,
+    // index
+    const uint32_t idx,
+    // hash
+    uint32_t * hash
+)
+{
+    ctx_t ctx;
+    uint64_t aux[32];
+
+    HashIndexConstMes(&ctx, aux, idx);
+    UpdateContext(&ctx, aux, pnp, 2 * PK_SIZE_8 + NUM_SIZE_8);
+    FinalizeContext(&ctx, aux, hash);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Uncompleted first iteration of hash precalculation for one index
+////////////////////////////////////////////////////////////////////////////////
+void HostUncompleteInitPrehash(
+    // public key
+    const uint8_t * pk,
+    // index
+    const uint32_t idx,
+    // unfinalized hash context
+    uctx_t * uctx
+)
+{
+    ctx_t ctx;
+    uint64_t aux[32];
+
+    HashIndexConstMes(&ctx, aux, idx);
+    UpdateContext(&ctx, aux, pk, PK_SIZE_8);
+
+    memcpy(uctx->h, ctx.h, sizeof(ctx.h));
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Complete first iteration of hash precalculation for one index
+////////////////////////////////////////////////////////////////////////////////
+void HostCompleteInitPrehash(
+    // pk || mes || w
+    const uint8_t * pnp,
+    // unfinalized hash context
+    const uctx_t * uctx,
+    // hash
+    uint32_t * hash
+)
+{
+    ctx_t ctx;
+    uint64_t aux[32];
+
+    //========================================================================//
+    //  Restore context: last constant message bytes and public key
+    //========================================================================//
+    memset(ctx.b, 0, BUF_SIZE_8);
+    ctx.c = 0;
+
+    for (
+        uint32_t j
+            = CONST_MES_SIZE_8 - (INDEX_SIZE_8 + CONST_MES_SIZE_8) % BUF_SIZE_8;
+        j < CONST_MES_SIZE_8;
+        ++j
+    )
+    {
+        ctx.b[ctx.c++] = ConstMesByte(j);
+    }
+
+    memcpy(ctx.b + ctx.c, pnp, PK_SIZE_8);
+    ctx.c += PK_SIZE_8;
+
+    memcpy(ctx.h, uctx->h, sizeof(ctx.h));
+    ctx.t[0] = UCTX_COUNT;
+    ctx.t[1] = 0;
+
+    //========================================================================//
+    //  Hash message & one-time public key
+    //========================================================================//
+    UpdateContext(&ctx, aux, pnp + PK_SIZE_8, PK_SIZE_8 + NUM_SIZE_8);
+    FinalizeContext(&ctx, aux, hash);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Hash multiplication modulo Q by one time secret key
+////////////////////////////////////////////////////////////////////////////////
+// literal port of FinalPrehashMultSecKey carry chains
+void HostFinalPrehashMultSecKey(
+    // one-time secret key
+    const uint32_t * x,
+    // hash
+    uint32_t * hash
+)
+{
+    uint32_t h[NUM_SIZE_32];
+    uint32_t r[NUM_SIZE_32 << 1];
+    uint32_t cf = 0;
+
+    for (int j = 0; j < NUM_SIZE_8; ++j)
+    {
+        ((uint8_t *)h)[j] = ((uint8_t *)hash)[NUM_SIZE_8 - j - 1];
+    }
+
+    //========================================================================//
+    //  r[0, ..., 7, 8] = h[0] * x
+    //========================================================================//
+    for (int j = 0; j < 8; j += 2)
+    {
+        HOST_MUL_LO(r[j], h[0], x[j]);
+        HOST_MUL_HI(r[j + 1], h[0], x[j]);
+    }
+
+    HOST_MAD_LO_CC(r[1], h[0], x[1], r[1], cf);
+    HOST_MADC_HI_CC(r[2], h[0], x[1], r[2], cf);
+
+    for (int j = 3; j < 6; j += 2)
+    {
+        HOST_MADC_LO_CC(r[j], h[0], x[j], r[j], cf);
+        HOST_MADC_HI_CC(r[j + 1], h[0], x[j], r[j + 1], cf);
+    }
+
+    HOST_MADC_LO_CC(r[7], h[0], x[7], r[7], cf);
+    HOST_MADC_HI(r[8], h[0], x[7], 0, cf);
+
+    //========================================================================//
+    //  r[i, ..., i + 7, i + 8] += h[i] * x
+    //========================================================================//
+    for (int i = 1; i < NUM_SIZE_32; ++i)
+    {
+        HOST_MAD_LO_CC(r[i], h[i], x[0], r[i], cf);
+        HOST_MADC_HI_CC(r[i + 1], h[i], x[0], r[i + 1], cf);
+
+        for (int j = 2; j < 8; j += 2)
+        {
+            HOST_MADC_LO_CC(r[i + j], h[i], x[j], r[i + j], cf);
+            HOST_MADC_HI_CC(r[i + j + 1], h[i], x[j], r[i + j + 1], cf);
+        }
+
+        HOST_ADDC(r[i + 8], 0, 0, cf);
+
+        HOST_MAD_LO_CC(r[i + 1], h[i], x[1], r[i + 1], cf);
+        HOST_MADC_HI_CC(r[i + 2], h[i], x[1], r[i + 2], cf);
+
+        for (int j = 3; j < 6; j += 2)
+        {
+            HOST_MADC_LO_CC(r[i + j], h[i], x[j], r[i + j], cf);
+            HOST_MADC_HI_CC(r[i + j + 1], h[i], x[j], r[i + j + 1], cf);
+        }
+
+        HOST_MADC_LO_CC(r[i + 7], h[i], x[7], r[i + 7], cf);
+        HOST_MADC_HI(r[i + 8], h[i], x[7], r[i + 8], cf);
+    }
+
+    //========================================================================//
+    //  Mod Q
+    //========================================================================//
+    uint32_t d[2];
+    uint32_t med[6];
+    uint32_t carry;
+
+    for (int i = (NUM_SIZE_32 - 1) << 1; i >= NUM_SIZE_32; i -= 2)
+    {
+        d[0] = r[i];
+        d[1] = r[i + 1];
+
+    //========================================================================//
+    //  med[0, ..., 5] = d * Q
+    //========================================================================//
+        HOST_MUL_LO(med[0], d[0], (uint32_t)Q0);
+        HOST_MUL_HI(med[1], d[0], (uint32_t)Q0);
+        HOST_MUL_LO(med[2], d[0], (uint32_t)Q1);
+        HOST_MUL_HI(med[3], d[0], (uint32_t)Q1);
+
+        HOST_MAD_LO_CC(med[1], d[0], (uint32_t)(Q0 >> 32), med[1], cf);
+        HOST_MADC_HI_CC(med[2], d[0], (uint32_t)(Q0 >> 32), med[2], cf);
+        HOST_MADC_LO_CC(med[3], d[0], (uint32_t)(Q1 >> 32), med[3], cf);
+        HOST_MADC_HI(med[4], d[0], (uint32_t)(Q1 >> 32), 0, cf);
+
+    //========================================================================//
+        HOST_MAD_LO_CC(med[1], d[1], (uint32_t)Q0, med[1], cf);
+        HOST_MADC_HI_CC(med[2], d[1], (uint32_t)Q0, med[2], cf);
+        HOST_MADC_LO_CC(med[3], d[1], (uint32_t)Q1, med[3], cf);
+        HOST_MADC_HI_CC(med[4], d[1], (uint32_t)Q1, med[4], cf);
+        HOST_ADDC(med[5], 0, 0, cf);
+
+        HOST_MAD_LO_CC(med[2], d[1], (uint32_t)(Q0 >> 32), med[2], cf);
+        HOST_MADC_HI_CC(med[3], d[1], (uint32_t)(Q0 >> 32), med[3], cf);
+        HOST_MADC_LO_CC(med[4], d[1], (uint32_t)(Q1 >> 32), med[4], cf);
+        HOST_MADC_HI(med[5], d[1], (uint32_t)(Q1 >> 32), med[5], cf);
+
+    //========================================================================//
+    //  x[i/2 - 2, i/2 - 3, i/2 - 4] -= d * Q
+    //========================================================================//
+        HOST_SUB_CC(r[i - 8], r[i - 8], med[0], cf);
+
+        for (int j = 1; j < 6; ++j)
+        {
+            HOST_SUBC_CC(r[i + j - 8], r[i + j - 8], med[j], cf);
+        }
+
+        HOST_SUBC_CC(r[i - 2], r[i - 2], 0, cf);
+        HOST_SUBC(r[i - 1], r[i - 1], 0, cf);
+
+    //========================================================================//
+    //  x[i/2 - 1, i/2 - 2] += 2 * d
+    //========================================================================//
+        carry = d[1] >> 31;
+        d[1] = (d[1] << 1) | (d[0] >> 31);
+        d[0] <<= 1;
+
+        HOST_ADD_CC(r[i - 4], r[i - 4], d[0], cf);
+        HOST_ADDC_CC(r[i - 3], r[i - 3], d[1], cf);
+        HOST_ADDC_CC(r[i - 2], r[i - 2], carry, cf);
+        HOST_ADDC(r[i - 1], r[i - 1], 0, cf);
+    }
+
+    //========================================================================//
+    //  Last 256 bit correction
+    //========================================================================//
+    HOST_SUB_CC(r[0], r[0], (uint32_t)Q0, cf);
+    HOST_SUBC_CC(r[1], r[1], (uint32_t)(Q0 >> 32), cf);
+    HOST_SUBC_CC(r[2], r[2], (uint32_t)Q1, cf);
+    HOST_SUBC_CC(r[3], r[3], (uint32_t)(Q1 >> 32), cf);
+    HOST_SUBC_CC(r[4], r[4], (uint32_t)Q2, cf);
+
+    for (int j = 5; j < 8; ++j)
+    {
+        HOST_SUBC_CC(r[j], r[j], 0xFFFFFFFF, cf);
+    }
+
+    //========================================================================//
+    HOST_SUBC(carry, 0, 0, cf);
+
+    carry = 0 - carry;
+
+    //========================================================================//
+    HOST_MAD_LO_CC(r[0], carry, (uint32_t)Q0, r[0], cf);
+    HOST_MADC_LO_CC(r[1], carry, (uint32_t)(Q0 >> 32), r[1], cf);
+    HOST_MADC_LO_CC(r[2], carry, (uint32_t)Q1, r[2], cf);
+    HOST_MADC_LO_CC(r[3], carry, (uint32_t)(Q1 >> 32), r[3], cf);
+    HOST_MADC_LO_CC(r[4], carry, (uint32_t)Q2, r[4], cf);
+
+    for (int j = 5; j < 7; ++j)
+    {
+        HOST_MADC_LO_CC(r[j], carry, 0xFFFFFFFF, r[j], cf);
+    }
+
+    HOST_MADC_LO(r[7], carry, 0xFFFFFFFF, r[7], cf);
+
+    //========================================================================//
+    //  Dump result -- LITTLE ENDIAN
+    //========================================================================//
+    memcpy(hash, r, NUM_SIZE_8);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Precalculate hashes in range
+////////////////////////////////////////////////////////////////////////////////
+int HostPrehash(
+    const int keep,
+    // pk || mes || w
+    const uint8_t * pnp,
+    // one-time secret key
+    const uint32_t * x,
+    // unfinalized hash contexts
+    const uctx_t * uctxs,
+    // hashes
+    uint32_t * hashes,
+    // range of indices
+    const uint32_t from,
+    const uint32_t to
+)
+{
+    const int engine = ModQBestEngine();
+
+    // chunk of hashes is multiplied while it is in cache
+    for (uint32_t chunk = from; chunk < to; chunk += PREHASH_CHUNK)
+    {
+        uint32_t end = (chunk + PREHASH_CHUNK < to)? chunk + PREHASH_CHUNK: to;
+
+        for (uint32_t i = chunk; i < end; ++i)
+        {
+            if (keep)
+            {
+                HostCompleteInitPrehash(
+                    pnp, uctxs + i, hashes + i * NUM_SIZE_32
+                );
+            }
+            else
+            {
+                HostInitPrehash(pnp, i, hashes + i * NUM_SIZE_32);
+            }
+        }
+
+        HostMultSecKeyBatch(
+            engine, x, hashes + chunk * NUM_SIZE_32, end - chunk
+        );
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// hostprehash.cc
@@ -9,7 +9,7 @@ inline int key(std::pair<int,int> x)
 
 
 // outputs JSON with GPUs hashrates, temps, and power usages
-void HttpApiThread(std::vector<double>* hashrates, std::vector<std::pair<int,int>>* props)
+void HttpApiThread(hashrate_t* hashrates, std::vector<std::pair<int,int>>* props)
 {
     std::chrono::time_point<std::chrono::system_clock> timeStart;
     timeStart = std::chrono::system_clock::now();
@@ -18,10 +18,11 @@ void HttpApiThread(std::vector<double>* hashrates, std::vector<std::pair<int,int
 
     svr.Get("/", [&](const Request& req, Response& res) {
         
-        std::unordered_map<int, double> hrMap;
-        for(int i = 0; i < (*hashrates).size() ; i++)
+        // device index by PCI bus and device IDs
+        std::unordered_map<int, int> hrMap;
+        for(int i = 0; i < hashrates->devices ; i++)
         {
-            hrMap[key((*props)[i])] = (*hashrates)[i];
+            hrMap[key((*props)[i])] = i;
         }
         
         
@@ -76,8 +77,13 @@ void HttpApiThread(std::vector<double>* hashrates, std::vector<std::pair<int,int
                     double hrate;
                     try{
 
-                        hrate = hrMap.at(key(std::make_pair((int)pciInfo.bus, (int)pciInfo.device)));
+                        int dev = hrMap.at(key(std::make_pair((int)pciInfo.bus, (int)pciInfo.device)));
+                        hrate = hashrates->Rate(dev, 10) / 1e6;
                         deviceInfo << " \"hashrate\" : " << hrate << " , ";
+                        deviceInfo << " \"hashrate1m\" : " << hashrates->Rate(dev, 60) / 1e6 << " , ";
+                        deviceInfo << " \"hashrate15m\" : " << hashrates->Rate(dev, 900) / 1e6 << " , ";
+                        deviceInfo << " \"hashrateEwma\" : " << hashrates->Ewma(dev) / 1e6 << " , ";
+                        deviceInfo << " \"alive\" : " << (hashrates->Alive(dev)? "true": "false") << " , ";
                         totalHr += hrate;
                     }
                     catch (...) // if GPU is not mining ( CUDA_VISIBLE_DEVICES is set)
@@ -0,0 +1,200 @@
+// hugepages.cc
+
+/*******************************************************************************
+
+    HUGEPAGES -- Host tables on huge pages
+
+*******************************************************************************/
+
+#include "../include/hugepages.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#ifndef _WIN32
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB    0x40000
+#endif
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#endif
+
+#define PAGE_4K ((size_t)1 << 12)
+#define PAGE_2M ((size_t)1 << 21)
+#define PAGE_1G ((size_t)1 << 30)
+
+////////////////////////////////////////////////////////////////////////////////
+//  Size rounded up to page
+////////////////////////////////////////////////////////////////////////////////
+static size_t RoundUp(const size_t bytes, const size_t page)
+{
+    return (bytes + page - 1) / page * page;
+}
+
+#ifdef _WIN32
+////////////////////////////////////////////////////////////////////////////////
+//  Enable privilege needed for large pages, if account has it
+////////////////////////////////////////////////////////////////////////////////
+static int EnableLockMemory(void)
+{
+    HANDLE token;
+    TOKEN_PRIVILEGES tp;
+
+    if (!OpenProcessToken(
+        GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token
+    ))
+    {
+        return 0;
+    }
+
+    tp.PrivilegeCount = 1;
+    tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+    int status = LookupPrivilegeValue(
+        NULL, SE_LOCK_MEMORY_NAME, &tp.Privileges[0].Luid
+    ) && AdjustTokenPrivileges(token, FALSE, &tp, 0, NULL, NULL)
+    && GetLastError() == ERROR_SUCCESS;
+
+    CloseHandle(token);
+
+    return status;
+}
+#endif
+
+huge_buffer_t::huge_buffer_t(void)
+{
+    ptr = NULL;
+    size = 0;
+    page = 0;
+    transparent = 0;
+}
+
+huge_buffer_t::~huge_buffer_t(void)
+{
+    Free();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Allocate memory on the largest pages available
+////////////////////////////////////////////////////////////////////////////////
+void * huge_buffer_t::Allocate(const size_t bytes)
+{
+    Free();
+
+#ifdef _WIN32
+    size_t large = GetLargePageMinimum();
+
+    if (large && EnableLockMemory())
+    {
+        size = RoundUp(bytes, large);
+        ptr = VirtualAlloc(
+            NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+            PAGE_READWRITE
+        );
+
+        if (ptr)
+        {
+            page = large;
+            return ptr;
+        }
+    }
+
+    size = RoundUp(bytes, PAGE_4K);
+    ptr = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+    if (ptr) { page = PAGE_4K; } else { size = 0; }
+#else
+    const size_t pages[2] = { PAGE_1G, PAGE_2M };
+    const int shifts[2] = { 30, 21 };
+
+    // hugetlb pool pages are reserved by mmap, failure leaves no mapping
+    for (int i = 0; i < 2; ++i)
+    {
+        size = RoundUp(bytes, pages[i]);
+        ptr = mmap(
+            NULL, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB
+            | (shifts[i] << MAP_HUGE_SHIFT), -1, 0
+        );
+
+        if (ptr != MAP_FAILED)
+        {
+            page = pages[i];
+            return ptr;
+        }
+    }
+
+    // extra 2 MiB to align mapping for transparent huge pages
+    size = RoundUp(bytes, PAGE_2M);
+
+    uint8_t * map = (uint8_t *)mmap(
+        NULL, size + PAGE_2M, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+    );
+
+    if (map == MAP_FAILED)
+    {
+        ptr = NULL;
+        size = 0;
+
+        return NULL;
+    }
+
+    uint8_t * start = (uint8_t *)RoundUp((size_t)map, PAGE_2M);
+
+    if (start > map) { munmap(map, start - map); }
+    munmap(start + size, map + PAGE_2M - start);
+
+    ptr = start;
+    page = PAGE_4K;
+
+#ifdef MADV_HUGEPAGE
+    // before the first touch, so that faults take 2 MiB pages
+    transparent = !madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+#endif
+
+    return ptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Release memory
+////////////////////////////////////////////////////////////////////////////////
+void huge_buffer_t::Free(void)
+{
+    if (ptr)
+    {
+#ifdef _WIN32
+        VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+        munmap(ptr, size);
+#endif
+    }
+
+    ptr = NULL;
+    size = 0;
+    page = 0;
+    transparent = 0;
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Page kind for logs
+////////////////////////////////////////////////////////////////////////////////
+const char * huge_buffer_t::PageName(void) const
+{
+    if (page >= PAGE_1G) { return "1 GiB pages"; }
+    if (page >= PAGE_2M) { return "2 MiB pages"; }
+    if (transparent) { return "transparent huge pages"; }
+
+    return "4 KiB pages";
+}
+
+// hugepages.cc
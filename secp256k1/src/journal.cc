@@ -0,0 +1,490 @@
+// journal.cc
+
+/*******************************************************************************
+
+    JOURNAL -- Durable journal of found solutions
+
+*******************************************************************************/
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#endif
+
+#include "../include/journal.h"
+#include "../include/conversion.h"
+#include "../include/easylogging++.h"
+#include "../include/fanout.h"
+#include "../include/processing.h"
+#include "../include/request.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#define open _open
+#define write _write
+#define close _close
+#define fsync _commit
+#define O_APPEND _O_APPEND
+#define O_CREAT _O_CREAT
+#define O_TRUNC _O_TRUNC
+#define O_WRONLY _O_WRONLY | _O_BINARY
+#else
+#include <unistd.h>
+#endif
+
+#define JOURNAL_MODE 0644
+
+////////////////////////////////////////////////////////////////////////////////
+//  Replace file atomically
+////////////////////////////////////////////////////////////////////////////////
+static int ReplaceFile(const char * from, const char * to)
+{
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING)? 0: -1;
+#else
+    return rename(from, to);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Format solution record
+////////////////////////////////////////////////////////////////////////////////
+static void FormatEntry(const journal_entry_t * entry, char * line)
+{
+    char mes[NUM_SIZE_4 + 1];
+    char w[PK_SIZE_4 + 1];
+    char nonce[NONCE_SIZE_4 + 1];
+    char d[NUM_SIZE_4 + 1];
+
+    BigEndianToHexStr(entry->mes, NUM_SIZE_8, mes);
+    BigEndianToHexStr(entry->w, PK_SIZE_8, w);
+    BigEndianToHexStr(entry->nonce, NONCE_SIZE_8, nonce);
+    BigEndianToHexStr(entry->d, NUM_SIZE_8, d);
+
+    snprintf(
+        line, JOURNAL_LINE_SIZE, "S %llu %lld %s %s %s %s %s\n",
+        (unsigned long long)entry->id, (long long)entry->time,
+        mes, entry->pkstr, w, nonce, d
+    );
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Parse solution record, fails on truncated line
+////////////////////////////////////////////////////////////////////////////////
+static int ParseEntry(const char * line, journal_entry_t * entry)
+{
+    unsigned long long id;
+    long long time;
+    char mes[NUM_SIZE_4 + 1];
+    char w[PK_SIZE_4 + 1];
+    char nonce[NONCE_SIZE_4 + 1];
+    char d[NUM_SIZE_4 + 1];
+
+    if (
+        sscanf(
+            line, "S %llu %lld %64s %66s %66s %16s %64s",
+            &id, &time, mes, entry->pkstr, w, nonce, d
+        ) != 7
+        || strlen(mes) != NUM_SIZE_4 || strlen(entry->pkstr) != PK_SIZE_4
+        || strlen(w) != PK_SIZE_4 || strlen(nonce) != NONCE_SIZE_4
+        || strlen(d) != NUM_SIZE_4
+    )
+    {
+        return EXIT_FAILURE;
+    }
+
+    entry->id = id;
+    entry->time = time;
+
+    HexStrToBigEndian(mes, NUM_SIZE_4, entry->mes, NUM_SIZE_8);
+    HexStrToBigEndian(w, PK_SIZE_4, entry->w, PK_SIZE_8);
+    HexStrToBigEndian(nonce, NONCE_SIZE_4, entry->nonce, NONCE_SIZE_8);
+    HexStrToBigEndian(d, NUM_SIZE_4, entry->d, NUM_SIZE_8);
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Constructor and destructor
+////////////////////////////////////////////////////////////////////////////////
+journal_t::journal_t(void)
+{
+    fileName[0] = '\0';
+    fd = -1;
+    nextId = 1;
+    finished = 0;
+    fresh = 0;
+    written = 0;
+    synced = 0;
+    memset(lastMes, 0, NUM_SIZE_8);
+    proxy = NULL;
+}
+
+journal_t::~journal_t(void)
+{
+    if (fd >= 0) { close(fd); }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Read pending entries and open file for appending
+////////////////////////////////////////////////////////////////////////////////
+int journal_t::Open(const char * name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    fileName[0] = '\0';
+    strncat(fileName, name, MAX_URL_SIZE - 1);
+
+    pending.clear();
+    finished = 0;
+
+    FILE * in = fopen(fileName, "r");
+
+    if (in)
+    {
+        char line[JOURNAL_LINE_SIZE];
+        journal_entry_t entry;
+        unsigned long long id;
+
+        while (fgets(line, JOURNAL_LINE_SIZE, in))
+        {
+            if (line[0] == 'S' && ParseEntry(line, &entry) == EXIT_SUCCESS)
+            {
+                pending.push_back(entry);
+
+                if (entry.id >= nextId) { nextId = entry.id + 1; }
+            }
+            else if (line[0] == 'P' && sscanf(line, "P %llu", &id) == 1)
+            {
+                for (size_t i = 0; i < pending.size(); ++i)
+                {
+                    if (pending[i].id == id)
+                    {
+                        pending.erase(pending.begin() + i);
+                        break;
+                    }
+                }
+
+                ++finished;
+            }
+            else if (line[0] != '\n')
+            {
+                // record was being written when the miner stopped
+                LOG(ERROR) << "Skipping broken journal record: " << line;
+            }
+        }
+
+        fclose(in);
+    }
+
+    if (fd >= 0) { close(fd); }
+
+    fd = open(fileName, O_WRONLY | O_APPEND | O_CREAT, JOURNAL_MODE);
+
+    if (fd < 0)
+    {
+        LOG(ERROR) << "Cannot open solution journal " << fileName;
+        return EXIT_FAILURE;
+    }
+
+    if (pending.size())
+    {
+        LOG(INFO) << pending.size() << " unposted solutions found in journal "
+            << fileName;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Write record line, mutex is held
+////////////////////////////////////////////////////////////////////////////////
+int journal_t::Write(const char * line)
+{
+    size_t len = strlen(line);
+
+    if (fd < 0 || write(fd, line, len) != (int)len)
+    {
+        LOG(ERROR) << "Cannot write solution journal " << fileName;
+        return EXIT_FAILURE;
+    }
+
+    ++written;
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Sync records up to seq to disk
+////////////////////////////////////////////////////////////////////////////////
+int journal_t::Sync(const uint64_t seq)
+{
+    std::lock_guard<std::mutex> lock(syncMutex);
+
+    // another thread synced it meanwhile
+    if (synced.load() >= seq) { return EXIT_SUCCESS; }
+
+    // records written so far are covered by this fsync
+    uint64_t target = written.load();
+
+    if (fsync(fd))
+    {
+        LOG(ERROR) << "Cannot sync solution journal " << fileName;
+        return EXIT_FAILURE;
+    }
+
+    synced = target;
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Write solution to disk and queue it for posting
+////////////////////////////////////////////////////////////////////////////////
+int journal_t::Append(
+    const uint8_t * mes,
+    const char * pkstr,
+    const uint8_t * w,
+    const uint8_t * nonce,
+    const uint8_t * d
+)
+{
+    journal_entry_t entry;
+    char line[JOURNAL_LINE_SIZE];
+    int status;
+    uint64_t seq;
+
+    memcpy(entry.mes, mes, NUM_SIZE_8);
+    memcpy(entry.pkstr, pkstr, PK_SIZE_4 + 1);
+    memcpy(entry.w, w, PK_SIZE_8);
+    memcpy(entry.nonce, nonce, NONCE_SIZE_8);
+    memcpy(entry.d, d, NUM_SIZE_8);
+    entry.time = (int64_t)time(NULL);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        entry.id = nextId++;
+
+        FormatEntry(&entry, line);
+        status = Write(line);
+        seq = written.load();
+
+        // solution is posted even if the disk failed
+        pending.push_back(entry);
+        fresh = 1;
+    }
+
+    if (status == EXIT_SUCCESS) { status = Sync(seq); }
+
+    added.notify_one();
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Mark entry finished, mutex is held
+////////////////////////////////////////////////////////////////////////////////
+int journal_t::Finish(const uint64_t id)
+{
+    char line[JOURNAL_LINE_SIZE];
+
+    for (size_t i = 0; i < pending.size(); ++i)
+    {
+        if (pending[i].id == id)
+        {
+            pending.erase(pending.begin() + i);
+            break;
+        }
+    }
+
+    ++finished;
+
+    snprintf(line, JOURNAL_LINE_SIZE, "P %llu\n", (unsigned long long)id);
+
+    return Write(line);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Post pending entries of current block, drop stale ones
+////////////////////////////////////////////////////////////////////////////////
+int journal_t::Replay(info_t * info)
+{
+    block_data_t block;
+
+    info->block.Read(&block);
+
+    const uint8_t * mes = block.mes;
+    // node address is set by config before threads start
+    const char * to = info->to;
+
+    std::vector<journal_entry_t> entries;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries = pending;
+        fresh = 0;
+    }
+
+    int status = EXIT_SUCCESS;
+    int stale = 0;
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const journal_entry_t & entry = entries[i];
+
+        if (memcmp(entry.mes, mes, NUM_SIZE_8))
+        {
+            LOG(INFO) << "Dropping solution " << entry.id
+                << " found at " << entry.time << ", block has changed";
+            stale = 1;
+        }
+        else if (
+            (
+                (proxy)? proxy->PostSolution(entry.w, entry.nonce, entry.d):
+                PostPuzzleSolution(
+                    to, entry.pkstr, entry.w, entry.nonce, entry.d
+                )
+            ) != EXIT_SUCCESS
+        )
+        {
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Finish(entry.id);
+    }
+
+    // posted marks are synced in one batch
+    if (synced.load() < written.load()) { Sync(written.load()); }
+
+    // block moved on, finished entries are useless
+    if (stale || memcmp(lastMes, mes, NUM_SIZE_8))
+    {
+        memcpy(lastMes, mes, NUM_SIZE_8);
+
+        if (finished) { Compact(); }
+    }
+
+    return status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Rewrite file with pending entries only
+////////////////////////////////////////////////////////////////////////////////
+int journal_t::Compact(void)
+{
+    std::lock_guard<std::mutex> syncLock(syncMutex);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    char tmpName[MAX_URL_SIZE + 4];
+    char line[JOURNAL_LINE_SIZE];
+
+    snprintf(tmpName, sizeof(tmpName), "%s.tmp", fileName);
+
+    int tmp = open(tmpName, O_WRONLY | O_CREAT | O_TRUNC, JOURNAL_MODE);
+
+    if (tmp < 0)
+    {
+        LOG(ERROR) << "Cannot compact solution journal " << fileName;
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+
+    for (size_t i = 0; i < pending.size() && status == EXIT_SUCCESS; ++i)
+    {
+        FormatEntry(&pending[i], line);
+
+        size_t len = strlen(line);
+
+        if (write(tmp, line, len) != (int)len) { status = EXIT_FAILURE; }
+    }
+
+    if (status == EXIT_SUCCESS && fsync(tmp)) { status = EXIT_FAILURE; }
+
+    close(tmp);
+
+    if (status == EXIT_SUCCESS && ReplaceFile(tmpName, fileName))
+    {
+        status = EXIT_FAILURE;
+    }
+
+    if (status != EXIT_SUCCESS)
+    {
+        LOG(ERROR) << "Cannot compact solution journal " << fileName;
+        remove(tmpName);
+
+        return EXIT_FAILURE;
+    }
+
+    close(fd);
+
+    fd = open(fileName, O_WRONLY | O_APPEND | O_CREAT, JOURNAL_MODE);
+
+    if (fd < 0)
+    {
+        LOG(ERROR) << "Cannot open solution journal " << fileName;
+        return EXIT_FAILURE;
+    }
+
+    // new file holds all pending records on disk
+    synced = written.load();
+    finished = 0;
+
+    VLOG(1) << "Compacted solution journal to " << pending.size()
+        << " entries";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Number of pending entries
+////////////////////////////////////////////////////////////////////////////////
+int journal_t::Pending(void)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return pending.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Submitter thread
+////////////////////////////////////////////////////////////////////////////////
+void JournalThread(journal_t * journal, info_t * info)
+{
+    el::Helpers::setThreadName("submitter");
+
+    // pending entries are checked against the first block
+    while (info->blockId.load() == 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    while (1)
+    {
+        journal->Replay(info);
+
+        std::unique_lock<std::mutex> lock(journal->mutex);
+
+        // wake up on new solution or repost period
+        journal->added.wait_for(
+            lock, std::chrono::milliseconds(JOURNAL_REPLAY_MS),
+            [journal]{ return journal->fresh; }
+        );
+    }
+}
+
+// journal.cc
@@ -7,43 +7,6 @@
 *******************************************************************************/
 
 #include "../include/mining.h"
-#include <cuda.h>
-
-////////////////////////////////////////////////////////////////////////////////
-//  Unfinalized hash of message
-////////////////////////////////////////////////////////////////////////////////
-void InitMining(
-    // context
-    ctx_t * ctx,
-    // message
-    const uint32_t * mes,
-    // message length in bytes
-    const uint32_t meslen
-)
-{
-    uint64_t aux[32];
-
-    //========================================================================//
-    //  Initialize context
-    //========================================================================//
-    memset(ctx->b, 0, BUF_SIZE_8);
-    B2B_IV(ctx->h);
-    ctx->h[0] ^= 0x01010000 ^ NUM_SIZE_8;
-    memset(ctx->t, 0, 16);
-    ctx->c = 0;
-
-    //========================================================================//
-    //  Hash message
-    //========================================================================//
-    for (uint_t j = 0; j < meslen; ++j)
-    {
-        if (ctx->c == BUF_SIZE_8) { HOST_B2B_H(ctx, aux); }
-
-        ctx->b[ctx->c++] = ((const uint8_t *)mes)[j];
-    }
-
-    return;
-}
 
 ////////////////////////////////////////////////////////////////////////////////
 //  Block mining                                                               
@@ -55,6 +18,8 @@ __global__ void BlockMining(
     const uint32_t * data,
     // nonce base
     const uint64_t base,
+    // number of nonces in iteration
+    const uint32_t nonces,
     // precalculated hashes
     const uint32_t * hashes,
     // results
@@ -68,14 +33,10 @@ __global__ void BlockMining(
     // shared memory
     __shared__ uint32_t sdata[ROUND_NC_SIZE_32];
 
-#pragma unroll
-    for (int i = 0; i < NC_SIZE_32_BLOCK; ++i)
+    // block size is chosen at runtime, copy with block stride
+    for (uint32_t i = tid; i < ROUND_NC_SIZE_32; i += blockDim.x)
     {
-        sdata[NC_SIZE_32_BLOCK * tid + i]
-            = data[
-                NC_SIZE_32_BLOCK * tid + NUM_SIZE_32 * 2
-                + COUPLED_PK_SIZE_32 + i
-            ];
+        sdata[i] = data[NUM_SIZE_32 * 2 + COUPLED_PK_SIZE_32 + i];
     }
 
     __syncthreads();
@@ -96,7 +57,7 @@ __global__ void BlockMining(
     // (212 + 4) bytes 
     ctx_t * ctx = (ctx_t *)(ldata + 64);
 
-#pragma unroll
+    KERNEL_UNROLL
     for (int t = 0; t < NONCES_PER_THREAD; ++t) 
     {
         *ctx = *((ctx_t *)(sdata + NUM_SIZE_32));
@@ -104,35 +65,29 @@ __global__ void BlockMining(
         tid = threadIdx.x + blockDim.x * blockIdx.x
             + t * gridDim.x * blockDim.x;
 
-        if (tid < NONCES_PER_ITER)
+        if (tid < nonces)
         {
             uint32_t j;
             uint32_t non[NONCE_SIZE_32];
 
-            asm volatile (
-                "add.cc.u32 %0, %1, %2;":
-                "=r"(non[0]): "r"(((uint32_t *)&base)[0]), "r"(tid)
-            );
-
-            asm volatile (
-                "addc.u32 %0, %1, 0;": "=r"(non[1]): "r"(((uint32_t *)&base)[1])
-            );
+            PTX_ADD_CC(non[0], ((uint32_t *)&base)[0], tid);
+            PTX_ADDC(non[1], ((uint32_t *)&base)[1], 0);
 
             //================================================================//
             //  Hash nonce
             //================================================================//
-#pragma unroll
+            KERNEL_UNROLL
             for (j = 0; ctx->c < BUF_SIZE_8 && j < NONCE_SIZE_8; ++j)
             {
                 ctx->b[ctx->c++] = ((uint8_t *)non)[NONCE_SIZE_8 - j - 1];
             }
 
-#pragma unroll
+            KERNEL_UNROLL
             for ( ; j < NONCE_SIZE_8; )
             {
                 DEVICE_B2B_H(ctx, aux);
                
-#pragma unroll
+                KERNEL_UNROLL
                 for ( ; ctx->c < BUF_SIZE_8 && j < NONCE_SIZE_8; ++j)
                 {
                     ctx->b[ctx->c++] = ((uint8_t *)non)[NONCE_SIZE_8 - j - 1];
@@ -144,7 +99,7 @@ __global__ void BlockMining(
             //================================================================//
             DEVICE_B2B_H_LAST(ctx, aux);
 
-#pragma unroll
+            KERNEL_UNROLL
             for (j = 0; j < NUM_SIZE_8; ++j)
             {
                 ((uint8_t *)r)[(j & 0xFFFFFFFC) + (3 - (j & 3))]
@@ -154,18 +109,18 @@ __global__ void BlockMining(
             //================================================================//
             //  Generate indices
             //================================================================//
-#pragma unroll
+            KERNEL_UNROLL
             for (int i = 1; i < INDEX_SIZE_8; ++i)
             {
                 ((uint8_t *)r)[NUM_SIZE_8 + i] = ((uint8_t *)r)[i];
             }
 
-#pragma unroll
+            KERNEL_UNROLL
             for (int k = 0; k < K_LEN; k += INDEX_SIZE_8) 
             { 
                 ind[k] = r[k >> 2] & N_MASK; 
             
-#pragma unroll 
+                KERNEL_UNROLL
                 for (int i = 1; i < INDEX_SIZE_8; ++i) 
                 { 
                     ind[k + i] 
@@ -180,57 +135,43 @@ __global__ void BlockMining(
             //  Calculate result
             //================================================================//
             // first addition of hashes -> r
-            asm volatile (
-                "add.cc.u32 %0, %1, %2;":
-                "=r"(r[0]): "r"(hashes[ind[0] << 3]), "r"(hashes[ind[1] << 3])
-            );
+            PTX_ADD_CC(r[0], hashes[ind[0] << 3], hashes[ind[1] << 3]);
 
-#pragma unroll
+            KERNEL_UNROLL
             for (int i = 1; i < 8; ++i)
             {
-                asm volatile (
-                    "addc.cc.u32 %0, %1, %2;":
-                    "=r"(r[i]):
-                    "r"(hashes[(ind[0] << 3) + i]),
-                    "r"(hashes[(ind[1] << 3) + i])
+                PTX_ADDC_CC(
+                    r[i], hashes[(ind[0] << 3) + i], hashes[(ind[1] << 3) + i]
                 );
             }
 
-            asm volatile ("addc.u32 %0, 0, 0;": "=r"(r[8]));
+            PTX_ADDC(r[8], 0, 0);
 
          // remaining additions
-#pragma unroll
+            KERNEL_UNROLL
             for (int k = 2; k < K_LEN; ++k)
             {
-                asm volatile (
-                    "add.cc.u32 %0, %0, %1;":
-                    "+r"(r[0]): "r"(hashes[ind[k] << 3])
-                );
+                PTX_ADD_CC(r[0], r[0], hashes[ind[k] << 3]);
 
-#pragma unroll
+                KERNEL_UNROLL
                 for (int i = 1; i < 8; ++i)
                 {
-                    asm volatile (
-                        "addc.cc.u32 %0, %0, %1;":
-                        "+r"(r[i]): "r"(hashes[(ind[k] << 3) + i])
-                    );
+                    PTX_ADDC_CC(r[i], r[i], hashes[(ind[k] << 3) + i]);
                 }
 
-                asm volatile ("addc.u32 %0, %0, 0;": "+r"(r[8]));
+                PTX_ADDC(r[8], r[8], 0);
             }
 
             // subtraction of secret key
-            asm volatile ("sub.cc.u32 %0, %0, %1;": "+r"(r[0]): "r"(sk[0]));
+            PTX_SUB_CC(r[0], r[0], sk[0]);
 
-#pragma unroll
+            KERNEL_UNROLL
             for (int i = 1; i < 8; ++i)
             {
-                asm volatile (
-                    "subc.cc.u32 %0, %0, %1;": "+r"(r[i]): "r"(sk[i])
-                );
+                PTX_SUBC_CC(r[i], r[i], sk[i]);
             }
 
-            asm volatile ("subc.u32 %0, %0, 0;": "+r"(r[8]));
+            PTX_SUBC(r[8], r[8], 0);
 
             //================================================================//
             //  Result mod Q
@@ -244,129 +185,85 @@ __global__ void BlockMining(
             d[0] = r[8];
 
             //================================================================//
-            asm volatile (
-                "mul.lo.u32 %0, %1, " q0_s ";": "=r"(med[0]): "r"(*d)
-            );
-
-            asm volatile (
-                "mul.hi.u32 %0, %1, " q0_s ";": "=r"(med[1]): "r"(*d)
-            );
-
-            asm volatile (
-                "mul.lo.u32 %0, %1, " q2_s ";": "=r"(med[2]): "r"(*d)
-            );
-
-            asm volatile (
-                "mul.hi.u32 %0, %1, " q2_s ";": "=r"(med[3]): "r"(*d)
-            );
-
-            asm volatile (
-                "mad.lo.cc.u32 %0, %1, " q1_s ", %0;": "+r"(med[1]): "r"(*d)
-            );
-
-            asm volatile (
-                "madc.hi.cc.u32 %0, %1, " q1_s ", %0;": "+r"(med[2]): "r"(*d)
-            );
-
-            asm volatile (
-                "madc.lo.cc.u32 %0, %1, " q3_s ", %0;": "+r"(med[3]): "r"(*d)
-            );
-
-            asm volatile (
-                "madc.hi.u32 %0, %1, " q3_s ", 0;": "=r"(med[4]): "r"(*d)
-            );
+            PTX_MUL_LO(med[0], *d, q0_u32);
+            PTX_MUL_HI(med[1], *d, q0_u32);
+            PTX_MUL_LO(med[2], *d, q2_u32);
+            PTX_MUL_HI(med[3], *d, q2_u32);
+            PTX_MAD_LO_CC(med[1], *d, q1_u32, med[1]);
+            PTX_MADC_HI_CC(med[2], *d, q1_u32, med[2]);
+            PTX_MADC_LO_CC(med[3], *d, q3_u32, med[3]);
+            PTX_MADC_HI(med[4], *d, q3_u32, 0);
 
             //================================================================//
-            asm volatile ("sub.cc.u32 %0, %0, %1;": "+r"(r[0]): "r"(med[0]));
+            PTX_SUB_CC(r[0], r[0], med[0]);
 
-#pragma unroll
+            KERNEL_UNROLL
             for (int i = 1; i < 5; ++i)
             {
-                asm volatile (
-                    "subc.cc.u32 %0, %0, %1;": "+r"(r[i]): "r"(med[i])
-                );
+                PTX_SUBC_CC(r[i], r[i], med[i]);
             }
 
-#pragma unroll
+            KERNEL_UNROLL
             for (int i = 5; i < 7; ++i)
             {
-                asm volatile ("subc.cc.u32 %0, %0, 0;": "+r"(r[i]));
+                PTX_SUBC_CC(r[i], r[i], 0);
             }
 
-            asm volatile ("subc.u32 %0, %0, 0;": "+r"(r[7]));
+            PTX_SUBC(r[7], r[7], 0);
 
             //================================================================//
             d[1] = d[0] >> 31;
             d[0] <<= 1;
 
-            asm volatile ("add.cc.u32 %0, %0, %1;": "+r"(r[4]): "r"(d[0]));
-            asm volatile ("addc.cc.u32 %0, %0, %1;": "+r"(r[5]): "r"(d[1]));
-            asm volatile ("addc.cc.u32 %0, %0, 0;": "+r"(r[6]));
-            asm volatile ("addc.u32 %0, %0, 0;": "+r"(r[7]));
+            PTX_ADD_CC(r[4], r[4], d[0]);
+            PTX_ADDC_CC(r[5], r[5], d[1]);
+            PTX_ADDC_CC(r[6], r[6], 0);
+            PTX_ADDC(r[7], r[7], 0);
 
             //================================================================//
-            asm volatile ("sub.cc.u32 %0, %0, " q0_s ";": "+r"(r[0]));
-            asm volatile ("subc.cc.u32 %0, %0, " q1_s ";": "+r"(r[1]));
-            asm volatile ("subc.cc.u32 %0, %0, " q2_s ";": "+r"(r[2]));
-            asm volatile ("subc.cc.u32 %0, %0, " q3_s ";": "+r"(r[3]));
-            asm volatile ("subc.cc.u32 %0, %0, " q4_s ";": "+r"(r[4]));
+            PTX_SUB_CC(r[0], r[0], q0_u32);
+            PTX_SUBC_CC(r[1], r[1], q1_u32);
+            PTX_SUBC_CC(r[2], r[2], q2_u32);
+            PTX_SUBC_CC(r[3], r[3], q3_u32);
+            PTX_SUBC_CC(r[4], r[4], q4_u32);
 
-#pragma unroll
+            KERNEL_UNROLL
             for (int i = 5; i < 8; ++i)
             {
-                asm volatile ("subc.cc.u32 %0, %0, " qhi_s ";": "+r"(r[i]));
+                PTX_SUBC_CC(r[i], r[i], qhi_u32);
             }
 
-            asm volatile ("subc.u32 %0, 0, 0;": "=r"(*carry));
+            PTX_SUBC(*carry, 0, 0);
 
             *carry = 0 - *carry;
 
             //================================================================//
-            asm volatile (
-                "mad.lo.cc.u32 %0, %1, " q0_s ", %0;": "+r"(r[0]): "r"(*carry)
-            );
-
-            asm volatile (
-                "madc.lo.cc.u32 %0, %1, " q1_s ", %0;": "+r"(r[1]): "r"(*carry)
-            );
-
-            asm volatile (
-                "madc.lo.cc.u32 %0, %1, " q2_s ", %0;": "+r"(r[2]): "r"(*carry)
-            );
-
-            asm volatile (
-                "madc.lo.cc.u32 %0, %1, " q3_s ", %0;": "+r"(r[3]): "r"(*carry)
-            );
+            PTX_MAD_LO_CC(r[0], *carry, q0_u32, r[0]);
+            PTX_MADC_LO_CC(r[1], *carry, q1_u32, r[1]);
+            PTX_MADC_LO_CC(r[2], *carry, q2_u32, r[2]);
+            PTX_MADC_LO_CC(r[3], *carry, q3_u32, r[3]);
+            PTX_MADC_LO_CC(r[4], *carry, q4_u32, r[4]);
 
-            asm volatile (
-                "madc.lo.cc.u32 %0, %1, " q4_s ", %0;": "+r"(r[4]): "r"(*carry)
-            );
-
-#pragma unroll
+            KERNEL_UNROLL
             for (int i = 5; i < 7; ++i)
             {
-                asm volatile (
-                    "madc.lo.cc.u32 %0, %1, " qhi_s ", %0;":
-                    "+r"(r[i]): "r"(*carry)
-                );
+                PTX_MADC_LO_CC(r[i], *carry, qhi_u32, r[i]);
             }
 
-            asm volatile (
-                "madc.lo.u32 %0, %1, " qhi_s ", %0;": "+r"(r[7]): "r"(*carry)
-            );
+            PTX_MADC_LO(r[7], *carry, qhi_u32, r[7]);
 
             //================================================================//
             //  Dump result to global memory -- LITTLE ENDIAN
             //================================================================//
             j = ((uint64_t *)r)[3] < ((uint64_t *)bound)[3]
-                || ((uint64_t *)r)[3] == ((uint64_t *)bound)[3] && (
+                || (((uint64_t *)r)[3] == ((uint64_t *)bound)[3] && (
                     ((uint64_t *)r)[2] < ((uint64_t *)bound)[2]
-                    || ((uint64_t *)r)[2] == ((uint64_t *)bound)[2] && (
+                    || (((uint64_t *)r)[2] == ((uint64_t *)bound)[2] && (
                         ((uint64_t *)r)[1] < ((uint64_t *)bound)[1]
-                        || ((uint64_t *)r)[1] == ((uint64_t *)bound)[1]
-                        && ((uint64_t *)r)[0] < ((uint64_t *)bound)[0]
-                    )
-                );
+                        || (((uint64_t *)r)[1] == ((uint64_t *)bound)[1]
+                        && ((uint64_t *)r)[0] < ((uint64_t *)bound)[0])
+                    ))
+                ));
 
             
 
@@ -375,7 +272,7 @@ __global__ void BlockMining(
 
                 
                 valid[0] = tid+1; 
-                #pragma unroll
+                KERNEL_UNROLL
                 for (int i = 0; i < NUM_SIZE_32; ++i)
                 {
                     res[i] = r[i];
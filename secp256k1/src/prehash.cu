@@ -9,7 +9,12 @@
 #include "../include/prehash.h"
 #include "../include/compaction.h"
 #include "../include/definitions.h"
-#include <cuda.h>
+#include "../include/easylogging++.h"
+
+// idx || M with zero index bytes as message words, broadcast to warp
+__constant__ uint64_t constMesSchedule[CONST_SCHEDULE_SIZE_64] = {
+    CONST_MES_SCHEDULE
+};
 
 ////////////////////////////////////////////////////////////////////////////////
 //  First iteration of hashes precalculation
@@ -28,7 +33,7 @@ __global__ void InitPrehash(
     // shared memory
     __shared__ uint32_t sdata[ROUND_PNP_SIZE_32];
 
-#pragma unroll
+    KERNEL_UNROLL
     for (int i = 0; i < PNP_SIZE_32_BLOCK; ++i)
     {
         sdata[PNP_SIZE_32_BLOCK * tid + i] = data[PNP_SIZE_32_BLOCK * tid + i];
@@ -65,45 +70,35 @@ __global__ void InitPrehash(
         ctx->c = 0;
 
         //====================================================================//
-        //  Hash tid
-        //====================================================================//
-#pragma unroll
-        for (j = 0; ctx->c < BUF_SIZE_8 && j < INDEX_SIZE_8; ++j)
-        {
-            ctx->b[ctx->c++] = ((const uint8_t *)&tid)[INDEX_SIZE_8 - j - 1];
-        }
-
-        //====================================================================//
-        //  Hash constant message
+        //  Hash tid and constant message by schedule words
         //====================================================================//
-#pragma unroll
-        for (j = 0; ctx->c < BUF_SIZE_8 && j < CONST_MES_SIZE_8; ++j)
+        for (j = 0; j < CONST_MES_BLOCKS; ++j)
         {
-            ctx->b[ctx->c++]
-                = (
-                    !((7 - (j & 7)) >> 1)
-                    * ((j >> 3) >> (((~(j & 7)) & 1) << 3))
-                ) & 0xFF;
-        }
-
-        while (j < CONST_MES_SIZE_8)
-        {
-            DEVICE_B2B_H(ctx, aux);
+            KERNEL_UNROLL
+            for (int i = 0; i < 16; ++i)
+            {
+                ((uint64_t *)ctx->b)[i] = constMesSchedule[j * 16 + i];
+            }
 
-            for ( ; ctx->c < BUF_SIZE_8 && j < CONST_MES_SIZE_8; ++j)
+            if (!j)
             {
-                ctx->b[ctx->c++]
-                    = (
-                        !((7 - (j & 7)) >> 1)
-                        * ((j >> 3) >> (((~(j & 7)) & 1) << 3))
-                    ) & 0xFF;
+                KERNEL_UNROLL
+                for (int i = 0; i < INDEX_SIZE_8; ++i)
+                {
+                    ctx->b[i] = ((const uint8_t *)&tid)[INDEX_SIZE_8 - i - 1];
+                }
             }
+
+            DEVICE_B2B_H(ctx, aux);
         }
 
+        ((uint64_t *)ctx->b)[0] = constMesSchedule[CONST_MES_BLOCKS * 16];
+        ctx->c = CONST_MES_REM_8;
+
         //====================================================================//
         //  Hash public key, message & one-time public key
         //====================================================================//
-#pragma unroll
+        KERNEL_UNROLL
         for (j = 0; ctx->c < BUF_SIZE_8 && j < 2 * PK_SIZE_8 + NUM_SIZE_8; ++j)
         {
             ctx->b[ctx->c++] = ((const uint8_t *)rem)[j];
@@ -124,7 +119,7 @@ __global__ void InitPrehash(
         //====================================================================//
         DEVICE_B2B_H_LAST(ctx, aux);
 
-#pragma unroll
+        KERNEL_UNROLL
         for (j = 0; j < NUM_SIZE_8; ++j)
         {
             ((uint8_t *)ldata)[NUM_SIZE_8 - j - 1]
@@ -135,18 +130,18 @@ __global__ void InitPrehash(
         //  Dump result to global memory -- BIG ENDIAN
         //====================================================================//
         j = ((uint64_t *)ldata)[3] < Q3
-            || ((uint64_t *)ldata)[3] == Q3 && (
+            || (((uint64_t *)ldata)[3] == Q3 && (
                 ((uint64_t *)ldata)[2] < Q2
-                || ((uint64_t *)ldata)[2] == Q2 && (
+                || (((uint64_t *)ldata)[2] == Q2 && (
                     ((uint64_t *)ldata)[1] < Q1
-                    || ((uint64_t *)ldata)[1] == Q1
-                    && ((uint64_t *)ldata)[0] < Q0
-                )
-            );
+                    || (((uint64_t *)ldata)[1] == Q1
+                    && ((uint64_t *)ldata)[0] < Q0)
+                ))
+            ));
 
         //invalid[tid] = (1 - j) * (tid + 1);
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int i = 0; i < NUM_SIZE_8; ++i)
         {
             ((uint8_t *)hashes)[(tid + 1) * NUM_SIZE_8 - i - 1]
@@ -165,19 +160,19 @@ __global__ void InitPrehash(
             //====================================================================//
             //  Hash previous hash
             //====================================================================//
-            #pragma unroll
+            KERNEL_UNROLL
             for (j = 0; ctx->c < BUF_SIZE_8 && j < NUM_SIZE_8; ++j)
             {
                 ctx->b[ctx->c++]
                     = ((const uint8_t *)(hashes + tid * NUM_SIZE_32))[j];
             }
 
-            #pragma unroll
+            KERNEL_UNROLL
             for ( ; j < NUM_SIZE_8; )
             {
                 DEVICE_B2B_H(ctx, aux);
             
-            #pragma unroll
+                KERNEL_UNROLL
                 for ( ; ctx->c < BUF_SIZE_8 && j < NUM_SIZE_8; ++j)
                 {
                     ctx->b[ctx->c++]
@@ -190,7 +185,7 @@ __global__ void InitPrehash(
             //====================================================================//
             DEVICE_B2B_H_LAST(ctx, aux);
 
-            #pragma unroll
+            KERNEL_UNROLL
             for (j = 0; j < NUM_SIZE_8; ++j)
             {
                 ((uint8_t *)ldata)[NUM_SIZE_8 - j - 1]
@@ -201,16 +196,16 @@ __global__ void InitPrehash(
             //  Dump result to global memory -- BIG ENDIAN
             //====================================================================//
             j = ((uint64_t *)ldata)[3] < Q3
-                || ((uint64_t *)ldata)[3] == Q3 && (
+                || (((uint64_t *)ldata)[3] == Q3 && (
                     ((uint64_t *)ldata)[2] < Q2
-                    || ((uint64_t *)ldata)[2] == Q2 && (
+                    || (((uint64_t *)ldata)[2] == Q2 && (
                         ((uint64_t *)ldata)[1] < Q1
-                        || ((uint64_t *)ldata)[1] == Q1
-                        && ((uint64_t *)ldata)[0] < Q0
-                    )
-                );
+                        || (((uint64_t *)ldata)[1] == Q1
+                        && ((uint64_t *)ldata)[0] < Q0)
+                    ))
+                ));
 
-            #pragma unroll
+            KERNEL_UNROLL
             for (int i = 0; i < NUM_SIZE_8; ++i)
             {
                     ((uint8_t *)hashes)[(tid + 1) * NUM_SIZE_8 - i - 1]
@@ -240,7 +235,7 @@ __global__ void UncompleteInitPrehash(
     // shared memory
     __shared__ uint32_t sdata[ROUND_PK_SIZE_32];
 
-#pragma unroll
+    KERNEL_UNROLL
     for (int i = 0; i < PK_SIZE_32_BLOCK; ++i)
     {
         sdata[PK_SIZE_32_BLOCK * tid + i] = data[PK_SIZE_32_BLOCK * tid + i];
@@ -277,56 +272,46 @@ __global__ void UncompleteInitPrehash(
         ctx->c = 0;
 
         //====================================================================//
-        //  Hash tid
+        //  Hash tid and constant message by schedule words
         //====================================================================//
-#pragma unroll
-        for (j = 0; ctx->c < BUF_SIZE_8 && j < INDEX_SIZE_8; ++j)
+        for (j = 0; j < CONST_MES_BLOCKS; ++j)
         {
-            ctx->b[ctx->c++] = ((const uint8_t *)&tid)[INDEX_SIZE_8 - j - 1];
-        }
-
-        //====================================================================//
-        //  Hash constant message
-        //====================================================================//
-#pragma unroll
-        for (j = 0; ctx->c < BUF_SIZE_8 && j < CONST_MES_SIZE_8; ++j)
-        {
-            ctx->b[ctx->c++]
-                = (
-                    !((7 - (j & 7)) >> 1)
-                    * ((j >> 3) >> (((~(j & 7)) & 1) << 3))
-                ) & 0xFF;
-        }
-
-        while (j < CONST_MES_SIZE_8)
-        {
-            DEVICE_B2B_H(ctx, aux);
+            KERNEL_UNROLL
+            for (int i = 0; i < 16; ++i)
+            {
+                ((uint64_t *)ctx->b)[i] = constMesSchedule[j * 16 + i];
+            }
 
-            for ( ; ctx->c < BUF_SIZE_8 && j < CONST_MES_SIZE_8; ++j)
+            if (!j)
             {
-                ctx->b[ctx->c++]
-                    = (
-                        !((7 - (j & 7)) >> 1)
-                        * ((j >> 3) >> (((~(j & 7)) & 1) << 3))
-                    ) & 0xFF;
+                KERNEL_UNROLL
+                for (int i = 0; i < INDEX_SIZE_8; ++i)
+                {
+                    ctx->b[i] = ((const uint8_t *)&tid)[INDEX_SIZE_8 - i - 1];
+                }
             }
+
+            DEVICE_B2B_H(ctx, aux);
         }
 
+        ((uint64_t *)ctx->b)[0] = constMesSchedule[CONST_MES_BLOCKS * 16];
+        ctx->c = CONST_MES_REM_8;
+
         //====================================================================//
         //  Hash public key
         //====================================================================//
-#pragma unroll
+        KERNEL_UNROLL
         for (j = 0; ctx->c < BUF_SIZE_8 && j < PK_SIZE_8; ++j)
         {
             ctx->b[ctx->c++] = ((const uint8_t *)pk)[j];
         }
 
-#pragma unroll
+        KERNEL_UNROLL
         for ( ; j < PK_SIZE_8; )
         {
             DEVICE_B2B_H(ctx, aux);
            
-#pragma unroll
+            KERNEL_UNROLL
             for ( ; ctx->c < BUF_SIZE_8 && j < PK_SIZE_8; ++j)
             {
                 ctx->b[ctx->c++] = ((const uint8_t *)pk)[j];
@@ -336,17 +321,11 @@ __global__ void UncompleteInitPrehash(
         //====================================================================//
         //  Dump result to global memory
         //====================================================================//
-#pragma unroll
+        KERNEL_UNROLL
         for (int i = 0; i < 16; ++i)
         {
             ((uint32_t *)uctxs[tid].h)[i] = ((uint32_t *)ctx->h)[i];
         }
-
-#pragma unroll
-        for (int i = 0; i < 4; ++i)
-        {
-            ((uint32_t *)uctxs[tid].t)[i] = ((uint32_t *)ctx->t)[i];
-        }
     }
 
     return;
@@ -372,7 +351,7 @@ __global__ void CompleteInitPrehash(
     // shared memory
     __shared__ uint32_t sdata[ROUND_NP_SIZE_32];
 
-#pragma unroll
+    KERNEL_UNROLL
     for (int i = 0; i < NP_SIZE_32_BLOCK; ++i)
     {
         sdata[NP_SIZE_32_BLOCK * tid + i]
@@ -403,7 +382,7 @@ __global__ void CompleteInitPrehash(
         //====================================================================//
         ctx->c = CONTINUE_POS;
 
-#pragma unroll
+        KERNEL_UNROLL
         for (
             j = CONST_MES_SIZE_8 - BUF_SIZE_8 + PK_SIZE_8 - 1;
             ctx->c < BUF_SIZE_8 && j < CONST_MES_SIZE_8;
@@ -419,7 +398,7 @@ __global__ void CompleteInitPrehash(
 
         ctx->c = 0;
 
-#pragma unroll
+        KERNEL_UNROLL
         for ( ; j < CONST_MES_SIZE_8; ++j)
         {
             ctx->b[ctx->c++]
@@ -429,7 +408,7 @@ __global__ void CompleteInitPrehash(
                 ) & 0xFF;
         }
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int i = 0; i < NUM_SIZE_32; ++i)
         {
             ((uint32_t *)(ctx->b + ctx->c))[i] = ((uint32_t *)data)[i]; 
@@ -440,33 +419,30 @@ __global__ void CompleteInitPrehash(
 
         ctx->c += PK_SIZE_8;
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int i = 0; i < 16; ++i)
         {
             ((uint32_t *)ctx->h)[i] = ((uint32_t *)uctxs[tid].h)[i];
         }
 
-#pragma unroll
-        for (int i = 0; i < 4; ++i)
-        {
-            ((uint32_t *)ctx->t)[i] = ((uint32_t *)uctxs[tid].t)[i];
-        }
+        ctx->t[0] = UCTX_COUNT;
+        ctx->t[1] = 0;
 
         //====================================================================//
         //  Hash public key, message & one-time public key
         //====================================================================//
-#pragma unroll
+        KERNEL_UNROLL
         for (j = 0; ctx->c < BUF_SIZE_8 && j < PK_SIZE_8 + NUM_SIZE_8; ++j)
         {
             ctx->b[ctx->c++] = rem[j];
         }
 
-#pragma unroll
+        KERNEL_UNROLL
         for ( ; j < PK_SIZE_8 + NUM_SIZE_8; )
         {
             DEVICE_B2B_H(ctx, aux);
            
-#pragma unroll
+            KERNEL_UNROLL
             for ( ; ctx->c < BUF_SIZE_8 && j < PK_SIZE_8 + NUM_SIZE_8; ++j)
             {
                 ctx->b[ctx->c++] = rem[j];
@@ -478,7 +454,7 @@ __global__ void CompleteInitPrehash(
         //====================================================================//
         DEVICE_B2B_H_LAST(ctx, aux);
 
-#pragma unroll
+        KERNEL_UNROLL
         for (j = 0; j < NUM_SIZE_8; ++j)
         {
             ((uint8_t *)ldata)[NUM_SIZE_8 - j - 1]
@@ -489,18 +465,18 @@ __global__ void CompleteInitPrehash(
         //  Dump result to global memory -- BIG ENDIAN
         //====================================================================//
         j = ((uint64_t *)ldata)[3] < Q3
-            || ((uint64_t *)ldata)[3] == Q3 && (
+            || (((uint64_t *)ldata)[3] == Q3 && (
                 ((uint64_t *)ldata)[2] < Q2
-                || ((uint64_t *)ldata)[2] == Q2 && (
+                || (((uint64_t *)ldata)[2] == Q2 && (
                     ((uint64_t *)ldata)[1] < Q1
-                    || ((uint64_t *)ldata)[1] == Q1
-                    && ((uint64_t *)ldata)[0] < Q0
-                )
-            );
+                    || (((uint64_t *)ldata)[1] == Q1
+                    && ((uint64_t *)ldata)[0] < Q0)
+                ))
+            ));
 
         //invalid[tid] = (1 - j) * (tid + 1);
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int i = 0; i < NUM_SIZE_8; ++i)
         {
             ((uint8_t *)hashes)[tid * NUM_SIZE_8 + NUM_SIZE_8 - i - 1]
@@ -519,19 +495,19 @@ __global__ void CompleteInitPrehash(
             //====================================================================//
             //  Hash previous hash
             //====================================================================//
-            #pragma unroll
+            KERNEL_UNROLL
             for (j = 0; ctx->c < BUF_SIZE_8 && j < NUM_SIZE_8; ++j)
             {
                 ctx->b[ctx->c++]
                     = ((const uint8_t *)(hashes + tid*NUM_SIZE_32))[j];
             }
 
-            #pragma unroll
+            KERNEL_UNROLL
             for ( ; j < NUM_SIZE_8; )
             {
                 DEVICE_B2B_H(ctx, aux);
             
-            #pragma unroll
+                KERNEL_UNROLL
                 for ( ; ctx->c < BUF_SIZE_8 && j < NUM_SIZE_8; ++j)
                 {
                     ctx->b[ctx->c++]
@@ -544,7 +520,7 @@ __global__ void CompleteInitPrehash(
             //====================================================================//
             DEVICE_B2B_H_LAST(ctx, aux);
 
-            #pragma unroll
+            KERNEL_UNROLL
             for (j = 0; j < NUM_SIZE_8; ++j)
             {
                 ((uint8_t *)ldata)[NUM_SIZE_8 - j - 1]
@@ -555,16 +531,16 @@ __global__ void CompleteInitPrehash(
             //  Dump result to global memory -- BIG ENDIAN
             //====================================================================//
             j = ((uint64_t *)ldata)[3] < Q3
-                || ((uint64_t *)ldata)[3] == Q3 && (
+                || (((uint64_t *)ldata)[3] == Q3 && (
                     ((uint64_t *)ldata)[2] < Q2
-                    || ((uint64_t *)ldata)[2] == Q2 && (
+                    || (((uint64_t *)ldata)[2] == Q2 && (
                         ((uint64_t *)ldata)[1] < Q1
-                        || ((uint64_t *)ldata)[1] == Q1
-                        && ((uint64_t *)ldata)[0] < Q0
-                    )
-                );
+                        || (((uint64_t *)ldata)[1] == Q1
+                        && ((uint64_t *)ldata)[0] < Q0)
+                    ))
+                ));
 
-            #pragma unroll
+            KERNEL_UNROLL
             for (int i = 0; i < NUM_SIZE_8; ++i)
             {
                     ((uint8_t *)hashes)[ (tid+1) * NUM_SIZE_8 - i - 1]
@@ -621,19 +597,19 @@ __global__ void UpdatePrehash(
         //====================================================================//
         //  Hash previous hash
         //====================================================================//
-#pragma unroll
+        KERNEL_UNROLL
         for (j = 0; ctx->c < BUF_SIZE_8 && j < NUM_SIZE_8; ++j)
         {
             ctx->b[ctx->c++]
                 = ((const uint8_t *)(hashes + addr * NUM_SIZE_32))[j];
         }
 
-#pragma unroll
+        KERNEL_UNROLL
         for ( ; j < NUM_SIZE_8; )
         {
             DEVICE_B2B_H(ctx, aux);
            
-#pragma unroll
+            KERNEL_UNROLL
             for ( ; ctx->c < BUF_SIZE_8 && j < NUM_SIZE_8; ++j)
             {
                 ctx->b[ctx->c++]
@@ -646,7 +622,7 @@ __global__ void UpdatePrehash(
         //====================================================================//
         DEVICE_B2B_H_LAST(ctx, aux);
 
-#pragma unroll
+        KERNEL_UNROLL
         for (j = 0; j < NUM_SIZE_8; ++j)
         {
             ((uint8_t *)ldata)[NUM_SIZE_8 - j - 1]
@@ -657,18 +633,18 @@ __global__ void UpdatePrehash(
         //  Dump result to global memory -- BIG ENDIAN
         //====================================================================//
         j = ((uint64_t *)ldata)[3] < Q3
-            || ((uint64_t *)ldata)[3] == Q3 && (
+            || (((uint64_t *)ldata)[3] == Q3 && (
                 ((uint64_t *)ldata)[2] < Q2
-                || ((uint64_t *)ldata)[2] == Q2 && (
+                || (((uint64_t *)ldata)[2] == Q2 && (
                     ((uint64_t *)ldata)[1] < Q1
-                    || ((uint64_t *)ldata)[1] == Q1
-                    && ((uint64_t *)ldata)[0] < Q0
-                )
-            );
+                    || (((uint64_t *)ldata)[1] == Q1
+                    && ((uint64_t *)ldata)[0] < Q0)
+                ))
+            ));
 
         invalid[tid] *= 1 - j;
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int i = 0; i < NUM_SIZE_8; ++i)
         {
             ((uint8_t *)hashes)[(addr + 1) * NUM_SIZE_8 - i - 1]
@@ -694,7 +670,7 @@ __global__ void FinalPrehash(
         // local memory
         uint32_t h[NUM_SIZE_32];
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int i = 0; i < NUM_SIZE_8; ++i)
         {
              ((uint8_t *)h)[i]
@@ -706,55 +682,41 @@ __global__ void FinalPrehash(
         //====================================================================//
         uint32_t carry;
 
-        asm volatile ("sub.cc.u32 %0, %0, " q0_s ";": "+r"(h[0]));
-        asm volatile ("subc.cc.u32 %0, %0, " q1_s ";": "+r"(h[1]));
-        asm volatile ("subc.cc.u32 %0, %0, " q2_s ";": "+r"(h[2]));
-        asm volatile ("subc.cc.u32 %0, %0, " q3_s ";": "+r"(h[3]));
-        asm volatile ("subc.cc.u32 %0, %0, " q4_s ";": "+r"(h[4]));
+        PTX_SUB_CC(h[0], h[0], q0_u32);
+        PTX_SUBC_CC(h[1], h[1], q1_u32);
+        PTX_SUBC_CC(h[2], h[2], q2_u32);
+        PTX_SUBC_CC(h[3], h[3], q3_u32);
+        PTX_SUBC_CC(h[4], h[4], q4_u32);
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int j = 5; j < 8; ++j)
         {
-            asm volatile ("subc.cc.u32 %0, %0, " qhi_s ";": "+r"(h[j]));
+            PTX_SUBC_CC(h[j], h[j], qhi_u32);
         }
 
-        asm volatile ("subc.u32 %0, 0, 0;": "=r"(carry));
+        PTX_SUBC(carry, 0, 0);
 
         carry = 0 - carry;
 
         //====================================================================//
-        asm volatile (
-            "mad.lo.cc.u32 %0, %1, " q0_s ", %0;": "+r"(h[0]): "r"(carry)
-        );
-        asm volatile (
-            "madc.lo.cc.u32 %0, %1, " q1_s ", %0;": "+r"(h[1]): "r"(carry)
-        );
-        asm volatile (
-            "madc.lo.cc.u32 %0, %1, " q2_s ", %0;": "+r"(h[2]): "r"(carry)
-        );
-        asm volatile (
-            "madc.lo.cc.u32 %0, %1, " q3_s ", %0;": "+r"(h[3]): "r"(carry)
-        );
-        asm volatile (
-            "madc.lo.cc.u32 %0, %1, " q4_s ", %0;": "+r"(h[4]): "r"(carry)
-        );
+        PTX_MAD_LO_CC(h[0], carry, q0_u32, h[0]);
+        PTX_MADC_LO_CC(h[1], carry, q1_u32, h[1]);
+        PTX_MADC_LO_CC(h[2], carry, q2_u32, h[2]);
+        PTX_MADC_LO_CC(h[3], carry, q3_u32, h[3]);
+        PTX_MADC_LO_CC(h[4], carry, q4_u32, h[4]);
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int j = 5; j < 7; ++j)
         {
-            asm volatile (
-                "madc.lo.cc.u32 %0, %1, " qhi_s ", %0;": "+r"(h[j]): "r"(carry)
-            );
+            PTX_MADC_LO_CC(h[j], carry, qhi_u32, h[j]);
         }
 
-        asm volatile (
-            "madc.lo.u32 %0, %1, " qhi_s ", %0;": "+r"(h[7]): "r"(carry)
-        );
+        PTX_MADC_LO(h[7], carry, qhi_u32, h[7]);
 
         //====================================================================//
         //  Dump result to global memory -- BIG ENDIAN
         //====================================================================//
-#pragma unroll
+        KERNEL_UNROLL
         for (int i = 0; i < NUM_SIZE_8; ++i)
         {
             ((uint8_t *)hashes)[tid * NUM_SIZE_8 + i]
@@ -780,7 +742,7 @@ __global__ void FinalPrehashMultSecKey(
     // shared memory
     __shared__ uint32_t sdata[ROUND_NUM_SIZE_32];
 
-#pragma unroll
+    KERNEL_UNROLL
     for (int i = 0; i < NUM_SIZE_32_BLOCK; ++i)
     {
         sdata[NUM_SIZE_32_BLOCK * tid + i]
@@ -802,7 +764,7 @@ __global__ void FinalPrehashMultSecKey(
         // local memory
         uint32_t h[NUM_SIZE_32];
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int j = 0; j < NUM_SIZE_8; ++j)
         {
              ((uint8_t *)h)[j]
@@ -815,117 +777,61 @@ __global__ void FinalPrehashMultSecKey(
         //  r[0, ..., 7, 8] = h[0] * x
         //====================================================================//
         // initialize r[0, ..., 7]
-#pragma unroll
+        KERNEL_UNROLL
         for (int j = 0; j < 8; j += 2)
         {
-            asm volatile (
-                "mul.lo.u32 %0, %1, %2;": "=r"(r[j]): "r"(h[0]), "r"(x[j])
-            );
-
-            asm volatile (
-                "mul.hi.u32 %0, %1, %2;": "=r"(r[j + 1]): "r"(h[0]), "r"(x[j])
-            );
+            PTX_MUL_LO(r[j], h[0], x[j]);
+            PTX_MUL_HI(r[j + 1], h[0], x[j]);
         }
 
         //====================================================================//
-        asm volatile (
-            "mad.lo.cc.u32 %0, %1, %2, %0;": "+r"(r[1]): "r"(h[0]), "r"(x[1])
-        );
-
-        asm volatile (
-            "madc.hi.cc.u32 %0, %1, %2, %0;": "+r"(r[2]): "r"(h[0]), "r"(x[1])
-        );
+        PTX_MAD_LO_CC(r[1], h[0], x[1], r[1]);
+        PTX_MADC_HI_CC(r[2], h[0], x[1], r[2]);
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int j = 3; j < 6; j += 2)
         {
-            asm volatile (
-                "madc.lo.cc.u32 %0, %1, %2, %0;":
-                "+r"(r[j]): "r"(h[0]), "r"(x[j])
-            );
-
-            asm volatile (
-                "madc.hi.cc.u32 %0, %1, %2, %0;":
-                "+r"(r[j + 1]): "r"(h[0]), "r"(x[j])
-            );
+            PTX_MADC_LO_CC(r[j], h[0], x[j], r[j]);
+            PTX_MADC_HI_CC(r[j + 1], h[0], x[j], r[j + 1]);
         }
 
-        asm volatile (
-            "madc.lo.cc.u32 %0, %1, %2, %0;": "+r"(r[7]): "r"(h[0]), "r"(x[7])
-        );
+        PTX_MADC_LO_CC(r[7], h[0], x[7], r[7]);
 
         // initialize r[8]
-        asm volatile (
-            "madc.hi.u32 %0, %1, %2, 0;": "=r"(r[8]): "r"(h[0]), "r"(x[7])
-        );
+        PTX_MADC_HI(r[8], h[0], x[7], 0);
 
         //====================================================================//
         //  r[i, ..., i + 7, i + 8] += h[i] * x
         //====================================================================//
-#pragma unroll
+        KERNEL_UNROLL
         for (int i = 1; i < NUM_SIZE_32; ++i)
         {
-            asm volatile (
-                "mad.lo.cc.u32 %0, %1, %2, %0;":
-                "+r"(r[i]): "r"(h[i]), "r"(x[0])
-            );
-
-            asm volatile (
-                "madc.hi.cc.u32 %0, %1, %2, %0;":
-                "+r"(r[i + 1]): "r"(h[i]), "r"(x[0])
-            );
+            PTX_MAD_LO_CC(r[i], h[i], x[0], r[i]);
+            PTX_MADC_HI_CC(r[i + 1], h[i], x[0], r[i + 1]);
 
-#pragma unroll
+            KERNEL_UNROLL
             for (int j = 2; j < 8; j += 2)
             {
-                asm volatile (
-                    "madc.lo.cc.u32 %0, %1, %2, %0;":
-                    "+r"(r[i + j]): "r"(h[i]), "r"(x[j])
-                );
-
-                asm volatile (
-                    "madc.hi.cc.u32 %0, %1, %2, %0;":
-                    "+r"(r[i + j + 1]): "r"(h[i]), "r"(x[j])
-                );
+                PTX_MADC_LO_CC(r[i + j], h[i], x[j], r[i + j]);
+                PTX_MADC_HI_CC(r[i + j + 1], h[i], x[j], r[i + j + 1]);
             }
 
             // initialize r[i + 8]
-            asm volatile ("addc.u32 %0, 0, 0;": "=r"(r[i + 8]));
+            PTX_ADDC(r[i + 8], 0, 0);
 
         //====================================================================//
-            asm volatile (
-                "mad.lo.cc.u32 %0, %1, %2, %0;":
-                "+r"(r[i + 1]): "r"(h[i]), "r"(x[1])
-            );
+            PTX_MAD_LO_CC(r[i + 1], h[i], x[1], r[i + 1]);
+            PTX_MADC_HI_CC(r[i + 2], h[i], x[1], r[i + 2]);
 
-            asm volatile (
-                "madc.hi.cc.u32 %0, %1, %2, %0;":
-                "+r"(r[i + 2]): "r"(h[i]), "r"(x[1])
-            );
-
-#pragma unroll
+            KERNEL_UNROLL
             for (int j = 3; j < 6; j += 2)
             {
-                asm volatile (
-                    "madc.lo.cc.u32 %0, %1, %2, %0;":
-                    "+r"(r[i + j]): "r"(h[i]), "r"(x[j])
-                );
-
-                asm volatile (
-                    "madc.hi.cc.u32 %0, %1, %2, %0;":
-                    "+r"(r[i + j + 1]): "r"(h[i]), "r"(x[j])
-                );
+                PTX_MADC_LO_CC(r[i + j], h[i], x[j], r[i + j]);
+                PTX_MADC_HI_CC(r[i + j + 1], h[i], x[j], r[i + j + 1]);
             }
 
-            asm volatile (
-                "madc.lo.cc.u32 %0, %1, %2, %0;":
-                "+r"(r[i + 7]): "r"(h[i]), "r"(x[7])
-            );
-
-            asm volatile (
-                "madc.hi.u32 %0, %1, %2, %0;":
-                "+r"(r[i + 8]): "r"(h[i]), "r"(x[7])
-            );
+            PTX_MADC_LO_CC(r[i + 7], h[i], x[7], r[i + 7]);
+            PTX_MADC_HI(r[i + 8], h[i], x[7], r[i + 8]);
         }
 
         //====================================================================//
@@ -935,7 +841,7 @@ __global__ void FinalPrehashMultSecKey(
         uint32_t med[6];
         uint32_t carry;
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int i = (NUM_SIZE_32 - 1) << 1; i >= NUM_SIZE_32; i -= 2)
         {
             *((uint64_t *)d) = ((uint64_t *)r)[i >> 1];
@@ -943,90 +849,39 @@ __global__ void FinalPrehashMultSecKey(
         //====================================================================//
         //  med[0, ..., 5] = d * Q
         //====================================================================//
-            asm volatile (
-                "mul.lo.u32 %0, %1, " q0_s ";": "=r"(med[0]): "r"(d[0])
-            );
-
-            asm volatile (
-                "mul.hi.u32 %0, %1, " q0_s ";": "=r"(med[1]): "r"(d[0])
-            );
-
-            asm volatile (
-                "mul.lo.u32 %0, %1, " q2_s ";": "=r"(med[2]): "r"(d[0])
-            );
-
-            asm volatile (
-                "mul.hi.u32 %0, %1, " q2_s ";": "=r"(med[3]): "r"(d[0])
-            );
-
-            asm volatile (
-                "mad.lo.cc.u32 %0, %1, " q1_s ", %0;": "+r"(med[1]): "r"(d[0])
-            );
-
-            asm volatile (
-                "madc.hi.cc.u32 %0, %1, " q1_s ", %0;": "+r"(med[2]): "r"(d[0])
-            );
-
-            asm volatile (
-                "madc.lo.cc.u32 %0, %1, " q3_s ", %0;": "+r"(med[3]): "r"(d[0])
-            );
-
-            asm volatile (
-                "madc.hi.u32 %0, %1, " q3_s ", 0;": "=r"(med[4]): "r"(d[0])
-            );
+            PTX_MUL_LO(med[0], d[0], q0_u32);
+            PTX_MUL_HI(med[1], d[0], q0_u32);
+            PTX_MUL_LO(med[2], d[0], q2_u32);
+            PTX_MUL_HI(med[3], d[0], q2_u32);
+            PTX_MAD_LO_CC(med[1], d[0], q1_u32, med[1]);
+            PTX_MADC_HI_CC(med[2], d[0], q1_u32, med[2]);
+            PTX_MADC_LO_CC(med[3], d[0], q3_u32, med[3]);
+            PTX_MADC_HI(med[4], d[0], q3_u32, 0);
 
         //====================================================================//
-            asm volatile (
-                "mad.lo.cc.u32 %0, %1, " q0_s ", %0;": "+r"(med[1]): "r"(d[1])
-            );
-
-            asm volatile (
-                "madc.hi.cc.u32 %0, %1, " q0_s ", %0;": "+r"(med[2]): "r"(d[1])
-            );
-
-            asm volatile (
-                "madc.lo.cc.u32 %0, %1, " q2_s ", %0;": "+r"(med[3]): "r"(d[1])
-            );
-
-            asm volatile (
-                "madc.hi.cc.u32 %0, %1," q2_s", %0;": "+r"(med[4]): "r"(d[1])
-            );
-
-            asm volatile ("addc.u32 %0, 0, 0;": "=r"(med[5]));
-
-            asm volatile (
-                "mad.lo.cc.u32 %0, %1, " q1_s ", %0;": "+r"(med[2]): "r"(d[1])
-            );
-
-            asm volatile (
-                "madc.hi.cc.u32 %0, %1, " q1_s ", %0;": "+r"(med[3]): "r"(d[1])
-            );
-
-            asm volatile (
-                "madc.lo.cc.u32 %0, %1, " q3_s ", %0;": "+r"(med[4]): "r"(d[1])
-            );
-
-            asm volatile (
-                "madc.hi.u32 %0, %1, " q3_s ", %0;": "+r"(med[5]): "r"(d[1])
-            );
+            PTX_MAD_LO_CC(med[1], d[1], q0_u32, med[1]);
+            PTX_MADC_HI_CC(med[2], d[1], q0_u32, med[2]);
+            PTX_MADC_LO_CC(med[3], d[1], q2_u32, med[3]);
+            PTX_MADC_HI_CC(med[4], d[1], q2_u32, med[4]);
+            PTX_ADDC(med[5], 0, 0);
+            PTX_MAD_LO_CC(med[2], d[1], q1_u32, med[2]);
+            PTX_MADC_HI_CC(med[3], d[1], q1_u32, med[3]);
+            PTX_MADC_LO_CC(med[4], d[1], q3_u32, med[4]);
+            PTX_MADC_HI(med[5], d[1], q3_u32, med[5]);
 
         //====================================================================//
         //  x[i/2 - 2, i/2 - 3, i/2 - 4] -= d * Q
         //====================================================================//
-            asm volatile (
-                "sub.cc.u32 %0, %0, %1;": "+r"(r[i - 8]): "r"(med[0])
-            );
+            PTX_SUB_CC(r[i - 8], r[i - 8], med[0]);
 
-#pragma unroll
+            KERNEL_UNROLL
             for (int j = 1; j < 6; ++j)
             {
-                asm volatile (
-                    "subc.cc.u32 %0, %0, %1;": "+r"(r[i + j - 8]): "r"(med[j])
-                );
+                PTX_SUBC_CC(r[i + j - 8], r[i + j - 8], med[j]);
             }
 
-            asm volatile ("subc.cc.u32 %0, %0, 0;": "+r"(r[i - 2]));
-            asm volatile ("subc.u32 %0, %0, 0;": "+r"(r[i - 1]));
+            PTX_SUBC_CC(r[i - 2], r[i - 2], 0);
+            PTX_SUBC(r[i - 1], r[i - 1], 0);
 
         //====================================================================//
         //  x[i/2 - 1, i/2 - 2] += 2 * d
@@ -1035,69 +890,51 @@ __global__ void FinalPrehashMultSecKey(
             d[1] = (d[1] << 1) | (d[0] >> 31);
             d[0] <<= 1;
 
-            asm volatile ("add.cc.u32 %0, %0, %1;": "+r"(r[i - 4]): "r"(d[0]));
-            asm volatile ("addc.cc.u32 %0, %0, %1;": "+r"(r[i - 3]): "r"(d[1]));
-
-            asm volatile (
-                "addc.cc.u32 %0, %0, %1;": "+r"(r[i - 2]): "r"(carry)
-            );
-
-            asm volatile ("addc.u32 %0, %0, 0;": "+r"(r[i - 1]));
+            PTX_ADD_CC(r[i - 4], r[i - 4], d[0]);
+            PTX_ADDC_CC(r[i - 3], r[i - 3], d[1]);
+            PTX_ADDC_CC(r[i - 2], r[i - 2], carry);
+            PTX_ADDC(r[i - 1], r[i - 1], 0);
         }
 
         //====================================================================//
         //  Last 256 bit correction
         //====================================================================//
-        asm volatile ("sub.cc.u32 %0, %0, " q0_s ";": "+r"(r[0]));
-        asm volatile ("subc.cc.u32 %0, %0, " q1_s ";": "+r"(r[1]));
-        asm volatile ("subc.cc.u32 %0, %0, " q2_s ";": "+r"(r[2]));
-        asm volatile ("subc.cc.u32 %0, %0, " q3_s ";": "+r"(r[3]));
-        asm volatile ("subc.cc.u32 %0, %0, " q4_s ";": "+r"(r[4]));
+        PTX_SUB_CC(r[0], r[0], q0_u32);
+        PTX_SUBC_CC(r[1], r[1], q1_u32);
+        PTX_SUBC_CC(r[2], r[2], q2_u32);
+        PTX_SUBC_CC(r[3], r[3], q3_u32);
+        PTX_SUBC_CC(r[4], r[4], q4_u32);
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int j = 5; j < 8; ++j)
         {
-            asm volatile ("subc.cc.u32 %0, %0, " qhi_s ";": "+r"(r[j]));
+            PTX_SUBC_CC(r[j], r[j], qhi_u32);
         }
 
         //====================================================================//
-        asm volatile ("subc.u32 %0, 0, 0;": "=r"(carry));
+        PTX_SUBC(carry, 0, 0);
 
         carry = 0 - carry;
 
         //====================================================================//
-        asm volatile (
-            "mad.lo.cc.u32 %0, %1, " q0_s ", %0;": "+r"(r[0]): "r"(carry)
-        );
-        asm volatile (
-            "madc.lo.cc.u32 %0, %1, " q1_s ", %0;": "+r"(r[1]): "r"(carry)
-        );
-        asm volatile (
-            "madc.lo.cc.u32 %0, %1, " q2_s ", %0;": "+r"(r[2]): "r"(carry)
-        );
-        asm volatile (
-            "madc.lo.cc.u32 %0, %1, " q3_s ", %0;": "+r"(r[3]): "r"(carry)
-        );
-        asm volatile (
-            "madc.lo.cc.u32 %0, %1, " q4_s ", %0;": "+r"(r[4]): "r"(carry)
-        );
+        PTX_MAD_LO_CC(r[0], carry, q0_u32, r[0]);
+        PTX_MADC_LO_CC(r[1], carry, q1_u32, r[1]);
+        PTX_MADC_LO_CC(r[2], carry, q2_u32, r[2]);
+        PTX_MADC_LO_CC(r[3], carry, q3_u32, r[3]);
+        PTX_MADC_LO_CC(r[4], carry, q4_u32, r[4]);
 
-#pragma unroll
+        KERNEL_UNROLL
         for (int j = 5; j < 7; ++j)
         {
-            asm volatile (
-                "madc.lo.cc.u32 %0, %1, " qhi_s ", %0;": "+r"(r[j]): "r"(carry)
-            );
+            PTX_MADC_LO_CC(r[j], carry, qhi_u32, r[j]);
         }
 
-        asm volatile (
-            "madc.lo.u32 %0, %1, " qhi_s ", %0;": "+r"(r[7]): "r"(carry)
-        );
+        PTX_MADC_LO(r[7], carry, qhi_u32, r[7]);
 
         //====================================================================//
         //  Dump result to global memory -- LITTLE ENDIAN
         //====================================================================//
-#pragma unroll
+        KERNEL_UNROLL
         for (int i = 0; i < NUM_SIZE_32; ++i)
         {
             hashes[tid * NUM_SIZE_32 + i] = r[i];
@@ -1107,6 +944,9 @@ __global__ void FinalPrehashMultSecKey(
     return;
 }
 
+// kernel launches, host build runs kernels by HostLaunch
+#ifdef __CUDACC__
+
 ////////////////////////////////////////////////////////////////////////////////
 //  Precalculate hashes
 ////////////////////////////////////////////////////////////////////////////////
@@ -1131,7 +971,7 @@ int Prehash(
         CompleteInitPrehash<<<1 + (N_LEN - 1) / BLOCK_DIM, BLOCK_DIM>>>(
             data, uctxs, hashes, ind
         );
-        CUDA_CALL(cudaPeekAtLastError());
+        CUDA_CHECK(cudaPeekAtLastError());
     }
     // hash index, constant message and public key
     else
@@ -1139,15 +979,18 @@ int Prehash(
         InitPrehash<<<1 + (N_LEN - 1) / BLOCK_DIM, BLOCK_DIM>>>(
             data, hashes, ind
         );
-        CUDA_CALL(cudaPeekAtLastError());
+        CUDA_CHECK(cudaPeekAtLastError());
     }
     
     // multiply by secret key moq Q
     FinalPrehashMultSecKey<<<1 + (N_LEN - 1) / BLOCK_DIM, BLOCK_DIM>>>(
         data, hashes
     );
+    CUDA_CHECK(cudaPeekAtLastError());
 
     return EXIT_SUCCESS;
 }
 
+#endif // __CUDACC__
+
 // prehash.cu
@@ -6,10 +6,12 @@
 
 *******************************************************************************/
 #include "../include/easylogging++.h"
+#include "../include/backend.h"
 #include "../include/conversion.h"
 #include "../include/cryptography.h"
 #include "../include/definitions.h"
 #include "../include/jsmn.h"
+#include "../include/sharedtable.h"
 #include <ctype.h>
 #include <curl/curl.h>
 #include <inttypes.h>
@@ -18,6 +20,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
+#include <chrono>
 #include <fstream>
 #include <string>
 
@@ -27,13 +30,15 @@
 // understands single-level json strings ({"a":"b", "c":"d", ...})
 int ReadConfig(
     const char * fileName,
-    uint8_t * sk,
-    char * skstr,
     char * from,
-    char * to,
-    int * keep
+    info_t * info
 )
 {
+    uint8_t * sk = info->sk;
+    char * skstr = info->skstr;
+    char * to = info->to;
+    int * keep = &info->keepPrehash;
+
     std::ifstream file(
         fileName, std::ios::in | std::ios::binary | std::ios::ate
     );
@@ -77,9 +82,34 @@ int ReadConfig(
     // default keepPrehash = false
     *keep = 0;
 
+    // default backend is all CUDA devices
+    info->backend = BACKEND_CUDA;
+    info->devices = 1;
+    info->cpuThreads = 0;
+    info->cpuNumaReplicate = 0;
+    info->cpuShared = SHARED_NONE;
+    strcpy(info->cpuSharedName, "autolykos");
+    info->threadPlacement = PLACEMENT_NONE;
+    info->simPrehashMs = SIM_PREHASH_MS;
+    info->simIterMs = SIM_ITER_MS;
+    info->simMemory = SIM_MEMORY;
+    info->noncesPerIter = 0;
+    info->blockDim = 0;
+    info->autotune = 0;
+    info->targetTemp = 0;
+    info->targetPower = 0;
+    strcpy(info->tuneProfile, "./autotune.profile");
+    strcpy(info->journal, "./solutions.journal");
+
+    // node is not polled if candidates come from a proxy
+    from[0] = '\0';
+    to[0] = '\0';
+    info->proxy[0] = '\0';
+
     char* seedstring;
     char* seedPass;
 
+    // options are counted by CONF_OPTIONS
     for (int t = 1; t < numtoks; t += 2)
     {
         if (config.jsoneq(t, "node"))
@@ -109,6 +139,152 @@ int ReadConfig(
                 VLOG(1) << "Setting keepPrehash to 1";
             }
         }
+        else if (config.jsoneq(t, "backend"))
+        {
+            if (
+                ParseBackendType(
+                    config.GetTokenStart(t + 1), config.GetTokenLen(t + 1),
+                    &info->backend
+                ) != EXIT_SUCCESS
+            )
+            {
+                LOG(ERROR) << "Unknown backend, valid backends are "
+                              "\"cuda\", \"cpu\" and \"sim\"";
+                return EXIT_FAILURE;
+            }
+
+            VLOG(1) << "Setting backend to " << info->backend;
+        }
+        else if (config.jsoneq(t, "devices"))
+        {
+            info->devices = atoi(config.GetTokenStart(t + 1));
+
+            if (info->devices <= 0)
+            {
+                LOG(ERROR) << "Number of devices should be positive";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (config.jsoneq(t, "cpuThreads"))
+        {
+            info->cpuThreads = atoi(config.GetTokenStart(t + 1));
+        }
+        else if (config.jsoneq(t, "cpuNumaReplicate"))
+        {
+            info->cpuNumaReplicate
+                = !strncmp(config.GetTokenStart(t + 1), "true", 4);
+        }
+        else if (config.jsoneq(t, "cpuSharedTable"))
+        {
+            if (config.jsoneq(t + 1, "none"))
+            {
+                info->cpuShared = SHARED_NONE;
+            }
+            else if (config.jsoneq(t + 1, "builder"))
+            {
+                info->cpuShared = SHARED_BUILDER;
+            }
+            else if (config.jsoneq(t + 1, "reader"))
+            {
+                info->cpuShared = SHARED_READER;
+            }
+            else
+            {
+                LOG(ERROR) << "Unknown shared table role, valid ones are "
+                              "\"none\", \"builder\" and \"reader\"";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (config.jsoneq(t, "cpuSharedName"))
+        {
+            info->cpuSharedName[0] = '\0';
+
+            strncat(
+                info->cpuSharedName, config.GetTokenStart(t + 1),
+                (config.GetTokenLen(t + 1) < 64)?
+                config.GetTokenLen(t + 1): 63
+            );
+        }
+        else if (config.jsoneq(t, "threadPlacement"))
+        {
+            if (config.jsoneq(t + 1, "none"))
+            {
+                info->threadPlacement = PLACEMENT_NONE;
+            }
+            else if (config.jsoneq(t + 1, "cores"))
+            {
+                info->threadPlacement = PLACEMENT_CORES;
+            }
+            else
+            {
+                LOG(ERROR) << "Unknown thread placement, valid ones are "
+                              "\"none\" and \"cores\"";
+                return EXIT_FAILURE;
+            }
+        }
+        else if (config.jsoneq(t, "simPrehashMs"))
+        {
+            info->simPrehashMs = atoi(config.GetTokenStart(t + 1));
+        }
+        else if (config.jsoneq(t, "simIterMs"))
+        {
+            info->simIterMs = atoi(config.GetTokenStart(t + 1));
+        }
+        else if (config.jsoneq(t, "simMemory"))
+        {
+            info->simMemory = atoi(config.GetTokenStart(t + 1));
+        }
+        else if (config.jsoneq(t, "noncesPerIter"))
+        {
+            info->noncesPerIter = strtoul(config.GetTokenStart(t + 1), NULL, 0);
+        }
+        else if (config.jsoneq(t, "blockDim"))
+        {
+            info->blockDim = strtoul(config.GetTokenStart(t + 1), NULL, 0);
+        }
+        else if (config.jsoneq(t, "autotune"))
+        {
+            info->autotune
+                = !strncmp(config.GetTokenStart(t + 1), "true", 4);
+        }
+        else if (config.jsoneq(t, "tuneProfile"))
+        {
+            info->tuneProfile[0] = '\0';
+
+            strncat(
+                info->tuneProfile, config.GetTokenStart(t + 1),
+                (config.GetTokenLen(t + 1) < MAX_URL_SIZE)?
+                config.GetTokenLen(t + 1): MAX_URL_SIZE - 1
+            );
+        }
+        else if (config.jsoneq(t, "targetTemp"))
+        {
+            info->targetTemp = atof(config.GetTokenStart(t + 1));
+        }
+        else if (config.jsoneq(t, "targetPower"))
+        {
+            info->targetPower = atof(config.GetTokenStart(t + 1));
+        }
+        else if (config.jsoneq(t, "journal"))
+        {
+            info->journal[0] = '\0';
+
+            strncat(
+                info->journal, config.GetTokenStart(t + 1),
+                (config.GetTokenLen(t + 1) < MAX_URL_SIZE)?
+                config.GetTokenLen(t + 1): MAX_URL_SIZE - 1
+            );
+        }
+        else if (config.jsoneq(t, "proxy"))
+        {
+            info->proxy[0] = '\0';
+
+            strncat(
+                info->proxy, config.GetTokenStart(t + 1),
+                (config.GetTokenLen(t + 1) < MAX_URL_SIZE)?
+                config.GetTokenLen(t + 1): MAX_URL_SIZE - 1
+            );
+        }
         else if (config.jsoneq(t, "mnemonic") || config.jsoneq(t,"seed"))
         {
 
@@ -130,7 +306,14 @@ int ReadConfig(
         else
         {
             LOG(INFO) << "Unrecognized config option, currently valid options are "
-                         "\"node\", \"mnemonic\", \"mnemonicPass\" and \"keepPrehash\"";
+                         "\"node\", \"mnemonic\", \"mnemonicPass\", \"keepPrehash\", "
+                         "\"backend\", \"devices\", \"cpuThreads\", "
+                         "\"cpuNumaReplicate\", \"cpuSharedTable\", "
+                         "\"cpuSharedName\", \"threadPlacement\", "
+                         "\"simPrehashMs\", \"simIterMs\", \"simMemory\", "
+                         "\"noncesPerIter\", \"blockDim\", \"autotune\", "
+                         "\"tuneProfile\", \"targetTemp\", \"targetPower\", "
+                         "\"journal\" and \"proxy\"";
         }
     }
 
@@ -175,7 +358,7 @@ int ReadConfig(
 
 
 
-    if (readSeed & readNode) { return EXIT_SUCCESS; }
+    if (readSeed && (readNode || info->proxy[0])) { return EXIT_SUCCESS; }
     else
     {
         LOG(ERROR) << "Incomplete config: node or seed are not specified";
@@ -183,6 +366,58 @@ int ReadConfig(
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//  Lock info mutex accounting wait time
+////////////////////////////////////////////////////////////////////////////////
+void LockInfo(info_t * info)
+{
+    using namespace std::chrono;
+
+    steady_clock::time_point start = steady_clock::now();
+
+    info->info_mutex.lock();
+
+    info->lockWaitNs += duration_cast<nanoseconds>(
+        steady_clock::now() - start
+    ).count();
+    ++(info->lockCount);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Publish block data and wake waiting miners
+////////////////////////////////////////////////////////////////////////////////
+void PublishBlock(info_t * info, const block_data_t * block)
+{
+    info->block.Publish(block);
+
+    {
+        // increment under mutex is not lost between check and wait
+        std::lock_guard<std::mutex> lock(info->blockMutex);
+        ++(info->blockId);
+    }
+
+    info->blockSignal.notify_all();
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Wait for a new block without spinning
+////////////////////////////////////////////////////////////////////////////////
+uint_t WaitBlock(info_t * info, const uint_t blockId, const int ms)
+{
+    std::unique_lock<std::mutex> lock(info->blockMutex);
+
+    info->blockSignal.wait_for(
+        lock, std::chrono::milliseconds(ms),
+        [&](void) { return info->blockId.load() != blockId; }
+    );
+
+    return info->blockId.load();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //  Print public key
 ////////////////////////////////////////////////////////////////////////////////
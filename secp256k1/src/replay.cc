@@ -0,0 +1,159 @@
+// replay.cc
+
+/*******************************************************************************
+
+    REPLAY -- Candidate stream recorder, replay server, node emulator,
+              share validation service and candidate fan-out proxy
+
+    replay.out record <node URL> <file>
+    replay.out serve <file> [speed] [port]
+    replay.out emulate <config> [solutions/s] [block s] [hashrate] [port]
+    replay.out validate [threads] [port]
+    replay.out load <server URL> [batch] [clients] [seconds] [invalid]
+    replay.out proxy <node URL> [port] [poll ms]
+
+*******************************************************************************/
+
+#include "../include/candidates.h"
+#include "../include/cryptography.h"
+#include "../include/definitions.h"
+#include "../include/easylogging++.h"
+#include "../include/emulator.h"
+#include "../include/fanout.h"
+#include "../include/processing.h"
+#include "../include/validator.h"
+#include <curl/curl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+INITIALIZE_EASYLOGGINGPP
+
+////////////////////////////////////////////////////////////////////////////////
+//  Main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char ** argv)
+{
+    START_EASYLOGGINGPP(argc, argv);
+
+    el::Loggers::reconfigureAllLoggers(
+        el::ConfigurationType::Format, "%datetime %level [%thread] %msg"
+    );
+
+    el::Helpers::setThreadName("replay thread");
+
+    if (argc == 4 && !strcmp(argv[1], "record"))
+    {
+        curl_global_init(CURL_GLOBAL_ALL);
+
+        return RecordCandidates(argv[2], argv[3]);
+    }
+
+    if (argc >= 3 && argc <= 5 && !strcmp(argv[1], "serve"))
+    {
+        std::vector<candidate_t> stream;
+
+        double speed = (argc > 3)? atof(argv[3]): 1;
+        int port = (argc > 4)? atoi(argv[4]): CANDIDATES_PORT;
+
+        if (speed <= 0)
+        {
+            LOG(ERROR) << "Replay speed should be positive";
+            return EXIT_FAILURE;
+        }
+
+        if (ReadCandidates(argv[2], &stream) != EXIT_SUCCESS)
+        {
+            return EXIT_FAILURE;
+        }
+
+        return ServeCandidates(stream, speed, port);
+    }
+
+    if (argc >= 3 && argc <= 7 && !strcmp(argv[1], "emulate"))
+    {
+        char from[MAX_URL_SIZE];
+        info_t info;
+
+        info.lockWaitNs = 0;
+        info.lockCount = 0;
+
+        // public key of the miner using the same configuration
+        if (ReadConfig(argv[2], from, &info) != EXIT_SUCCESS)
+        {
+            return EXIT_FAILURE;
+        }
+
+        GeneratePublicKey(info.skstr, info.pkstr, info.pk);
+
+        double rate = (argc > 3)? atof(argv[3]): 0.1;
+        double blockSec = (argc > 4)? atof(argv[4]): 120;
+        double hashrate = (argc > 5)? atof(argv[5]): 1e8;
+        int port = (argc > 6)? atoi(argv[6]): EMULATOR_PORT;
+
+        if (rate <= 0 || blockSec <= 0 || hashrate <= 0)
+        {
+            LOG(ERROR) << "Solution rate, block time and hashrate "
+                "should be positive";
+            return EXIT_FAILURE;
+        }
+
+        return EmulateNode(info.pkstr, rate, blockSec, hashrate, port);
+    }
+
+    if (argc >= 2 && argc <= 4 && !strcmp(argv[1], "validate"))
+    {
+        int threads = (argc > 2)? atoi(argv[2]): 0;
+        int port = (argc > 3)? atoi(argv[3]): VALIDATOR_PORT;
+
+        return ServeValidation(threads, port);
+    }
+
+    if (argc >= 3 && argc <= 7 && !strcmp(argv[1], "load"))
+    {
+        curl_global_init(CURL_GLOBAL_ALL);
+
+        int batch = (argc > 3)? atoi(argv[3]): 64;
+        int clients = (argc > 4)? atoi(argv[4]): 4;
+        double seconds = (argc > 5)? atof(argv[5]): 10;
+        double invalid = (argc > 6)? atof(argv[6]): 0.1;
+
+        if (batch <= 0 || clients <= 0 || seconds <= 0)
+        {
+            LOG(ERROR) << "Batch, clients and duration should be positive";
+            return EXIT_FAILURE;
+        }
+
+        return LoadValidation(argv[2], batch, clients, seconds, invalid);
+    }
+
+    if (argc >= 3 && argc <= 5 && !strcmp(argv[1], "proxy"))
+    {
+        curl_global_init(CURL_GLOBAL_ALL);
+
+        int port = (argc > 3)? atoi(argv[3]): FANOUT_PORT;
+        int pollMs = (argc > 4)? atoi(argv[4]): FANOUT_POLL_MS;
+
+        if (pollMs <= 0)
+        {
+            LOG(ERROR) << "Poll period should be positive";
+            return EXIT_FAILURE;
+        }
+
+        return ServeFanout(argv[2], port, pollMs);
+    }
+
+    LOG(ERROR) << "Usage:\n"
+        << "   " << argv[0] << " record <node URL> <file>\n"
+        << "   " << argv[0] << " serve <file> [speed] [port]\n"
+        << "   " << argv[0]
+        << " emulate <config> [solutions/s] [block s] [hashrate] [port]\n"
+        << "   " << argv[0] << " validate [threads] [port]\n"
+        << "   " << argv[0]
+        << " load <server URL> [batch] [clients] [seconds] [invalid]\n"
+        << "   " << argv[0] << " proxy <node URL> [port] [poll ms]";
+
+    return EXIT_FAILURE;
+}
+
+// replay.cc
@@ -193,11 +193,15 @@ int ParseRequest(json_t * oldreq , json_t * newreq, info_t *info, int checkPubKe
         }
     }
 
-    // check if we need to change anything, only then lock info mutex
+    // check if we need to change anything, only then publish block data
     if (mesChanged || boundChanged || !(oldreq->len))
     {
-        info->info_mutex.lock();
-        
+        block_data_t block;
+
+        // poller is the only writer, its own snapshot is never torn
+        info->block.Read(&block);
+        block.changed = 0;
+
         //================================================================//
         //  Substitute message and change state when message changed
         //================================================================//
@@ -205,8 +209,10 @@ int ParseRequest(json_t * oldreq , json_t * newreq, info_t *info, int checkPubKe
         {
                 HexStrToBigEndian(
                     newreq->GetTokenStart(MesPos), newreq->GetTokenLen(MesPos),
-                    info->mes, NUM_SIZE_8
+                    block.mes, NUM_SIZE_8
                 );
+
+                block.changed |= BLOCK_MES_CHANGED;
         }
 
         //================================================================//
@@ -222,13 +228,13 @@ int ParseRequest(json_t * oldreq , json_t * newreq, info_t *info, int checkPubKe
                 buf
             );
 
-            HexStrToLittleEndian(buf, NUM_SIZE_4, info->bound, NUM_SIZE_8);
+            HexStrToLittleEndian(buf, NUM_SIZE_4, block.bound, NUM_SIZE_8);
+
+            block.changed |= BLOCK_BOUND_CHANGED;
         }
-        
-        info->info_mutex.unlock();
-        
+
         // signaling uint
-        ++(info->blockId);
+        PublishBlock(info, &block);
         LOG(INFO) << "Got new block in main thread, block data: " << newreq->ptr;
     }
 
@@ -382,16 +388,92 @@ int PostPuzzleSolution(
     }
     while (retries < MAX_POST_RETRIES && curlError != CURLE_OK);
 
-    
-    
     CurlLogError(curlError);
 
-    LOG(INFO) << "Node response:" << respond.ptr;
+    long code = 0;
+
+    if (curlError == CURLE_OK)
+    {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+
+        LOG(INFO) << "Node response:" << respond.ptr;
+    }
 
     curl_easy_cleanup(curl);
     curl_slist_free_all(headers);
 
+    // node is down or failed, solution was not checked
+    if (curlError != CURLE_OK || code >= 500)
+    {
+        LOG(ERROR) << "Solution was not delivered to node, HTTP code " << code;
+        return EXIT_FAILURE;
+    }
+
     return EXIT_SUCCESS;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//  Parse body of solution POST request
+////////////////////////////////////////////////////////////////////////////////
+int ParseSolution(
+    const char * body,
+    uint8_t * pk,
+    uint8_t * w,
+    uint8_t * nonce,
+    uint8_t * d
+)
+{
+    json_t sol(strlen(body), SOL_LEN);
+    jsmn_parser parser;
+
+    memcpy(sol.ptr, body, sol.len);
+    ToUppercase(sol.ptr);
+    jsmn_init(&parser);
+
+    int numtoks = jsmn_parse(&parser, sol.ptr, sol.len, sol.toks, SOL_LEN);
+
+    if (numtoks < 0) { return EXIT_FAILURE; }
+
+    int read = 0;
+
+    for (int t = 1; t + 1 < numtoks; t += 2)
+    {
+        const char * val = sol.GetTokenStart(t + 1);
+        int len = sol.GetTokenLen(t + 1);
+
+        if (sol.jsoneq(t, "PK") && len == PK_SIZE_4)
+        {
+            HexStrToBigEndian(val, len, pk, PK_SIZE_8);
+            read |= 1;
+        }
+        else if (sol.jsoneq(t, "W") && len == PK_SIZE_4)
+        {
+            HexStrToBigEndian(val, len, w, PK_SIZE_8);
+            read |= 2;
+        }
+        else if (sol.jsoneq(t, "N") && len == NONCE_SIZE_4)
+        {
+            HexStrToLittleEndian(val, len, nonce, NONCE_SIZE_8);
+            read |= 4;
+        }
+        else if (sol.jsoneq(t, "D"))
+        {
+            // decimal digits of number without exponent
+            int digits = 0;
+
+            while (digits < len && isdigit(val[digits])) { ++digits; }
+
+            if (!digits || digits > 78) { return EXIT_FAILURE; }
+
+            char hex[NUM_SIZE_4 + 1];
+
+            DecStrToHexStrOf64(val, digits, hex);
+            HexStrToLittleEndian(hex, NUM_SIZE_4, d, NUM_SIZE_8);
+            read |= 8;
+        }
+    }
+
+    return (read == 15)? EXIT_SUCCESS: EXIT_FAILURE;
+}
+
 // request.cc
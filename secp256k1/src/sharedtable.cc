@@ -0,0 +1,330 @@
+// sharedtable.cc
+
+/*******************************************************************************
+
+    SHAREDTABLE -- Prehash contexts shared by miner processes on host
+
+*******************************************************************************/
+
+#include "../include/sharedtable.h"
+#include "../include/easylogging++.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+shared_table_t::shared_table_t(void)
+{
+    role = SHARED_NONE;
+    header = NULL;
+    uctxs = NULL;
+    bytes = 0;
+
+#ifdef _WIN32
+    handle = NULL;
+#else
+    fd = -1;
+#endif
+}
+
+shared_table_t::~shared_table_t(void)
+{
+    Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Create or attach as builder, attach as reader
+////////////////////////////////////////////////////////////////////////////////
+int shared_table_t::Open(const char * name, const int kind, const size_t size)
+{
+    char path[256];
+    size_t total = SHARED_HEADER_SIZE + size;
+    int builder = (kind == SHARED_BUILDER);
+
+    Close();
+
+    role = kind;
+    bytes = size;
+
+#ifdef _WIN32
+    snprintf(path, sizeof(path), "Local\\%s", name);
+
+    // pagefile-backed mapping is committed here, so lack of memory fails now
+    handle = (builder)? CreateFileMappingA(
+        INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(total >> 32),
+        (DWORD)(total & 0xFFFFFFFF), path
+    ): OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, path);
+
+    if (!handle)
+    {
+        LOG(ERROR) << "Cannot open shared table " << name
+            << ((builder)? "": ", builder has not created it");
+
+        Close();
+        return EXIT_FAILURE;
+    }
+
+    header = (shared_header_t *)MapViewOfFile(
+        handle, FILE_MAP_ALL_ACCESS, 0, 0, SHARED_HEADER_SIZE
+    );
+    uctxs = (uctx_t *)MapViewOfFile(
+        handle, (builder)? FILE_MAP_ALL_ACCESS: FILE_MAP_READ, 0,
+        SHARED_HEADER_SIZE, size
+    );
+
+    if (!header || !uctxs)
+    {
+        LOG(ERROR) << "Cannot map shared table " << name << ", "
+            << (total >> 20) << " MiB needed";
+
+        Close();
+        return EXIT_FAILURE;
+    }
+#else
+    struct stat st;
+
+    snprintf(path, sizeof(path), "/%s", name);
+
+    fd = shm_open(path, O_RDWR | ((builder)? O_CREAT: 0), 0600);
+
+    if (fd < 0)
+    {
+        LOG(ERROR) << "Cannot open shared table " << name
+            << ((builder)? "": ", builder has not created it");
+
+        Close();
+        return EXIT_FAILURE;
+    }
+
+    if (fstat(fd, &st))
+    {
+        LOG(ERROR) << "Cannot read size of shared table " << name;
+
+        Close();
+        return EXIT_FAILURE;
+    }
+
+    if ((size_t)st.st_size != total)
+    {
+        // reserved pages fail now instead of SIGBUS on first touch
+        if (
+            !builder || ftruncate(fd, total)
+            || posix_fallocate(fd, 0, total)
+        )
+        {
+            LOG(ERROR) << "Shared table " << name << " is "
+                << (st.st_size >> 20) << " MiB, " << (total >> 20)
+                << " MiB of shared memory needed";
+
+            Close();
+            return EXIT_FAILURE;
+        }
+    }
+
+    void * head = mmap(
+        NULL, SHARED_HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0
+    );
+    void * table = mmap(
+        NULL, size, (builder)? PROT_READ | PROT_WRITE: PROT_READ, MAP_SHARED,
+        fd, SHARED_HEADER_SIZE
+    );
+
+    header = (head == MAP_FAILED)? NULL: (shared_header_t *)head;
+    uctxs = (table == MAP_FAILED)? NULL: (uctx_t *)table;
+
+    if (!header || !uctxs)
+    {
+        LOG(ERROR) << "Cannot map shared table " << name;
+
+        Close();
+        return EXIT_FAILURE;
+    }
+
+#ifdef MADV_HUGEPAGE
+    // effective if shared memory transparent huge pages are advised
+    madvise(uctxs, size, MADV_HUGEPAGE);
+#endif
+#endif
+
+    if (builder && (header->magic != SHARED_MAGIC || header->bytes != size))
+    {
+        header->generation = 0;
+        header->bytes = size;
+        header->magic = SHARED_MAGIC;
+    }
+    else if (header->magic != SHARED_MAGIC || header->bytes != size)
+    {
+        LOG(ERROR) << "Shared table " << name << " has another layout";
+
+        Close();
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Unmap segment
+////////////////////////////////////////////////////////////////////////////////
+void shared_table_t::Close(void)
+{
+#ifdef _WIN32
+    if (header) { UnmapViewOfFile(header); }
+    if (uctxs) { UnmapViewOfFile(uctxs); }
+    if (handle) { CloseHandle(handle); }
+
+    handle = NULL;
+#else
+    if (header) { munmap(header, SHARED_HEADER_SIZE); }
+    if (uctxs) { munmap(uctxs, bytes); }
+    if (fd >= 0) { close(fd); }
+
+    fd = -1;
+#endif
+
+    role = SHARED_NONE;
+    header = NULL;
+    uctxs = NULL;
+    bytes = 0;
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Mark contexts as being written
+////////////////////////////////////////////////////////////////////////////////
+void shared_table_t::BeginWrite(void)
+{
+    uint64_t gen = header->generation.load(std::memory_order_relaxed);
+
+    // odd already if previous builder stopped while writing
+    header->generation.store(gen + 1 + (gen & 1), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Publish contexts built for public key
+////////////////////////////////////////////////////////////////////////////////
+void shared_table_t::Publish(const uint8_t * pk)
+{
+    memcpy(header->pk, pk, PK_SIZE_8);
+
+    header->generation.store(
+        header->generation.load(std::memory_order_relaxed) + 1,
+        std::memory_order_release
+    );
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Consistent copy of published header
+////////////////////////////////////////////////////////////////////////////////
+int shared_table_t::Snapshot(uint8_t * pk, uint64_t * gen) const
+{
+    uint64_t g = header->generation.load(std::memory_order_acquire);
+
+    if (!g || (g & 1)) { return 0; }
+
+    memcpy(pk, header->pk, PK_SIZE_8);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // copy is consistent if no write started meanwhile
+    if (header->generation.load(std::memory_order_relaxed) != g) { return 0; }
+
+    *gen = g;
+
+    return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Contexts of public key are published
+////////////////////////////////////////////////////////////////////////////////
+int shared_table_t::Published(const uint8_t * pk, uint64_t * gen) const
+{
+    uint8_t pkCopy[PK_SIZE_8];
+
+    return Snapshot(pkCopy, gen) && !memcmp(pkCopy, pk, PK_SIZE_8);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Wait for contexts of public key
+////////////////////////////////////////////////////////////////////////////////
+int shared_table_t::Acquire(
+    const uint8_t * pk,
+    uint64_t * gen,
+    const int waitMs
+)
+{
+    using namespace std::chrono;
+
+    steady_clock::time_point start = steady_clock::now();
+    uint8_t pkCopy[PK_SIZE_8];
+
+    while (1)
+    {
+        if (Snapshot(pkCopy, gen))
+        {
+            if (memcmp(pkCopy, pk, PK_SIZE_8))
+            {
+                LOG(ERROR) << "Shared table is built for another public key";
+
+                return EXIT_FAILURE;
+            }
+
+            return EXIT_SUCCESS;
+        }
+
+        if (steady_clock::now() - start > milliseconds(waitMs))
+        {
+            LOG(ERROR) << "Shared table is not published in " << waitMs
+                << " ms";
+
+            return EXIT_FAILURE;
+        }
+
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Contexts of generation are still published
+////////////////////////////////////////////////////////////////////////////////
+int shared_table_t::Valid(const uint64_t gen) const
+{
+    return header->generation.load(std::memory_order_acquire) == gen;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Remove segment
+////////////////////////////////////////////////////////////////////////////////
+int RemoveSharedTable(const char * name)
+{
+#ifdef _WIN32
+    // mapping is removed with its last handle
+    (void)name;
+
+    return EXIT_SUCCESS;
+#else
+    char path[256];
+
+    snprintf(path, sizeof(path), "/%s", name);
+
+    return (shm_unlink(path))? EXIT_FAILURE: EXIT_SUCCESS;
+#endif
+}
+
+// sharedtable.cc
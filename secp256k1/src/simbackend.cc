@@ -0,0 +1,236 @@
+// simbackend.cc
+
+/*******************************************************************************
+
+    SIMBACKEND -- Deterministic simulated device backend
+
+*******************************************************************************/
+
+#include "../include/backend.h"
+#include "../include/definitions.h"
+#include "../include/easylogging++.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+// simulated kernel launch and result readback overhead
+#define SIM_LAUNCH_US      1000
+
+////////////////////////////////////////////////////////////////////////////////
+//  SplitMix64 pseudo-random generator step
+////////////////////////////////////////////////////////////////////////////////
+static inline uint64_t SplitMix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+
+    return x ^ (x >> 31);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Simulated device backend
+////////////////////////////////////////////////////////////////////////////////
+// solutions are drawn from a generator seeded by device, message and nonce
+// base, so that a run with the same block sequence is reproducible,
+// prehash and iteration take the configured time, memory capacity decides
+// whether the device can mine and keep prehashes like a real one
+struct sim_backend_t: backend_t
+{
+    int deviceId;
+    int prehashMs;
+    int iterMs;
+    int memory;
+    char name[64];
+
+    uint64_t seed;
+    uint64_t block;
+    uint64_t bound[NUM_SIZE_64];
+
+    // result of the last iteration
+    uint32_t ind;
+    uint64_t res[NUM_SIZE_64];
+
+    sim_backend_t(const int id, const info_t * info);
+
+    const char * Name(void) { return name; }
+
+    int Allocate(int * keep);
+    int SetKeys(const uint8_t *, const uint8_t *) { return EXIT_SUCCESS; }
+    int UncompletePrehash(void);
+
+    int SetBlock(
+        const uint8_t * mes,
+        const uint8_t * bnd,
+        const uint8_t * x,
+        const uint8_t * w
+    );
+
+    int SetBound(const uint8_t * bnd)
+    {
+        memcpy(bound, bnd, NUM_SIZE_8);
+        return EXIT_SUCCESS;
+    }
+
+    int Prehash(void);
+    int Mine(const uint64_t base);
+    int GetResult(uint32_t * valid, uint8_t * result);
+
+    sensor_t * CreateSensor(void) { return CreateMockSensor(); }
+};
+
+sim_backend_t::sim_backend_t(const int id, const info_t * info)
+{
+    deviceId = id;
+    prehashMs = info->simPrehashMs;
+    iterMs = info->simIterMs;
+    memory = info->simMemory;
+    seed = SplitMix64(id);
+    block = 0;
+    ind = 0;
+    blockDim = maxBlockDim = 1;
+
+    memset(bound, 0, NUM_SIZE_8);
+    snprintf(name, sizeof(name), "Simulated device %i MiB", memory);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Memory check
+////////////////////////////////////////////////////////////////////////////////
+int sim_backend_t::Allocate(int * keep)
+{
+    size_t freeMem = (size_t)memory << 20;
+
+    if (freeMem < MIN_FREE_MEMORY)
+    {
+        LOG(ERROR) << "Not enough GPU memory for mining, minimum "
+            << (MIN_FREE_MEMORY >> 20) << " MiB needed";
+
+        return EXIT_FAILURE;
+    }
+
+    if (*keep && freeMem < MIN_FREE_MEMORY_PREHASH)
+    {
+        LOG(ERROR) << "Not enough memory for keeping prehashes, "
+                   << "setting keepPrehash to false";
+
+        *keep = 0;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Unfinalized hash contexts precalculation
+////////////////////////////////////////////////////////////////////////////////
+int sim_backend_t::UncompletePrehash(void)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(prehashMs));
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Block data setting
+////////////////////////////////////////////////////////////////////////////////
+int sim_backend_t::SetBlock(
+    const uint8_t * mes,
+    const uint8_t * bnd,
+    const uint8_t *,
+    const uint8_t *
+)
+{
+    block = seed;
+
+    for (int i = 0; i < NUM_SIZE_64; ++i)
+    {
+        block = SplitMix64(block ^ ((const uint64_t *)mes)[i]);
+    }
+
+    memcpy(bound, bnd, NUM_SIZE_8);
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Hashes precalculation
+////////////////////////////////////////////////////////////////////////////////
+int sim_backend_t::Prehash(void)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(prehashMs));
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Mining iteration
+////////////////////////////////////////////////////////////////////////////////
+int sim_backend_t::Mine(const uint64_t base)
+{
+    // iteration time scales with work size on top of a launch overhead
+    std::this_thread::sleep_for(
+        std::chrono::microseconds(
+            SIM_LAUNCH_US
+            + (uint64_t)iterMs * 1000 * noncesPerIter / NONCES_PER_ITER
+        )
+    );
+
+    uint64_t rnd = SplitMix64(block ^ base);
+
+    // probability of a nonce to be a solution: bound / 2^256
+    double prob = 0;
+
+    for (int i = 0; i < NUM_SIZE_64; ++i)
+    {
+        prob += ldexp((double)bound[i], 64 * (i - NUM_SIZE_64));
+    }
+
+    double iterProb = -expm1(-(double)noncesPerIter * prob);
+
+    ind = 0;
+
+    if (ldexp((double)(rnd >> 11), -53) < iterProb)
+    {
+        rnd = SplitMix64(rnd);
+        ind = 1 + rnd % noncesPerIter;
+
+        // result strictly below bound
+        int shift = 1 + (rnd >> 32) % 8;
+
+        for (int i = 0; i < NUM_SIZE_64; ++i)
+        {
+            res[i] = (bound[i] >> shift)
+                | ((i + 1 < NUM_SIZE_64)? bound[i + 1] << (64 - shift): 0);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Mining iteration result
+////////////////////////////////////////////////////////////////////////////////
+int sim_backend_t::GetResult(uint32_t * valid, uint8_t * result)
+{
+    *valid = ind;
+
+    if (ind)
+    {
+        memcpy(result, res, NUM_SIZE_8);
+        ind = 0;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Create simulated backend
+////////////////////////////////////////////////////////////////////////////////
+backend_t * CreateSimBackend(const int deviceId, const info_t * info)
+{
+    return new sim_backend_t(deviceId, info);
+}
+
+// simbackend.cc
@@ -6,13 +6,33 @@
 
 *******************************************************************************/
 
+#include "../include/asynclog.h"
+#include "../include/autotune.h"
+#include "../include/backend.h"
+#include "../include/candidates.h"
 #include "../include/cryptography.h"
 #include "../include/definitions.h"
 #include "../include/easylogging++.h"
+#include "../include/emulator.h"
+#include "../include/fanout.h"
+#include "../include/hashrate.h"
+#include "../include/hostkernel.h"
+#include "../include/hostmining.h"
+#include "../include/hostmodq.h"
+#include "../include/hostprehash.h"
+#include "../include/hugepages.h"
+#include "../include/journal.h"
 #include "../include/mining.h"
 #include "../include/prehash.h"
 #include "../include/reduction.h"
 #include "../include/request.h"
+#include "../include/sharedtable.h"
+#include "../include/throttle.h"
+#include "../include/topology.h"
+#include "../include/validator.h"
+#include "../include/verify.h"
+#include "../include/verifyapi.h"
+#include "../include/watchdog.h"
 #include <ctype.h>
 #include <cuda.h>
 #include <cuda_runtime.h>
@@ -20,16 +40,28 @@
 #include <curl/curl.h>
 #include <inttypes.h>
 #include <iostream>
+#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <mutex>
 #include <thread>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 INITIALIZE_EASYLOGGINGPP
 
@@ -50,6 +82,10 @@ int TestSolutions(
     //========================================================================//
     //  Host memory allocation
     //========================================================================//
+    // block data
+    block_data_t block;
+    info->block.Read(&block);
+
     // hash context
     // (212 + 4) bytes
     ctx_t ctx_h;
@@ -89,7 +125,7 @@ int TestSolutions(
     //========================================================================//
     // copy boundary
     CUDA_CALL(cudaMemcpy(
-        bound_d, info->bound, NUM_SIZE_8, cudaMemcpyHostToDevice
+        bound_d, block.bound, NUM_SIZE_8, cudaMemcpyHostToDevice
     ));
 
     // copy public key
@@ -97,7 +133,7 @@ int TestSolutions(
 
     // copy message
     CUDA_CALL(cudaMemcpy(
-        (uint8_t *)data_d + PK_SIZE_8, info->mes, NUM_SIZE_8,
+        (uint8_t *)data_d + PK_SIZE_8, block.mes, NUM_SIZE_8,
         cudaMemcpyHostToDevice
     ));
 
@@ -135,7 +171,7 @@ int TestSolutions(
     CUDA_CALL(cudaDeviceSynchronize());
 
     // calculate unfinalized hash of message
-    InitMining(&ctx_h, (uint32_t *)info->mes, NUM_SIZE_8);
+    InitMining(&ctx_h, (uint32_t *)block.mes, NUM_SIZE_8);
 
     // copy context
     CUDA_CALL(cudaMemcpy(
@@ -145,7 +181,7 @@ int TestSolutions(
 
     // calculate solution candidates
     BlockMining<<<1 + (THREADS_PER_ITER - 1) / BLOCK_DIM, BLOCK_DIM>>>(
-        bound_d, data_d, base, hashes_d, res_d, indices_d
+        bound_d, data_d, base, NONCES_PER_ITER, hashes_d, res_d, indices_d
     );
 
     uint64_t res_h[NUM_SIZE_64];
@@ -181,6 +217,69 @@ int TestSolutions(
     return EXIT_SUCCESS;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//  Test CPU backend against solutions test nonce
+////////////////////////////////////////////////////////////////////////////////
+int TestCpuBackend(
+    const info_t * info,
+    const uint8_t * x,
+    const uint8_t * w
+)
+{
+    LOG(INFO) << "CPU backend test started";
+    LOG(INFO) << "Set keepPrehash = " << ((info->keepPrehash)? "true": "false");
+
+    block_data_t block;
+    info->block.Read(&block);
+
+    backend_t * backend = CreateCpuBackend(0, info, NULL);
+    int keep = info->keepPrehash;
+
+    if (backend->Allocate(&keep) != EXIT_SUCCESS)
+    {
+        LOG(INFO) << "Not enough host memory for CPU backend, skip test\n";
+
+        delete backend;
+        return EXIT_SUCCESS;
+    }
+
+    uint32_t ind = 0;
+    uint8_t res[NUM_SIZE_8];
+
+    int status = backend->SetKeys(info->pk, info->sk);
+
+    if (status == EXIT_SUCCESS && keep)
+    {
+        status = backend->UncompletePrehash();
+    }
+
+    if (
+        status != EXIT_SUCCESS
+        || backend->SetBlock(block.mes, block.bound, x, w) != EXIT_SUCCESS
+        || backend->Prehash() != EXIT_SUCCESS
+        || backend->Mine(0) != EXIT_SUCCESS
+        || backend->GetResult(&ind, res) != EXIT_SUCCESS
+    )
+    {
+        LOG(ERROR) << "CPU backend test failed: backend error";
+        exit(EXIT_FAILURE);
+    }
+
+    delete backend;
+
+    LOG(INFO) << "Found nonce: " << ind - 1;
+
+    if (ind != 0x3381BF)
+    {
+        LOG(ERROR) << "CPU backend test failed: wrong nonce";
+        exit(EXIT_FAILURE);
+    }
+
+    LOG(INFO) << "CPU backend test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //  Test performance
 ////////////////////////////////////////////////////////////////////////////////
@@ -195,6 +294,10 @@ int TestPerformance(
     //========================================================================//
     //  Host memory allocation
     //========================================================================//
+    // block data
+    block_data_t block;
+    info->block.Read(&block);
+
     // hash context
     // (212 + 4) bytes
     ctx_t ctx_h;
@@ -234,7 +337,7 @@ int TestPerformance(
     //========================================================================//
     // copy boundary
     CUDA_CALL(cudaMemcpy(
-        bound_d, info->bound, NUM_SIZE_8, cudaMemcpyHostToDevice
+        bound_d, block.bound, NUM_SIZE_8, cudaMemcpyHostToDevice
     ));
 
     // copy public key
@@ -242,7 +345,7 @@ int TestPerformance(
 
     // copy message
     CUDA_CALL(cudaMemcpy(
-        (uint8_t *)data_d + PK_SIZE_8, info->mes, NUM_SIZE_8,
+        (uint8_t *)data_d + PK_SIZE_8, block.mes, NUM_SIZE_8,
         cudaMemcpyHostToDevice
     ));
 
@@ -315,7 +418,7 @@ int TestPerformance(
     CUDA_CALL(cudaDeviceSynchronize());
 
     // calculate unfinalized hash of message
-    InitMining(&ctx_h, (uint32_t *)info->mes, NUM_SIZE_8);
+    InitMining(&ctx_h, (uint32_t *)block.mes, NUM_SIZE_8);
 
     // copy context
     CUDA_CALL(cudaMemcpy(
@@ -337,7 +440,7 @@ int TestPerformance(
     {
         // calculate solution candidates
         BlockMining<<<1 + (THREADS_PER_ITER - 1) / BLOCK_DIM, BLOCK_DIM>>>(
-            bound_d, data_d, base, hashes_d, res_d, indices_d
+            bound_d, data_d, base, NONCES_PER_ITER, hashes_d, res_d, indices_d
         );
 
         CUDA_CALL(cudaMemcpy(
@@ -494,102 +597,2443 @@ void TestNewCrypto()
 
 
 ////////////////////////////////////////////////////////////////////////////////
-//  Main
+//  Test work size autotuning on simulated device
 ////////////////////////////////////////////////////////////////////////////////
-int main(int argc, char ** argv)
+int TestAutotune(void)
 {
-    START_EASYLOGGINGPP(argc, argv);
+    LOG(INFO) << "Autotune test started";
 
-    el::Loggers::reconfigureAllLoggers(
-        el::ConfigurationType::Format, "%datetime %level [%thread] %msg"
+    info_t info;
+    uint8_t zero[PK_SIZE_8];
+
+    memset(zero, 0, PK_SIZE_8);
+
+    info.simPrehashMs = 0;
+    info.simIterMs = 2;
+    info.simMemory = SIM_MEMORY;
+
+    backend_t * backend = CreateSimBackend(0, &info);
+
+    backend->SetBlock(zero, zero, zero, zero);
+
+    uint32_t nonces = 0;
+    uint32_t dim = 0;
+
+    if (
+        TuneWorkSize(backend, &nonces, &dim) != EXIT_SUCCESS
+        || nonces < TUNE_MIN_NONCES || nonces > TUNE_MAX_NONCES
+        || backend->noncesPerIter != nonces || backend->blockDim != dim
+    )
+    {
+        LOG(ERROR) << "Autotune test failed: wrong work size";
+        exit(EXIT_FAILURE);
+    }
+
+    char profile[] = "./autotune.test.profile";
+    uint32_t readNonces = 0;
+    uint32_t readDim = 0;
+
+    remove(profile);
+    WriteTuneProfile(profile, "Other device", 1, 1);
+    WriteTuneProfile(profile, backend->Name(), nonces, dim);
+
+    if (
+        ReadTuneProfile(profile, backend->Name(), &readNonces, &readDim)
+        != EXIT_SUCCESS || readNonces != nonces || readDim != dim
+    )
+    {
+        LOG(ERROR) << "Autotune test failed: wrong profile";
+        exit(EXIT_FAILURE);
+    }
+
+    remove(profile);
+    delete backend;
+
+    LOG(INFO) << "Autotune test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+// mock device driven by the schedule actually run, read as real sensors
+// are regardless of the duty the controller assumes
+struct plant_sensor_t: sensor_t
+{
+    sensor_t * model;
+    double temp;
+    double power;
+
+    plant_sensor_t(void): model(CreateMockSensor()), temp(0), power(0) {}
+    ~plant_sensor_t(void) { delete model; }
+
+    int Read(const double duty, const double sec, double * t, double * p)
+    {
+        *t = temp;
+        *p = power;
+
+        return EXIT_SUCCESS;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test duty-cycle controller on mock sensor
+////////////////////////////////////////////////////////////////////////////////
+int TestThrottle(void)
+{
+    LOG(INFO) << "Throttle test started";
+
+    const double target[2][2] = { { 75, 0 }, { 0, 150 } };
+
+    // every 4th pause is cut short by new block in the second pass
+    for (int k = 0; k < 4; ++k)
+    {
+        const int t = k & 1;
+        const int cut = k >> 1;
+
+        plant_sensor_t * plant = new plant_sensor_t;
+        throttle_t throttle(plant, target[t][0], target[t][1]);
+
+        // 10 minutes of 50 ms iterations in model time
+        double iterSec = 0.05;
+        double slept = 0;
+        double busy = 0;
+        double elapsed = 0;
+        double sec = 0;
+
+        for (int i = 0; sec < 600; ++i)
+        {
+            double pause = throttle.Update(iterSec, slept, NONCES_PER_ITER);
+
+            slept = (cut && !(i & 3))? pause / 4: pause;
+
+            busy += iterSec;
+            elapsed += iterSec + slept;
+            sec += iterSec + slept;
+
+            // device follows the duty actually run
+            if (elapsed >= 0.1)
+            {
+                plant->model->Read(
+                    busy / elapsed, elapsed, &plant->temp, &plant->power
+                );
+
+                busy = elapsed = 0;
+            }
+        }
+
+        double value = (t)? throttle.power: throttle.temp;
+        double goal = (t)? target[t][1]: target[t][0];
+
+        LOG(INFO) << "Target " << goal << ", reached " << value
+            << " at duty " << throttle.duty << ", "
+            << throttle.HashesPerJoule() << " H/J"
+            << ((cut)? " with cut pauses": "");
+
+        if (value < goal * 0.97 || value > goal * 1.03)
+        {
+            LOG(ERROR) << "Throttle test failed: target is not reached";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    LOG(INFO) << "Throttle test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+// model time of hashrate and watchdog tests
+static int64_t modelMs = 0;
+
+static int64_t ModelClock(void) { return modelMs; }
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test hashrate windows, average and liveness on model time
+////////////////////////////////////////////////////////////////////////////////
+int TestHashrate(void)
+{
+    LOG(INFO) << "Hashrate test started";
+
+    // counters need static storage for their alignment
+    static hashrate_t hashrates;
+
+    hashrates.clock = ModelClock;
+    modelMs = 1000000;
+    hashrates.Init(2);
+
+    // 15 minutes sampled every 500 ms, the second device stops at 14 min
+    for (int s = 1; s <= 900; ++s)
+    {
+        modelMs += 500;
+        hashrates.Sample();
+
+        modelMs += 500;
+        hashrates.Add(0, 1000);
+        if (s <= 840) { hashrates.Add(1, 2000); }
+        hashrates.Sample();
+    }
+
+    const int windows[4] = { 10, 60, 120, 900 };
+    const double rates[2][4] = {
+        { 1000, 1000, 1000, 1000 }, { 0, 0, 1000, 2000.0 * 840 / 900 }
+    };
+
+    for (int i = 0; i < 2; ++i)
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            if (fabs(hashrates.Rate(i, windows[k]) - rates[i][k]) > 1e-6)
+            {
+                LOG(ERROR) << "Hashrate test failed: device " << i
+                    << " rate over " << windows[k] << " s is "
+                    << hashrates.Rate(i, windows[k]) << " instead of "
+                    << rates[i][k];
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    // 14 min of 2000 H/s decayed for 1 min
+    double ewma = 2000 * -expm1(-14.0) * exp(-1.0);
+
+    if (
+        fabs(hashrates.Ewma(0) - 1000) > 1e-3
+        || fabs(hashrates.Ewma(1) - ewma) > 1e-3
+    )
+    {
+        LOG(ERROR) << "Hashrate test failed: average is " << hashrates.Ewma(0)
+            << " and " << hashrates.Ewma(1) << " instead of 1000 and "
+            << ewma;
+        exit(EXIT_FAILURE);
+    }
+
+    int alive = hashrates.Alive(0) && !hashrates.Alive(1);
+
+    modelMs += HASHRATE_LIVENESS_MS - 1;
+    alive = alive && hashrates.Alive(0);
+    modelMs += 1;
+    alive = alive && !hashrates.Alive(0);
+
+    if (!alive)
+    {
+        LOG(ERROR) << "Hashrate test failed: wrong liveness";
+        exit(EXIT_FAILURE);
+    }
+
+    LOG(INFO) << "Hashrate test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test async log rings wraparound, drop counting and order
+////////////////////////////////////////////////////////////////////////////////
+int TestAsyncLog(void)
+{
+    LOG(INFO) << "Async log test started";
+
+    FILE * out = tmpfile();
+
+    AsyncLogOutput(out, 0);
+
+    // ring wraps in three drain passes and overflows in the fourth one
+    const int passes[4] = { 200, 200, 200, 300 };
+    std::string expected;
+
+    std::thread producer(
+        [&](void)
+        {
+            char record[ASYNCLOG_MAX_RECORD];
+            int n = 0;
+
+            for (int p = 0; p < 4; ++p)
+            {
+                size_t used = 0;
+                int dropped = 0;
+
+                for (int i = 0; i < passes[p]; ++i, ++n)
+                {
+                    // lengths vary so that records and their headers wrap
+                    size_t len = 900 + (n * 37) % 200;
+
+                    memset(record, 'a' + n % 26, len);
+                    record[sprintf(record, "%06d", n)] = ' ';
+                    record[len - 1] = '\n';
+
+                    AsyncLogPush(record, len);
+
+                    if (ASYNCLOG_RING_SIZE - used < sizeof(uint32_t) + len)
+                    {
+                        ++dropped;
+                    }
+                    else
+                    {
+                        used += sizeof(uint32_t) + len;
+                        expected.append(record, len);
+                    }
+                }
+
+                FlushAsyncLog();
+
+                if (dropped)
+                {
+                    snprintf(
+                        record, ASYNCLOG_MAX_RECORD,
+                        "%d log records dropped\n", dropped
+                    );
+
+                    expected += record;
+                }
+            }
+        }
     );
 
-    el::Helpers::setThreadName("test thread");
+    producer.join();
 
-    LOG(INFO) << "Checking crypto: ";
+    // records of exited threads are drained in order of passes
+    std::thread([](void) { AsyncLogPush("first\n", 6); }).join();
+    FlushAsyncLog();
+    std::thread([](void) { AsyncLogPush("second\n", 7); }).join();
+    FlushAsyncLog();
 
-    TestNewCrypto();
+    expected += "first\nsecond\n";
 
-    LOG(INFO) << "Testing requests:";
+    std::string written(ftell(out), '\0');
 
-    TestRequests();
-    //========================================================================//
-    //  Check requirements
-    //========================================================================//
-    int deviceCount;
+    rewind(out);
 
-    if (cudaGetDeviceCount(&deviceCount) != cudaSuccess)
+    size_t len = fread(&written[0], 1, written.size(), out);
+
+    AsyncLogOutput(NULL, 1);
+    fclose(out);
+
+    if (len != expected.size() || written != expected)
     {
-        LOG(ERROR) << "Error checking GPU";
+        LOG(ERROR) << "Async log test failed: " << len << " bytes written, "
+            << expected.size() << " expected";
         exit(EXIT_FAILURE);
     }
 
-    size_t freeMem;
-    size_t totalMem;
+    LOG(INFO) << "Async log test passed\n";
 
-    CUDA_CALL(cudaMemGetInfo(&freeMem, &totalMem));
-    
-    if (freeMem < MIN_FREE_MEMORY)
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test watchdog stall detection and downtime on model time
+////////////////////////////////////////////////////////////////////////////////
+int TestWatchdog(void)
+{
+    LOG(INFO) << "Watchdog test started";
+
+    static hashrate_t hashrates;
+    watchdog_t watchdog;
+    device_health_t * health = watchdog.health;
+    const int64_t start = 1000000;
+
+    hashrates.clock = watchdog.clock = ModelClock;
+    modelMs = start;
+    hashrates.Init(3);
+    watchdog.Init(3);
+
+    // main thread checks while device 2 waits for a block
+    auto run = [&](const int64_t until)
     {
-        LOG(ERROR) << "Not enough GPU memory for mining,"
-            << " minimum 2.8 GiB needed";
+        for (; modelMs < start + until; modelMs += 100)
+        {
+            hashrates.Add(2, 0);
+            watchdog.Check(&hashrates);
+        }
+    };
 
+    // device 0 prehashes for 100 s, device 1 hangs
+    hashrates.Busy(0, 1);
+    run(61000);
+
+    if (
+        health[0].recover || !health[1].recover || health[2].recover
+        || health[1].downSinceMs != start
+    )
+    {
+        LOG(ERROR) << "Watchdog test failed: wrong stall detection";
         exit(EXIT_FAILURE);
     }
-    
-    //========================================================================//
-    //  Set test info
-    //========================================================================//
-    info_t info;
-    uint8_t x[NUM_SIZE_8];
+
+    // miner thread of device 1 serves the request and backs off for 2 min
+    watchdog.Down(1);
+    hashrates.Busy(1, 1);
+    health[1].recover = 0;
+
+    run(100000);
+    hashrates.Busy(0, 0);
+    run(181000);
+
+    if (
+        !health[0].recover || health[1].recover || health[2].recover
+        || health[0].downSinceMs != start + 100000
+        || watchdog.DowntimeMs(0) != 81000
+    )
+    {
+        LOG(ERROR) << "Watchdog test failed: busy device is stalled";
+        exit(EXIT_FAILURE);
+    }
+
+    hashrates.Busy(1, 0);
+    hashrates.Add(1, NONCES_PER_ITER);
+    watchdog.Up(1);
+    run(182000);
+
+    if (
+        health[1].recover || health[1].recoveries != 1
+        || health[1].downSinceMs || watchdog.DowntimeMs(1) != 181000
+    )
+    {
+        LOG(ERROR) << "Watchdog test failed: wrong downtime";
+        exit(EXIT_FAILURE);
+    }
+
+    LOG(INFO) << "Watchdog test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test solution journal recovery and compaction
+////////////////////////////////////////////////////////////////////////////////
+int TestJournal(void)
+{
+    LOG(INFO) << "Journal test started";
+
+    const char * fileName = "./test.journal";
+
+    uint8_t mes[NUM_SIZE_8];
     uint8_t w[PK_SIZE_8];
-    char seed[256] = "Va'esse deireadh aep eigean, va'esse eigh faidh'ar";
+    uint8_t nonce[NONCE_SIZE_8];
+    uint8_t d[NUM_SIZE_8];
+    char pkstr[PK_SIZE_4 + 1];
 
-    // generate secret key from seed
-    GenerateSecKey(seed, 50, info.sk, info.skstr);
-    // generate public key from secret key
-    GeneratePublicKey(info.skstr, info.pkstr, info.pk);
+    for (int i = 0; i < NUM_SIZE_8; ++i) { mes[i] = i; d[i] = 0xFF - i; }
+    for (int i = 0; i < PK_SIZE_8; ++i) { w[i] = 3 * i; }
+    for (int i = 0; i < PK_SIZE_4; ++i) { pkstr[i] = 'A' + i % 6; }
+    pkstr[PK_SIZE_4] = '\0';
 
-    const char ref_pkstr[PK_SIZE_4 + 1]
-        = "020C16DFC5E23C59357E89D44977038F0A7851CC9926B3AABB3FF9E7E6A57315AD";
+    remove(fileName);
 
-    int test = !strncmp(ref_pkstr, info.pkstr, PK_SIZE_4);
+    {
+        journal_t journal;
+        journal.Open(fileName);
 
-    if (!test)
+        for (int i = 0; i < 2; ++i)
+        {
+            *((uint64_t *)nonce) = 0x1234567890ABCDEF + i;
+            journal.Append(mes, pkstr, w, nonce, d);
+        }
+    }
+
+    // unposted solutions survive restart
+    info_t info;
+    info.lockWaitNs = 0;
+    info.lockCount = 0;
+    info.to[0] = '\0';
+
+    journal_t journal;
+    journal.Open(fileName);
+
+    if (
+        journal.Pending() != 2
+        || memcmp(journal.pending[1].mes, mes, NUM_SIZE_8)
+        || memcmp(journal.pending[1].w, w, PK_SIZE_8)
+        || memcmp(journal.pending[1].d, d, NUM_SIZE_8)
+        || strcmp(journal.pending[1].pkstr, pkstr)
+        || *((uint64_t *)journal.pending[1].nonce) != 0x1234567890ABCDF0
+    )
     {
-        LOG(ERROR) << "OpenSSL: generated wrong public key";
-        return EXIT_FAILURE;
+        LOG(ERROR) << "Journal test failed: solutions are not recovered";
+        exit(EXIT_FAILURE);
     }
 
-    ((uint64_t *)info.bound)[0] = 0xFFFFFFFFFFFFFFFF;
-    ((uint64_t *)info.bound)[1] = 0xFFFFFFFFFFFFFFFF;
-    ((uint64_t *)info.bound)[2] = 0xFFFFFFFFFFFFFFFF;
-    ((uint64_t *)info.bound)[3] = 0x000002FFFFFFFFFF;
+    // solutions of previous block are dropped without posting
+    block_data_t block;
 
-    ((uint64_t *)info.mes)[0] = 1;
-    ((uint64_t *)info.mes)[1] = 0;
-    ((uint64_t *)info.mes)[2] = 0;
-    ((uint64_t *)info.mes)[3] = 0;
+    memset(&block, 0, sizeof(block_data_t));
+    info.block.Publish(&block);
+    journal.Replay(&info);
 
-    sprintf(seed, "%d", 0);
+    journal_t compacted;
+    compacted.Open(fileName);
 
-    // generate secret key from seed
-    GenerateSecKey(seed, 1, x, info.skstr);
-    // generate public key from secret key
-    GeneratePublicKey(info.skstr, info.pkstr, w);
+    if (journal.Pending() || compacted.Pending() || compacted.finished)
+    {
+        LOG(ERROR) << "Journal test failed: stale solutions are not dropped";
+        exit(EXIT_FAILURE);
+    }
 
-    //========================================================================//
-    //  Run solutions correctness tests
-    //========================================================================//
-    if (NONCES_PER_ITER <= 0x3D5B84)
+    remove(fileName);
+
+    LOG(INFO) << "Journal test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test candidate record and replay schedule
+////////////////////////////////////////////////////////////////////////////////
+int TestCandidates(void)
+{
+    LOG(INFO) << "Candidates test started";
+
+    const char * fileName = "./test.candidates";
+    const char * bodies[3] = { "{\"b\":1}", "{\"b\":2}", "{\"b\":3}" };
+    const int64_t ms[3] = { 1000, 3000, 7000 };
+
+    FILE * out = fopen(fileName, "wb");
+
+    for (int i = 0; i < 3; ++i) { WriteCandidate(out, ms[i], bodies[i]); }
+
+    // recorder was stopped in the middle of a record
+    fputs("T 9000 100\n{\"b\"", out);
+    fclose(out);
+
+    std::vector<candidate_t> stream;
+
+    if (
+        ReadCandidates(fileName, &stream) != EXIT_SUCCESS
+        || stream.size() != 3 || stream[2].ms != ms[2]
+        || stream[1].body != bodies[1]
+    )
     {
-        LOG(INFO) << "Need WORKSPACE value for at least 4021125,"
-            << " skip solutions tests\n";
+        LOG(ERROR) << "Candidates test failed: record is not read back";
+        exit(EXIT_FAILURE);
     }
-    else
+
+    remove(fileName);
+
+    // switches at 0, 1000 and 3000 ms at double speed
+    replay_t replay(stream, 2);
+
+    replay.Poll(0);
+
+    int ind = replay.Poll(1250);
+
+    // third candidate is due but no poll saw it
+    replay.Post(3100);
+    replay.Poll(3500);
+    replay.Post(3600);
+    replay.Poll(10000);
+
+    if (
+        ind != 1 || replay.Current(2999) != 1 || replay.Current(3000) != 2
+        || replay.polls != 4 || replay.switches != 3
+        || replay.latencySum != 750 || replay.latencyMax != 500
+        || replay.solutions != 2 || replay.stale != 1
+    )
     {
-        info.keepPrehash = 0;
-        TestSolutions(&info, x, w);
+        LOG(ERROR) << "Candidates test failed: wrong replay statistics";
+        exit(EXIT_FAILURE);
+    }
+
+    LOG(INFO) << "Candidates test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test emulator bound and its difficulty control
+////////////////////////////////////////////////////////////////////////////////
+int TestBoundControl(void)
+{
+    LOG(INFO) << "Bound control test started";
+
+    uint8_t bound[NUM_SIZE_8];
+    int correct = 1;
+
+    ProbabilityToBound(0.25, bound);
+    correct = correct && bound[NUM_SIZE_8 - 1] == 0x40;
+    for (int i = 0; i < NUM_SIZE_8 - 1; ++i) { correct &= !bound[i]; }
+
+    ProbabilityToBound(1, bound);
+    for (int i = 0; i < NUM_SIZE_8; ++i) { correct &= bound[i] == 0xFF; }
+
+    if (!correct)
+    {
+        LOG(ERROR) << "Bound control test failed: wrong bound";
+        exit(EXIT_FAILURE);
+    }
+
+    // miners far slower than expected find nothing, correction is limited
+    bound_control_t slow(2, 1e6);
+
+    if (
+        slow.Retarget(EMULATOR_RETARGET_SEC - 0.1)
+        || !slow.Retarget(EMULATOR_RETARGET_SEC)
+        || fabs(slow.probability / 2e-6 - EMULATOR_MAX_RETARGET) > 1e-9
+    )
+    {
+        LOG(ERROR) << "Bound control test failed: wrong limited correction";
+        exit(EXIT_FAILURE);
+    }
+
+    // miners 3 times faster than expected, 5 minutes of model time
+    bound_control_t fast(2, 1e6);
+    double found = 0;
+
+    for (int s = 1; s <= 300; ++s)
+    {
+        found += 3e6 * fast.probability;
+        fast.valid = (uint64_t)found;
+        fast.Retarget(s);
+    }
+
+    if (fabs(fast.probability * 3e6 / 2 - 1) > 0.01)
+    {
+        LOG(ERROR) << "Bound control test failed: " << fast.probability * 3e6
+            << " solutions/s instead of 2";
+        exit(EXIT_FAILURE);
+    }
+
+    LOG(INFO) << "Bound control test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test host verification of solution found by host mining procedures
+////////////////////////////////////////////////////////////////////////////////
+int TestVerify(void)
+{
+    LOG(INFO) << "Verification test started";
+
+    uint8_t sk[NUM_SIZE_8];
+    uint8_t pk[PK_SIZE_8];
+    uint8_t x[NUM_SIZE_8];
+    uint8_t w[PK_SIZE_8];
+    uint8_t mes[NUM_SIZE_8];
+    uint8_t bound[NUM_SIZE_8];
+    uint8_t pnp[2 * PK_SIZE_8 + NUM_SIZE_8];
+    uint32_t d[NUM_SIZE_32];
+
+    GenerateKeyPair(sk, pk);
+    GenerateKeyPair(x, w);
+
+    for (int i = 0; i < NUM_SIZE_8; ++i) { mes[i] = 7 * i + 1; }
+
+    memcpy(pnp, pk, PK_SIZE_8);
+    memcpy(pnp + PK_SIZE_8, mes, NUM_SIZE_8);
+    memcpy(pnp + PK_SIZE_8 + NUM_SIZE_8, w, PK_SIZE_8);
+
+    // result of mining for a nonce from the selected hashes only
+    ctx_t ctx;
+    uint64_t nonce = 0x0123456789ABCDEF;
+    uint32_t ind[K_LEN];
+    uint32_t seq[K_LEN];
+    uint32_t hashes[K_LEN * NUM_SIZE_32];
+
+    InitMining(&ctx, (uint32_t *)mes, NUM_SIZE_8);
+    HostNonceIndices(&ctx, nonce, ind);
+
+    for (int k = 0; k < K_LEN; ++k)
+    {
+        HostInitPrehash(pnp, ind[k], hashes + k * NUM_SIZE_32);
+        HostFinalPrehashMultSecKey(
+            (uint32_t *)x, hashes + k * NUM_SIZE_32
+        );
+
+        seq[k] = k;
+    }
+
+    HostNonceResult((uint32_t *)sk, hashes, seq, d);
+
+    // any result is below maximal bound
+    memset(bound, 0xFF, NUM_SIZE_8);
+
+    if (
+        VerifySolution(
+            mes, pk, w, (uint8_t *)&nonce, (uint8_t *)d, bound
+        ) != EXIT_SUCCESS
+    )
+    {
+        LOG(ERROR) << "Verification test failed: valid solution rejected";
+        exit(EXIT_FAILURE);
+    }
+
+    ++nonce;
+
+    if (
+        VerifySolution(
+            mes, pk, w, (uint8_t *)&nonce, (uint8_t *)d, bound
+        ) == EXIT_SUCCESS
+    )
+    {
+        LOG(ERROR) << "Verification test failed: wrong nonce accepted";
+        exit(EXIT_FAILURE);
+    }
+
+    //========================================================================//
+    //  Batch verification throughput
+    //========================================================================//
+    const int count = 1024;
+    std::vector<autolykos_share_t> shares(count);
+    std::vector<int> verdicts(count);
+
+    --nonce;
+
+    for (int i = 0; i < count; ++i)
+    {
+        memcpy(shares[i].mes, mes, NUM_SIZE_8);
+        memcpy(shares[i].pk, pk, PK_SIZE_8);
+        memcpy(shares[i].w, w, PK_SIZE_8);
+        memcpy(shares[i].nonce, &nonce, NONCE_SIZE_8);
+        memcpy(shares[i].d, d, NUM_SIZE_8);
+        memcpy(shares[i].bound, bound, NUM_SIZE_8);
+
+        // every other share is wrong
+        shares[i].d[0] ^= i & 1;
+    }
+
+    ch::steady_clock::time_point start = ch::steady_clock::now();
+
+    for (int i = 0; i < count / 8; ++i) { AutolykosVerify(&shares[i]); }
+
+    double single = count / 8 / ch::duration<double>(
+        ch::steady_clock::now() - start
+    ).count();
+
+    // key off the curve is invalid share and not a failure
+    autolykos_share_t offCurve = shares[0];
+
+    offCurve.w[0] = 0x05;
+
+    // verifier reallocates its numbers once freed
+    verifier_t verifier;
+
+    verifier.Free();
+
+    if (
+        AutolykosVerify(&offCurve) != 0
+        || verifier.Verify(
+            mes, pk, w, (uint8_t *)&nonce, (uint8_t *)d, bound
+        ) != EXIT_SUCCESS
+    )
+    {
+        LOG(ERROR) << "Verification test failed: wrong status";
+        exit(EXIT_FAILURE);
+    }
+
+    int threads = std::thread::hardware_concurrency();
+
+    start = ch::steady_clock::now();
+
+    int valid = AutolykosVerifyBatch(
+        shares.data(), count, threads, verdicts.data()
+    );
+
+    double batch = count / ch::duration<double>(
+        ch::steady_clock::now() - start
+    ).count();
+
+    LOG(INFO) << "Verification: " << single << " shares/s on one thread, "
+        << batch << " shares/s on " << threads << " threads, "
+        << batch / threads << " per thread";
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (verdicts[i] != !(i & 1))
+        {
+            LOG(ERROR) << "Verification test failed: wrong batch verdict";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (valid != count / 2)
+    {
+        LOG(ERROR) << "Verification test failed: wrong batch valid count";
+        exit(EXIT_FAILURE);
+    }
+
+    LOG(INFO) << "Verification test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test batch of shares through JSON and validation pool
+////////////////////////////////////////////////////////////////////////////////
+int TestValidation(void)
+{
+    LOG(INFO) << "Validation test started";
+
+    uint8_t sk[NUM_SIZE_8];
+    uint8_t pk[PK_SIZE_8];
+    uint8_t x[NUM_SIZE_8];
+    uint8_t w[PK_SIZE_8];
+    uint8_t mes[NUM_SIZE_8];
+
+    GenerateKeyPair(sk, pk);
+    GenerateKeyPair(x, w);
+
+    for (int i = 0; i < NUM_SIZE_8; ++i) { mes[i] = 3 * i + 5; }
+
+    const int count = 64;
+    std::vector<autolykos_share_t> shares(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        GenerateShare(sk, pk, x, w, mes, 1000 + i, &shares[i]);
+
+        // every fourth share is wrong
+        if (!(i & 3)) { shares[i].d[0] ^= 1; }
+    }
+
+    std::string body;
+
+    PrintShares(shares.data(), count, &body);
+
+    // share without distance
+    body.replace(body.size() - 1, 1, ",{\"msg\":\"00\"}]");
+
+    std::vector<autolykos_share_t> parsed;
+    std::vector<int> verdicts;
+
+    if (
+        ParseShares(body.c_str(), &parsed, &verdicts) != EXIT_SUCCESS
+        || (int)parsed.size() != count + 1 || verdicts[count] != -1
+    )
+    {
+        LOG(ERROR) << "Validation test failed: batch not parsed";
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (memcmp(&parsed[i], &shares[i], sizeof(autolykos_share_t)))
+        {
+            LOG(ERROR) << "Validation test failed: share " << i
+                << " changed by JSON";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    validation_pool_t pool(4);
+
+    int valid = pool.Validate(parsed.data(), count + 1, verdicts.data());
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (verdicts[i] != !!(i & 3))
+        {
+            LOG(ERROR) << "Validation test failed: wrong verdict";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (valid != count * 3 / 4 || verdicts[count] != -1)
+    {
+        LOG(ERROR) << "Validation test failed: wrong valid count";
+        exit(EXIT_FAILURE);
+    }
+
+    if (ParseShares("{\"msg\":\"00\"}", &parsed, &verdicts) == EXIT_SUCCESS)
+    {
+        LOG(ERROR) << "Validation test failed: object accepted as batch";
+        exit(EXIT_FAILURE);
+    }
+
+    std::stringstream strBuf;
+
+    pool.shareLatency.Print(strBuf);
+
+    LOG(INFO) << "Share latency (us): " << strBuf.str();
+    LOG(INFO) << "Validation test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test single block nonce hash against generic one
+////////////////////////////////////////////////////////////////////////////////
+int TestNonceHash(void)
+{
+    LOG(INFO) << "Nonce hash test started";
+
+    ctx_t ctx;
+    nctx_t nctx;
+    uint8_t mes[NUM_SIZE_8 + 8];
+    uint32_t ind[K_LEN];
+    uint32_t folded[K_LEN];
+
+    // mining message, and longer one for fallback
+    for (int len = NUM_SIZE_8; len <= NUM_SIZE_8 + 1; ++len)
+    {
+        for (int i = 0; i < len; ++i) { mes[i] = 11 * i + len; }
+
+        InitMining(&ctx, (uint32_t *)mes, len);
+        InitNonceHash(&ctx, &nctx);
+
+        if (nctx.folded != (len == NUM_SIZE_8))
+        {
+            LOG(ERROR) << "Nonce hash test failed: wrong folding";
+            exit(EXIT_FAILURE);
+        }
+
+        for (uint64_t n = 0; n < 1 << 12; ++n)
+        {
+            uint64_t nonce = n * 0x9E3779B97F4A7C15;
+
+            HostNonceIndices(&ctx, nonce, ind);
+            HostNonceIndicesFolded(&nctx, nonce, folded);
+
+            if (memcmp(ind, folded, K_LEN * 4))
+            {
+                LOG(ERROR) << "Nonce hash test failed: indices differ";
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    //========================================================================//
+    //  Speedup over generic hash
+    //========================================================================//
+    const uint32_t count = 1 << 20;
+    uint32_t check = 0;
+
+    InitMining(&ctx, (uint32_t *)mes, NUM_SIZE_8);
+    InitNonceHash(&ctx, &nctx);
+
+    ch::steady_clock::time_point start = ch::steady_clock::now();
+
+    for (uint32_t n = 0; n < count; ++n)
+    {
+        HostNonceIndices(&ctx, n, ind);
+        check += ind[0];
+    }
+
+    double generic = count / ch::duration<double>(
+        ch::steady_clock::now() - start
+    ).count();
+
+    start = ch::steady_clock::now();
+
+    for (uint32_t n = 0; n < count; ++n)
+    {
+        HostNonceIndicesFolded(&nctx, n, ind);
+        check -= ind[0];
+    }
+
+    double single = count / ch::duration<double>(
+        ch::steady_clock::now() - start
+    ).count();
+
+    if (check)
+    {
+        LOG(ERROR) << "Nonce hash test failed: indices differ";
+        exit(EXIT_FAILURE);
+    }
+
+    LOG(INFO) << "Nonce hash: generic " << generic << " nonces/s, "
+        << "single block " << single << " nonces/s, speedup "
+        << single / generic;
+    LOG(INFO) << "Nonce hash test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Hardware event count of calling thread, -1 if counters are unavailable
+////////////////////////////////////////////////////////////////////////////////
+struct event_counter_t
+{
+    int fd;
+
+    // tlb: count data TLB read misses instead of cache misses
+    event_counter_t(const int tlb)
+    {
+        fd = -1;
+
+#ifdef __linux__
+        perf_event_attr attr;
+
+        memset(&attr, 0, sizeof(attr));
+
+        attr.size = sizeof(attr);
+        attr.type = (tlb)? PERF_TYPE_HW_CACHE: PERF_TYPE_HARDWARE;
+        attr.config = (tlb)?
+            PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16):
+            PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~event_counter_t(void)
+    {
+#ifdef __linux__
+        if (fd >= 0) { close(fd); }
+#endif
+    }
+
+    void Start(void)
+    {
+#ifdef __linux__
+        if (fd < 0) { return; }
+
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    int64_t Stop(void)
+    {
+        int64_t count = -1;
+
+#ifdef __linux__
+        if (fd < 0 || ioctl(fd, PERF_EVENT_IOC_DISABLE, 0)) { return -1; }
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) { return -1; }
+#endif
+
+        return count;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//  CPU mining gather from table, plain and grouped with prefetch
+////////////////////////////////////////////////////////////////////////////////
+static void GatherBenchmark(uint32_t * hashes, const char * table)
+{
+    // table content does not matter for gather, only for equal results
+    uint64_t state = 0x9E3779B97F4A7C15;
+
+    for (size_t i = 0; i < (size_t)N_LEN * NUM_SIZE_8 / 8; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        ((uint64_t *)hashes)[i] = state;
+    }
+
+    ctx_t ctx;
+    uint32_t mes[NUM_SIZE_32];
+    uint32_t sk[NUM_SIZE_32];
+    uint32_t bound[NUM_SIZE_32];
+
+    for (int i = 0; i < NUM_SIZE_32; ++i)
+    {
+        mes[i] = 0x01020304U * (i + 1);
+        sk[i] = 0x10203040U * (i + 1);
+        bound[i] = 0xFFFFFFFF;
+    }
+
+    InitMining(&ctx, mes, NUM_SIZE_8);
+
+    // one nonce of 256 is a solution
+    bound[NUM_SIZE_32 - 1] = 0x00FFFFFF;
+
+    //========================================================================//
+    //  Same first solution of both paths
+    //========================================================================//
+    uint32_t ind[K_LEN];
+    uint32_t plainRes[NUM_SIZE_32];
+    uint32_t groupRes[NUM_SIZE_32];
+    uint32_t plainValid = 0;
+    uint32_t groupValid;
+
+    for (uint32_t n = 0; n < 1 << 16 && !plainValid; ++n)
+    {
+        HostNonceIndices(&ctx, n, ind);
+        HostNonceResult(sk, hashes, ind, plainRes);
+
+        if (HostIsSolution(plainRes, bound)) { plainValid = n + 1; }
+    }
+
+    HostBlockMining(
+        bound, sk, &ctx, 0, 1 << 16, hashes, groupRes, &groupValid
+    );
+
+    if (
+        !plainValid || plainValid != groupValid
+        || memcmp(plainRes, groupRes, NUM_SIZE_8)
+    )
+    {
+        LOG(ERROR) << "Gather test failed: grouped mining differs";
+        exit(EXIT_FAILURE);
+    }
+
+    //========================================================================//
+    //  Throughput, cache and TLB misses per nonce
+    //========================================================================//
+    const uint32_t count = 1 << 18;
+
+    event_counter_t llc(0);
+    event_counter_t tlb(1);
+
+    memset(bound, 0, NUM_SIZE_8);
+
+    // 0: indices only, 1: plain, 2: grouped with prefetch
+    const char * names[3] = { "indices only", "plain", "grouped" };
+
+    for (int mode = 0; mode < 3; ++mode)
+    {
+        llc.Start();
+        tlb.Start();
+
+        ch::steady_clock::time_point start = ch::steady_clock::now();
+
+        if (mode < 2)
+        {
+            for (uint32_t n = 0; n < count; ++n)
+            {
+                HostNonceIndices(&ctx, n, ind);
+
+                if (mode) { HostNonceResult(sk, hashes, ind, plainRes); }
+            }
+        }
+        else
+        {
+            HostBlockMining(
+                bound, sk, &ctx, 0, count, hashes, groupRes, &groupValid
+            );
+        }
+
+        double sec = ch::duration<double>(
+            ch::steady_clock::now() - start
+        ).count();
+
+        int64_t misses = llc.Stop();
+        int64_t tlbMisses = tlb.Stop();
+
+        std::stringstream strBuf;
+
+        strBuf << "Gather " << names[mode] << " on " << table << ": "
+            << count / sec << " nonces/s";
+
+        if (mode)
+        {
+            // K_LEN cache lines per nonce
+            strBuf << ", " << count / sec * K_LEN * 64 / 1e9
+                << " GB/s of table lines";
+        }
+
+        if (misses >= 0)
+        {
+            strBuf << ", " << (double)misses / count
+                << " cache misses per nonce";
+        }
+
+        if (tlbMisses >= 0)
+        {
+            strBuf << ", " << (double)tlbMisses / count
+                << " TLB misses per nonce";
+        }
+
+        LOG(INFO) << strBuf.str();
+    }
+
+    if (llc.fd < 0)
+    {
+        LOG(INFO) << "Hardware counters are unavailable, misses not measured";
+    }
+
+    return;
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test CPU mining gather on table of malloc and on huge pages
+////////////////////////////////////////////////////////////////////////////////
+int TestGather(void)
+{
+    LOG(INFO) << "Gather test started";
+
+    uint32_t * hashes = (uint32_t *)malloc((size_t)N_LEN * NUM_SIZE_8);
+
+    if (!hashes)
+    {
+        LOG(INFO) << "Gather test skipped: 2 GiB of host memory needed\n";
+        return EXIT_SUCCESS;
+    }
+
+    GatherBenchmark(hashes, "malloc");
+
+    free(hashes);
+
+    huge_buffer_t buffer;
+
+    hashes = (uint32_t *)buffer.Allocate((size_t)N_LEN * NUM_SIZE_8);
+
+    if (hashes)
+    {
+        GatherBenchmark(hashes, buffer.PageName());
+    }
+
+    LOG(INFO) << "Gather test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test compact unfinalized prehash contexts against direct prehash
+////////////////////////////////////////////////////////////////////////////////
+int TestCompactPrehash(void)
+{
+    LOG(INFO) << "Compact prehash test started";
+
+    uint8_t pnp[2 * PK_SIZE_8 + NUM_SIZE_8];
+    uint32_t hash[NUM_SIZE_32];
+    uint32_t completed[NUM_SIZE_32];
+    uctx_t uctx;
+
+    if (sizeof(uctx_t) != 64)
+    {
+        LOG(ERROR) << "Compact prehash test failed: uctx_t is "
+            << sizeof(uctx_t) << " bytes";
+        exit(EXIT_FAILURE);
+    }
+
+    for (uint32_t i = 0; i < sizeof(pnp); ++i) { pnp[i] = 29 * i + 7; }
+
+    // both ends of index range and a spread in between
+    for (uint32_t k = 0; k <= 1 << 12; ++k)
+    {
+        uint32_t idx = (k == 1 << 12)? N_LEN - 1: k * 0x9E3779B1U % N_LEN;
+
+        HostUncompleteInitPrehash(pnp, idx, &uctx);
+        HostCompleteInitPrehash(pnp, &uctx, completed);
+        HostInitPrehash(pnp, idx, hash);
+
+        if (memcmp(hash, completed, NUM_SIZE_8))
+        {
+            LOG(ERROR) << "Compact prehash test failed: index " << idx;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    LOG(INFO) << "Compact prehash test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test constant message schedule against byte by byte hashing
+////////////////////////////////////////////////////////////////////////////////
+int TestConstMesSchedule(void)
+{
+    LOG(INFO) << "Constant message schedule test started";
+
+    ctx_t bytes;
+    ctx_t words;
+
+    for (uint32_t k = 0; k <= 1 << 10; ++k)
+    {
+        uint32_t idx = (k == 1 << 10)? N_LEN - 1: k * 0x9E3779B1U % N_LEN;
+
+        HostHashIndexConstMes(idx, 0, &bytes);
+        HostHashIndexConstMes(idx, 1, &words);
+
+        if (
+            memcmp(bytes.h, words.h, sizeof(bytes.h))
+            || memcmp(bytes.t, words.t, sizeof(bytes.t))
+            || bytes.c != words.c || memcmp(bytes.b, words.b, bytes.c)
+        )
+        {
+            LOG(ERROR) << "Constant message schedule test failed: index "
+                << idx;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    //========================================================================//
+    //  Speedup over byte by byte hashing
+    //========================================================================//
+    const uint32_t count = 1 << 12;
+    double rate[2];
+
+    for (int schedule = 0; schedule < 2; ++schedule)
+    {
+        ch::steady_clock::time_point start = ch::steady_clock::now();
+
+        for (uint32_t idx = 0; idx < count; ++idx)
+        {
+            HostHashIndexConstMes(idx, schedule, &words);
+        }
+
+        rate[schedule] = count / ch::duration<double>(
+            ch::steady_clock::now() - start
+        ).count();
+    }
+
+    LOG(INFO) << "Constant message: bytes " << rate[0] << " indices/s, "
+        << "schedule " << rate[1] << " indices/s, speedup "
+        << rate[1] / rate[0];
+    LOG(INFO) << "Constant message schedule test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test batched multiplication modulo Q against device carry chains port
+////////////////////////////////////////////////////////////////////////////////
+int TestModQ(void)
+{
+    LOG(INFO) << "Batched modulo Q multiplication test started";
+
+    const uint32_t count = 1 << 16;
+
+    std::vector<uint32_t> source(count * NUM_SIZE_32);
+    std::vector<uint32_t> expected(count * NUM_SIZE_32);
+    std::vector<uint32_t> hashes(count * NUM_SIZE_32);
+
+    uint64_t seed = 0x0123456789ABCDEF;
+    uint32_t x[NUM_SIZE_32];
+
+    for (uint32_t i = 0; i < count * NUM_SIZE_32; ++i)
+    {
+        seed = seed * 6364136223846793005U + 1442695040888963407U;
+        source[i] = seed >> 32;
+    }
+
+    // extreme hashes
+    memset(source.data(), 0, NUM_SIZE_8);
+    memset(source.data() + NUM_SIZE_32, 0xFF, NUM_SIZE_8);
+
+    for (int j = 0; j < NUM_SIZE_32; ++j) { x[j] = source[j + 100]; }
+
+    // one-time secret key below Q
+    x[NUM_SIZE_32 - 1] &= 0x7FFFFFFF;
+
+    expected = source;
+
+    ch::steady_clock::time_point start = ch::steady_clock::now();
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        HostFinalPrehashMultSecKey(x, expected.data() + i * NUM_SIZE_32);
+    }
+
+    LOG(INFO) << "Modulo Q: carry chains " << count / ch::duration<double>(
+        ch::steady_clock::now() - start
+    ).count() << " entries/s";
+
+    for (int engine = 0; engine < MODQ_ENGINES; ++engine)
+    {
+        if (!ModQSupported(engine))
+        {
+            LOG(INFO) << "Modulo Q: " << ModQEngineName(engine)
+                << " not supported by CPU";
+
+            continue;
+        }
+
+        // count not divisible by vector width
+        hashes = source;
+        HostMultSecKeyBatch(engine, x, hashes.data(), count - 3);
+
+        if (memcmp(
+            hashes.data(), expected.data(), (count - 3) * NUM_SIZE_8
+        ))
+        {
+            LOG(ERROR) << "Batched modulo Q multiplication test failed: "
+                << ModQEngineName(engine);
+            exit(EXIT_FAILURE);
+        }
+
+        hashes = source;
+        start = ch::steady_clock::now();
+
+        HostMultSecKeyBatch(engine, x, hashes.data(), count);
+
+        LOG(INFO) << "Modulo Q: " << ModQEngineName(engine) << " "
+            << count / ch::duration<double>(
+                ch::steady_clock::now() - start
+            ).count() << " entries/s";
+    }
+
+    LOG(INFO) << "Batched modulo Q multiplication test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test nonce results in vector lanes against carry chains port
+////////////////////////////////////////////////////////////////////////////////
+int TestNonceResults(void)
+{
+    LOG(INFO) << "Nonce results in lanes test started";
+
+    // cache resident table, row 0 of all ones and row 1 of zeros
+    const uint32_t rows = 1 << 12;
+    const uint32_t batches = 1 << 12;
+
+    std::vector<uint32_t> hashes(rows * NUM_SIZE_32);
+    std::vector<uint32_t> ind(batches * HOST_MINING_LANES * K_LEN);
+
+    uint64_t seed = 0xFEDCBA9876543210;
+
+    for (uint32_t i = 0; i < hashes.size(); ++i)
+    {
+        seed = seed * 6364136223846793005U + 1442695040888963407U;
+        hashes[i] = seed >> 32;
+    }
+
+    memset(hashes.data(), 0xFF, NUM_SIZE_8);
+    memset(hashes.data() + NUM_SIZE_32, 0, NUM_SIZE_8);
+
+    for (uint32_t i = 0; i < ind.size(); ++i)
+    {
+        seed = seed * 6364136223846793005U + 1442695040888963407U;
+        ind[i] = (seed >> 32) % rows;
+    }
+
+    // largest and smallest sums in first batches
+    for (uint32_t i = 0; i < HOST_MINING_LANES * K_LEN; ++i)
+    {
+        ind[i] = 0;
+        ind[HOST_MINING_LANES * K_LEN + i] = 1;
+    }
+
+    uint32_t sk[NUM_SIZE_32];
+    uint32_t bound[NUM_SIZE_32];
+    uint32_t res[HOST_MINING_LANES * NUM_SIZE_32];
+    uint32_t r[NUM_SIZE_32];
+
+    // secret keys of random, all ones and zero words
+    for (int key = 0; key < 3; ++key)
+    {
+        for (int i = 0; i < NUM_SIZE_32; ++i)
+        {
+            seed = seed * 6364136223846793005U + 1442695040888963407U;
+            sk[i] = (key == 0)? seed >> 32: (key == 1)? 0xFFFFFFFF: 0;
+            bound[i] = (i == NUM_SIZE_32 - 1)? 0x7FFFFFFF: seed;
+        }
+
+        for (uint32_t b = 0; b < batches; ++b)
+        {
+            const uint32_t * bind = ind.data() + b * HOST_MINING_LANES * K_LEN;
+
+            uint32_t below = HostNonceResults(
+                sk, hashes.data(), bind, bound, res
+            );
+
+            for (int l = 0; l < HOST_MINING_LANES; ++l)
+            {
+                HostNonceResult(sk, hashes.data(), bind + l * K_LEN, r);
+
+                if (
+                    memcmp(r, res + l * NUM_SIZE_32, NUM_SIZE_8)
+                    || ((below >> l) & 1) != (uint32_t)HostIsSolution(r, bound)
+                )
+                {
+                    LOG(ERROR) << "Nonce results in lanes test failed: batch "
+                        << b << ", lane " << l;
+                    exit(EXIT_FAILURE);
+                }
+            }
+        }
+    }
+
+    //========================================================================//
+    //  Speedup of summation over carry chains
+    //========================================================================//
+    uint32_t check = 0;
+    double rate[2];
+
+    for (int lanes = 0; lanes < 2; ++lanes)
+    {
+        ch::steady_clock::time_point start = ch::steady_clock::now();
+
+        for (uint32_t b = 0; b < batches; ++b)
+        {
+            const uint32_t * bind = ind.data() + b * HOST_MINING_LANES * K_LEN;
+
+            if (lanes)
+            {
+                check -= HostNonceResults(sk, hashes.data(), bind, bound, res);
+                continue;
+            }
+
+            uint32_t below = 0;
+
+            for (int l = 0; l < HOST_MINING_LANES; ++l)
+            {
+                HostNonceResult(sk, hashes.data(), bind + l * K_LEN, r);
+                below |= (uint32_t)HostIsSolution(r, bound) << l;
+            }
+
+            check += below;
+        }
+
+        rate[lanes] = batches * HOST_MINING_LANES / ch::duration<double>(
+            ch::steady_clock::now() - start
+        ).count();
+    }
+
+    if (check)
+    {
+        LOG(ERROR) << "Nonce results in lanes test failed: masks differ";
+        exit(EXIT_FAILURE);
+    }
+
+    LOG(INFO) << "Nonce results: carry chains " << rate[0] << " nonces/s, "
+        << HOST_MINING_LANES << " lanes " << rate[1] << " nonces/s, speedup "
+        << rate[1] / rate[0];
+    LOG(INFO) << "Nonce results in lanes test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test NUMA topology reading and table copy to node
+////////////////////////////////////////////////////////////////////////////////
+int TestTopology(void)
+{
+    const char * lists[5] = { "0-3,8,10-11\n", "5", "", "3-1", "1,,2" };
+    const int sizes[5] = { 7, 1, 0, -1, -1 };
+    std::vector<int> list;
+
+    for (int i = 0; i < 5; ++i)
+    {
+        int status = ParseCpuList(lists[i], &list);
+
+        if (
+            (sizes[i] < 0)? status == EXIT_SUCCESS:
+            status != EXIT_SUCCESS || (int)list.size() != sizes[i]
+        )
+        {
+            LOG(ERROR) << "Topology test failed: list \"" << lists[i] << "\"";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    ParseCpuList(lists[0], &list);
+
+    if (list[3] != 3 || list[4] != 8 || list[6] != 11)
+    {
+        LOG(ERROR) << "Topology test failed: list values";
+        exit(EXIT_FAILURE);
+    }
+
+    numa_t numa;
+    numa.Read();
+
+    for (int n = 0; n < numa.count; ++n)
+    {
+        LOG(INFO) << "NUMA node " << numa.ids[n] << ": "
+            << numa.cpus[n].size() << " CPUs";
+    }
+
+    //========================================================================//
+    //  Copy of table part to memory bound to last node
+    //========================================================================//
+    const size_t bytes = (size_t)1 << 28;
+
+    huge_buffer_t src;
+    huge_buffer_t dst;
+
+    if (!src.Allocate(bytes) || !dst.Allocate(bytes))
+    {
+        LOG(INFO) << "Topology test skipped copy: not enough memory\n";
+        return EXIT_SUCCESS;
+    }
+
+    memset(src.ptr, 0xA5, bytes);
+
+    int bound = BindMemory(dst.ptr, dst.size, numa.ids[numa.count - 1]);
+    int pinned = RunOnCpus(numa.cpus[numa.count - 1]);
+
+    ch::steady_clock::time_point start = ch::steady_clock::now();
+
+    memcpy(dst.ptr, src.ptr, bytes);
+
+    double sec = ch::duration<double>(ch::steady_clock::now() - start).count();
+
+    if (memcmp(dst.ptr, src.ptr, bytes))
+    {
+        LOG(ERROR) << "Topology test failed: copy differs";
+        exit(EXIT_FAILURE);
+    }
+
+    // return test thread to all CPUs
+    list.clear();
+
+    for (int n = 0; n < numa.count; ++n)
+    {
+        list.insert(list.end(), numa.cpus[n].begin(), numa.cpus[n].end());
+    }
+
+    RunOnCpus(list);
+
+    LOG(INFO) << "Copy to node " << numa.ids[numa.count - 1]
+        << ((bound == EXIT_SUCCESS)? " (bound": " (not bound")
+        << ((pinned == EXIT_SUCCESS)? ", pinned)": ", not pinned)") << ": "
+        << bytes / sec / 1e9 << " GB/s";
+    LOG(INFO) << "Topology test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test thread placement plans and feeder wake-up jitter under load
+////////////////////////////////////////////////////////////////////////////////
+int TestPlacement(void)
+{
+    placement_t plan;
+
+    // 2 nodes of 4 cores with 2 SMT siblings, CPU c and c + 8 share core
+    for (int c = 0; c < 8; ++c)
+    {
+        std::vector<int> core(1, c);
+        core.push_back(c + 8);
+        plan.cores.push_back(core);
+    }
+
+    for (int compute = 0; compute < 2; ++compute)
+    {
+        plan.Plan(3, compute);
+
+        std::vector<int> used(16, 0);
+
+        for (size_t i = 0; i < plan.service.size(); ++i)
+        {
+            ++used[plan.service[i]];
+        }
+
+        for (int d = 0; d < 3; ++d)
+        {
+            for (size_t i = 0; i < plan.workers[d].size(); ++i)
+            {
+                ++used[plan.workers[d][i]];
+            }
+
+            if (compute) { continue; }
+
+            for (size_t i = 0; i < plan.feeders[d].size(); ++i)
+            {
+                ++used[plan.feeders[d][i]];
+            }
+        }
+
+        for (int c = 0; c < 16; ++c)
+        {
+            if (used[c] > 1 || (compute && !used[c]))
+            {
+                LOG(ERROR) << "Placement test failed: CPU " << c
+                    << " used " << used[c] << " times";
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        // first CPUs of cores go before SMT siblings
+        if (compute && (plan.workers[0][0] != 1 || plan.workers[0][1] != 2))
+        {
+            LOG(ERROR) << "Placement test failed: workers "
+                << FormatCpuList(plan.workers[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (FormatCpuList(plan.workers[2]) != "5-7,13-15")
+    {
+        LOG(ERROR) << "Placement test failed: list format";
+        exit(EXIT_FAILURE);
+    }
+
+    //========================================================================//
+    //  Feeder wake-up jitter with busy host threads
+    //========================================================================//
+    if (plan.Read() != EXIT_SUCCESS)
+    {
+        LOG(INFO) << "Placement test skipped jitter: topology is unknown\n";
+        return EXIT_SUCCESS;
+    }
+
+    plan.Plan(1, 0);
+    plan.Report();
+
+    // busy threads on every CPU but feeder ones, if there are any
+    std::vector<int> rest;
+
+    for (size_t c = 0; c < plan.cores.size(); ++c)
+    {
+        if (plan.cores[c] == plan.feeders[0] && plan.cores.size() > 1)
+        {
+            continue;
+        }
+
+        rest.insert(rest.end(), plan.cores[c].begin(), plan.cores[c].end());
+    }
+
+    for (int placed = 0; placed < 2; ++placed)
+    {
+        std::atomic<int> stop(0);
+        std::atomic<uint64_t> work(0);
+        std::vector<std::thread> busy;
+        std::vector<double> late;
+
+        for (size_t t = 0; t < rest.size(); ++t)
+        {
+            busy.push_back(std::thread(
+                [&, t](void)
+                {
+                    if (placed) { RunOnCpus(std::vector<int>(1, rest[t])); }
+
+                    uint64_t x = t + 1;
+                    uint64_t n = 0;
+
+                    while (!stop.load(std::memory_order_relaxed))
+                    {
+                        for (int i = 0; i < 1000; ++i) { x = x * 3 + 1; }
+                        ++n;
+                    }
+
+                    work += n + (x & 1);
+                }
+            ));
+        }
+
+        std::thread feeder(
+            [&](void)
+            {
+                if (placed) { RunOnCpus(plan.feeders[0]); }
+
+                for (int i = 0; i < 500; ++i)
+                {
+                    ch::steady_clock::time_point start
+                        = ch::steady_clock::now();
+
+                    std::this_thread::sleep_for(ch::microseconds(500));
+
+                    late.push_back(ch::duration<double, std::micro>(
+                        ch::steady_clock::now() - start
+                    ).count() - 500);
+                }
+            }
+        );
+
+        ch::steady_clock::time_point start = ch::steady_clock::now();
+
+        feeder.join();
+        stop = 1;
+
+        for (size_t t = 0; t < busy.size(); ++t) { busy[t].join(); }
+
+        double sec
+            = ch::duration<double>(ch::steady_clock::now() - start).count();
+
+        std::sort(late.begin(), late.end());
+
+        LOG(INFO) << ((placed)? "Placed": "Unplaced") << " feeder wake-up"
+            << " delay median " << late[late.size() / 2] << " us, 99% "
+            << late[late.size() * 99 / 100] << " us, busy threads "
+            << work.load() / sec / 1e3 << " M steps/s";
+    }
+
+    LOG(INFO) << "Placement test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test prehash contexts shared between builder and readers
+////////////////////////////////////////////////////////////////////////////////
+int TestSharedTable(void)
+{
+    const size_t bytes = (size_t)1 << 20;
+    char name[64];
+
+    snprintf(
+        name, sizeof(name), "autolykos-test-%llx", (unsigned long long)
+        ch::steady_clock::now().time_since_epoch().count()
+    );
+    RemoveSharedTable(name);
+
+    shared_table_t builder;
+    shared_table_t reader;
+    shared_table_t other;
+
+    uint8_t pk[PK_SIZE_8];
+    uint64_t gen;
+
+    for (int i = 0; i < PK_SIZE_8; ++i) { pk[i] = 3 * i + 1; }
+
+    // readers cannot create table
+    if (reader.Open(name, SHARED_READER, bytes) == EXIT_SUCCESS)
+    {
+        LOG(ERROR) << "Shared table test failed: reader created table";
+        exit(EXIT_FAILURE);
+    }
+
+    if (
+        builder.Open(name, SHARED_BUILDER, bytes) != EXIT_SUCCESS
+        || reader.Open(name, SHARED_READER, bytes) != EXIT_SUCCESS
+        || other.Open(name, SHARED_READER, bytes) != EXIT_SUCCESS
+    )
+    {
+        LOG(ERROR) << "Shared table test failed: cannot attach";
+        exit(EXIT_FAILURE);
+    }
+
+    // nothing is published yet
+    if (
+        reader.Acquire(pk, &gen, 10) == EXIT_SUCCESS
+        || builder.Published(pk, &gen)
+    )
+    {
+        LOG(ERROR) << "Shared table test failed: empty table acquired";
+        exit(EXIT_FAILURE);
+    }
+
+    builder.BeginWrite();
+
+    for (size_t i = 0; i < bytes / sizeof(uctx_t); ++i)
+    {
+        for (int j = 0; j < 8; ++j) { builder.uctxs[i].h[j] = i * 29 + j; }
+    }
+
+    builder.Publish(pk);
+
+    if (
+        reader.Acquire(pk, &gen, 10) != EXIT_SUCCESS
+        || memcmp(builder.uctxs, reader.uctxs, bytes)
+        || !reader.Valid(gen)
+    )
+    {
+        LOG(ERROR) << "Shared table test failed: published table";
+        exit(EXIT_FAILURE);
+    }
+
+    // builder of the same public key reuses published contexts
+    uint64_t again;
+
+    builder.Close();
+
+    if (
+        builder.Open(name, SHARED_BUILDER, bytes) != EXIT_SUCCESS
+        || !builder.Published(pk, &again) || again != gen
+        || memcmp(builder.uctxs, reader.uctxs, bytes)
+    )
+    {
+        LOG(ERROR) << "Shared table test failed: reopened builder";
+        exit(EXIT_FAILURE);
+    }
+
+    // contexts of another wallet are refused
+    pk[0] ^= 1;
+
+    if (
+        other.Acquire(pk, &again, 10) == EXIT_SUCCESS
+        || builder.Published(pk, &again)
+    )
+    {
+        LOG(ERROR) << "Shared table test failed: another public key";
+        exit(EXIT_FAILURE);
+    }
+
+    // rewrite for another public key invalidates contexts of old one
+    builder.BeginWrite();
+
+    if (reader.Valid(gen))
+    {
+        LOG(ERROR) << "Shared table test failed: rewrite is not seen";
+        exit(EXIT_FAILURE);
+    }
+
+    builder.Publish(pk);
+    pk[0] ^= 1;
+
+    if (
+        reader.Acquire(pk, &again, 10) == EXIT_SUCCESS
+        || reader.Valid(gen)
+    )
+    {
+        LOG(ERROR) << "Shared table test failed: old public key acquired";
+        exit(EXIT_FAILURE);
+    }
+
+    builder.Close();
+    reader.Close();
+    other.Close();
+    RemoveSharedTable(name);
+
+    LOG(INFO) << "Shared table test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+// every word of snapshot k is derived from k
+static void FillBlock(block_data_t * block, const uint64_t k)
+{
+    for (int i = 0; i < NUM_SIZE_64; ++i)
+    {
+        ((uint64_t *)block->mes)[i] = k * 4 + i;
+        ((uint64_t *)block->bound)[i] = ~(k * 4 + i);
+    }
+
+    block->changed = k;
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test lock-free block data publication
+////////////////////////////////////////////////////////////////////////////////
+int TestBlockSeqlock(void)
+{
+    const uint64_t publications = 200000;
+    const int readers = 3;
+
+    block_seqlock_t lock;
+    block_data_t block;
+    std::atomic<int> done(0);
+    std::atomic<uint64_t> torn(0);
+    std::atomic<uint64_t> reads(0);
+    std::vector<std::thread> threads;
+
+    FillBlock(&block, 0);
+    lock.Publish(&block);
+
+    for (int r = 0; r < readers; ++r)
+    {
+        threads.push_back(std::thread([&](void)
+        {
+            block_data_t block;
+            uint64_t last = 0;
+            uint64_t count = 0;
+
+            while (!done.load())
+            {
+                uint64_t seq = lock.Read(&block);
+                uint64_t k = block.changed;
+
+                if (seq < last || seq & 1) { ++torn; }
+
+                for (int i = 0; i < NUM_SIZE_64; ++i)
+                {
+                    if (
+                        ((uint64_t *)block.mes)[i] != k * 4 + i
+                        || ((uint64_t *)block.bound)[i] != ~(k * 4 + i)
+                    )
+                    {
+                        ++torn;
+                    }
+                }
+
+                last = seq;
+                ++count;
+            }
+
+            reads += count;
+        }));
+    }
+
+    ch::steady_clock::time_point start = ch::steady_clock::now();
+
+    for (uint64_t k = 1; k <= publications; ++k)
+    {
+        FillBlock(&block, k);
+        lock.Publish(&block);
+    }
+
+    double publishNs = ch::duration_cast<ch::nanoseconds>(
+        ch::steady_clock::now() - start
+    ).count() / (double)publications;
+
+    done = 1;
+
+    for (int r = 0; r < readers; ++r) { threads[r].join(); }
+
+    LOG(INFO) << "Block data: " << publications << " publications, "
+        << publishNs << " ns each, " << reads.load() << " reads by "
+        << readers << " threads, " << lock.retries.load() << " retries";
+
+    if (
+        torn.load() || lock.seq.load() != 2 * (publications + 1)
+        || lock.reads.load() != reads.load()
+    )
+    {
+        LOG(ERROR) << "Block seqlock test failed: " << torn.load()
+            << " inconsistent snapshots";
+        exit(EXIT_FAILURE);
+    }
+
+    LOG(INFO) << "Block seqlock test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+// wait for condition up to 10 s
+template<typename Condition>
+static int WaitFor(Condition condition)
+{
+    for (int i = 0; i < 10000 && !condition(); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return condition();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test candidate fan-out through proxy
+////////////////////////////////////////////////////////////////////////////////
+int TestFanout(void)
+{
+    const int port = 39060;
+    const int miners = 4;
+
+    char address[32];
+    fanout_server_t server;
+    fanout_client_t clients[miners];
+    info_t infos[miners];
+    std::vector<std::thread> threads;
+    fanout_candidate_t cand;
+    block_data_t block;
+    uint8_t sol[NUM_SIZE_8];
+    int ok = 1;
+
+    // nothing listens on discard port, solutions fail fast
+    strcpy(server.to, "http://127.0.0.1:9/mining/solution");
+
+    if (server.Listen(port) != EXIT_SUCCESS)
+    {
+        LOG(ERROR) << "Fan-out test failed: cannot listen";
+        exit(EXIT_FAILURE);
+    }
+
+    memset(&cand, 0, sizeof(cand));
+    memset(sol, 0, NUM_SIZE_8);
+
+    for (int i = 0; i < PK_SIZE_8; ++i) { cand.pk[i] = i + 2; }
+
+    snprintf(address, sizeof(address), "127.0.0.1:%i", port);
+
+    for (int m = 0; m < miners; ++m)
+    {
+        infos[m].blockId = 0;
+        memcpy(infos[m].pk, cand.pk, PK_SIZE_8);
+
+        if (clients[m].Init(address) != EXIT_SUCCESS) { ok = 0; }
+
+        threads.push_back(
+            std::thread(&fanout_client_t::Run, &clients[m], &infos[m])
+        );
+    }
+
+    ok &= WaitFor([&](void)
+    {
+        std::lock_guard<std::mutex> lock(server.mutex);
+        return server.peers.size() == (size_t)miners;
+    });
+
+    FillBlock(&block, 1);
+    memcpy(cand.mes, block.mes, NUM_SIZE_8);
+
+    // new candidate, then new bound, then the same candidate again
+    for (uint64_t k = 1; k <= 3; ++k)
+    {
+        FillBlock(&block, (k < 3)? k: 2);
+
+        cand.seq = k;
+        memcpy(cand.bound, block.bound, NUM_SIZE_8);
+
+        server.Broadcast(&cand);
+
+        for (int m = 0; m < miners; ++m)
+        {
+            ok &= WaitFor([&](void)
+            {
+                return clients[m].received.load() == k;
+            });
+
+            infos[m].block.Read(&block);
+
+            ok &= (infos[m].blockId.load() == ((k < 3)? k: 2));
+            ok &= !memcmp(block.mes, cand.mes, NUM_SIZE_8);
+            ok &= !memcmp(block.bound, cand.bound, NUM_SIZE_8);
+
+            if (k < 3)
+            {
+                ok &= (block.changed == ((k == 1)?
+                    BLOCK_MES_CHANGED | BLOCK_BOUND_CHANGED:
+                    BLOCK_BOUND_CHANGED));
+            }
+        }
+
+        ok &= WaitFor([&](void)
+        {
+            std::lock_guard<std::mutex> lock(server.mutex);
+            return server.acks == k * miners;
+        });
+    }
+
+    double meanUs = server.latencySumUs / server.acks;
+    double maxUs = server.latencyMaxUs;
+
+    // node is down, proxy answers with failure
+    ok &= (
+        clients[0].PostSolution(cand.pk, sol, sol) == EXIT_FAILURE
+        && server.solutions.load() == 1 && server.delivered.load() == 0
+    );
+
+    for (int m = 0; m < miners; ++m)
+    {
+        clients[m].Stop();
+        threads[m].join();
+    }
+
+    LOG(INFO) << "Fan-out: " << miners << " miners, latency mean "
+        << meanUs << " us, max " << maxUs << " us";
+
+    if (!ok)
+    {
+        LOG(ERROR) << "Fan-out test failed";
+        exit(EXIT_FAILURE);
+    }
+
+    LOG(INFO) << "Fan-out test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Test kernels built for host against host procedures
+////////////////////////////////////////////////////////////////////////////////
+int TestHostKernels(void)
+{
+    LOG(INFO) << "Host kernels test started";
+
+    const uint32_t grid = 64;
+    const uint32_t count = grid * BLOCK_DIM;
+
+    // kernels copy whole rounds of block into shared memory
+    std::vector<uint32_t> data(DATA_SIZE_8 + ROUND_NC_SIZE_32, 0);
+    uint8_t * pnp = (uint8_t *)data.data();
+    uint32_t * x = data.data() + COUPLED_PK_SIZE_32 + NUM_SIZE_32;
+    uint32_t * sk = data.data() + COUPLED_PK_SIZE_32 + 2 * NUM_SIZE_32;
+    uint8_t pk[PK_SIZE_8];
+    uint8_t w[PK_SIZE_8];
+    uint8_t mes[NUM_SIZE_8];
+
+    GenerateKeyPair((uint8_t *)sk, pk);
+    GenerateKeyPair((uint8_t *)x, w);
+
+    for (int i = 0; i < NUM_SIZE_8; ++i) { mes[i] = 5 * i + 3; }
+
+    memcpy(pnp, pk, PK_SIZE_8);
+    memcpy(pnp + PK_SIZE_8, mes, NUM_SIZE_8);
+    memcpy(pnp + PK_SIZE_8 + NUM_SIZE_8, w, PK_SIZE_8);
+
+    ctx_t ctx;
+
+    InitMining(&ctx, (uint32_t *)mes, NUM_SIZE_8);
+    memcpy(
+        data.data() + COUPLED_PK_SIZE_32 + 3 * NUM_SIZE_32, &ctx, sizeof(ctx_t)
+    );
+
+    //========================================================================//
+    //  Prehash of the first indices
+    //========================================================================//
+    std::vector<uint32_t> hashes(count * NUM_SIZE_32);
+    std::vector<uint32_t> completed(count * NUM_SIZE_32);
+    std::vector<uctx_t> uctxs(count);
+    uint32_t invalid;
+    uint32_t h[NUM_SIZE_32];
+
+    ch::steady_clock::time_point start = ch::steady_clock::now();
+
+    HostLaunch(grid, BLOCK_DIM, 0, [&](void) {
+        hostkernel::InitPrehash(data.data(), hashes.data(), &invalid);
+    });
+
+    double prehashRate = count / ch::duration<double>(
+        ch::steady_clock::now() - start
+    ).count();
+
+    HostLaunch(grid, BLOCK_DIM, 0, [&](void) {
+        hostkernel::UncompleteInitPrehash(data.data(), uctxs.data());
+    });
+
+    HostLaunch(grid, BLOCK_DIM, 0, [&](void) {
+        hostkernel::CompleteInitPrehash(
+            data.data(), uctxs.data(), completed.data(), &invalid
+        );
+    });
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        HostInitPrehash(pnp, i, h);
+
+        if (
+            memcmp(h, hashes.data() + i * NUM_SIZE_32, NUM_SIZE_8)
+            || memcmp(h, completed.data() + i * NUM_SIZE_32, NUM_SIZE_8)
+        )
+        {
+            LOG(ERROR) << "Host kernels test failed: prehash of index " << i;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    HostLaunch(grid, BLOCK_DIM, 0, [&](void) {
+        hostkernel::FinalPrehashMultSecKey(data.data(), hashes.data());
+    });
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        HostInitPrehash(pnp, i, h);
+        HostFinalPrehashMultSecKey(x, h);
+
+        if (memcmp(h, hashes.data() + i * NUM_SIZE_32, NUM_SIZE_8))
+        {
+            LOG(ERROR) << "Host kernels test failed: secret key product of "
+                "index " << i;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    //========================================================================//
+    //  Block mining over random table
+    //========================================================================//
+    uint32_t * table = (uint32_t *)malloc((size_t)N_LEN * NUM_SIZE_8);
+
+    if (!table)
+    {
+        LOG(INFO) << "Host kernels test skipped mining: 2 GiB of host memory "
+            "needed\n";
+        return EXIT_SUCCESS;
+    }
+
+    uint64_t seed = 0x0F1E2D3C4B5A6978;
+
+    for (size_t i = 0; i < (size_t)N_LEN * NUM_SIZE_32; ++i)
+    {
+        seed = seed * 6364136223846793005U + 1442695040888963407U;
+        table[i] = seed >> 32;
+    }
+
+    uint32_t bound[NUM_SIZE_32];
+    uint32_t res[NUM_SIZE_32];
+    uint32_t r[NUM_SIZE_32];
+    uint32_t ind[K_LEN];
+    uint32_t valid;
+    std::vector<int> below(count);
+    double mineRate = 0;
+
+    // bases crossing 32-bit word of nonce, about 1/256 nonces below bound
+    const uint64_t bases[3] = { 0, 0xFFFFFFFF - count / 2, 0x123456789ABC };
+
+    for (int b = 0; b < 4; ++b)
+    {
+        const uint64_t base = bases[b % 3];
+
+        memset(bound, 0xFF, NUM_SIZE_8);
+        bound[NUM_SIZE_32 - 1] = (b == 3)? 0: 0x00FFFFFF;
+
+        valid = 0;
+
+        // one host thread so that result and index come from one thread
+        start = ch::steady_clock::now();
+
+        HostLaunch(grid, BLOCK_DIM, 1, [&](void) {
+            hostkernel::BlockMining(
+                bound, data.data(), base, count, table, res, &valid
+            );
+        });
+
+        mineRate += count / ch::duration<double>(
+            ch::steady_clock::now() - start
+        ).count() / 4;
+
+        uint32_t solutions = 0;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            HostNonceIndices(&ctx, base + i, ind);
+            HostNonceResult(sk, table, ind, r);
+
+            below[i] = HostIsSolution(r, bound);
+            solutions += below[i];
+
+            if (valid == i + 1 && memcmp(r, res, NUM_SIZE_8))
+            {
+                LOG(ERROR) << "Host kernels test failed: result of nonce "
+                    << base + i;
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        if (
+            (solutions && (!valid || valid > count || !below[valid - 1]))
+            || (!solutions && valid)
+        )
+        {
+            LOG(ERROR) << "Host kernels test failed: index " << valid
+                << " of base " << base << ", " << solutions << " solutions";
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    free(table);
+
+    LOG(INFO) << "Host kernels: prehash " << prehashRate << " hashes/s, "
+        "mining " << mineRate << " nonces/s per host thread";
+    LOG(INFO) << "Host kernels test passed\n";
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Main
+////////////////////////////////////////////////////////////////////////////////
+int main(int argc, char ** argv)
+{
+    START_EASYLOGGINGPP(argc, argv);
+
+    el::Loggers::reconfigureAllLoggers(
+        el::ConfigurationType::Format, "%datetime %level [%thread] %msg"
+    );
+
+    el::Helpers::setThreadName("test thread");
+
+    LOG(INFO) << "Checking crypto: ";
+
+    TestNewCrypto();
+
+    LOG(INFO) << "Testing requests:";
+
+    TestRequests();
+
+    TestAutotune();
+
+    TestThrottle();
+
+    TestHashrate();
+
+    TestAsyncLog();
+
+    TestWatchdog();
+
+    TestJournal();
+
+    TestCandidates();
+
+    TestBoundControl();
+
+    TestVerify();
+
+    TestValidation();
+
+    TestNonceHash();
+
+    TestGather();
+
+    TestCompactPrehash();
+
+    TestConstMesSchedule();
+
+    TestModQ();
+
+    TestNonceResults();
+
+    TestTopology();
+
+    TestPlacement();
+
+    TestSharedTable();
+
+    TestBlockSeqlock();
+
+    TestFanout();
+
+    TestHostKernels();
+
+    //========================================================================//
+    //  Check requirements
+    //========================================================================//
+    int deviceCount;
+
+    if (cudaGetDeviceCount(&deviceCount) != cudaSuccess)
+    {
+        LOG(ERROR) << "Error checking GPU";
+        exit(EXIT_FAILURE);
+    }
+
+    size_t freeMem;
+    size_t totalMem;
+
+    CUDA_CALL(cudaMemGetInfo(&freeMem, &totalMem));
+    
+    if (freeMem < MIN_FREE_MEMORY)
+    {
+        LOG(ERROR) << "Not enough GPU memory for mining, minimum "
+            << (MIN_FREE_MEMORY >> 20) << " MiB needed";
+
+        exit(EXIT_FAILURE);
+    }
+    
+    //========================================================================//
+    //  Set test info
+    //========================================================================//
+    info_t info;
+    uint8_t x[NUM_SIZE_8];
+    uint8_t w[PK_SIZE_8];
+    char seed[256] = "Va'esse deireadh aep eigean, va'esse eigh faidh'ar";
+
+    // generate secret key from seed
+    GenerateSecKey(seed, 50, info.sk, info.skstr);
+    // generate public key from secret key
+    GeneratePublicKey(info.skstr, info.pkstr, info.pk);
+
+    const char ref_pkstr[PK_SIZE_4 + 1]
+        = "020C16DFC5E23C59357E89D44977038F0A7851CC9926B3AABB3FF9E7E6A57315AD";
+
+    int test = !strncmp(ref_pkstr, info.pkstr, PK_SIZE_4);
+
+    if (!test)
+    {
+        LOG(ERROR) << "OpenSSL: generated wrong public key";
+        return EXIT_FAILURE;
+    }
+
+    block_data_t block;
+
+    ((uint64_t *)block.bound)[0] = 0xFFFFFFFFFFFFFFFF;
+    ((uint64_t *)block.bound)[1] = 0xFFFFFFFFFFFFFFFF;
+    ((uint64_t *)block.bound)[2] = 0xFFFFFFFFFFFFFFFF;
+    ((uint64_t *)block.bound)[3] = 0x000002FFFFFFFFFF;
+
+    ((uint64_t *)block.mes)[0] = 1;
+    ((uint64_t *)block.mes)[1] = 0;
+    ((uint64_t *)block.mes)[2] = 0;
+    ((uint64_t *)block.mes)[3] = 0;
+
+    block.changed = BLOCK_MES_CHANGED | BLOCK_BOUND_CHANGED;
+    info.block.Publish(&block);
+
+    sprintf(seed, "%d", 0);
+
+    // generate secret key from seed
+    GenerateSecKey(seed, 1, x, info.skstr);
+    // generate public key from secret key
+    GeneratePublicKey(info.skstr, info.pkstr, w);
+
+    //========================================================================//
+    //  Run solutions correctness tests
+    //========================================================================//
+    if (NONCES_PER_ITER <= 0x3D5B84)
+    {
+        LOG(INFO) << "Need WORKSPACE value for at least 4021125,"
+            << " skip solutions tests\n";
+    }
+    else
+    {
+        info.keepPrehash = 0;
+        TestSolutions(&info, x, w);
+
+        info.cpuThreads = 0;
+        info.cpuNumaReplicate = 0;
+        info.cpuShared = SHARED_NONE;
+        info.cpuSharedName[0] = '\0';
+        TestCpuBackend(&info, x, w);
 
         if (freeMem < MIN_FREE_MEMORY_PREHASH)
         {
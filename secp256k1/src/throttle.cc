@@ -0,0 +1,179 @@
+// throttle.cc
+
+/*******************************************************************************
+
+    THROTTLE -- Temperature and power target duty-cycle controller
+
+*******************************************************************************/
+
+#include "../include/throttle.h"
+#include "../include/easylogging++.h"
+#include <nvml.h>
+#include <stdlib.h>
+
+////////////////////////////////////////////////////////////////////////////////
+//  NVML sensor
+////////////////////////////////////////////////////////////////////////////////
+struct nvml_sensor_t: sensor_t
+{
+    nvmlDevice_t device;
+
+    nvml_sensor_t(nvmlDevice_t dev) { device = dev; }
+    ~nvml_sensor_t(void) { nvmlShutdown(); }
+
+    int Read(const double, const double, double * temp, double * power)
+    {
+        unsigned int t;
+        unsigned int p;
+
+        if (
+            nvmlDeviceGetTemperature(device, NVML_TEMPERATURE_GPU, &t)
+            != NVML_SUCCESS
+            || nvmlDeviceGetPowerUsage(device, &p) != NVML_SUCCESS
+        )
+        {
+            return EXIT_FAILURE;
+        }
+
+        *temp = t;
+        *power = p / 1000.0;
+
+        return EXIT_SUCCESS;
+    }
+};
+
+sensor_t * CreateNvmlSensor(const char * pciBusId)
+{
+    nvmlDevice_t device;
+
+    if (nvmlInit() != NVML_SUCCESS)
+    {
+        LOG(ERROR) << "NVML error, device sensors are not available";
+        return NULL;
+    }
+
+    if (nvmlDeviceGetHandleByPciBusId(pciBusId, &device) != NVML_SUCCESS)
+    {
+        LOG(ERROR) << "NVML error, no device with PCI bus id " << pciBusId;
+        nvmlShutdown();
+
+        return NULL;
+    }
+
+    return new nvml_sensor_t(device);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Mock sensor
+////////////////////////////////////////////////////////////////////////////////
+struct mock_sensor_t: sensor_t
+{
+    double temp;
+
+    mock_sensor_t(void) { temp = MOCK_AMBIENT; }
+
+    int Read(const double duty, const double sec, double * t, double * p)
+    {
+        double power
+            = MOCK_IDLE_POWER + (MOCK_MAX_POWER - MOCK_IDLE_POWER) * duty;
+
+        double k = sec / MOCK_THERMAL_TAU;
+        if (k > 1) { k = 1; }
+
+        temp += (MOCK_AMBIENT + MOCK_THERMAL_RES * power - temp) * k;
+
+        *t = temp;
+        *p = power;
+
+        return EXIT_SUCCESS;
+    }
+};
+
+sensor_t * CreateMockSensor(void)
+{
+    return new mock_sensor_t();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Duty-cycle controller
+////////////////////////////////////////////////////////////////////////////////
+throttle_t::throttle_t(sensor_t * s, const double temp, const double power)
+{
+    sensor = s;
+    targetTemp = temp;
+    targetPower = power;
+
+    duty = 1;
+    pause = 0;
+    periodSec = 0;
+    periodBusy = 0;
+    this->temp = 0;
+    this->power = 0;
+    joules = 0;
+    hashes = 0;
+}
+
+throttle_t::~throttle_t(void)
+{
+    delete sensor;
+}
+
+double throttle_t::Update(
+    const double iterSec,
+    const double sleptSec,
+    const uint32_t nonces
+)
+{
+    periodSec += iterSec + sleptSec;
+    periodBusy += iterSec;
+    hashes += nonces;
+
+    if (periodSec * 1000 < THROTTLE_PERIOD_MS) { return pause; }
+
+    if (
+        sensor->Read(periodBusy / periodSec, periodSec, &temp, &power)
+        == EXIT_SUCCESS
+    )
+    {
+        joules += power * periodSec;
+
+        int active = 0;
+        double err = 0;
+
+        if (targetTemp > 0)
+        {
+            err = (temp - targetTemp) / targetTemp;
+            active = 1;
+        }
+
+        if (targetPower > 0)
+        {
+            double e = (power - targetPower) / targetPower;
+
+            if (!active || e > err) { err = e; }
+            active = 1;
+        }
+
+        if (active)
+        {
+            duty -= THROTTLE_GAIN * err;
+
+            if (duty < THROTTLE_MIN_DUTY) { duty = THROTTLE_MIN_DUTY; }
+            if (duty > 1) { duty = 1; }
+        }
+    }
+
+    periodSec = 0;
+    periodBusy = 0;
+
+    pause = iterSec * (1 - duty) / duty;
+
+    return pause;
+}
+
+double throttle_t::HashesPerJoule(void) const
+{
+    return (joules > 0)? hashes / joules: 0;
+}
+
+// throttle.cc
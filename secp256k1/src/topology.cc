@@ -0,0 +1,407 @@
+// topology.cc
+
+/*******************************************************************************
+
+    TOPOLOGY -- Host NUMA nodes, CPU cores and thread placement
+
+*******************************************************************************/
+
+#include "../include/topology.h"
+#include "../include/easylogging++.h"
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#ifndef MPOL_BIND
+#define MPOL_BIND     2
+#endif
+#ifndef MPOL_MF_MOVE
+#define MPOL_MF_MOVE  (1 << 1)
+#endif
+#endif
+
+#define NODE_PATH "/sys/devices/system/node"
+#define CPU_PATH  "/sys/devices/system/cpu"
+
+////////////////////////////////////////////////////////////////////////////////
+//  Parse list like "0-3,8,10-11"
+////////////////////////////////////////////////////////////////////////////////
+int ParseCpuList(const char * str, std::vector<int> * list)
+{
+    list->clear();
+
+    while (*str && *str != '\n')
+    {
+        char * end;
+        long from = strtol(str, &end, 10);
+        long to = from;
+
+        if (end == str || from < 0 || from >= MAX_CPU_ID)
+        {
+            return EXIT_FAILURE;
+        }
+
+        str = end;
+
+        if (*str == '-')
+        {
+            to = strtol(++str, &end, 10);
+
+            if (end == str || to < from || to >= MAX_CPU_ID)
+            {
+                return EXIT_FAILURE;
+            }
+
+            str = end;
+        }
+
+        for (long i = from; i <= to; ++i) { list->push_back((int)i); }
+
+        if (*str == ',') { ++str; }
+        else if (*str && *str != '\n') { return EXIT_FAILURE; }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Read one line of sysfs file
+////////////////////////////////////////////////////////////////////////////////
+static int ReadLine(const char * path, char * line, const int size)
+{
+    FILE * in = fopen(path, "r");
+
+    if (!in) { return EXIT_FAILURE; }
+
+    int status = (fgets(line, size, in))? EXIT_SUCCESS: EXIT_FAILURE;
+
+    fclose(in);
+
+    return status;
+}
+
+numa_t::numa_t(void)
+{
+    count = 1;
+    ids[0] = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Read nodes of host
+////////////////////////////////////////////////////////////////////////////////
+void numa_t::Read(void)
+{
+    char path[64];
+    char line[4096];
+    std::vector<int> nodes;
+    std::vector<int> list;
+
+    count = 1;
+    ids[0] = 0;
+    cpus[0].clear();
+
+    if (
+        ReadLine(NODE_PATH "/online", line, sizeof(line)) != EXIT_SUCCESS
+        || ParseCpuList(line, &nodes) != EXIT_SUCCESS
+    )
+    {
+        return;
+    }
+
+    int found = 0;
+
+    for (size_t i = 0; i < nodes.size() && found < MAX_NUMA_NODES; ++i)
+    {
+        if (nodes[i] >= MAX_NODE_ID) { break; }
+
+        snprintf(path, sizeof(path), NODE_PATH "/node%i/cpulist", nodes[i]);
+
+        // memory-only nodes have empty CPU list
+        if (
+            ReadLine(path, line, sizeof(line)) != EXIT_SUCCESS
+            || ParseCpuList(line, &list) != EXIT_SUCCESS || list.empty()
+        )
+        {
+            continue;
+        }
+
+        ids[found] = nodes[i];
+        cpus[found] = list;
+        ++found;
+    }
+
+    if (found) { count = found; }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Node index of CPU
+////////////////////////////////////////////////////////////////////////////////
+int numa_t::NodeOf(const int cpu) const
+{
+    for (int n = 0; n < count; ++n)
+    {
+        if (std::find(cpus[n].begin(), cpus[n].end(), cpu) != cpus[n].end())
+        {
+            return n;
+        }
+    }
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Read nodes and cores of host
+////////////////////////////////////////////////////////////////////////////////
+int placement_t::Read(void)
+{
+    char path[96];
+    char line[4096];
+    std::vector<int> online;
+    // node, package, core and CPU
+    std::vector<std::vector<int> > keys;
+
+    numa.Read();
+    cores.clear();
+
+    if (
+        ReadLine(CPU_PATH "/online", line, sizeof(line)) != EXIT_SUCCESS
+        || ParseCpuList(line, &online) != EXIT_SUCCESS
+    )
+    {
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < online.size(); ++i)
+    {
+        std::vector<int> key(4);
+
+        key[0] = numa.NodeOf(online[i]);
+        key[3] = online[i];
+
+        snprintf(
+            path, sizeof(path), CPU_PATH "/cpu%i/topology/physical_package_id",
+            online[i]
+        );
+
+        if (ReadLine(path, line, sizeof(line)) != EXIT_SUCCESS)
+        {
+            return EXIT_FAILURE;
+        }
+
+        key[1] = atoi(line);
+
+        snprintf(
+            path, sizeof(path), CPU_PATH "/cpu%i/topology/core_id", online[i]
+        );
+
+        if (ReadLine(path, line, sizeof(line)) != EXIT_SUCCESS)
+        {
+            return EXIT_FAILURE;
+        }
+
+        key[2] = atoi(line);
+        keys.push_back(key);
+    }
+
+    // siblings are neighbours after sorting
+    std::sort(keys.begin(), keys.end());
+
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        if (
+            !i || keys[i][0] != keys[i - 1][0] || keys[i][1] != keys[i - 1][1]
+            || keys[i][2] != keys[i - 1][2]
+        )
+        {
+            cores.push_back(std::vector<int>());
+        }
+
+        cores.back().push_back(keys[i][3]);
+    }
+
+    return (cores.empty())? EXIT_FAILURE: EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Split cores between threads of devices
+////////////////////////////////////////////////////////////////////////////////
+void placement_t::Plan(const int devices, const int compute)
+{
+    const int total = cores.size();
+
+    service.clear();
+    feeders.assign(devices, std::vector<int>());
+    workers.assign(devices, std::vector<int>());
+
+    if (!total) { return; }
+
+    service = cores[0];
+
+    // cores left after service core
+    int first = (total > 1)? 1: 0;
+    int left = total - first;
+
+    if (!compute)
+    {
+        for (int d = 0; d < devices; ++d)
+        {
+            feeders[d] = cores[first + d % left];
+        }
+
+        return;
+    }
+
+    for (int d = 0; d < devices; ++d)
+    {
+        feeders[d] = service;
+
+        // contiguous cores of device, all of them if there are too few
+        int from = first + (int)((int64_t)left * d / devices);
+        int to = first + (int)((int64_t)left * (d + 1) / devices);
+
+        if (from == to) { from = first; to = total; }
+
+        for (size_t k = 0;; ++k)
+        {
+            int added = 0;
+
+            for (int c = from; c < to; ++c)
+            {
+                if (k < cores[c].size())
+                {
+                    workers[d].push_back(cores[c][k]);
+                    added = 1;
+                }
+            }
+
+            if (!added) { break; }
+        }
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Log decisions
+////////////////////////////////////////////////////////////////////////////////
+void placement_t::Report(void) const
+{
+    size_t cpus = 0;
+
+    for (size_t c = 0; c < cores.size(); ++c) { cpus += cores[c].size(); }
+
+    LOG(INFO) << "Placement: " << cpus << " CPUs in " << cores.size()
+        << " cores on " << numa.count << " NUMA nodes, service threads on"
+        << " CPUs " << FormatCpuList(service);
+
+    for (size_t d = 0; d < feeders.size(); ++d)
+    {
+        LOG(INFO) << "Placement: device " << d << " miner thread on CPUs "
+            << FormatCpuList(feeders[d])
+            << ((workers[d].empty())? "": ", compute workers on CPUs ")
+            << FormatCpuList(workers[d]);
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Bind memory not yet touched to node
+////////////////////////////////////////////////////////////////////////////////
+int BindMemory(void * ptr, const size_t size, const int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    const int bits = 8 * sizeof(unsigned long);
+    unsigned long mask[MAX_NODE_ID / bits];
+
+    if (node < 0 || node >= MAX_NODE_ID) { return EXIT_FAILURE; }
+
+    memset(mask, 0, sizeof(mask));
+    mask[node / bits] = 1UL << (node % bits);
+
+    return (syscall(
+        SYS_mbind, ptr, size, MPOL_BIND, mask, MAX_NODE_ID, MPOL_MF_MOVE
+    ))? EXIT_FAILURE: EXIT_SUCCESS;
+#else
+    (void)ptr;
+    (void)size;
+    (void)node;
+
+    return EXIT_FAILURE;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  List in "0-3,8" form
+////////////////////////////////////////////////////////////////////////////////
+std::string FormatCpuList(const std::vector<int> & list)
+{
+    std::vector<int> sorted(list);
+    std::string str;
+    char range[32];
+
+    std::sort(sorted.begin(), sorted.end());
+
+    for (size_t i = 0; i < sorted.size();)
+    {
+        size_t j = i;
+
+        while (j + 1 < sorted.size() && sorted[j + 1] <= sorted[j] + 1) { ++j; }
+
+        if (sorted[j] > sorted[i])
+        {
+            snprintf(range, sizeof(range), "%i-%i", sorted[i], sorted[j]);
+        }
+        else
+        {
+            snprintf(range, sizeof(range), "%i", sorted[i]);
+        }
+
+        if (!str.empty()) { str += ","; }
+        str += range;
+        i = j + 1;
+    }
+
+    return str;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Run calling thread on CPUs of list
+////////////////////////////////////////////////////////////////////////////////
+int RunOnCpus(const std::vector<int> & cpus)
+{
+#ifdef __linux__
+    cpu_set_t * set = CPU_ALLOC(MAX_CPU_ID);
+    size_t size = CPU_ALLOC_SIZE(MAX_CPU_ID);
+
+    if (!set) { return EXIT_FAILURE; }
+
+    CPU_ZERO_S(size, set);
+
+    for (size_t i = 0; i < cpus.size(); ++i) { CPU_SET_S(cpus[i], size, set); }
+
+    int status = (cpus.empty() || sched_setaffinity(0, size, set))?
+        EXIT_FAILURE: EXIT_SUCCESS;
+
+    CPU_FREE(set);
+
+    return status;
+#else
+    (void)cpus;
+
+    return EXIT_FAILURE;
+#endif
+}
+
+// topology.cc
@@ -0,0 +1,761 @@
+// validator.cc
+
+/*******************************************************************************
+
+    VALIDATOR -- Share validation service and its load generator
+
+*******************************************************************************/
+
+#include "../include/validator.h"
+#include "../include/conversion.h"
+#include "../include/cryptography.h"
+#include "../include/definitions.h"
+#include "../include/easylogging++.h"
+#include "../include/hostmining.h"
+#include "../include/hostprehash.h"
+#include "../include/httplib.h"
+#include "../include/jsmn.h"
+#include "../include/request.h"
+#include "../include/verify.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <sstream>
+
+using namespace std::chrono;
+
+////////////////////////////////////////////////////////////////////////////////
+//  Empty histogram
+////////////////////////////////////////////////////////////////////////////////
+latency_histogram_t::latency_histogram_t(void)
+{
+    for (int k = 0; k < LATENCY_BUCKETS; ++k) { counts[k] = 0; }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Count latency
+////////////////////////////////////////////////////////////////////////////////
+void latency_histogram_t::Add(const double us)
+{
+    int k = 0;
+
+    while (k + 1 < LATENCY_BUCKETS && us >= (double)(2ULL << k)) { ++k; }
+
+    ++counts[k];
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Upper bound of bucket of quantile
+////////////////////////////////////////////////////////////////////////////////
+double latency_histogram_t::Quantile(const double q) const
+{
+    uint64_t total = 0;
+
+    for (int k = 0; k < LATENCY_BUCKETS; ++k) { total += counts[k]; }
+
+    if (!total) { return 0; }
+
+    uint64_t seen = 0;
+
+    for (int k = 0; k < LATENCY_BUCKETS; ++k)
+    {
+        seen += counts[k];
+
+        if (seen >= q * total) { return (double)(2ULL << k); }
+    }
+
+    return (double)(2ULL << (LATENCY_BUCKETS - 1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  JSON object with counts and quantiles
+////////////////////////////////////////////////////////////////////////////////
+void latency_histogram_t::Print(std::ostream & out) const
+{
+    int last = LATENCY_BUCKETS - 1;
+
+    while (last > 0 && !counts[last]) { --last; }
+
+    out << "{ \"counts\": [";
+
+    for (int k = 0; k <= last; ++k) { out << ((k)? ", ": "") << counts[k]; }
+
+    out << "], \"p50\": " << Quantile(0.5)
+        << ", \"p90\": " << Quantile(0.9)
+        << ", \"p99\": " << Quantile(0.99)
+        << ", \"p999\": " << Quantile(0.999) << " }";
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Start validation threads
+////////////////////////////////////////////////////////////////////////////////
+validation_pool_t::validation_pool_t(const int threads): finished(0)
+{
+    int n = (threads > 0)? threads: std::thread::hardware_concurrency();
+
+    if (n <= 0) { n = 1; }
+
+    for (int t = 0; t < n; ++t)
+    {
+        workers.push_back(std::thread(&validation_pool_t::Work, this));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Finish queued batches and stop validation threads
+////////////////////////////////////////////////////////////////////////////////
+validation_pool_t::~validation_pool_t(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = 1;
+    }
+
+    work.notify_all();
+
+    for (size_t t = 0; t < workers.size(); ++t) { workers[t].join(); }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Verify chunks of queued batches
+////////////////////////////////////////////////////////////////////////////////
+void validation_pool_t::Work(void)
+{
+    verifier_t verifier;
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (1)
+    {
+        work.wait(lock, [&] { return finished || !queue.empty(); });
+
+        if (queue.empty()) { return; }
+
+        // chunk of the oldest batch
+        validation_batch_t * batch = queue.front();
+
+        int from = batch->next;
+        int to = std::min(from + VALIDATOR_CHUNK, batch->count);
+
+        batch->next = to;
+
+        if (to == batch->count) { queue.pop_front(); }
+
+        lock.unlock();
+
+        for (int i = from; i < to; ++i)
+        {
+            const autolykos_share_t * s = batch->shares + i;
+
+            if (batch->verdicts[i] < 0) { continue; }
+
+            steady_clock::time_point start = steady_clock::now();
+
+            batch->verdicts[i] = verifier.Verify(
+                s->mes, s->pk, s->w, s->nonce, s->d, s->bound
+            ) == EXIT_SUCCESS;
+
+            shareLatency.Add(
+                duration<double, std::micro>(steady_clock::now() - start)
+                .count()
+            );
+        }
+
+        lock.lock();
+
+        batch->done += to - from;
+
+        if (batch->done == batch->count) { done.notify_all(); }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Verify shares with non-negative verdicts, block until done
+////////////////////////////////////////////////////////////////////////////////
+int validation_pool_t::Validate(
+    const autolykos_share_t * shares,
+    const int count,
+    int * verdicts
+)
+{
+    validation_batch_t batch = { shares, verdicts, count, 0, 0 };
+
+    if (count > 0)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        queue.push_back(&batch);
+        work.notify_all();
+
+        done.wait(lock, [&] { return batch.done == count; });
+    }
+
+    return (int)std::count(verdicts, verdicts + count, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Share of keys for message and nonce, valid for any bound
+////////////////////////////////////////////////////////////////////////////////
+void GenerateShare(
+    // secret key (LITTLE ENDIAN)
+    const uint8_t * sk,
+    // public key
+    const uint8_t * pk,
+    // one-time secret key (LITTLE ENDIAN)
+    const uint8_t * x,
+    // one-time public key
+    const uint8_t * w,
+    // message
+    const uint8_t * mes,
+    const uint64_t nonce,
+    autolykos_share_t * share
+)
+{
+    uint8_t pnp[2 * PK_SIZE_8 + NUM_SIZE_8];
+
+    memcpy(pnp, pk, PK_SIZE_8);
+    memcpy(pnp + PK_SIZE_8, mes, NUM_SIZE_8);
+    memcpy(pnp + PK_SIZE_8 + NUM_SIZE_8, w, PK_SIZE_8);
+
+    // result of mining for the nonce from the selected hashes only
+    ctx_t ctx;
+    uint32_t ind[K_LEN];
+    uint32_t seq[K_LEN];
+    uint32_t hashes[K_LEN * NUM_SIZE_32];
+    uint32_t d[NUM_SIZE_32];
+
+    InitMining(&ctx, (const uint32_t *)mes, NUM_SIZE_8);
+    HostNonceIndices(&ctx, nonce, ind);
+
+    for (int k = 0; k < K_LEN; ++k)
+    {
+        HostInitPrehash(pnp, ind[k], hashes + k * NUM_SIZE_32);
+        HostFinalPrehashMultSecKey(
+            (const uint32_t *)x, hashes + k * NUM_SIZE_32
+        );
+
+        seq[k] = k;
+    }
+
+    HostNonceResult((const uint32_t *)sk, hashes, seq, d);
+
+    memcpy(share->mes, mes, NUM_SIZE_8);
+    memcpy(share->pk, pk, PK_SIZE_8);
+    memcpy(share->w, w, PK_SIZE_8);
+    memcpy(share->nonce, &nonce, NONCE_SIZE_8);
+    memcpy(share->d, d, NUM_SIZE_8);
+    memset(share->bound, 0xFF, NUM_SIZE_8);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Decimal number without exponent to little endian of 256 bits
+////////////////////////////////////////////////////////////////////////////////
+static int DecStrToLittleEndian(
+    const char * in,
+    const int inlen,
+    uint8_t * out
+)
+{
+    char hex[NUM_SIZE_4 + 1];
+    int digits = 0;
+
+    while (digits < inlen && isdigit(in[digits])) { ++digits; }
+
+    if (!digits || digits > 78) { return EXIT_FAILURE; }
+
+    DecStrToHexStrOf64(in, digits, hex);
+    HexStrToLittleEndian(hex, NUM_SIZE_4, out, NUM_SIZE_8);
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Parse batch of shares
+////////////////////////////////////////////////////////////////////////////////
+int ParseShares(
+    const char * body,
+    std::vector<autolykos_share_t> * shares,
+    std::vector<int> * verdicts
+)
+{
+    int len = strlen(body);
+    jsmn_parser parser;
+
+    // count tokens first, batch size is not limited
+    jsmn_init(&parser);
+
+    int numtoks = jsmn_parse(&parser, body, len, NULL, 0);
+
+    if (numtoks < 1) { return EXIT_FAILURE; }
+
+    json_t batch(len, numtoks);
+
+    memcpy(batch.ptr, body, len);
+    ToUppercase(batch.ptr);
+    jsmn_init(&parser);
+
+    if (
+        jsmn_parse(&parser, batch.ptr, len, batch.toks, numtoks) != numtoks
+        || batch.toks[0].type != JSMN_ARRAY
+    )
+    {
+        return EXIT_FAILURE;
+    }
+
+    shares->resize(batch.toks[0].size);
+    verdicts->assign(batch.toks[0].size, 0);
+
+    int t = 1;
+
+    for (int s = 0; s < batch.toks[0].size; ++s)
+    {
+        if (t >= numtoks || batch.toks[t].type != JSMN_OBJECT)
+        {
+            return EXIT_FAILURE;
+        }
+
+        autolykos_share_t * share = &(*shares)[s];
+        int keys = batch.toks[t].size;
+        int read = 0;
+
+        ++t;
+
+        for (int k = 0; k < keys; ++k, t += 2)
+        {
+            if (
+                t + 1 >= numtoks
+                || batch.toks[t + 1].type == JSMN_OBJECT
+                || batch.toks[t + 1].type == JSMN_ARRAY
+            )
+            {
+                return EXIT_FAILURE;
+            }
+
+            const char * val = batch.GetTokenStart(t + 1);
+            int vlen = batch.GetTokenLen(t + 1);
+
+            if (batch.jsoneq(t, "MSG") && vlen == NUM_SIZE_4)
+            {
+                HexStrToBigEndian(val, vlen, share->mes, NUM_SIZE_8);
+                read |= 1;
+            }
+            else if (batch.jsoneq(t, "B"))
+            {
+                if (DecStrToLittleEndian(val, vlen, share->bound)
+                    == EXIT_SUCCESS) { read |= 2; }
+            }
+            else if (batch.jsoneq(t, "PK") && vlen == PK_SIZE_4)
+            {
+                HexStrToBigEndian(val, vlen, share->pk, PK_SIZE_8);
+                read |= 4;
+            }
+            else if (batch.jsoneq(t, "W") && vlen == PK_SIZE_4)
+            {
+                HexStrToBigEndian(val, vlen, share->w, PK_SIZE_8);
+                read |= 8;
+            }
+            else if (batch.jsoneq(t, "N") && vlen == NONCE_SIZE_4)
+            {
+                HexStrToLittleEndian(val, vlen, share->nonce, NONCE_SIZE_8);
+                read |= 16;
+            }
+            else if (batch.jsoneq(t, "D"))
+            {
+                if (DecStrToLittleEndian(val, vlen, share->d)
+                    == EXIT_SUCCESS) { read |= 32; }
+            }
+        }
+
+        if (read != 63) { (*verdicts)[s] = -1; }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  JSON array of shares
+////////////////////////////////////////////////////////////////////////////////
+void PrintShares(
+    const autolykos_share_t * shares,
+    const int count,
+    std::string * body
+)
+{
+    char str[NUM_SIZE_4 * 2];
+    uint32_t len;
+
+    body->assign("[");
+
+    for (int i = 0; i < count; ++i)
+    {
+        const autolykos_share_t * s = shares + i;
+
+        *body += (i)? ",{\"msg\":\"": "{\"msg\":\"";
+        BigEndianToHexStr(s->mes, NUM_SIZE_8, str);
+        *body += str;
+
+        *body += "\",\"b\":";
+        LittleEndianOf256ToDecStr(s->bound, str, &len);
+        body->append(str, len);
+
+        *body += ",\"pk\":\"";
+        BigEndianToHexStr(s->pk, PK_SIZE_8, str);
+        *body += str;
+
+        *body += "\",\"w\":\"";
+        BigEndianToHexStr(s->w, PK_SIZE_8, str);
+        *body += str;
+
+        *body += "\",\"n\":\"";
+        LittleEndianToHexStr(s->nonce, NONCE_SIZE_8, str);
+        *body += str;
+
+        *body += "\",\"d\":";
+        LittleEndianOf256ToDecStr(s->d, str, &len);
+        body->append(str, len);
+
+        *body += "}";
+    }
+
+    *body += "]";
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Serve share validation
+////////////////////////////////////////////////////////////////////////////////
+int ServeValidation(const int threads, const int port)
+{
+    validation_pool_t pool(threads);
+    latency_histogram_t batchLatency;
+
+    std::atomic<uint64_t> batches(0);
+    std::atomic<uint64_t> shares(0);
+    std::atomic<uint64_t> valid(0);
+    std::atomic<uint64_t> malformed(0);
+
+    steady_clock::time_point start = steady_clock::now();
+
+    httplib::Server svr;
+
+    // a connection thread per validation thread keeps all of them busy
+    int connections = std::max(
+        (int)pool.workers.size(), CPPHTTPLIB_THREAD_POOL_COUNT
+    );
+
+    svr.new_task_queue = [connections]
+    {
+        return new httplib::ThreadPool(connections);
+    };
+
+    svr.Post(
+        "/shares",
+        [&](const httplib::Request & req, httplib::Response & res)
+        {
+            steady_clock::time_point received = steady_clock::now();
+
+            std::vector<autolykos_share_t> batch;
+            std::vector<int> verdicts;
+
+            if (ParseShares(req.body.c_str(), &batch, &verdicts)
+                != EXIT_SUCCESS)
+            {
+                res.status = 400;
+                res.set_content(
+                    "{\"error\":400,\"reason\":\"malformed batch\"}",
+                    "application/json"
+                );
+
+                return;
+            }
+
+            int count = batch.size();
+            int v = pool.Validate(batch.data(), count, verdicts.data());
+
+            std::stringstream strBuf;
+
+            strBuf << "{\"valid\":" << v << ",\"verdicts\":[";
+
+            for (int i = 0; i < count; ++i)
+            {
+                strBuf << ((i)? ",": "") << verdicts[i];
+            }
+
+            strBuf << "]}";
+
+            res.set_content(strBuf.str(), "application/json");
+
+            batchLatency.Add(
+                duration<double, std::micro>(steady_clock::now() - received)
+                .count()
+            );
+
+            ++batches;
+            shares += count;
+            valid += v;
+            malformed += std::count(verdicts.begin(), verdicts.end(), -1);
+        }
+    );
+
+    svr.Get(
+        "/stats",
+        [&](const httplib::Request & req, httplib::Response & res)
+        {
+            double sec = duration<double>(steady_clock::now() - start).count();
+
+            std::stringstream strBuf;
+
+            strBuf << "{ \"threads\": " << pool.workers.size()
+                << ", \"batches\": " << batches
+                << ", \"shares\": " << shares
+                << ", \"valid\": " << valid
+                << ", \"malformed\": " << malformed
+                << ", \"sharesPerSec\": " << shares / sec
+                << ", \"shareLatencyUs\": ";
+
+            pool.shareLatency.Print(strBuf);
+
+            strBuf << ", \"batchLatencyUs\": ";
+
+            batchLatency.Print(strBuf);
+
+            strBuf << " }";
+
+            res.set_content(strBuf.str(), "application/json");
+        }
+    );
+
+    LOG(INFO) << "Validating shares on port " << port << " with "
+        << pool.workers.size() << " threads";
+
+    if (!svr.listen("0.0.0.0", port))
+    {
+        LOG(ERROR) << "Cannot listen on port " << port;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Write function for CURL response of any length
+////////////////////////////////////////////////////////////////////////////////
+static size_t AppendFunc(
+    void * ptr,
+    size_t size,
+    size_t nmemb,
+    std::string * response
+)
+{
+    response->append((const char *)ptr, size * nmemb);
+
+    return size * nmemb;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Number of verdicts of response differing from expected ones
+////////////////////////////////////////////////////////////////////////////////
+static int CountWrongVerdicts(
+    const std::string & response,
+    const std::vector<int> & expected
+)
+{
+    size_t pos = response.find("\"verdicts\":[");
+
+    if (pos == std::string::npos) { return expected.size(); }
+
+    const char * ptr = response.c_str() + pos + 12;
+    int wrong = 0;
+
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        char * end;
+        long verdict = strtol(ptr, &end, 10);
+
+        if (end == ptr) { return wrong + expected.size() - i; }
+
+        wrong += verdict != expected[i];
+        ptr = end + 1;
+    }
+
+    return wrong;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Post synthetic shares to validation server
+////////////////////////////////////////////////////////////////////////////////
+int LoadValidation(
+    // server URL
+    const char * url,
+    // shares per request
+    const int batch,
+    // concurrent clients
+    const int clients,
+    // duration of load
+    const double seconds,
+    // fraction of invalid shares
+    const double invalid
+)
+{
+    //========================================================================//
+    //  Synthetic shares, two batches per client
+    //========================================================================//
+    uint8_t sk[NUM_SIZE_8];
+    uint8_t pk[PK_SIZE_8];
+    uint8_t x[NUM_SIZE_8];
+    uint8_t w[PK_SIZE_8];
+    uint8_t mes[NUM_SIZE_8];
+
+    GenerateKeyPair(sk, pk);
+    GenerateKeyPair(x, w);
+
+    std::mt19937_64 generator(std::random_device{}());
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    int bodies = 2 * clients;
+    std::vector<std::string> body(bodies);
+    std::vector<std::vector<int> > expected(bodies);
+    std::vector<autolykos_share_t> shares(batch);
+
+    for (int b = 0; b < bodies; ++b)
+    {
+        for (int i = 0; i < NUM_SIZE_8; i += 8)
+        {
+            uint64_t r = generator();
+            memcpy(mes + i, &r, 8);
+        }
+
+        uint64_t nonce = generator();
+
+        expected[b].resize(batch);
+
+        for (int i = 0; i < batch; ++i)
+        {
+            GenerateShare(sk, pk, x, w, mes, nonce + i, &shares[i]);
+
+            expected[b][i] = uniform(generator) >= invalid;
+
+            if (!expected[b][i]) { shares[i].d[0] ^= 1; }
+        }
+
+        PrintShares(shares.data(), batch, &body[b]);
+    }
+
+    LOG(INFO) << "Generated " << bodies * batch << " shares, posting them to "
+        << url << " from " << clients << " clients for " << seconds << " s";
+
+    //========================================================================//
+    //  Clients
+    //========================================================================//
+    std::string to = std::string(url) + "/shares";
+    latency_histogram_t latency;
+
+    std::atomic<uint64_t> requests(0);
+    std::atomic<uint64_t> failed(0);
+    std::atomic<uint64_t> wrong(0);
+
+    steady_clock::time_point start = steady_clock::now();
+    steady_clock::time_point end = start + duration_cast<nanoseconds>(
+        duration<double>(seconds)
+    );
+
+    auto client = [&](const int c)
+    {
+        CURL * curl = curl_easy_init();
+
+        if (!curl)
+        {
+            LOG(ERROR) << "CURL initialization failed in LoadValidation";
+            return;
+        }
+
+        std::string response;
+        curl_slist * headers
+            = curl_slist_append(NULL, "Content-Type: application/json");
+
+        CurlLogError(curl_easy_setopt(curl, CURLOPT_URL, to.c_str()));
+        CurlLogError(curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers));
+        CurlLogError(curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, AppendFunc));
+        CurlLogError(curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response));
+        CurlLogError(curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L));
+        CurlLogError(curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L));
+
+        for (int b = c; steady_clock::now() < end; b = (b + clients) % bodies)
+        {
+            long code = 0;
+
+            response.clear();
+
+            CurlLogError(curl_easy_setopt(
+                curl, CURLOPT_POSTFIELDS, body[b].c_str()
+            ));
+            CurlLogError(curl_easy_setopt(
+                curl, CURLOPT_POSTFIELDSIZE, (long)body[b].size()
+            ));
+
+            steady_clock::time_point sent = steady_clock::now();
+
+            CURLcode status = curl_easy_perform(curl);
+
+            if (status == CURLE_OK)
+            {
+                curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+            }
+
+            if (code != 200)
+            {
+                ++failed;
+
+                // server is down or overloaded
+                std::this_thread::sleep_for(milliseconds(100));
+
+                continue;
+            }
+
+            latency.Add(
+                duration<double, std::micro>(steady_clock::now() - sent)
+                .count()
+            );
+
+            ++requests;
+            wrong += CountWrongVerdicts(response, expected[b]);
+        }
+
+        curl_slist_free_all(headers);
+        curl_easy_cleanup(curl);
+    };
+
+    std::vector<std::thread> pool;
+
+    for (int c = 0; c < clients; ++c)
+    {
+        pool.push_back(std::thread(client, c));
+    }
+
+    for (int c = 0; c < clients; ++c) { pool[c].join(); }
+
+    double sec = duration<double>(steady_clock::now() - start).count();
+
+    std::stringstream strBuf;
+
+    latency.Print(strBuf);
+
+    LOG(INFO) << requests << " batches of " << batch << " shares, "
+        << requests * batch / sec << " shares/s, " << failed
+        << " failed requests, " << wrong << " wrong verdicts";
+    LOG(INFO) << "Batch latency (us): " << strBuf.str();
+
+    return (requests && !failed && !wrong)? EXIT_SUCCESS: EXIT_FAILURE;
+}
+
+// validator.cc
@@ -0,0 +1,220 @@
+// verify.cc
+
+/*******************************************************************************
+
+    VERIFY -- Autolykos solution verification on host
+
+*******************************************************************************/
+
+#include "../include/verify.h"
+#include "../include/definitions.h"
+#include "../include/hostmining.h"
+#include "../include/hostprehash.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/obj_mac.h>
+
+////////////////////////////////////////////////////////////////////////////////
+//  Sum of hashes selected by nonce modulo Q
+////////////////////////////////////////////////////////////////////////////////
+static void NonceSum(
+    const uint8_t * pnp,
+    const uint64_t nonce,
+    uint32_t * sum
+)
+{
+    ctx_t ctx;
+    uint32_t ind[K_LEN];
+    uint32_t seq[K_LEN];
+    uint32_t hashes[K_LEN * NUM_SIZE_32];
+
+    const uint32_t one[NUM_SIZE_32] = { 1, 0, 0, 0, 0, 0, 0, 0 };
+    const uint32_t zero[NUM_SIZE_32] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    InitMining(&ctx, (const uint32_t *)(pnp + PK_SIZE_8), NUM_SIZE_8);
+    HostNonceIndices(&ctx, nonce, ind);
+
+    // compact table of selected hashes only
+    for (int k = 0; k < K_LEN; ++k)
+    {
+        HostInitPrehash(pnp, ind[k], hashes + k * NUM_SIZE_32);
+        HostFinalPrehashMultSecKey(one, hashes + k * NUM_SIZE_32);
+
+        seq[k] = k;
+    }
+
+    HostNonceResult(zero, hashes, seq, sum);
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Little endian number to OpenSSL big number
+////////////////////////////////////////////////////////////////////////////////
+static BIGNUM * LittleEndianToBN(const uint8_t * in, BIGNUM * out)
+{
+    uint8_t be[NUM_SIZE_8];
+
+    for (int i = 0; i < NUM_SIZE_8; ++i) { be[i] = in[NUM_SIZE_8 - i - 1]; }
+
+    return BN_bin2bn(be, NUM_SIZE_8, out);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Allocate curve and scratch numbers
+////////////////////////////////////////////////////////////////////////////////
+verifier_t::verifier_t(void)
+{
+    ready = 0;
+    group = NULL;
+    bnctx = NULL;
+    f = d = NULL;
+    pk = w = left = right = NULL;
+
+    Init();
+}
+
+verifier_t::~verifier_t(void)
+{
+    Free();
+}
+
+int verifier_t::Init(void)
+{
+    Free();
+
+    // library code reports failure instead of terminating the process
+    ready = (group = EC_GROUP_new_by_curve_name(NID_secp256k1))
+        && (bnctx = BN_CTX_new())
+        && (f = BN_new())
+        && (d = BN_new())
+        && (pk = EC_POINT_new(group))
+        && (w = EC_POINT_new(group))
+        && (left = EC_POINT_new(group))
+        && (right = EC_POINT_new(group))
+        // multiples of generator for g^d
+        && EC_GROUP_precompute_mult(group, bnctx);
+
+    if (!ready) { Free(); }
+
+    return (ready)? EXIT_SUCCESS: EXIT_FAILURE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Free curve and scratch numbers
+////////////////////////////////////////////////////////////////////////////////
+void verifier_t::Free(void)
+{
+    EC_POINT_free(right);
+    EC_POINT_free(left);
+    EC_POINT_free(w);
+    EC_POINT_free(pk);
+    BN_free(d);
+    BN_free(f);
+    BN_CTX_free(bnctx);
+    EC_GROUP_free(group);
+
+    ready = 0;
+    group = NULL;
+    bnctx = NULL;
+    f = d = NULL;
+    pk = w = left = right = NULL;
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Check posted solution
+////////////////////////////////////////////////////////////////////////////////
+int verifier_t::Verify(
+    // message
+    const uint8_t * mes,
+    // public key
+    const uint8_t * pkey,
+    // one-time public key
+    const uint8_t * wkey,
+    // nonce (LITTLE ENDIAN)
+    const uint8_t * nonce,
+    // distance (LITTLE ENDIAN)
+    const uint8_t * dist,
+    // boundary for puzzle (LITTLE ENDIAN)
+    const uint8_t * bound
+)
+{
+    uint32_t dw[NUM_SIZE_32];
+    uint32_t bw[NUM_SIZE_32];
+
+    memcpy(dw, dist, NUM_SIZE_8);
+    memcpy(bw, bound, NUM_SIZE_8);
+
+    if (!HostIsSolution(dw, bw)) { return EXIT_FAILURE; }
+
+    if (!ready && Init() != EXIT_SUCCESS) { return VERIFY_ERROR; }
+
+    //========================================================================//
+    //  f := sum of hashes selected by nonce
+    //========================================================================//
+    uint8_t pnp[2 * PK_SIZE_8 + NUM_SIZE_8];
+    uint32_t sum[NUM_SIZE_32];
+    uint64_t n;
+
+    memcpy(pnp, pkey, PK_SIZE_8);
+    memcpy(pnp + PK_SIZE_8, mes, NUM_SIZE_8);
+    memcpy(pnp + PK_SIZE_8 + NUM_SIZE_8, wkey, PK_SIZE_8);
+    memcpy(&n, nonce, NONCE_SIZE_8);
+
+    NonceSum(pnp, n, sum);
+
+    //========================================================================//
+    //  w^f == g^d * pk
+    //========================================================================//
+    // keys off the curve make the share invalid
+    if (
+        !EC_POINT_oct2point(group, pk, pkey, PK_SIZE_8, bnctx)
+        || !EC_POINT_oct2point(group, w, wkey, PK_SIZE_8, bnctx)
+    )
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (
+        !LittleEndianToBN((const uint8_t *)sum, f)
+        || !LittleEndianToBN(dist, d)
+        || !EC_POINT_mul(group, left, NULL, w, f, bnctx)
+        || !EC_POINT_mul(group, right, d, NULL, NULL, bnctx)
+        || !EC_POINT_add(group, right, right, pk, bnctx)
+    )
+    {
+        return VERIFY_ERROR;
+    }
+
+    int cmp = EC_POINT_cmp(group, left, right, bnctx);
+
+    return (cmp < 0)? VERIFY_ERROR: (cmp)? EXIT_FAILURE: EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Check posted solution with verifier of calling thread
+////////////////////////////////////////////////////////////////////////////////
+int VerifySolution(
+    // message
+    const uint8_t * mes,
+    // public key
+    const uint8_t * pk,
+    // one-time public key
+    const uint8_t * w,
+    // nonce (LITTLE ENDIAN)
+    const uint8_t * nonce,
+    // distance (LITTLE ENDIAN)
+    const uint8_t * d,
+    // boundary for puzzle (LITTLE ENDIAN)
+    const uint8_t * bound
+)
+{
+    static thread_local verifier_t verifier;
+
+    return verifier.Verify(mes, pk, w, nonce, d, bound);
+}
+
+// verify.cc
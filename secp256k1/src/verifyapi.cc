@@ -0,0 +1,100 @@
+// verifyapi.cc
+
+/*******************************************************************************
+
+    VERIFYAPI -- C interface of Autolykos share verification library
+
+*******************************************************************************/
+
+#include "../include/verifyapi.h"
+#include "../include/verify.h"
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// shares taken by a thread at once
+#define VERIFY_CHUNK 16
+
+////////////////////////////////////////////////////////////////////////////////
+//  Verify one share
+////////////////////////////////////////////////////////////////////////////////
+int AutolykosVerify(const autolykos_share_t * share)
+{
+    int status = VerifySolution(
+        share->mes, share->pk, share->w, share->nonce, share->d, share->bound
+    );
+
+    return (status == VERIFY_ERROR)?
+        AUTOLYKOS_VERIFY_ERROR: status == EXIT_SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Verify shares in parallel
+////////////////////////////////////////////////////////////////////////////////
+int AutolykosVerifyBatch(
+    const autolykos_share_t * shares,
+    const int count,
+    const int threads,
+    int * verdicts
+)
+{
+    std::atomic<int> next(0);
+    std::atomic<int> valid(0);
+    std::atomic<int> failed(0);
+
+    int n = (threads > 0)? threads: std::thread::hardware_concurrency();
+
+    if (n <= 0) { n = 1; }
+    if (n > (count + VERIFY_CHUNK - 1) / VERIFY_CHUNK)
+    {
+        n = (count + VERIFY_CHUNK - 1) / VERIFY_CHUNK;
+    }
+
+    // shares are taken in chunks, verification time varies with rejection
+    auto work = [&](void)
+    {
+        verifier_t verifier;
+        int found = 0;
+
+        for (int from; (from = next.fetch_add(VERIFY_CHUNK)) < count; )
+        {
+            int to = (from + VERIFY_CHUNK < count)? from + VERIFY_CHUNK: count;
+
+            for (int i = from; i < to; ++i)
+            {
+                const autolykos_share_t * s = shares + i;
+
+                int status = verifier.Verify(
+                    s->mes, s->pk, s->w, s->nonce, s->d, s->bound
+                );
+
+                verdicts[i] = (status == VERIFY_ERROR)?
+                    AUTOLYKOS_VERIFY_ERROR: status == EXIT_SUCCESS;
+
+                if (status == VERIFY_ERROR) { failed = 1; }
+                else { found += verdicts[i]; }
+            }
+        }
+
+        valid += found;
+    };
+
+    std::vector<std::thread> pool;
+
+    // exceptions must not cross the C interface, the calling thread
+    // verifies whatever the threads started do not
+    try
+    {
+        for (int t = 1; t < n; ++t) { pool.push_back(std::thread(work)); }
+    }
+    catch (...) {}
+
+    work();
+
+    for (size_t t = 0; t < pool.size(); ++t) { pool[t].join(); }
+
+    return (failed)? AUTOLYKOS_VERIFY_ERROR: valid.load();
+}
+
+// verifyapi.cc
@@ -0,0 +1,104 @@
+// watchdog.cc
+
+/*******************************************************************************
+
+    WATCHDOG -- Miner thread supervision and device recovery accounting
+
+*******************************************************************************/
+
+#include "../include/watchdog.h"
+#include "../include/easylogging++.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//  Set number of devices
+////////////////////////////////////////////////////////////////////////////////
+void watchdog_t::Init(const int n)
+{
+    devices = n;
+
+    for (int i = 0; i < n; ++i)
+    {
+        health[i].recover = 0;
+        health[i].recoveries = 0;
+        health[i].downtimeMs = 0;
+        health[i].downSinceMs = 0;
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Device failed
+////////////////////////////////////////////////////////////////////////////////
+void watchdog_t::Down(const int device)
+{
+    int64_t zero = 0;
+
+    // supervisor may have marked it already
+    health[device].downSinceMs.compare_exchange_strong(
+        zero, clock()
+    );
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Device mines again
+////////////////////////////////////////////////////////////////////////////////
+void watchdog_t::Up(const int device)
+{
+    int64_t since = health[device].downSinceMs.exchange(0);
+
+    if (since)
+    {
+        int64_t down = clock() - since;
+
+        health[device].downtimeMs += down;
+        ++(health[device].recoveries);
+
+        LOG(INFO) << "GPU " << device << " recovered after " << down
+            << " ms, recoveries " << health[device].recoveries
+            << ", total downtime " << health[device].downtimeMs << " ms";
+    }
+
+    health[device].recover = 0;
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Request recovery of stalled devices
+////////////////////////////////////////////////////////////////////////////////
+void watchdog_t::Check(hashrate_t * hashrates)
+{
+    for (int i = 0; i < devices; ++i)
+    {
+        if (!hashrates->Alive(i) && !health[i].recover.exchange(1))
+        {
+            LOG(ERROR) << "GPU " << i << " stalled, requesting recovery";
+
+            // stall started when the last iteration finished
+            int64_t zero = 0;
+
+            health[i].downSinceMs.compare_exchange_strong(
+                zero,
+                hashrates->counters[i].updateMs.load(std::memory_order_relaxed)
+            );
+        }
+    }
+
+    return;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  Total downtime including current failure
+////////////////////////////////////////////////////////////////////////////////
+int64_t watchdog_t::DowntimeMs(const int device)
+{
+    int64_t since = health[device].downSinceMs.load();
+
+    return health[device].downtimeMs.load()
+        + ((since)? clock() - since: 0);
+}
+
+// watchdog.cc
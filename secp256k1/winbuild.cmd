@@ -10,8 +10,9 @@ nvcc -o ../miner.exe -Xcompiler "/std:c++14" -gencode arch=compute_%CUDA_COMPUTE
  -I %LIBCURL_DIR%\include ^
  -l %LIBCURL_DIR%\builds\libcurl-vc-x64-release-dll-ipv6-sspi-winssl-obj-lib/libcurl ^
  -l %OPENSSL_DIR%\lib\libeay32 -L %OPENSSL_DIR%/lib ^
- -lnvml ^
+ -lnvml -lws2_32 ^
 conversion.cc cryptography.cc definitions.cc jsmn.c httpapi.cc ^
+asynclog.cc autotune.cc backend.cc cpubackend.cc simbackend.cc cudabackend.cu fanout.cc hashrate.cc hostkernel.cc hostmining.cc hostmodq.cc hostprehash.cc hugepages.cc journal.cc sharedtable.cc throttle.cc topology.cc verify.cc verifyapi.cc watchdog.cc ^
 mining.cu prehash.cu processing.cc request.cc easylogging++.cc bip39/bip39.cc bip39/util.cc autolykos.cu
 
 nvcc -o ../test.exe -Xcompiler "/std:c++14" -gencode arch=compute_%CUDA_COMPUTE_ARCH%,code=sm_%CUDA_COMPUTE_ARCH%^
@@ -20,7 +21,25 @@ nvcc -o ../test.exe -Xcompiler "/std:c++14" -gencode arch=compute_%CUDA_COMPUTE_
  -I %LIBCURL_DIR%\include ^
  -l %LIBCURL_DIR%\builds\libcurl-vc-x64-release-dll-ipv6-sspi-winssl-obj-lib/libcurl ^
  -l %OPENSSL_DIR%\lib\libeay32 -L %OPENSSL_DIR%/lib ^
-test.cu conversion.cc cryptography.cc definitions.cc jsmn.c ^
+ -lnvml -lws2_32 ^
+test.cu validator.cc conversion.cc cryptography.cc definitions.cc jsmn.c ^
+asynclog.cc autotune.cc backend.cc cpubackend.cc simbackend.cc cudabackend.cu fanout.cc hashrate.cc hostkernel.cc hostmining.cc hostmodq.cc hostprehash.cc hugepages.cc journal.cc sharedtable.cc throttle.cc topology.cc verify.cc verifyapi.cc watchdog.cc ^
 mining.cu prehash.cu processing.cc request.cc easylogging++.cc
+
+nvcc -o ../replay.exe -Xcompiler "/std:c++14" -gencode arch=compute_%CUDA_COMPUTE_ARCH%,code=sm_%CUDA_COMPUTE_ARCH%^
+ -gencode arch=compute_30,code=compute_30 -DBLOCK_DIM=%BLOCK_DIM% -DNONCES_PER_ITER=%WORKSPACE%^
+ -I %OPENSSL_DIR%\include ^
+ -I %LIBCURL_DIR%\include ^
+ -l %LIBCURL_DIR%\builds\libcurl-vc-x64-release-dll-ipv6-sspi-winssl-obj-lib/libcurl ^
+ -l %OPENSSL_DIR%\lib\libeay32 -L %OPENSSL_DIR%/lib ^
+ -lnvml -lws2_32 ^
+replay.cc candidates.cc emulator.cc validator.cc conversion.cc cryptography.cc definitions.cc jsmn.c ^
+asynclog.cc autotune.cc backend.cc cpubackend.cc simbackend.cc cudabackend.cu fanout.cc hashrate.cc hostkernel.cc hostmining.cc hostmodq.cc hostprehash.cc hugepages.cc journal.cc sharedtable.cc throttle.cc topology.cc verify.cc verifyapi.cc watchdog.cc ^
+mining.cu prehash.cu processing.cc request.cc easylogging++.cc
+
+nvcc -o ../autolykos_verify.dll --shared -Xcompiler "/std:c++14" -DAUTOLYKOS_VERIFY_BUILD -DBLOCK_DIM=%BLOCK_DIM% -DNONCES_PER_ITER=%WORKSPACE%^
+ -I %OPENSSL_DIR%\include ^
+ -l %OPENSSL_DIR%\lib\libeay32 -L %OPENSSL_DIR%/lib ^
+verify.cc verifyapi.cc hostmining.cc hostmodq.cc hostprehash.cc
 cd ..
 SET PATH=%PATH%;C:\Program Files\NVIDIA Corporation\NVSMI
\ No newline at end of file